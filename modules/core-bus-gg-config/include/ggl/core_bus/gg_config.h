@@ -23,6 +23,13 @@ GgError ggl_gg_config_read_str(
     GgBufList key_path, GgArena *alloc, GgBuffer *result
 );
 
+/// Wrapper for core-bus `gg_config` `read_many`
+// key_paths is a list of key paths, each a list of buffer objects. values_out
+// has the value at each key path in order, or null if it is not set.
+GgError ggl_gg_config_read_many(
+    GgList key_paths, GgArena *alloc, GgList *values_out
+);
+
 /// Wrapper for core-bus `gg_config` `list`
 // subkeys_out is a list of buffer objects.
 GgError ggl_gg_config_list(
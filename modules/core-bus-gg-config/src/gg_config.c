@@ -47,6 +47,36 @@ GgError ggl_gg_config_read(
     return err;
 }
 
+GgError ggl_gg_config_read_many(
+    GgList key_paths, GgArena *alloc, GgList *values_out
+) {
+    GgMap args = GG_MAP(gg_kv(GG_STR("key_paths"), gg_obj_list(key_paths)));
+
+    GgError remote_err = GG_ERR_OK;
+    GgObject result_obj = { 0 };
+    GgError err = ggl_call(
+        GG_STR("gg_config"),
+        GG_STR("read_many"),
+        args,
+        &remote_err,
+        alloc,
+        &result_obj
+    );
+    if ((err == GG_ERR_REMOTE) && (remote_err != GG_ERR_OK)) {
+        err = remote_err;
+    }
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+    if ((gg_obj_type(result_obj) != GG_TYPE_LIST)
+        || (gg_obj_into_list(result_obj).len != key_paths.len)) {
+        GG_LOGE("Configuration read_many returned an unexpected response.");
+        return GG_ERR_FAILURE;
+    }
+    *values_out = gg_obj_into_list(result_obj);
+    return GG_ERR_OK;
+}
+
 GgError ggl_gg_config_list(
     GgBufList key_path, GgArena *alloc, GgList *subkeys_out
 ) {
@@ -17,6 +17,14 @@ GgError ggl_gghealthd_retrieve_component_status(
     GgBuffer component, GgArena *alloc, GgBuffer *component_status
 );
 
+/// Retrieve the lifecycle state of each component in components, or of every
+/// root component if components is NULL, in one request. statuses maps
+/// component names to lifecycle state buffers and is allocated in alloc;
+/// components without a known state are omitted.
+GgError ggl_gghealthd_retrieve_component_statuses(
+    const GgList *components, GgArena *alloc, GgMap *statuses
+);
+
 /// Subscribe to lifecycle state changes of every Greengrass (`ggl.*`)
 /// component. `on_response` receives a map with `component_name` and
 /// `lifecycle_state` buffers for each terminal-state change. Wraps the
@@ -9,6 +9,7 @@
 #include <gg/map.h>
 #include <gg/object.h>
 #include <gg/types.h>
+#include <gg/vector.h>
 #include <ggl/core_bus/client.h>
 #include <ggl/core_bus/gg_healthd.h>
 #include <stdint.h>
@@ -66,6 +67,47 @@ GgError ggl_gghealthd_retrieve_component_status(
     return GG_ERR_OK;
 }
 
+GgError ggl_gghealthd_retrieve_component_statuses(
+    const GgList *components, GgArena *alloc, GgMap *statuses
+) {
+    GgKVVec args = GG_KV_VEC((GgKV[1]) { 0 });
+    if (components != NULL) {
+        (void) gg_kv_vec_push(
+            &args, gg_kv(GG_STR("component_names"), gg_obj_list(*components))
+        );
+    }
+
+    GgObject result;
+    GgError method_error;
+    GgError ret = ggl_call(
+        GG_STR("gg_health"),
+        GG_STR("get_statuses"),
+        args.map,
+        &method_error,
+        alloc,
+        &result
+    );
+    if (ret != GG_ERR_OK) {
+        if (ret == GG_ERR_REMOTE) {
+            return method_error;
+        }
+        return ret;
+    }
+    if (gg_obj_type(result) != GG_TYPE_MAP) {
+        GG_LOGE("Invalid response; lifecycle states must be a map.");
+        return GG_ERR_INVALID;
+    }
+    GgMap result_map = gg_obj_into_map(result);
+    GG_MAP_FOREACH (pair, result_map) {
+        if (gg_obj_type(*gg_kv_val(pair)) != GG_TYPE_BUF) {
+            GG_LOGE("Invalid response; lifecycle state must be a buffer.");
+            return GG_ERR_INVALID;
+        }
+    }
+    *statuses = result_map;
+    return GG_ERR_OK;
+}
+
 GgError ggl_gghealthd_subscribe_to_all_component_state_changes(
     GglSubscribeCallback on_response,
     GglSubscribeCloseCallback on_close,
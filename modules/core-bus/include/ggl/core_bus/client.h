@@ -18,6 +18,19 @@
 #define GGL_COREBUS_CLIENT_MAX_SUBSCRIPTIONS 100
 #endif
 
+/// Maximum number of subscriptions made with `ggl_subscribe_mux`.
+/// Can be configured with `-DGGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS=<N>`.
+#ifndef GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS
+#define GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS 200
+#endif
+
+/// Maximum number of interfaces with a shared subscription connection.
+/// Each uses one of the `GGL_COREBUS_CLIENT_MAX_SUBSCRIPTIONS` connections.
+/// Can be configured with `-DGGL_COREBUS_CLIENT_MAX_MUX_CHANNELS=<N>`.
+#ifndef GGL_COREBUS_CLIENT_MAX_MUX_CHANNELS
+#define GGL_COREBUS_CLIENT_MAX_MUX_CHANNELS 8
+#endif
+
 /// Send a Core Bus notification (call, but don't wait for response).
 GgError ggl_notify(GgBuffer interface, GgBuffer method, GgMap params);
 
@@ -52,6 +65,22 @@ GgError ggl_subscribe(
     uint32_t *handle
 );
 
+/// Make a Core Bus subscription sharing one connection per interface with the
+/// other subscriptions made with this function.
+/// Otherwise behaves as `ggl_subscribe`. If called from a subscription
+/// callback, falls back to `ggl_subscribe`, as the response to the request is
+/// received on the thread running the callbacks.
+GgError ggl_subscribe_mux(
+    GgBuffer interface,
+    GgBuffer method,
+    GgMap params,
+    GglSubscribeCallback on_response,
+    GglSubscribeCloseCallback on_close,
+    void *ctx,
+    GgError *error,
+    uint32_t *handle
+);
+
 /// Close a client subscription handle.
 void ggl_client_sub_close(uint32_t handle);
 
@@ -13,4 +13,20 @@
 #define GGL_COREBUS_MAX_MSG_LEN 10000
 #endif
 
+/// Number of times a client retries connecting to an interface whose socket
+/// does not exist yet or is not listening. Socket-activated interfaces accept
+/// connections before their daemon starts, so this is only needed when daemons
+/// are started in parallel without socket units, and is disabled by default.
+/// Can be configured with `-DGGL_COREBUS_CONNECT_RETRIES=<N>`.
+#ifndef GGL_COREBUS_CONNECT_RETRIES
+#define GGL_COREBUS_CONNECT_RETRIES 0
+#endif
+
+/// Delay before the first connect retry, in milliseconds.
+/// The delay doubles with each retry.
+/// Can be configured with `-DGGL_COREBUS_CONNECT_RETRY_MS=<N>`.
+#ifndef GGL_COREBUS_CONNECT_RETRY_MS
+#define GGL_COREBUS_CONNECT_RETRY_MS 10
+#endif
+
 #endif
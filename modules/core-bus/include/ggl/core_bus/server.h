@@ -19,6 +19,13 @@
 #define GGL_COREBUS_MAX_CLIENTS 100
 #endif
 
+/// Maximum number of subscriptions multiplexed over shared connections.
+/// These do not use a client connection each.
+/// Can be configured with `-DGGL_COREBUS_MAX_MUX_SUBSCRIPTIONS=<N>`.
+#ifndef GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS
+#define GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS 200
+#endif
+
 /// Function that receives client invocations of a method.
 /// For call/notify, the handler must either use the handle to respond and
 /// return GG_ERR_OK, or return an error without responding. For
@@ -60,6 +67,13 @@ void ggl_sub_accept(
 /// Subscriptions must be accepted before responding.
 void ggl_sub_respond(uint32_t handle, GgObject value);
 
+/// Send the same response on several subscriptions.
+/// Equivalent to calling ggl_sub_respond for each handle, but the value is
+/// serialized only once.
+void ggl_sub_respond_many(
+    const uint32_t *handles, size_t handles_len, GgObject value
+);
+
 /// Close a server subscription handle.
 void ggl_server_sub_close(uint32_t handle);
 
@@ -6,6 +6,7 @@
 #include "object_serde.h"
 #include "types.h"
 #include <assert.h>
+#include <errno.h>
 #include <gg/buffer.h>
 #include <gg/cleanup.h>
 #include <gg/error.h>
@@ -18,9 +19,12 @@
 #include <gg/log.h>
 #include <gg/object.h>
 #include <gg/socket.h>
+#include <gg/utils.h>
 #include <gg/vector.h>
 #include <ggl/core_bus/constants.h>
 #include <pthread.h>
+#include <sys/stat.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -28,7 +32,22 @@ uint8_t ggl_core_bus_client_payload_array[GGL_COREBUS_MAX_MSG_LEN];
 pthread_mutex_t ggl_core_bus_client_payload_array_mtx
     = PTHREAD_MUTEX_INITIALIZER;
 
-static GgError interface_connect(GgBuffer interface, int *conn_fd) {
+// A connect failing with ENOENT or ECONNREFUSED may succeed once the server
+// starts listening. gg_connect does not report errno, so this is inferred from
+// the socket path: either missing, or present as a socket.
+static bool server_may_start(GgByteVec *socket_path) {
+    if (gg_byte_vec_push(socket_path, '\0') != GG_ERR_OK) {
+        return false;
+    }
+    socket_path->buf.len -= 1;
+    struct stat info;
+    if (stat((char *) socket_path->buf.data, &info) != 0) {
+        return errno == ENOENT;
+    }
+    return S_ISSOCK(info.st_mode);
+}
+
+GgError ggl_client_connect(GgBuffer interface, int *conn_fd) {
     assert(conn_fd != NULL);
 
     uint8_t socket_path_buf
@@ -44,7 +63,22 @@ static GgError interface_connect(GgBuffer interface, int *conn_fd) {
         return GG_ERR_RANGE;
     }
 
-    return gg_connect(socket_path.buf, conn_fd);
+    ret = gg_connect(socket_path.buf, conn_fd);
+    int64_t delay_ms = GGL_COREBUS_CONNECT_RETRY_MS;
+    for (int i = 0; (ret != GG_ERR_OK) && (i < GGL_COREBUS_CONNECT_RETRIES)
+         && server_may_start(&socket_path);
+         i++) {
+        GG_LOGD(
+            "Interface %.*s not available; retrying in %d ms.",
+            (int) interface.len,
+            interface.data,
+            (int) delay_ms
+        );
+        (void) gg_sleep_ms(delay_ms);
+        delay_ms *= 2;
+        ret = gg_connect(socket_path.buf, conn_fd);
+    }
+    return ret;
 }
 
 GgError ggl_client_send_message(
@@ -56,7 +90,7 @@ GgError ggl_client_send_message(
 ) {
     int conn = -1;
     GG_LOGT("Connecting to %.*s.", (int) interface.len, interface.data);
-    GgError ret = interface_connect(interface, &conn);
+    GgError ret = ggl_client_connect(interface, &conn);
     if (ret != GG_ERR_OK) {
         return ret;
     }
@@ -17,6 +17,8 @@
 extern uint8_t ggl_core_bus_client_payload_array[GGL_COREBUS_MAX_MSG_LEN];
 extern pthread_mutex_t ggl_core_bus_client_payload_array_mtx;
 
+GgError ggl_client_connect(GgBuffer interface, int *conn_fd);
+
 GgError ggl_client_send_message(
     GgBuffer interface,
     GglCoreBusRequestType type,
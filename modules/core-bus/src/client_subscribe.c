@@ -11,18 +11,23 @@
 #include <gg/cleanup.h>
 #include <gg/error.h>
 #include <gg/eventstream/decode.h>
+#include <gg/eventstream/encode.h>
 #include <gg/eventstream/types.h>
 #include <gg/file.h>
+#include <gg/log-trail.h> // IWYU pragma: keep (used only under GG_LOG_TRAIL_ENABLED)
 #include <gg/log.h>
 #include <gg/socket.h>
 #include <gg/socket_epoll.h>
+#include <gg/object.h>
 #include <gg/types.h>
 #include <ggl/core_bus/client.h>
 #include <ggl/core_bus/constants.h>
 #include <ggl/socket_handle.h>
 #include <pthread.h>
+#include <string.h>
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -36,8 +41,13 @@
 #define PAYLOAD_MAX_SUBOBJECTS 50
 
 static_assert(
-    GGL_COREBUS_CLIENT_MAX_SUBSCRIPTIONS < UINT16_MAX,
-    "Max subscriptions cannot exceed UINT16_MAX."
+    GGL_COREBUS_CLIENT_MAX_SUBSCRIPTIONS < GGL_CORE_BUS_MUX_INDEX_BASE,
+    "GGL_COREBUS_CLIENT_MAX_SUBSCRIPTIONS overlaps multiplexed handles."
+);
+static_assert(
+    GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS
+        < UINT16_MAX - GGL_CORE_BUS_MUX_INDEX_BASE,
+    "GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS too large."
 );
 
 typedef struct {
@@ -48,6 +58,40 @@ typedef struct {
 
 static SubCallbacks sub_callbacks[GGL_COREBUS_CLIENT_MAX_SUBSCRIPTIONS];
 
+typedef enum {
+    MUX_SUB_FREE = 0,
+    MUX_SUB_PENDING,
+    MUX_SUB_ACTIVE,
+    MUX_SUB_FAILED,
+} MuxSubState;
+
+/// A subscription multiplexed over the connection `channel`. Its handle is
+/// also its `sub-id` on the wire.
+typedef struct {
+    uint32_t channel;
+    MuxSubState state;
+    /// Result of a failed subscribe request.
+    GgError result;
+    GgError remote_error;
+    SubCallbacks callbacks;
+} MuxSubscription;
+
+/// Connection shared by the multiplexed subscriptions to an interface.
+typedef struct {
+    uint8_t interface[GGL_INTERFACE_NAME_MAX_LEN];
+    size_t interface_len;
+    uint32_t conn;
+} MuxChannel;
+
+// Multiplexing state is protected by the socket pool mutex.
+static MuxSubscription mux_subs[GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS];
+static uint16_t mux_sub_generations[GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS];
+static MuxChannel mux_channels[GGL_COREBUS_CLIENT_MAX_MUX_CHANNELS];
+/// Signaled when a pending subscription is accepted or fails.
+static pthread_cond_t mux_sub_cond = PTHREAD_COND_INITIALIZER;
+/// Serializes opening channels.
+static pthread_mutex_t mux_channel_mtx = PTHREAD_MUTEX_INITIALIZER;
+
 static GgError reset_sub_state(uint32_t handle, size_t index);
 static GgError call_close_callback(uint32_t handle, size_t index);
 
@@ -69,6 +113,7 @@ __attribute__((constructor)) static void init_sub_pool(void) {
 static void *subscription_thread(void *args);
 
 static int epoll_fd = -1;
+static pthread_t subscription_thread_id;
 
 /// Initializes subscription epoll and starts epoll thread.
 /// Runs at startup (before main).
@@ -79,13 +124,14 @@ __attribute__((constructor)) static void start_subscription_thread(void) {
         _Exit(1);
     }
 
-    pthread_t sub_thread = { 0 };
-    int sys_ret = pthread_create(&sub_thread, NULL, subscription_thread, NULL);
+    int sys_ret = pthread_create(
+        &subscription_thread_id, NULL, subscription_thread, NULL
+    );
     if (sys_ret != 0) {
         GG_LOGE("Failed to create subscription response thread: %d.", sys_ret);
         _Exit(1);
     }
-    pthread_detach(sub_thread);
+    pthread_detach(subscription_thread_id);
 }
 
 static GgError reset_sub_state(uint32_t handle, size_t index) {
@@ -104,10 +150,87 @@ static void get_sub_callbacks(void *ctx, size_t index) {
     *callbacks = sub_callbacks[index];
 }
 
+static uint32_t mux_sub_handle(size_t index) {
+    return (uint32_t) mux_sub_generations[index] << 16
+        | (uint32_t) (GGL_CORE_BUS_MUX_INDEX_BASE + index + 1U);
+}
+
+/// Gets the slot index of a multiplexed subscription handle.
+/// Must be called with the pool mutex held.
+static bool mux_sub_lookup(uint32_t handle, size_t *index) {
+    if (!ggl_core_bus_is_mux_handle(handle)) {
+        return false;
+    }
+    size_t i = (handle & UINT16_MAX) - GGL_CORE_BUS_MUX_INDEX_BASE - 1U;
+    if ((i >= GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS)
+        || ((handle >> 16) != mux_sub_generations[i])
+        || (mux_subs[i].state == MUX_SUB_FREE)) {
+        return false;
+    }
+    *index = i;
+    return true;
+}
+
+/// Must be called with the pool mutex held.
+static void mux_sub_free(size_t index) {
+    mux_subs[index] = (MuxSubscription) { 0 };
+    mux_sub_generations[index] += 1;
+}
+
+/// Frees an active subscription and runs its close callback.
+/// Must be called with the pool mutex held.
+static void mux_sub_release(size_t index) {
+    uint32_t handle = mux_sub_handle(index);
+    SubCallbacks callbacks = mux_subs[index].callbacks;
+    mux_sub_free(index);
+    if (callbacks.on_close != NULL) {
+        GG_LOGT("Calling subscription close callback.");
+        callbacks.on_close(callbacks.ctx, handle);
+    }
+}
+
+/// Must be called with the pool mutex held.
+static MuxChannel *mux_channel_for_conn(uint32_t conn) {
+    for (size_t i = 0; i < GGL_COREBUS_CLIENT_MAX_MUX_CHANNELS; i++) {
+        if (mux_channels[i].conn == conn) {
+            return &mux_channels[i];
+        }
+    }
+    return NULL;
+}
+
+/// Ends the subscriptions of a closing channel.
+/// Must be called with the pool mutex held.
+static void mux_channel_closed(MuxChannel *channel) {
+    uint32_t conn = channel->conn;
+    *channel = (MuxChannel) { 0 };
+
+    for (size_t i = 0; i < GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS; i++) {
+        if (mux_subs[i].channel != conn) {
+            continue;
+        }
+        if (mux_subs[i].state == MUX_SUB_PENDING) {
+            mux_subs[i].state = MUX_SUB_FAILED;
+            mux_subs[i].result = GG_ERR_FAILURE;
+        } else if (mux_subs[i].state == MUX_SUB_ACTIVE) {
+            mux_sub_release(i);
+        }
+    }
+    pthread_cond_broadcast(&mux_sub_cond);
+}
+
 static GgError call_close_callback(uint32_t handle, size_t index) {
     (void) index;
     GG_LOGT("Calling subscription close callback.");
 
+    // Called with the pool mutex held
+    MuxChannel *channel = mux_channel_for_conn(handle);
+    if (channel != NULL) {
+        GG_LOGD("Closing multiplexed subscription connection %u.", handle);
+        mux_channel_closed(channel);
+        return GG_ERR_OK;
+    }
+
     GG_LOGT("Retrieving subscription callbacks.");
     SubCallbacks callbacks = { 0 };
     GgError ret = ggl_socket_handle_protected(
@@ -245,7 +368,240 @@ GgError ggl_subscribe(
     return GG_ERR_OK;
 }
 
+/// Sends a request on a multiplexed connection. Closes the connection if
+/// writing fails.
+static GgError mux_send(
+    uint32_t channel,
+    GglCoreBusRequestType type,
+    GgBuffer method,
+    uint32_t sub_handle,
+    GgMap params
+) {
+    static uint8_t mux_send_array[GGL_COREBUS_MAX_MSG_LEN];
+
+    // Holding the pool mutex also keeps concurrent requests from interleaving
+    GG_MTX_SCOPE_GUARD(&pool.mtx);
+
+    GgBuffer send_buffer = GG_BUF(mux_send_array);
+
+    EventStreamHeader headers[6] = {
+        { GG_STR("type"), { EVENTSTREAM_INT32, .int32 = (int32_t) type } },
+        { GG_STR("sub-id"),
+          { EVENTSTREAM_INT32, .int32 = (int32_t) sub_handle } },
+    };
+    size_t headers_len = 2;
+    if (type == GGL_CORE_BUS_SUBSCRIBE) {
+        headers[headers_len] = (EventStreamHeader) {
+            GG_STR("method"), { EVENTSTREAM_STRING, .string = method }
+        };
+        headers_len += 1;
+    }
+#ifdef GG_LOG_TRAIL_ENABLED
+    headers_len += gg_log_trail_attach_headers(
+        &headers[headers_len],
+        (sizeof(headers) / sizeof(headers[0])) - headers_len
+    );
+#endif
+
+    GgObject params_obj = gg_obj_map(params);
+    GgError ret = eventstream_encode(
+        &send_buffer, headers, headers_len, ggl_serialize_reader(&params_obj)
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    ret = ggl_socket_handle_write(&pool, channel, send_buffer);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to write to multiplexed connection %u.", channel);
+        (void) ggl_socket_handle_close(&pool, channel);
+    }
+    return ret;
+}
+
+static void mux_sub_close(uint32_t handle) {
+    GG_MTX_SCOPE_GUARD(&pool.mtx);
+
+    size_t index;
+    if (!mux_sub_lookup(handle, &index)
+        || (mux_subs[index].state != MUX_SUB_ACTIVE)) {
+        return;
+    }
+    uint32_t channel = mux_subs[index].channel;
+    mux_sub_release(index);
+
+    (void) mux_send(
+        channel, GGL_CORE_BUS_SUB_CLOSE, (GgBuffer) { 0 }, handle, (GgMap) { 0 }
+    );
+}
+
+/// Gets the connection shared by subscriptions to interface, opening it if
+/// needed.
+static GgError get_mux_channel(GgBuffer interface, uint32_t *channel) {
+    if (interface.len > GGL_INTERFACE_NAME_MAX_LEN) {
+        GG_LOGE("Interface name too long.");
+        return GG_ERR_RANGE;
+    }
+
+    GG_MTX_SCOPE_GUARD(&mux_channel_mtx);
+
+    {
+        GG_MTX_SCOPE_GUARD(&pool.mtx);
+        for (size_t i = 0; i < GGL_COREBUS_CLIENT_MAX_MUX_CHANNELS; i++) {
+            if ((mux_channels[i].conn != 0)
+                && gg_buffer_eq(
+                    interface,
+                    (GgBuffer) { .data = mux_channels[i].interface,
+                                 .len = mux_channels[i].interface_len }
+                )) {
+                *channel = mux_channels[i].conn;
+                return GG_ERR_OK;
+            }
+        }
+    }
+
+    int conn = -1;
+    GgError ret = ggl_client_connect(interface, &conn);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    uint32_t conn_handle = 0;
+    ret = ggl_socket_pool_register(&pool, conn, &conn_handle);
+    if (ret != GG_ERR_OK) {
+        (void) gg_close(conn);
+        GG_LOGW("Max subscriptions exceeded.");
+        return ret;
+    }
+
+    ret = GG_ERR_NOMEM;
+    {
+        GG_MTX_SCOPE_GUARD(&pool.mtx);
+        for (size_t i = 0; i < GGL_COREBUS_CLIENT_MAX_MUX_CHANNELS; i++) {
+            if (mux_channels[i].conn == 0) {
+                mux_channels[i].conn = conn_handle;
+                mux_channels[i].interface_len = interface.len;
+                memcpy(
+                    mux_channels[i].interface, interface.data, interface.len
+                );
+                ret = GG_ERR_OK;
+                break;
+            }
+        }
+    }
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Max multiplexed subscription interfaces exceeded.");
+    } else {
+        ret = gg_socket_epoll_add(epoll_fd, conn, conn_handle);
+    }
+    if (ret != GG_ERR_OK) {
+        (void) ggl_socket_handle_close(&pool, conn_handle);
+        return ret;
+    }
+
+    GG_LOGD(
+        "Opened multiplexed subscription connection to %.*s.",
+        (int) interface.len,
+        interface.data
+    );
+    *channel = conn_handle;
+    return GG_ERR_OK;
+}
+
+GgError ggl_subscribe_mux(
+    GgBuffer interface,
+    GgBuffer method,
+    GgMap params,
+    GglSubscribeCallback on_response,
+    GglSubscribeCloseCallback on_close,
+    void *ctx,
+    GgError *error,
+    uint32_t *handle
+) {
+    if (epoll_fd < 0) {
+        GG_LOGE("Subscription epoll not initialized.");
+        return GG_ERR_FATAL;
+    }
+
+    if (pthread_equal(pthread_self(), subscription_thread_id)) {
+        return ggl_subscribe(
+            interface, method, params, on_response, on_close, ctx, error, handle
+        );
+    }
+
+    GG_LOGT(
+        "Subscribing to %.*s:%.*s over shared connection.",
+        (int) interface.len,
+        interface.data,
+        (int) method.len,
+        method.data
+    );
+
+    uint32_t channel = 0;
+    GgError ret = get_mux_channel(interface, &channel);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    GG_MTX_SCOPE_GUARD(&pool.mtx);
+
+    uint32_t sub_handle = 0;
+    for (size_t i = 0; i < GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS; i++) {
+        if (mux_subs[i].state == MUX_SUB_FREE) {
+            mux_subs[i] = (MuxSubscription) {
+                .channel = channel,
+                .state = MUX_SUB_PENDING,
+                .callbacks = { .on_response = on_response,
+                               .on_close = on_close,
+                               .ctx = ctx },
+            };
+            sub_handle = mux_sub_handle(i);
+            break;
+        }
+    }
+    if (sub_handle == 0) {
+        GG_LOGW("Max multiplexed subscriptions exceeded.");
+        return GG_ERR_NOMEM;
+    }
+
+    ret = mux_send(channel, GGL_CORE_BUS_SUBSCRIBE, method, sub_handle, params);
+
+    size_t index;
+    while ((ret == GG_ERR_OK) && mux_sub_lookup(sub_handle, &index)
+           && (mux_subs[index].state == MUX_SUB_PENDING)) {
+        pthread_cond_wait(&mux_sub_cond, &pool.mtx);
+    }
+
+    if (mux_sub_lookup(sub_handle, &index)
+        && (mux_subs[index].state != MUX_SUB_ACTIVE)) {
+        if (ret == GG_ERR_OK) {
+            ret = mux_subs[index].result;
+            if ((ret == GG_ERR_REMOTE) && (error != NULL)) {
+                *error = mux_subs[index].remote_error;
+            }
+        }
+        mux_sub_free(index);
+        return ret;
+    }
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    // If the subscription was already closed, its close callback has run and
+    // closing the handle is a no-op, as with ggl_subscribe.
+    if (handle != NULL) {
+        *handle = sub_handle;
+    }
+
+    GG_LOGT("Subscription success.");
+    return GG_ERR_OK;
+}
+
 void ggl_client_sub_close(uint32_t handle) {
+    if (ggl_core_bus_is_mux_handle(handle)) {
+        mux_sub_close(handle);
+        return;
+    }
     (void) ggl_socket_handle_close(&pool, handle);
 }
 
@@ -272,6 +628,101 @@ static void call_on_response_callback(void *ctx, size_t index) {
     }
 }
 
+/// Dispatches a message received on a multiplexed connection.
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+static GgError handle_mux_response(
+    uint32_t channel, EventStreamMessage *msg, GgArena *alloc
+) {
+    uint32_t sub_handle = 0;
+    bool accepted = false;
+    bool closed = false;
+    bool failed = false;
+    GgError remote_error = GG_ERR_FAILURE;
+
+    EventStreamHeaderIter iter = msg->headers;
+    EventStreamHeader header;
+    while (eventstream_header_next(&iter, &header) == GG_ERR_OK) {
+        bool is_int = header.value.type == EVENTSTREAM_INT32;
+        if (gg_buffer_eq(header.name, GG_STR("sub-id")) && is_int) {
+            sub_handle = (uint32_t) header.value.int32;
+        } else if (gg_buffer_eq(header.name, GG_STR("accepted")) && is_int) {
+            accepted = header.value.int32 == 1;
+        } else if (gg_buffer_eq(header.name, GG_STR("closed")) && is_int) {
+            closed = header.value.int32 == 1;
+        } else if (gg_buffer_eq(header.name, GG_STR("error"))) {
+            failed = true;
+            if (is_int) {
+                remote_error = (GgError) header.value.int32;
+            }
+        }
+    }
+
+    if (sub_handle == 0) {
+        GG_LOGE("Multiplexed subscription response missing sub-id.");
+        return GG_ERR_INVALID;
+    }
+
+    GgObject data = GG_OBJ_NULL;
+    if (!accepted && !closed && !failed) {
+        GgError ret = ggl_deserialize(alloc, msg->payload, &data);
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Failed to decode subscription response payload.");
+            mux_sub_close(sub_handle);
+            return GG_ERR_OK;
+        }
+    }
+
+    GG_MTX_SCOPE_GUARD(&pool.mtx);
+
+    size_t index;
+    if (!mux_sub_lookup(sub_handle, &index)
+        || (mux_subs[index].channel != channel)) {
+        GG_LOGD(
+            "Response for unknown multiplexed subscription %u.", sub_handle
+        );
+        return GG_ERR_OK;
+    }
+
+    if (mux_subs[index].state == MUX_SUB_PENDING) {
+        if (accepted) {
+            mux_subs[index].state = MUX_SUB_ACTIVE;
+        } else {
+            if (failed) {
+                GG_LOGW("Server responded with an error.");
+            }
+            mux_subs[index].state = MUX_SUB_FAILED;
+            mux_subs[index].result = failed ? GG_ERR_REMOTE : GG_ERR_FAILURE;
+            mux_subs[index].remote_error = remote_error;
+        }
+        pthread_cond_broadcast(&mux_sub_cond);
+        return GG_ERR_OK;
+    }
+
+    if (mux_subs[index].state != MUX_SUB_ACTIVE) {
+        return GG_ERR_OK;
+    }
+
+    if (closed || failed) {
+        mux_sub_release(index);
+        return GG_ERR_OK;
+    }
+
+    SubCallbacks callbacks = mux_subs[index].callbacks;
+    if (callbacks.on_response != NULL) {
+        GG_LOGT("Calling subscription response callback.");
+
+        // User callback must not run during/after a subscription close; the
+        // pool mutex is held.
+        GgError ret = callbacks.on_response(callbacks.ctx, sub_handle, data);
+        if (ret != GG_ERR_OK) {
+            GG_LOGT("Subscription response callback returned error.");
+            mux_sub_close(sub_handle);
+        }
+    }
+
+    return GG_ERR_OK;
+}
+
 static GgError get_subscription_response(uint32_t handle) {
     GG_LOGD("Handling incoming subscription response.");
 
@@ -298,6 +749,15 @@ static GgError get_subscription_response(uint32_t handle) {
     static uint8_t obj_decode_mem[PAYLOAD_MAX_SUBOBJECTS * sizeof(GgObject)];
     GgArena alloc = gg_arena_init(GG_BUF(obj_decode_mem));
 
+    bool is_mux_channel = false;
+    {
+        GG_MTX_SCOPE_GUARD(&pool.mtx);
+        is_mux_channel = mux_channel_for_conn(handle) != NULL;
+    }
+    if (is_mux_channel) {
+        return handle_mux_response(handle, &msg, &alloc);
+    }
+
     GgObject result;
     ret = ggl_deserialize(&alloc, msg.payload, &result);
     if (ret != GG_ERR_OK) {
@@ -23,6 +23,7 @@
 #include <ggl/socket_handle.h>
 #include <ggl/socket_server.h>
 #include <pthread.h>
+#include <string.h>
 #include <sys/types.h>
 #include <stdatomic.h>
 #include <stdbool.h>
@@ -44,6 +45,11 @@ typedef struct {
 static uint8_t encode_array[GGL_COREBUS_MAX_MSG_LEN];
 static pthread_mutex_t encode_array_mtx = PTHREAD_MUTEX_INITIALIZER;
 
+// Serialized payload for ggl_sub_respond_many.
+// Must not be locked while encode_array_mtx is held.
+static uint8_t shared_payload[GGL_COREBUS_MAX_MSG_LEN];
+static pthread_mutex_t shared_payload_mtx = PTHREAD_MUTEX_INITIALIZER;
+
 static GglCoreBusRequestType client_request_types[GGL_COREBUS_MAX_CLIENTS];
 static SubCleanupCallback subscription_cleanup[GGL_COREBUS_MAX_CLIENTS];
 
@@ -53,6 +59,28 @@ static GgError close_subscription(uint32_t handle, size_t index);
 static int32_t client_fds[GGL_COREBUS_MAX_CLIENTS];
 static uint16_t client_generations[GGL_COREBUS_MAX_CLIENTS];
 
+static_assert(
+    GGL_COREBUS_MAX_CLIENTS < GGL_CORE_BUS_MUX_INDEX_BASE,
+    "GGL_COREBUS_MAX_CLIENTS overlaps multiplexed subscription handles."
+);
+static_assert(
+    GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS
+        < UINT16_MAX - GGL_CORE_BUS_MUX_INDEX_BASE,
+    "GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS too large."
+);
+
+/// A subscription multiplexed over the client connection `conn`.
+/// Protected by the socket pool mutex.
+typedef struct {
+    uint32_t conn;
+    int32_t sub_id;
+    GglServerSubCloseCallback on_close;
+    void *ctx;
+} MuxSubscription;
+
+static MuxSubscription mux_subs[GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS];
+static uint16_t mux_sub_generations[GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS];
+
 static GglSocketPool pool = {
     .max_fds = GGL_COREBUS_MAX_CLIENTS,
     .fds = client_fds,
@@ -86,10 +114,49 @@ static GgError reset_client_state(uint32_t handle, size_t index) {
     return GG_ERR_OK;
 }
 
+static uint32_t mux_sub_handle(size_t index) {
+    return (uint32_t) mux_sub_generations[index] << 16
+        | (uint32_t) (GGL_CORE_BUS_MUX_INDEX_BASE + index + 1U);
+}
+
+/// Gets the slot index of a live multiplexed subscription handle.
+/// Must be called with the pool mutex held.
+static bool mux_sub_lookup(uint32_t handle, size_t *index) {
+    if (!ggl_core_bus_is_mux_handle(handle)) {
+        return false;
+    }
+    size_t i = (handle & UINT16_MAX) - GGL_CORE_BUS_MUX_INDEX_BASE - 1U;
+    if ((i >= GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS)
+        || ((handle >> 16) != mux_sub_generations[i])
+        || (mux_subs[i].conn == 0)) {
+        return false;
+    }
+    *index = i;
+    return true;
+}
+
+/// Frees the slot and runs the close callback.
+/// Must be called with the pool mutex held.
+static void mux_sub_release(size_t index) {
+    uint32_t handle = mux_sub_handle(index);
+    MuxSubscription released = mux_subs[index];
+    mux_subs[index] = (MuxSubscription) { 0 };
+    mux_sub_generations[index] += 1;
+    if (released.on_close != NULL) {
+        released.on_close(released.ctx, handle);
+    }
+}
+
 static GgError close_subscription(uint32_t handle, size_t index) {
     if (subscription_cleanup[index].fn != NULL) {
         subscription_cleanup[index].fn(subscription_cleanup[index].ctx, handle);
     }
+    // Connection is closing; so are its multiplexed subscriptions
+    for (size_t i = 0; i < GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS; i++) {
+        if (mux_subs[i].conn == handle) {
+            mux_sub_release(i);
+        }
+    }
     return GG_ERR_OK;
 }
 
@@ -160,6 +227,201 @@ static void send_err_response(uint32_t handle, GgError error) {
     (void) ggl_socket_handle_close(&pool, handle);
 }
 
+/// Sends a message for a multiplexed subscription. Closes the connection if
+/// writing fails.
+static GgError send_mux_message(
+    uint32_t conn,
+    int32_t sub_id,
+    const EventStreamHeader *extra_header,
+    GgReader payload
+) {
+    GgError ret;
+    {
+        GG_MTX_SCOPE_GUARD(&encode_array_mtx);
+
+        GgBuffer send_buffer = GG_BUF(encode_array);
+
+        EventStreamHeader headers[2] = {
+            { GG_STR("sub-id"), { EVENTSTREAM_INT32, .int32 = sub_id } },
+        };
+        size_t headers_len = 1;
+        if (extra_header != NULL) {
+            headers[1] = *extra_header;
+            headers_len = 2;
+        }
+
+        ret = eventstream_encode(&send_buffer, headers, headers_len, payload);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+
+        ret = ggl_socket_handle_write(&pool, conn, send_buffer);
+    }
+
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to write to multiplexed connection %u.", conn);
+        (void) ggl_socket_handle_close(&pool, conn);
+    }
+    return ret;
+}
+
+static void send_mux_err_response(
+    uint32_t conn, int32_t sub_id, GgError error
+) {
+    assert(error != GG_ERR_OK); // Returning error ok is invalid
+
+    EventStreamHeader error_header
+        = { GG_STR("error"), { EVENTSTREAM_INT32, .int32 = (int32_t) error } };
+    (void) send_mux_message(conn, sub_id, &error_header, GG_NULL_READER);
+}
+
+static GgError decode_params(EventStreamMessage *msg, GgMap *params) {
+    *params = (GgMap) { 0 };
+    if (msg->payload.len == 0) {
+        return GG_ERR_OK;
+    }
+
+    static uint8_t payload_deserialize_mem
+        [PAYLOAD_VALUE_MAX_SUBOBJECTS * sizeof(GgObject)];
+    GgArena alloc = gg_arena_init(GG_BUF(payload_deserialize_mem));
+
+    GgObject payload_obj;
+    GgError ret = ggl_deserialize(&alloc, msg->payload, &payload_obj);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to decode request payload.");
+        return ret;
+    }
+
+    if (gg_obj_type(payload_obj) != GG_TYPE_MAP) {
+        GG_LOGE("Request payload is not a map.");
+        return GG_ERR_INVALID;
+    }
+
+    *params = gg_obj_into_map(payload_obj);
+    return GG_ERR_OK;
+}
+
+static GglRpcMethodDesc *find_handler(
+    InterfaceCtx *interface, GgBuffer method
+) {
+    for (size_t i = 0; i < interface->handlers_len; i++) {
+        if (gg_buffer_eq(method, interface->handlers[i].name)) {
+            return &interface->handlers[i];
+        }
+    }
+    GG_LOGW("No handler for method %.*s.", (int) method.len, method.data);
+    return NULL;
+}
+
+static void close_mux_sub_by_id(uint32_t conn, int32_t sub_id) {
+    GG_MTX_SCOPE_GUARD(&pool.mtx);
+
+    for (size_t i = 0; i < GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS; i++) {
+        if ((mux_subs[i].conn == conn) && (mux_subs[i].sub_id == sub_id)) {
+            mux_sub_release(i);
+            return;
+        }
+    }
+}
+
+static GgError mux_sub_register(
+    uint32_t conn, int32_t sub_id, uint32_t *handle
+) {
+    GG_MTX_SCOPE_GUARD(&pool.mtx);
+
+    for (size_t i = 0; i < GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS; i++) {
+        if ((mux_subs[i].conn == conn) && (mux_subs[i].sub_id == sub_id)) {
+            GG_LOGE("Duplicate multiplexed subscription id %d.", sub_id);
+            return GG_ERR_INVALID;
+        }
+    }
+    for (size_t i = 0; i < GGL_COREBUS_MAX_MUX_SUBSCRIPTIONS; i++) {
+        if (mux_subs[i].conn == 0) {
+            mux_subs[i] = (MuxSubscription) { .conn = conn, .sub_id = sub_id };
+            *handle = mux_sub_handle(i);
+            return GG_ERR_OK;
+        }
+    }
+
+    GG_LOGE("Maximum multiplexed subscriptions exceeded.");
+    return GG_ERR_NOMEM;
+}
+
+/// Handles a request on a connection multiplexing subscriptions. Errors are
+/// reported per subscription; the connection stays open.
+static void handle_mux_request(
+    InterfaceCtx *interface,
+    uint32_t conn,
+    GglCoreBusRequestType type,
+    GgBuffer method,
+    int32_t sub_id,
+    EventStreamMessage *msg
+) {
+    if (type == GGL_CORE_BUS_SUB_CLOSE) {
+        GG_LOGD("Closing multiplexed subscription %d on %u.", sub_id, conn);
+        close_mux_sub_by_id(conn, sub_id);
+        return;
+    }
+
+    if (type != GGL_CORE_BUS_SUBSCRIBE) {
+        GG_LOGE("Only subscriptions can be multiplexed.");
+        send_mux_err_response(conn, sub_id, GG_ERR_INVALID);
+        return;
+    }
+
+    GgMap params;
+    GgError ret = decode_params(msg, &params);
+    if (ret != GG_ERR_OK) {
+        send_mux_err_response(conn, sub_id, ret);
+        return;
+    }
+
+    GglRpcMethodDesc *handler = find_handler(interface, method);
+    if (handler == NULL) {
+        send_mux_err_response(conn, sub_id, GG_ERR_NOENTRY);
+        return;
+    }
+    if (!handler->is_subscription) {
+        GG_LOGE("Request type is unsupported for method.");
+        send_mux_err_response(conn, sub_id, GG_ERR_INVALID);
+        return;
+    }
+
+    uint32_t sub_handle = 0;
+    ret = mux_sub_register(conn, sub_id, &sub_handle);
+    if (ret != GG_ERR_OK) {
+        send_mux_err_response(conn, sub_id, ret);
+        return;
+    }
+
+    GG_LOGD(
+        "Dispatching multiplexed subscription for method %.*s.",
+        (int) method.len,
+        method.data
+    );
+
+    set_current_handle(sub_handle);
+
+    GG_LOG_TRAIL_INHERIT_SCOPE(msg->headers);
+
+    ret = handler->handler(handler->ctx, params, sub_handle);
+
+    assert(get_current_handle() == ((ret == GG_ERR_OK) ? 0 : sub_handle));
+
+    if (ret != GG_ERR_OK) {
+        {
+            GG_MTX_SCOPE_GUARD(&pool.mtx);
+            size_t index;
+            if (mux_sub_lookup(sub_handle, &index)) {
+                // Not accepted, so there is no close callback to run
+                mux_sub_release(index);
+            }
+        }
+        send_mux_err_response(conn, sub_id, ret);
+        clear_current_handle();
+    }
+}
+
 // TODO: Split this function up
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 static GgError client_ready(void *ctx, uint32_t handle) {
@@ -212,6 +474,8 @@ static GgError client_ready(void *ctx, uint32_t handle) {
     bool method_set = false;
     GglCoreBusRequestType type = GGL_CORE_BUS_CALL;
     bool type_set = false;
+    int32_t sub_id = 0;
+    bool sub_id_set = false;
 
     {
         EventStreamHeaderIter iter = msg.headers;
@@ -236,6 +500,7 @@ static GgError client_ready(void *ctx, uint32_t handle) {
                 case GGL_CORE_BUS_NOTIFY:
                 case GGL_CORE_BUS_CALL:
                 case GGL_CORE_BUS_SUBSCRIBE:
+                case GGL_CORE_BUS_SUB_CLOSE:
                     type = (GglCoreBusRequestType) header.value.int32;
                     break;
                 default:
@@ -244,38 +509,40 @@ static GgError client_ready(void *ctx, uint32_t handle) {
                     return GG_ERR_OK;
                 }
                 type_set = true;
+            } else if (gg_buffer_eq(header.name, GG_STR("sub-id"))) {
+                if (header.value.type != EVENTSTREAM_INT32) {
+                    GG_LOGE("Subscription id header not int.");
+                    send_err_response(handle, GG_ERR_INVALID);
+                    return GG_ERR_OK;
+                }
+                sub_id = header.value.int32;
+                sub_id_set = true;
             }
         }
     }
 
-    if (!method_set || !type_set) {
+    if (!type_set || (!method_set && (type != GGL_CORE_BUS_SUB_CLOSE))) {
         GG_LOGE("Required header missing.");
         send_err_response(handle, GG_ERR_INVALID);
         return GG_ERR_OK;
     }
 
-    GgMap params = { 0 };
-
-    if (msg.payload.len > 0) {
-        static uint8_t payload_deserialize_mem
-            [PAYLOAD_VALUE_MAX_SUBOBJECTS * sizeof(GgObject)];
-        GgArena alloc = gg_arena_init(GG_BUF(payload_deserialize_mem));
-
-        GgObject payload_obj;
-        ret = ggl_deserialize(&alloc, msg.payload, &payload_obj);
-        if (ret != GG_ERR_OK) {
-            GG_LOGE("Failed to decode request payload.");
-            send_err_response(handle, ret);
-            return GG_ERR_OK;
-        }
+    if (sub_id_set) {
+        handle_mux_request(interface, handle, type, method, sub_id, &msg);
+        return GG_ERR_OK;
+    }
 
-        if (gg_obj_type(payload_obj) != GG_TYPE_MAP) {
-            GG_LOGE("Request payload is not a map.");
-            send_err_response(handle, GG_ERR_INVALID);
-            return GG_ERR_OK;
-        }
+    if (type == GGL_CORE_BUS_SUB_CLOSE) {
+        GG_LOGE("Subscription close missing subscription id.");
+        send_err_response(handle, GG_ERR_INVALID);
+        return GG_ERR_OK;
+    }
 
-        params = gg_obj_into_map(payload_obj);
+    GgMap params;
+    ret = decode_params(&msg, &params);
+    if (ret != GG_ERR_OK) {
+        send_err_response(handle, ret);
+        return GG_ERR_OK;
     }
 
     GG_LOGT("Setting request type.");
@@ -288,40 +555,36 @@ static GgError client_ready(void *ctx, uint32_t handle) {
         "Dispatching request for method %.*s.", (int) method.len, method.data
     );
 
-    for (size_t i = 0; i < interface->handlers_len; i++) {
-        GglRpcMethodDesc *handler = &interface->handlers[i];
-        if (gg_buffer_eq(method, handler->name)) {
-            if (handler->is_subscription != (type == GGL_CORE_BUS_SUBSCRIBE)) {
-                GG_LOGE("Request type is unsupported for method.");
-                send_err_response(handle, GG_ERR_INVALID);
-                return GG_ERR_OK;
-            }
+    GglRpcMethodDesc *handler = find_handler(interface, method);
+    if (handler == NULL) {
+        send_err_response(handle, GG_ERR_NOENTRY);
+        return GG_ERR_OK;
+    }
 
-            set_current_handle(handle);
+    if (handler->is_subscription != (type == GGL_CORE_BUS_SUBSCRIBE)) {
+        GG_LOGE("Request type is unsupported for method.");
+        send_err_response(handle, GG_ERR_INVALID);
+        return GG_ERR_OK;
+    }
 
-            // Inherit any inbound trace context for the handler's duration;
-            // defensively clears stale context on this reused worker thread
-            // first, and clears again on scope exit.
-            GG_LOG_TRAIL_INHERIT_SCOPE(msg.headers);
+    set_current_handle(handle);
 
-            ret = handler->handler(handler->ctx, params, handle);
+    // Inherit any inbound trace context for the handler's duration;
+    // defensively clears stale context on this reused worker thread
+    // first, and clears again on scope exit.
+    GG_LOG_TRAIL_INHERIT_SCOPE(msg.headers);
 
-            // Handler must either error, or succeed after calling ggl_respond
-            // or ggl_sub_accept. Both of those clear current_handle
-            assert(get_current_handle() == ((ret == GG_ERR_OK) ? 0 : handle));
+    ret = handler->handler(handler->ctx, params, handle);
 
-            if (ret != GG_ERR_OK) {
-                send_err_response(handle, ret);
-                clear_current_handle();
-            }
+    // Handler must either error, or succeed after calling ggl_respond
+    // or ggl_sub_accept. Both of those clear current_handle
+    assert(get_current_handle() == ((ret == GG_ERR_OK) ? 0 : handle));
 
-            return GG_ERR_OK;
-        }
+    if (ret != GG_ERR_OK) {
+        send_err_response(handle, ret);
+        clear_current_handle();
     }
 
-    GG_LOGW("No handler for method %.*s.", (int) method.len, method.data);
-
-    send_err_response(handle, GG_ERR_NOENTRY);
     return GG_ERR_OK;
 }
 
@@ -396,6 +659,35 @@ void ggl_respond(uint32_t handle, GgObject value) {
     GG_LOGT("Completed call response to %d.", handle);
 }
 
+static void mux_sub_accept(
+    uint32_t handle, GglServerSubCloseCallback on_close, void *ctx
+) {
+    uint32_t conn = 0;
+    int32_t sub_id = 0;
+    {
+        GG_MTX_SCOPE_GUARD(&pool.mtx);
+        size_t index;
+        if (mux_sub_lookup(handle, &index)) {
+            mux_subs[index].on_close = on_close;
+            mux_subs[index].ctx = ctx;
+            conn = mux_subs[index].conn;
+            sub_id = mux_subs[index].sub_id;
+        }
+    }
+
+    if (conn == 0) {
+        if (on_close != NULL) {
+            on_close(ctx, handle);
+        }
+        return;
+    }
+
+    // On failure the connection is closed, which closes the subscription
+    EventStreamHeader accepted_header
+        = { GG_STR("accepted"), { EVENTSTREAM_INT32, .int32 = 1 } };
+    (void) send_mux_message(conn, sub_id, &accepted_header, GG_NULL_READER);
+}
+
 void ggl_sub_accept(
     uint32_t handle, GglServerSubCloseCallback on_close, void *ctx
 ) {
@@ -404,6 +696,11 @@ void ggl_sub_accept(
     assert(handle == get_current_handle());
     GG_CLEANUP(cleanup_current_handle, handle);
 
+    if (ggl_core_bus_is_mux_handle(handle)) {
+        mux_sub_accept(handle, on_close, ctx);
+        return;
+    }
+
     if (on_close != NULL) {
         SubCleanupCallback cleanup = { .fn = on_close, .ctx = ctx };
 
@@ -445,9 +742,38 @@ void ggl_sub_accept(
     GG_LOGT("Successfully accepted subscription %d.", handle);
 }
 
-void ggl_sub_respond(uint32_t handle, GgObject value) {
+static void mux_sub_respond(uint32_t handle, GgReader payload) {
+    wait_while_current_handle(handle);
+
+    uint32_t conn = 0;
+    int32_t sub_id = 0;
+    {
+        GG_MTX_SCOPE_GUARD(&pool.mtx);
+        size_t index;
+        if (!mux_sub_lookup(handle, &index)) {
+            return;
+        }
+        conn = mux_subs[index].conn;
+        sub_id = mux_subs[index].sub_id;
+    }
+
+    GgError ret = send_mux_message(conn, sub_id, NULL, payload);
+    if (ret != GG_ERR_OK) {
+        ggl_server_sub_close(handle);
+        return;
+    }
+
+    GG_LOGT("Sent response to %d.", handle);
+}
+
+static void sub_respond(uint32_t handle, GgReader payload) {
     GG_LOGT("Responding to %d.", handle);
 
+    if (ggl_core_bus_is_mux_handle(handle)) {
+        mux_sub_respond(handle, payload);
+        return;
+    }
+
 #ifndef NDEBUG
     {
         GglCoreBusRequestType type = GGL_CORE_BUS_CALL;
@@ -469,9 +795,7 @@ void ggl_sub_respond(uint32_t handle, GgObject value) {
 
     GgBuffer send_buffer = GG_BUF(encode_array);
 
-    GgError ret = eventstream_encode(
-        &send_buffer, NULL, 0, ggl_serialize_reader(&value)
-    );
+    GgError ret = eventstream_encode(&send_buffer, NULL, 0, payload);
     if (ret != GG_ERR_OK) {
         return;
     }
@@ -488,6 +812,79 @@ void ggl_sub_respond(uint32_t handle, GgObject value) {
     GG_LOGT("Sent response to %d.", handle);
 }
 
+void ggl_sub_respond(uint32_t handle, GgObject value) {
+    sub_respond(handle, ggl_serialize_reader(&value));
+}
+
+static GgError serialized_read(void *ctx, GgBuffer *buf) {
+    assert(buf != NULL);
+
+    const GgBuffer *serialized = ctx;
+
+    if (buf->len < serialized->len) {
+        return GG_ERR_NOMEM;
+    }
+
+    memcpy(buf->data, serialized->data, serialized->len);
+    buf->len = serialized->len;
+    return GG_ERR_OK;
+}
+
+void ggl_sub_respond_many(
+    const uint32_t *handles, size_t handles_len, GgObject value
+) {
+    assert((handles != NULL) || (handles_len == 0));
+
+    if (handles_len == 0) {
+        return;
+    }
+    if (handles_len == 1) {
+        ggl_sub_respond(handles[0], value);
+        return;
+    }
+
+    // Responses are framed per subscription, but the payload is shared. Keep
+    // it serialized so each frame only needs a copy.
+    GG_MTX_SCOPE_GUARD(&shared_payload_mtx);
+
+    GgBuffer serialized = GG_BUF(shared_payload);
+    GgError ret = ggl_serialize(value, &serialized);
+    if (ret != GG_ERR_OK) {
+        // Let each response fail as it would individually
+        for (size_t i = 0; i < handles_len; i++) {
+            ggl_sub_respond(handles[i], value);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < handles_len; i++) {
+        sub_respond(
+            handles[i],
+            (GgReader) { .read = serialized_read, .ctx = &serialized }
+        );
+    }
+}
+
 void ggl_server_sub_close(uint32_t handle) {
-    (void) ggl_socket_handle_close(&pool, handle);
+    if (!ggl_core_bus_is_mux_handle(handle)) {
+        (void) ggl_socket_handle_close(&pool, handle);
+        return;
+    }
+
+    uint32_t conn = 0;
+    int32_t sub_id = 0;
+    {
+        GG_MTX_SCOPE_GUARD(&pool.mtx);
+        size_t index;
+        if (!mux_sub_lookup(handle, &index)) {
+            return;
+        }
+        conn = mux_subs[index].conn;
+        sub_id = mux_subs[index].sub_id;
+        mux_sub_release(index);
+    }
+
+    EventStreamHeader closed_header
+        = { GG_STR("closed"), { EVENTSTREAM_INT32, .int32 = 1 } };
+    (void) send_mux_message(conn, sub_id, &closed_header, GG_NULL_READER);
 }
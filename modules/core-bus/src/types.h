@@ -5,6 +5,9 @@
 #ifndef GGL_COREBUS_TYPES_H
 #define GGL_COREBUS_TYPES_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /// Maximum length of name of core bus interface.
 #define GGL_INTERFACE_NAME_MAX_LEN 50
 
@@ -19,6 +22,21 @@ typedef enum {
     GGL_CORE_BUS_NOTIFY,
     GGL_CORE_BUS_CALL,
     GGL_CORE_BUS_SUBSCRIBE,
+    /// Close a multiplexed subscription.
+    GGL_CORE_BUS_SUB_CLOSE,
 } GglCoreBusRequestType;
 
+// Subscribe requests carrying a `sub-id` header are multiplexed: the
+// connection stays open for further requests, and every message for the
+// subscription in either direction carries the same `sub-id`. Handles for
+// multiplexed subscriptions use index values above any socket pool index so
+// they share a handle space with socket handles.
+
+/// Offset of the index of multiplexed subscription handles.
+#define GGL_CORE_BUS_MUX_INDEX_BASE 0x8000U
+
+static inline bool ggl_core_bus_is_mux_handle(uint32_t handle) {
+    return (handle & UINT16_MAX) > GGL_CORE_BUS_MUX_INDEX_BASE;
+}
+
 #endif
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "fleet_status_service.h"
+#include "published_state.h"
 #include <assert.h>
 #include <gg/arena.h>
 #include <gg/buffer.h>
@@ -15,6 +16,7 @@
 #include <gg/object.h>
 #include <gg/vector.h>
 #include <ggl/core_bus/aws_iot_mqtt.h>
+#include <ggl/core_bus/constants.h>
 #include <ggl/core_bus/gg_config.h>
 #include <ggl/core_bus/gg_healthd.h>
 #include <ggl/nucleus/constants.h>
@@ -24,6 +26,7 @@
 #include <sys/types.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define TOPIC_PREFIX "$aws/things/"
@@ -36,6 +39,10 @@
 
 #define PAYLOAD_BUFFER_LEN 5000
 
+// Components whose config is read per gg_config read_many call, at two keys
+// each
+#define FLEET_STATUS_CONFIG_BATCH 16
+
 static const GgBuffer ARCHITECTURE =
 #if defined(__x86_64__)
     GG_STR("amd64");
@@ -73,6 +80,346 @@ static GgError derive_message_type(
     return GG_ERR_INVALID;
 }
 
+static bool is_ignored_component(GgBuffer component) {
+    // ignore core components for now, gghealthd does not support
+    // getting their health yet
+    GgBufList ignored_components = GG_BUF_LIST(
+        GG_STR("aws.greengrass.NucleusLite"),
+        GG_STR("aws.greengrass.fleet_provisioning"),
+        GG_STR("DeploymentService"),
+        GG_STR("FleetStatusService"),
+        GG_STR("main"),
+        GG_STR("TelemetryAgent"),
+        GG_STR("UpdateSystemPolicyService")
+    );
+    GG_BUF_LIST_FOREACH (ignored_component, ignored_components) {
+        if (gg_buffer_eq(*ignored_component, component)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Collect names of reported components from a config list of services.
+static GgError collect_component_names(
+    GgArena *alloc, GgObjVec *component_names
+) {
+    GgList components = { 0 };
+    GgError ret = ggl_gg_config_list(
+        GG_BUF_LIST(GG_STR("services")), alloc, &components
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE(
+            "Unable to retrieve list of components from config with error %s",
+            gg_strerror(ret)
+        );
+        return ret;
+    }
+
+    GG_LIST_FOREACH (component_obj, components) {
+        if (gg_obj_type(*component_obj) != GG_TYPE_BUF) {
+            GG_LOGE(
+                "Incorrect type of component key received. Expected buffer. Cannot publish fleet status update for this entry."
+            );
+            continue;
+        }
+        GgBuffer component = gg_obj_into_buf(*component_obj);
+        if (is_ignored_component(component)) {
+            continue;
+        }
+        ret = gg_obj_vec_push(component_names, gg_obj_buf(component));
+        if (ret != GG_ERR_OK) {
+            GG_LOGE(
+                "Reached component cap (%d); dropping remaining components from this fleet status update.",
+                FLEET_STATUS_MAX_COMPONENTS
+            );
+            break;
+        }
+    }
+    return GG_ERR_OK;
+}
+
+// Reads the version and fleet configuration arn list of components
+// [start, start + len) with one read_many call. values receives, for each
+// component, its version then its arn list, null if unset.
+static GgError read_component_configs(
+    GgList component_names,
+    size_t start,
+    size_t len,
+    GgArena *alloc,
+    GgObject *values
+) {
+    static GgObject key_path_mem[FLEET_STATUS_CONFIG_BATCH * 2][3];
+    static GgObject key_paths_mem[FLEET_STATUS_CONFIG_BATCH * 2];
+    for (size_t i = 0; i < len; i++) {
+        GgObject component = component_names.items[start + i];
+        for (size_t j = 0; j < 2; j++) {
+            GgObject *key_path = key_path_mem[(i * 2) + j];
+            key_path[0] = gg_obj_buf(GG_STR("services"));
+            key_path[1] = component;
+            key_path[2] = gg_obj_buf(
+                (j == 0) ? GG_STR("version") : GG_STR("configArn")
+            );
+            key_paths_mem[(i * 2) + j]
+                = gg_obj_list((GgList) { .items = key_path, .len = 3 });
+        }
+    }
+
+    GgList result;
+    GgError ret = ggl_gg_config_read_many(
+        (GgList) { .items = key_paths_mem, .len = len * 2 }, alloc, &result
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    for (size_t i = 0; i < result.len; i++) {
+        values[i] = result.items[i];
+    }
+    return GG_ERR_OK;
+}
+
+// Get a component's version and fleet configuration arn list, from the values
+// read by read_component_configs if given, else from config.
+static GgError get_component_config(
+    const GgObject *values,
+    GgBuffer component,
+    GgArena *alloc,
+    GgBuffer *version,
+    GgObject *arn_list
+) {
+    // retrieve component version from config
+    GgError ret = GG_ERR_OK;
+    if (values == NULL) {
+        ret = ggl_gg_config_read_str(
+            GG_BUF_LIST(GG_STR("services"), component, GG_STR("version")),
+            alloc,
+            version
+        );
+    } else if (gg_obj_type(values[0]) == GG_TYPE_BUF) {
+        *version = gg_obj_into_buf(values[0]);
+    } else if (gg_obj_type(values[0]) == GG_TYPE_NULL) {
+        ret = GG_ERR_NOENTRY;
+    } else {
+        ret = GG_ERR_CONFIG;
+    }
+    if (ret != GG_ERR_OK) {
+        GG_LOGE(
+            "Unable to retrieve version of %.*s with error %s. Cannot publish fleet status update for this component.",
+            (int) component.len,
+            component.data,
+            gg_strerror(ret)
+        );
+        return ret;
+    }
+
+    // retrieve fleet config arn list from config
+    if (values == NULL) {
+        ret = ggl_gg_config_read(
+            GG_BUF_LIST(GG_STR("services"), component, GG_STR("configArn")),
+            alloc,
+            arn_list
+        );
+    } else if (gg_obj_type(values[1]) != GG_TYPE_NULL) {
+        *arn_list = values[1];
+    } else {
+        ret = GG_ERR_NOENTRY;
+    }
+    if (ret != GG_ERR_OK) {
+        GG_LOGE(
+            "Unable to retrieve fleet configuration arn list for component %.*s from config with error %s. Cannot publish fleet status update for this component.",
+            (int) component.len,
+            component.data,
+            gg_strerror(ret)
+        );
+        return ret;
+    }
+    if (gg_obj_type(*arn_list) != GG_TYPE_LIST) {
+        GG_LOGE(
+            "Fleet configuration arn retrieved from config not of type list for component %.*s. Cannot publish fleet status update for this component.",
+            (int) component.len,
+            component.data
+        );
+        return GG_ERR_INVALID;
+    }
+    return GG_ERR_OK;
+}
+
+typedef struct {
+    GgBuffer thing_name;
+    int64_t sequence;
+    int64_t timestamp;
+    GgBuffer message_type;
+    GgBuffer trigger;
+    GgBuffer overall_device_status;
+    GgMap deployment_info;
+} PayloadHeader;
+
+static GgError encode_payload(
+    const PayloadHeader *header,
+    GgList components,
+    size_t chunk_id,
+    size_t total_chunks,
+    GgByteVec *payload
+) {
+    GgKV kvs[] = {
+        gg_kv(GG_STR("ggcVersion"), gg_obj_buf(GG_STR(GGL_VERSION))),
+        gg_kv(GG_STR("platform"), gg_obj_buf(GG_STR("linux"))),
+        gg_kv(GG_STR("architecture"), gg_obj_buf(ARCHITECTURE)),
+        gg_kv(GG_STR("runtime"), gg_obj_buf(GG_STR("aws_nucleus_lite"))),
+        gg_kv(GG_STR("thing"), gg_obj_buf(header->thing_name)),
+        gg_kv(GG_STR("sequenceNumber"), gg_obj_i64(header->sequence)),
+        gg_kv(GG_STR("timestamp"), gg_obj_i64(header->timestamp)),
+        gg_kv(GG_STR("messageType"), gg_obj_buf(header->message_type)),
+        gg_kv(GG_STR("trigger"), gg_obj_buf(header->trigger)),
+        gg_kv(
+            GG_STR("overallDeviceStatus"),
+            gg_obj_buf(header->overall_device_status)
+        ),
+        gg_kv(GG_STR("components"), gg_obj_list(components)),
+        gg_kv(
+            GG_STR("deploymentInformation"),
+            gg_obj_map(header->deployment_info)
+        ),
+        // only included if the update is split across messages
+        gg_kv(
+            GG_STR("chunkInfo"),
+            gg_obj_map(GG_MAP(
+                gg_kv(GG_STR("chunkId"), gg_obj_i64((int64_t) chunk_id)),
+                gg_kv(GG_STR("totalChunks"), gg_obj_i64((int64_t) total_chunks))
+            ))
+        ),
+    };
+    size_t kvs_len = sizeof(kvs) / sizeof(kvs[0]);
+    GgMap payload_map = { .pairs = kvs,
+                          .len = (total_chunks > 1) ? kvs_len : kvs_len - 1 };
+
+    payload->buf.len = 0;
+    return gg_json_encode(gg_obj_map(payload_map), gg_byte_vec_writer(payload));
+}
+
+// Splits components into chunks that each encode within PAYLOAD_BUFFER_LEN.
+// chunk_ends receives the exclusive end index of each chunk. Components too
+// large for any message are dropped from the list.
+static GgError plan_chunks(
+    const PayloadHeader *header,
+    GgObjVec *components,
+    size_t *chunk_ends,
+    size_t *chunk_count
+) {
+    static uint8_t scratch_buf[PAYLOAD_BUFFER_LEN];
+    GgByteVec scratch = GG_BYTE_VEC(scratch_buf);
+
+    GgError ret = encode_payload(header, GG_LIST(), 0, 2, &scratch);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Fleet status payload without components does not fit.");
+        return ret;
+    }
+    // Encoding the chunk info digits and the separators between components
+    // is covered by this margin.
+    size_t budget = PAYLOAD_BUFFER_LEN - scratch.buf.len - 16;
+
+    size_t chunks = 0;
+    size_t used = 0;
+    size_t kept = 0;
+    for (size_t i = 0; i < components->list.len; i++) {
+        GgObject component = components->list.items[i];
+        scratch.buf.len = 0;
+        ret = gg_json_encode(component, gg_byte_vec_writer(&scratch));
+        if ((ret != GG_ERR_OK) || (scratch.buf.len + 1 > budget)) {
+            GG_LOGE("Component status too large for a fleet status update.");
+            continue;
+        }
+        size_t len = scratch.buf.len + 1;
+        if ((used + len > budget) && (kept > 0)) {
+            chunk_ends[chunks] = kept;
+            chunks += 1;
+            used = 0;
+        }
+        used += len;
+        components->list.items[kept] = component;
+        kept += 1;
+    }
+    components->list.len = kept;
+    chunk_ends[chunks] = kept;
+    chunks += 1;
+
+    *chunk_count = chunks;
+    return GG_ERR_OK;
+}
+
+// Updates the published state from a component info map as built below.
+static void record_published(GgMap component_info) {
+    GgObject *name = NULL;
+    GgObject *version = NULL;
+    GgObject *arns = NULL;
+    GgObject *status = NULL;
+    GgError ret = gg_map_validate(
+        component_info,
+        GG_MAP_SCHEMA(
+            { GG_STR("componentName"), GG_REQUIRED, GG_TYPE_BUF, &name },
+            { GG_STR("version"), GG_REQUIRED, GG_TYPE_BUF, &version },
+            { GG_STR("fleetConfigArns"), GG_REQUIRED, GG_TYPE_LIST, &arns },
+            { GG_STR("status"), GG_REQUIRED, GG_TYPE_BUF, &status },
+        )
+    );
+    if (ret != GG_ERR_OK) {
+        return;
+    }
+    GgBuffer component = gg_obj_into_buf(*name);
+    GgBuffer component_status = gg_obj_into_buf(*status);
+    if (gg_buffer_eq(component_status, GG_STR("UNINSTALLED"))) {
+        published_state_forget(component);
+        return;
+    }
+    published_state_record(
+        component,
+        published_state_fingerprint(
+            gg_obj_into_buf(*version),
+            component_status,
+            gg_obj_into_list(*arns)
+        )
+    );
+}
+
+static GgError publish_chunks(
+    const PayloadHeader *header, GgBuffer topic, GgObjVec *components
+) {
+    static size_t chunk_ends[FLEET_STATUS_MAX_COMPONENTS + 1];
+    size_t chunk_count = 0;
+    GgError ret = plan_chunks(header, components, chunk_ends, &chunk_count);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    static uint8_t payload_buf[PAYLOAD_BUFFER_LEN];
+    size_t start = 0;
+    for (size_t i = 0; i < chunk_count; i++) {
+        GgList chunk = { .items = &components->list.items[start],
+                         .len = chunk_ends[i] - start };
+        GgByteVec payload = GG_BYTE_VEC(payload_buf);
+        ret = encode_payload(header, chunk, i + 1, chunk_count, &payload);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+
+        ret = ggl_aws_iot_mqtt_publish(
+            GG_STR("aws_iot_mqtt"), topic, payload.buf, 0, false
+        );
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+
+        // Only components that reached the cloud count as published
+        GG_LIST_FOREACH (component, chunk) {
+            record_published(gg_obj_into_map(*component));
+        }
+        start = chunk_ends[i];
+    }
+
+    GG_LOGD("Published update in %zu message(s).", chunk_count);
+    return GG_ERR_OK;
+}
+
 // TODO: Split this function up
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 GgError publish_fleet_status_update(
@@ -86,98 +433,108 @@ GgError publish_fleet_status_update(
     if (ret != GG_ERR_OK) {
         return ret;
     }
+    // PARTIAL updates carry only components that changed since last published
+    bool complete = gg_buffer_eq(message_type, GG_STR("COMPLETE"));
 
     static pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
     GG_MTX_SCOPE_GUARD(&mtx);
 
     bool device_healthy = true;
 
-    // The size of the payload buffer minus some bytes we will need for
-    // boilerplate contents, is the max we can send
-    GgBuffer component_info_mem
-        = GG_BUF((uint8_t[PAYLOAD_BUFFER_LEN - 128]) { 0 });
-    GgArena alloc = gg_arena_init(component_info_mem);
+    static uint8_t component_info_mem[4 * GGL_COREBUS_MAX_MSG_LEN];
+    GgArena alloc = gg_arena_init(GG_BUF(component_info_mem));
 
-    // retrieve running components from services config
-    GgList components;
-    ret = ggl_gg_config_list(
-        GG_BUF_LIST(GG_STR("services")), &alloc, &components
-    );
+    static GgObject component_names_mem[FLEET_STATUS_MAX_COMPONENTS];
+    GgObjVec component_names = GG_OBJ_VEC(component_names_mem);
+    ret = collect_component_names(&alloc, &component_names);
     if (ret != GG_ERR_OK) {
-        GG_LOGE(
-            "Unable to retrieve list of components from config with error %s",
-            gg_strerror(ret)
-        );
         return ret;
     }
 
-    // get status for each running component
-    GgKV component_infos[GGL_MAX_GENERIC_COMPONENTS][5];
-    GgObjVec component_statuses
-        = GG_OBJ_VEC((GgObject[GGL_MAX_GENERIC_COMPONENTS]) { 0 });
-    size_t component_count = 0;
-    GG_LIST_FOREACH (component_obj, components) {
-        if (gg_obj_type(*component_obj) != GG_TYPE_BUF) {
-            GG_LOGE(
-                "Incorrect type of component key received. Expected buffer. Cannot publish fleet status update for this entry."
-            );
-            continue;
+    // retrieve the config keys used for each component in batches, falling
+    // back to per-component reads for a batch that cannot be read at once
+    static uint8_t config_mem[4 * GGL_COREBUS_MAX_MSG_LEN];
+    GgArena config_alloc = gg_arena_init(GG_BUF(config_mem));
+    static GgObject config_values[FLEET_STATUS_MAX_COMPONENTS][2];
+    static bool config_read[FLEET_STATUS_MAX_COMPONENTS];
+    for (size_t start = 0; start < component_names.list.len;
+         start += FLEET_STATUS_CONFIG_BATCH) {
+        size_t len = component_names.list.len - start;
+        if (len > FLEET_STATUS_CONFIG_BATCH) {
+            len = FLEET_STATUS_CONFIG_BATCH;
         }
-        GgBuffer component = gg_obj_into_buf(*component_obj);
-
-        // ignore core components for now, gghealthd does not support
-        // getting their health yet
-        GgBufList ignored_components = GG_BUF_LIST(
-            GG_STR("aws.greengrass.NucleusLite"),
-            GG_STR("aws.greengrass.fleet_provisioning"),
-            GG_STR("DeploymentService"),
-            GG_STR("FleetStatusService"),
-            GG_STR("main"),
-            GG_STR("TelemetryAgent"),
-            GG_STR("UpdateSystemPolicyService")
+        ret = read_component_configs(
+            component_names.list,
+            start,
+            len,
+            &config_alloc,
+            &config_values[start][0]
         );
-        bool ignore_component = false;
-        GG_BUF_LIST_FOREACH (ignored_component, ignored_components) {
-            if (gg_buffer_eq(*ignored_component, component)) {
-                ignore_component = true;
-                break;
-            }
+        if (ret != GG_ERR_OK) {
+            GG_LOGI(
+                "Failed to read config of %zu components at once with error %s; reading per component.",
+                len,
+                gg_strerror(ret)
+            );
         }
-        if (ignore_component) {
-            continue;
+        for (size_t i = start; i < start + len; i++) {
+            config_read[i] = ret == GG_ERR_OK;
         }
+    }
+
+    // retrieve health status of every component at once
+    GgMap component_healths = { 0 };
+    ret = ggl_gghealthd_retrieve_component_statuses(
+        &component_names.list, &alloc, &component_healths
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGW(
+            "Failed to retrieve component health statuses with error %s; retrieving individually.",
+            gg_strerror(ret)
+        );
+    }
+
+    // get status for each running component
+    static GgKV component_infos[FLEET_STATUS_MAX_COMPONENTS][5];
+    static GgObject component_statuses_mem[FLEET_STATUS_MAX_COMPONENTS];
+    GgObjVec component_statuses = GG_OBJ_VEC(component_statuses_mem);
+    size_t component_count = 0;
+    for (size_t i = 0; i < component_names.list.len; i++) {
+        GgBuffer component = gg_obj_into_buf(component_names.list.items[i]);
 
-        // retrieve component version from config
         GgBuffer version_resp;
-        ret = ggl_gg_config_read_str(
-            GG_BUF_LIST(GG_STR("services"), component, GG_STR("version")),
+        GgObject arn_list;
+        ret = get_component_config(
+            config_read[i] ? config_values[i] : NULL,
+            component,
             &alloc,
-            &version_resp
+            &version_resp,
+            &arn_list
         );
         if (ret != GG_ERR_OK) {
-            GG_LOGE(
-                "Unable to retrieve version of %.*s with error %s. Cannot publish fleet status update for this component.",
-                (int) component.len,
-                component.data,
-                gg_strerror(ret)
-            );
             continue;
         }
 
         // retrieve component health status
-        uint8_t component_health_arr[NAME_MAX];
-        GgBuffer component_health = GG_BUF(component_health_arr);
-        ret = ggl_gghealthd_retrieve_component_status(
-            component, &alloc, &component_health
-        );
-        if (ret != GG_ERR_OK) {
-            GG_LOGE(
-                "Failed to retrieve health status for %.*s with error %s. Cannot publish fleet status update for this component.",
-                (int) component.len,
-                component.data,
-                gg_strerror(ret)
+        GgBuffer component_health;
+        GgObject *component_health_obj;
+        if (gg_map_get(
+                component_healths, component, &component_health_obj
+            )) {
+            component_health = gg_obj_into_buf(*component_health_obj);
+        } else {
+            ret = ggl_gghealthd_retrieve_component_status(
+                component, &alloc, &component_health
             );
-            continue;
+            if (ret != GG_ERR_OK) {
+                GG_LOGE(
+                    "Failed to retrieve health status for %.*s with error %s. Cannot publish fleet status update for this component.",
+                    (int) component.len,
+                    component.data,
+                    gg_strerror(ret)
+                );
+                continue;
+            }
         }
 
         // if a component is broken, mark the device as unhealthy
@@ -185,28 +542,13 @@ GgError publish_fleet_status_update(
             device_healthy = false;
         }
 
-        // retrieve fleet config arn list from config
-        GgObject arn_list;
-        ret = ggl_gg_config_read(
-            GG_BUF_LIST(GG_STR("services"), component, GG_STR("configArn")),
-            &alloc,
-            &arn_list
-        );
-        if (ret != GG_ERR_OK) {
-            GG_LOGE(
-                "Unable to retrieve fleet configuration arn list for component %.*s from config with error %s. Cannot publish fleet status update for this component.",
-                (int) component.len,
-                component.data,
-                gg_strerror(ret)
-            );
-            continue;
-        }
-        if (gg_obj_type(arn_list) != GG_TYPE_LIST) {
-            GG_LOGE(
-                "Fleet configuration arn retrieved from config not of type list for component %.*s. Cannot publish fleet status update for this component.",
-                (int) component.len,
-                component.data
-            );
+        if (!complete
+            && !published_state_changed(
+                component,
+                published_state_fingerprint(
+                    version_resp, component_health, gg_obj_into_list(arn_list)
+                )
+            )) {
             continue;
         }
 
@@ -249,10 +591,10 @@ GgError publish_fleet_status_update(
     // component lingers in the cloud until the next COMPLETE update
     // (NUCLEUS_LAUNCH / CADENCE / NETWORK_RECONFIGURE).
     GG_LIST_FOREACH (removed_obj, removed_components) {
-        if (component_count >= GGL_MAX_GENERIC_COMPONENTS) {
+        if (component_count >= FLEET_STATUS_MAX_COMPONENTS) {
             GG_LOGW(
                 "Reached component cap (%d); dropping remaining UNINSTALLED entries from this fleet status update.",
-                GGL_MAX_GENERIC_COMPONENTS
+                FLEET_STATUS_MAX_COMPONENTS
             );
             break;
         }
@@ -299,6 +641,11 @@ GgError publish_fleet_status_update(
     }
     assert(component_count == component_statuses.list.len);
 
+    if (!complete && (component_count == 0) && (deployment_info.len == 0)) {
+        GG_LOGD("No component changes since last update; skipping publish.");
+        return GG_ERR_OK;
+    }
+
     GgBuffer overall_device_status;
     if (device_healthy) {
         overall_device_status = GG_STR("HEALTHY");
@@ -357,32 +704,22 @@ GgError publish_fleet_status_update(
         return ret;
     }
 
-    GgObject payload_obj = gg_obj_map(GG_MAP(
-        gg_kv(GG_STR("ggcVersion"), gg_obj_buf(GG_STR(GGL_VERSION))),
-        gg_kv(GG_STR("platform"), gg_obj_buf(GG_STR("linux"))),
-        gg_kv(GG_STR("architecture"), gg_obj_buf(ARCHITECTURE)),
-        gg_kv(GG_STR("runtime"), gg_obj_buf(GG_STR("aws_nucleus_lite"))),
-        gg_kv(GG_STR("thing"), gg_obj_buf(thing_name)),
-        gg_kv(GG_STR("sequenceNumber"), gg_obj_i64(sequence)),
-        gg_kv(GG_STR("timestamp"), gg_obj_i64(timestamp)),
-        gg_kv(GG_STR("messageType"), gg_obj_buf(message_type)),
-        gg_kv(GG_STR("trigger"), gg_obj_buf(trigger)),
-        gg_kv(GG_STR("overallDeviceStatus"), gg_obj_buf(overall_device_status)),
-        gg_kv(GG_STR("components"), gg_obj_list(component_statuses.list)),
-        gg_kv(GG_STR("deploymentInformation"), gg_obj_map(deployment_info))
-    ));
-
-    // build payload
-    static uint8_t payload_buf[PAYLOAD_BUFFER_LEN];
-    GgByteVec payload = GG_BYTE_VEC(payload_buf);
-    ret = gg_json_encode(payload_obj, gg_byte_vec_writer(&payload));
-    if (ret != GG_ERR_OK) {
-        return ret;
+    // A complete update replaces everything the cloud knows; components
+    // missing from it are no longer tracked.
+    if (complete) {
+        published_state_clear();
     }
 
-    ret = ggl_aws_iot_mqtt_publish(
-        GG_STR("aws_iot_mqtt"), topic_vec.buf, payload.buf, 0, false
-    );
+    PayloadHeader header = {
+        .thing_name = thing_name,
+        .sequence = sequence,
+        .timestamp = timestamp,
+        .message_type = message_type,
+        .trigger = trigger,
+        .overall_device_status = overall_device_status,
+        .deployment_info = deployment_info,
+    };
+    ret = publish_chunks(&header, topic_vec.buf, &component_statuses);
     if (ret != GG_ERR_OK) {
         return ret;
     }
@@ -10,11 +10,19 @@
 
 #define MAX_THING_NAME_LEN 128
 
+/// Maximum number of components reported in one fleet status update, across
+/// all of its messages.
+#ifndef FLEET_STATUS_MAX_COMPONENTS
+#define FLEET_STATUS_MAX_COMPONENTS 256
+#endif
+
 /// Publishes a fleet status update to the cloud. @p removed_components lists
 /// component names (as buffers) that have just been uninstalled by a
 /// deployment, if any; each is reported with status=UNINSTALLED so the cloud
 /// can prune them from its inventory even on PARTIAL updates. Pass an empty
-/// list when there are no removals.
+/// list when there are no removals. PARTIAL updates only carry components
+/// whose state changed since last published. Updates too large for one
+/// message are split into chunks sharing a sequence number.
 GgError publish_fleet_status_update(
     GgBuffer thing_name,
     GgBuffer trigger,
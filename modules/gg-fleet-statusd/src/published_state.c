@@ -0,0 +1,97 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "published_state.h"
+#include "fleet_status_service.h"
+#include <gg/buffer.h>
+#include <gg/list.h>
+#include <gg/log.h>
+#include <gg/object.h>
+#include <ggl/nucleus/constants.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t name[GGL_COMPONENT_NAME_MAX_LEN];
+    size_t name_len;
+    uint64_t fingerprint;
+} PublishedComponent;
+
+static PublishedComponent published[FLEET_STATUS_MAX_COMPONENTS];
+static size_t published_len;
+
+static uint64_t fnv1a_append(uint64_t hash, GgBuffer buf) {
+    for (size_t i = 0; i < buf.len; i++) {
+        hash ^= buf.data[i];
+        hash *= 1099511628211U;
+    }
+    // Separator so adjacent fields cannot alias
+    hash ^= 0xFFU;
+    hash *= 1099511628211U;
+    return hash;
+}
+
+uint64_t published_state_fingerprint(
+    GgBuffer version, GgBuffer status, GgList fleet_config_arns
+) {
+    uint64_t hash = 14695981039346656037U;
+    hash = fnv1a_append(hash, version);
+    hash = fnv1a_append(hash, status);
+    GG_LIST_FOREACH (arn, fleet_config_arns) {
+        if (gg_obj_type(*arn) == GG_TYPE_BUF) {
+            hash = fnv1a_append(hash, gg_obj_into_buf(*arn));
+        }
+    }
+    return hash;
+}
+
+static PublishedComponent *find_component(GgBuffer component_name) {
+    for (size_t i = 0; i < published_len; i++) {
+        GgBuffer name = { .data = published[i].name,
+                          .len = published[i].name_len };
+        if (gg_buffer_eq(name, component_name)) {
+            return &published[i];
+        }
+    }
+    return NULL;
+}
+
+bool published_state_changed(GgBuffer component_name, uint64_t fingerprint) {
+    PublishedComponent *entry = find_component(component_name);
+    return (entry == NULL) || (entry->fingerprint != fingerprint);
+}
+
+void published_state_record(GgBuffer component_name, uint64_t fingerprint) {
+    if (component_name.len > GGL_COMPONENT_NAME_MAX_LEN) {
+        return;
+    }
+    PublishedComponent *entry = find_component(component_name);
+    if (entry == NULL) {
+        if (published_len == FLEET_STATUS_MAX_COMPONENTS) {
+            // Untracked components are reported as changed every time
+            GG_LOGW("Published component state table full.");
+            return;
+        }
+        entry = &published[published_len];
+        published_len += 1;
+        memcpy(entry->name, component_name.data, component_name.len);
+        entry->name_len = component_name.len;
+    }
+    entry->fingerprint = fingerprint;
+}
+
+void published_state_forget(GgBuffer component_name) {
+    PublishedComponent *entry = find_component(component_name);
+    if (entry == NULL) {
+        return;
+    }
+    published_len -= 1;
+    *entry = published[published_len];
+}
+
+void published_state_clear(void) {
+    published_len = 0;
+}
@@ -0,0 +1,34 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef GG_FLEET_STATUSD_PUBLISHED_STATE_H
+#define GG_FLEET_STATUSD_PUBLISHED_STATE_H
+
+#include <gg/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Tracks the state of each component as last published to the cloud, so
+// PARTIAL updates only need to carry components that changed. State is kept
+// as a fingerprint of the reported fields. Not thread-safe; callers hold the
+// publish lock.
+
+/// Fingerprint of the reported state of a component.
+uint64_t published_state_fingerprint(
+    GgBuffer version, GgBuffer status, GgList fleet_config_arns
+);
+
+/// Returns true if the component was not published with this fingerprint.
+bool published_state_changed(GgBuffer component_name, uint64_t fingerprint);
+
+/// Records the component as published with the fingerprint.
+void published_state_record(GgBuffer component_name, uint64_t fingerprint);
+
+/// Forgets a component, e.g. once it was reported as uninstalled.
+void published_state_forget(GgBuffer component_name);
+
+/// Forgets all components, before publishing a complete state.
+void published_state_clear(void);
+
+#endif
@@ -23,6 +23,9 @@
 #include <time.h>
 #include <stdbool.h>
 
+/// Maximum key paths read by one read_many call.
+#define GGCONFIGD_READ_MANY_MAX_KEYS 64
+
 /// Given a GgObject of (possibly nested) GgMaps and/or GgBuffer(s),
 /// decode all the GgBuffers from json to their appropriate GGL object types.
 // NOLINTNEXTLINE(misc-no-recursion)
@@ -92,6 +95,71 @@ static GgError rpc_read(void *ctx, GgMap params, uint32_t handle) {
     return GG_ERR_OK;
 }
 
+static GgError rpc_read_many(void *ctx, GgMap params, uint32_t handle) {
+    (void) ctx;
+
+    GgObject *key_paths_obj;
+    if (!gg_map_get(params, GG_STR("key_paths"), &key_paths_obj)
+        || (gg_obj_type(*key_paths_obj) != GG_TYPE_LIST)) {
+        GG_LOGE("read_many received invalid key_paths argument.");
+        return GG_ERR_INVALID;
+    }
+    GgList key_paths = gg_obj_into_list(*key_paths_obj);
+    if (key_paths.len > GGCONFIGD_READ_MANY_MAX_KEYS) {
+        GG_LOGE("read_many received too many key paths.");
+        return GG_ERR_RANGE;
+    }
+    GgError ret = gg_list_type_check(key_paths, GG_TYPE_LIST);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("key_paths elements must be lists.");
+        return GG_ERR_INVALID;
+    }
+
+    // Each read reuses the database read memory, so values are copied out.
+    static GgObject values[GGCONFIGD_READ_MANY_MAX_KEYS];
+    static uint8_t values_memory[GGCONFIGD_MAX_OBJECT_DECODE_BYTES];
+    GgArena values_alloc = gg_arena_init(GG_BUF(values_memory));
+    static uint8_t object_decode_memory[GGCONFIGD_MAX_OBJECT_DECODE_BYTES];
+
+    for (size_t i = 0; i < key_paths.len; i++) {
+        GgList key_path = gg_obj_into_list(key_paths.items[i]);
+        ret = gg_list_type_check(key_path, GG_TYPE_BUF);
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("key_path elements must be strings.");
+            return GG_ERR_RANGE;
+        }
+
+        GgObject value;
+        ret = ggconfig_get_value_from_key(&key_path, &value);
+        if (ret == GG_ERR_NOENTRY) {
+            values[i] = GG_OBJ_NULL;
+            continue;
+        }
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+
+        GgArena object_alloc = gg_arena_init(GG_BUF(object_decode_memory));
+        ret = decode_object_destructive(&value, &object_alloc);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        ret = gg_arena_claim_obj(&value, &values_alloc);
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Values read by read_many do not fit in memory.");
+            return ret;
+        }
+        values[i] = value;
+    }
+
+    GG_LOGD("Processed request to read %zu keys.", key_paths.len);
+    ggl_respond(
+        handle,
+        gg_obj_list((GgList) { .items = values, .len = key_paths.len })
+    );
+    return GG_ERR_OK;
+}
+
 static GgError rpc_list(void *ctx, GgMap params, uint32_t handle) {
     (void) ctx;
 
@@ -358,6 +426,7 @@ static GgError rpc_restore(void *ctx, GgMap params, uint32_t handle) {
 void ggconfigd_start_server(void) {
     GglRpcMethodDesc handlers[]
         = { { GG_STR("read"), false, rpc_read, NULL },
+            { GG_STR("read_many"), false, rpc_read_many, NULL },
             { GG_STR("list"), false, rpc_list, NULL },
             { GG_STR("write"), false, rpc_write, NULL },
             { GG_STR("delete"), false, rpc_delete, NULL },
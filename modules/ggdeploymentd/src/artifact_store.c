@@ -0,0 +1,521 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "artifact_store.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/file.h>
+#include <gg/log.h>
+#include <gg/types.h>
+#include <ggl/digest.h>
+#include <limits.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define ARTIFACT_STORE_DIR "packages/artifacts-sha256"
+#define SHA256_LEN 32
+#define WRITE_BITS ((mode_t) (S_IWUSR | S_IWGRP | S_IWOTH))
+
+typedef struct {
+    char name[(SHA256_LEN * 2) + 1];
+} ArtifactStoreKey;
+
+static GgError artifact_store_key(GgBuffer digest, ArtifactStoreKey *key) {
+    if (digest.len != SHA256_LEN) {
+        return GG_ERR_INVALID;
+    }
+    GgBuffer hex = { .data = (uint8_t *) key->name, .len = SHA256_LEN * 2 };
+    GgError ret = ggl_digest_hex_encode(digest, &hex);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    key->name[hex.len] = '\0';
+    return GG_ERR_OK;
+}
+
+static GgError buffer_to_path(GgBuffer buf, char (*path)[PATH_MAX]) {
+    if (buf.len >= sizeof(*path)) {
+        return GG_ERR_NOMEM;
+    }
+    snprintf(*path, sizeof(*path), "%.*s", (int) buf.len, buf.data);
+    return GG_ERR_OK;
+}
+
+GgError artifact_store_open(int root_path_fd, int *store_fd) {
+    return gg_dir_openat(
+        root_path_fd, GG_STR(ARTIFACT_STORE_DIR), O_PATH, true, store_fd
+    );
+}
+
+static GgError copy_file_contents(int src_fd, int dest_fd) {
+    if (ioctl(dest_fd, FICLONE, src_fd) == 0) {
+        return GG_ERR_OK;
+    }
+
+    while (true) {
+        ssize_t copied
+            = copy_file_range(src_fd, NULL, dest_fd, NULL, SSIZE_MAX, 0);
+        if (copied == 0) {
+            return GG_ERR_OK;
+        }
+        if (copied > 0) {
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if ((errno != EXDEV) && (errno != ENOSYS) && (errno != EINVAL)) {
+            GG_LOGE("Failed to copy stored artifact (errno=%d).", errno);
+            return GG_ERR_FAILURE;
+        }
+        break;
+    }
+
+    // copy_file_range unsupported between these files.
+    uint8_t copy_buf[4096];
+    while (true) {
+        GgBuffer chunk = GG_BUF(copy_buf);
+        GgError ret = gg_file_read(src_fd, &chunk);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        if (chunk.len == 0) {
+            return GG_ERR_OK;
+        }
+        ret = gg_file_write(dest_fd, chunk);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+}
+
+GgError artifact_store_checkout(
+    int store_fd,
+    GgBuffer digest,
+    int dest_dir_fd,
+    GgBuffer name,
+    mode_t mode,
+    uid_t uid,
+    gid_t gid
+) {
+    ArtifactStoreKey key;
+    GgError ret = artifact_store_key(digest, &key);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    char dest_name[PATH_MAX];
+    ret = buffer_to_path(name, &dest_name);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    struct stat st;
+    if (fstatat(store_fd, key.name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        if (errno == ENOENT) {
+            return GG_ERR_NOENTRY;
+        }
+        GG_LOGE("Failed to stat stored artifact (errno=%d).", errno);
+        return GG_ERR_FAILURE;
+    }
+
+    if ((unlinkat(dest_dir_fd, dest_name, 0) != 0) && (errno != ENOENT)) {
+        GG_LOGE("Failed to replace artifact %s (errno=%d).", dest_name, errno);
+        return GG_ERR_FAILURE;
+    }
+
+    // Only read-only stored files are shared, so that a component cannot
+    // change the stored content through its artifact.
+    bool owner_matches = ((uid == (uid_t) -1) || (st.st_uid == uid))
+        && ((gid == (gid_t) -1) || (st.st_gid == gid));
+    bool read_only = (st.st_mode & WRITE_BITS) == 0;
+    if (read_only && ((st.st_mode & 07777) == (mode & ~WRITE_BITS))
+        && owner_matches) {
+        if (linkat(store_fd, key.name, dest_dir_fd, dest_name, 0) == 0) {
+            GG_LOGD("Linked stored artifact %s to %s.", key.name, dest_name);
+            return GG_ERR_OK;
+        }
+        GG_LOGD(
+            "Failed to link stored artifact (errno=%d); copying instead.", errno
+        );
+    }
+
+    int src_fd = -1;
+    ret = gg_file_openat(
+        store_fd, gg_buffer_from_null_term(key.name), O_RDONLY, 0, &src_fd
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, src_fd);
+
+    int dest_fd = -1;
+    ret = gg_file_openat(
+        dest_dir_fd, name, O_CREAT | O_WRONLY | O_EXCL, mode, &dest_fd
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, dest_fd);
+
+    ret = copy_file_contents(src_fd, dest_fd);
+    if ((ret == GG_ERR_OK) && ((uid != (uid_t) -1) || (gid != (gid_t) -1))
+        && (fchown(dest_fd, uid, gid) != 0)) {
+        GG_LOGE("Failed to chown artifact %s (errno=%d).", dest_name, errno);
+        ret = GG_ERR_FAILURE;
+    }
+    if (ret == GG_ERR_OK) {
+        ret = gg_fsync(dest_fd);
+    }
+    if (ret != GG_ERR_OK) {
+        (void) unlinkat(dest_dir_fd, dest_name, 0);
+        return ret;
+    }
+    GG_LOGD("Copied stored artifact %s to %s.", key.name, dest_name);
+    return GG_ERR_OK;
+}
+
+GgError artifact_store_add(
+    int store_fd, GgBuffer digest, int src_dir_fd, GgBuffer name
+) {
+    ArtifactStoreKey key;
+    GgError ret = artifact_store_key(digest, &key);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    char src_name[PATH_MAX];
+    ret = buffer_to_path(name, &src_name);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    if (linkat(src_dir_fd, src_name, store_fd, key.name, 0) != 0) {
+        if (errno == EEXIST) {
+            return GG_ERR_OK;
+        }
+        GG_LOGW(
+            "Failed to add artifact %s to store (errno=%d).", src_name, errno
+        );
+        return GG_ERR_FAILURE;
+    }
+
+    struct stat st;
+    int chmod_ret = fstatat(store_fd, key.name, &st, AT_SYMLINK_NOFOLLOW);
+    if (chmod_ret == 0) {
+        chmod_ret = fchmodat(
+            store_fd, key.name, st.st_mode & 07777 & ~WRITE_BITS, 0
+        );
+    }
+    if (chmod_ret != 0) {
+        GG_LOGW(
+            "Failed to make stored artifact %s read-only (errno=%d).",
+            key.name,
+            errno
+        );
+        (void) unlinkat(store_fd, key.name, 0);
+        return GG_ERR_FAILURE;
+    }
+    GG_LOGD("Added artifact %s to store as %s.", src_name, key.name);
+    return GG_ERR_OK;
+}
+
+void artifact_store_collect_garbage(int root_path_fd) {
+    int store_fd = -1;
+    GgError ret = gg_dir_openat(
+        root_path_fd, GG_STR(ARTIFACT_STORE_DIR), O_RDONLY, false, &store_fd
+    );
+    if (ret != GG_ERR_OK) {
+        return;
+    }
+
+    DIR *dir = fdopendir(store_fd);
+    if (dir == NULL) {
+        GG_LOGE("Failed to open artifact store.");
+        (void) gg_close(store_fd);
+        return;
+    }
+    GG_CLEANUP(cleanup_closedir, dir);
+
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    for (struct dirent *entry; (entry = readdir(dir)) != NULL;) {
+        if (entry->d_type != DT_REG) {
+            continue;
+        }
+        struct stat st;
+        if (fstatat(store_fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            continue;
+        }
+        if (st.st_nlink > 1) {
+            continue;
+        }
+        GG_LOGD("Removing unreferenced stored artifact %s.", entry->d_name);
+        if (unlinkat(store_fd, entry->d_name, 0) != 0) {
+            GG_LOGW(
+                "Failed to remove stored artifact %s (errno=%d).",
+                entry->d_name,
+                errno
+            );
+        }
+    }
+}
+
+#ifdef GG_SDK_TESTING
+
+#include <gg/test.h>
+#include <unity.h>
+#include <stdlib.h>
+
+GG_TEST_DEFINE(artifact_store_key_hex) {
+    uint8_t digest[SHA256_LEN] = { 0x00, 0x01, 0xAB, 0xFF };
+    ArtifactStoreKey key;
+    GG_TEST_ASSERT_OK(artifact_store_key(GG_BUF(digest), &key));
+    TEST_ASSERT_EQUAL_STRING(
+        "0001abff00000000000000000000000000000000000000000000000000000000",
+        key.name
+    );
+}
+
+GG_TEST_DEFINE(artifact_store_key_bad_len) {
+    ArtifactStoreKey key;
+    GG_TEST_ASSERT_BAD(artifact_store_key(GG_STR("short"), &key));
+}
+
+static const uint8_t TEST_DIGEST[SHA256_LEN] = { 0x12, 0x34 };
+
+typedef struct {
+    int root_fd;
+    int store_fd;
+    int src_fd;
+    int dest_fd;
+} TestStore;
+
+// Creates a store holding src/artifact, with the given mode.
+static TestStore test_store_init(mode_t mode) {
+    char root_path[] = "/tmp/ggl-artifact-store-test-XXXXXX";
+    TEST_ASSERT_NOT_NULL(mkdtemp(root_path));
+    TestStore store;
+    GG_TEST_ASSERT_OK(gg_dir_open(
+        gg_buffer_from_null_term(root_path), O_PATH, false, &store.root_fd
+    ));
+    GG_TEST_ASSERT_OK(artifact_store_open(store.root_fd, &store.store_fd));
+    GG_TEST_ASSERT_OK(gg_dir_openat(
+        store.root_fd, GG_STR("src"), O_PATH, true, &store.src_fd
+    ));
+    GG_TEST_ASSERT_OK(gg_dir_openat(
+        store.root_fd, GG_STR("dest"), O_PATH, true, &store.dest_fd
+    ));
+
+    int fd;
+    GG_TEST_ASSERT_OK(gg_file_openat(
+        store.src_fd,
+        GG_STR("artifact"),
+        O_WRONLY | O_CREAT | O_TRUNC,
+        mode,
+        &fd
+    ));
+    TEST_ASSERT_EQUAL(0, fchmod(fd, mode));
+    GgError ret = gg_file_write(fd, GG_STR("contents"));
+    (void) gg_close(fd);
+    GG_TEST_ASSERT_OK(ret);
+    return store;
+}
+
+static void test_store_cleanup(TestStore *store) {
+    (void) gg_close(store->dest_fd);
+    (void) gg_close(store->src_fd);
+    (void) gg_close(store->store_fd);
+    (void) gg_close(store->root_fd);
+}
+
+static struct stat test_stat(int dir_fd, const char *name) {
+    struct stat st;
+    TEST_ASSERT_EQUAL(0, fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW));
+    return st;
+}
+
+static void test_assert_contents(int dir_fd, const char *name) {
+    int fd;
+    GG_TEST_ASSERT_OK(gg_file_openat(
+        dir_fd, gg_buffer_from_null_term((char *) name), O_RDONLY, 0, &fd
+    ));
+    uint8_t mem[32];
+    GgBuffer contents = GG_BUF(mem);
+    GgError ret = gg_file_read(fd, &contents);
+    (void) gg_close(fd);
+    GG_TEST_ASSERT_OK(ret);
+    TEST_ASSERT_TRUE(gg_buffer_eq(contents, GG_STR("contents")));
+}
+
+GG_TEST_DEFINE(artifact_store_add_links_source) {
+    TestStore store = test_store_init(0644);
+    ArtifactStoreKey key;
+    GG_TEST_ASSERT_OK(artifact_store_key(GG_BUF(TEST_DIGEST), &key));
+
+    GG_TEST_ASSERT_OK(artifact_store_add(
+        store.store_fd, GG_BUF(TEST_DIGEST), store.src_fd, GG_STR("artifact")
+    ));
+    struct stat stored = test_stat(store.store_fd, key.name);
+    TEST_ASSERT_EQUAL(
+        test_stat(store.src_fd, "artifact").st_ino, stored.st_ino
+    );
+    TEST_ASSERT_EQUAL(2, stored.st_nlink);
+    TEST_ASSERT_EQUAL(0444, stored.st_mode & 07777);
+
+    // Adding a stored digest again keeps the stored file
+    GG_TEST_ASSERT_OK(artifact_store_add(
+        store.store_fd, GG_BUF(TEST_DIGEST), store.src_fd, GG_STR("artifact")
+    ));
+    TEST_ASSERT_EQUAL(2, test_stat(store.store_fd, key.name).st_nlink);
+
+    test_store_cleanup(&store);
+}
+
+GG_TEST_DEFINE(artifact_store_checkout_link_or_copy) {
+    TestStore store = test_store_init(0600);
+    ArtifactStoreKey key;
+    GG_TEST_ASSERT_OK(artifact_store_key(GG_BUF(TEST_DIGEST), &key));
+
+    GG_TEST_ASSERT_BAD(artifact_store_checkout(
+        store.store_fd,
+        GG_BUF(TEST_DIGEST),
+        store.dest_fd,
+        GG_STR("linked"),
+        0600,
+        (uid_t) -1,
+        (gid_t) -1
+    ));
+
+    GG_TEST_ASSERT_OK(artifact_store_add(
+        store.store_fd, GG_BUF(TEST_DIGEST), store.src_fd, GG_STR("artifact")
+    ));
+    ino_t stored_ino = test_stat(store.store_fd, key.name).st_ino;
+
+    // Matching mode (ignoring write permission) and owner share the stored
+    // file
+    GG_TEST_ASSERT_OK(artifact_store_checkout(
+        store.store_fd,
+        GG_BUF(TEST_DIGEST),
+        store.dest_fd,
+        GG_STR("linked"),
+        0600,
+        getuid(),
+        (gid_t) -1
+    ));
+    struct stat linked = test_stat(store.dest_fd, "linked");
+    TEST_ASSERT_EQUAL(stored_ino, linked.st_ino);
+    TEST_ASSERT_EQUAL(0400, linked.st_mode & 07777);
+
+    // Mode mismatch gets a private copy
+    GG_TEST_ASSERT_OK(artifact_store_checkout(
+        store.store_fd,
+        GG_BUF(TEST_DIGEST),
+        store.dest_fd,
+        GG_STR("other_mode"),
+        0700,
+        (uid_t) -1,
+        (gid_t) -1
+    ));
+    struct stat copied = test_stat(store.dest_fd, "other_mode");
+    TEST_ASSERT_NOT_EQUAL(stored_ino, copied.st_ino);
+    TEST_ASSERT_EQUAL(0700, copied.st_mode & 07777);
+    test_assert_contents(store.dest_fd, "other_mode");
+
+    // Owner mismatch gets a private copy with the requested owner. Changing
+    // the owner needs privileges.
+    if (geteuid() == 0) {
+        GG_TEST_ASSERT_OK(artifact_store_checkout(
+            store.store_fd,
+            GG_BUF(TEST_DIGEST),
+            store.dest_fd,
+            GG_STR("other_owner"),
+            0600,
+            getuid() + 1,
+            (gid_t) -1
+        ));
+        struct stat other_owner = test_stat(store.dest_fd, "other_owner");
+        TEST_ASSERT_NOT_EQUAL(stored_ino, other_owner.st_ino);
+        TEST_ASSERT_EQUAL(getuid() + 1, other_owner.st_uid);
+        test_assert_contents(store.dest_fd, "other_owner");
+    }
+
+    // Copies do not change the stored file
+    struct stat stored = test_stat(store.store_fd, key.name);
+    TEST_ASSERT_EQUAL(0400, stored.st_mode & 07777);
+    TEST_ASSERT_EQUAL(stored_ino, stored.st_ino);
+    TEST_ASSERT_EQUAL(3, stored.st_nlink);
+
+    test_store_cleanup(&store);
+}
+
+GG_TEST_DEFINE(artifact_store_checkout_cannot_change_store) {
+    TestStore store = test_store_init(0644);
+    ArtifactStoreKey key;
+    GG_TEST_ASSERT_OK(artifact_store_key(GG_BUF(TEST_DIGEST), &key));
+    GG_TEST_ASSERT_OK(artifact_store_add(
+        store.store_fd, GG_BUF(TEST_DIGEST), store.src_fd, GG_STR("artifact")
+    ));
+
+    // A writable stored file (e.g. stored before entries were read-only) is
+    // never shared
+    TEST_ASSERT_EQUAL(0, fchmodat(store.store_fd, key.name, 0644, 0));
+    GG_TEST_ASSERT_OK(artifact_store_checkout(
+        store.store_fd,
+        GG_BUF(TEST_DIGEST),
+        store.dest_fd,
+        GG_STR("checkout"),
+        0644,
+        (uid_t) -1,
+        (gid_t) -1
+    ));
+    TEST_ASSERT_NOT_EQUAL(
+        test_stat(store.store_fd, key.name).st_ino,
+        test_stat(store.dest_fd, "checkout").st_ino
+    );
+
+    // Writing the checked out artifact leaves the stored content intact
+    int fd;
+    GG_TEST_ASSERT_OK(gg_file_openat(
+        store.dest_fd, GG_STR("checkout"), O_WRONLY | O_TRUNC, 0, &fd
+    ));
+    GgError ret = gg_file_write(fd, GG_STR("modified"));
+    (void) gg_close(fd);
+    GG_TEST_ASSERT_OK(ret);
+    test_assert_contents(store.store_fd, key.name);
+
+    test_store_cleanup(&store);
+}
+
+GG_TEST_DEFINE(artifact_store_gc_removes_unreferenced) {
+    TestStore store = test_store_init(0644);
+    ArtifactStoreKey key;
+    GG_TEST_ASSERT_OK(artifact_store_key(GG_BUF(TEST_DIGEST), &key));
+    GG_TEST_ASSERT_OK(artifact_store_add(
+        store.store_fd, GG_BUF(TEST_DIGEST), store.src_fd, GG_STR("artifact")
+    ));
+
+    // Still linked from a component version
+    artifact_store_collect_garbage(store.root_fd);
+    (void) test_stat(store.store_fd, key.name);
+
+    TEST_ASSERT_EQUAL(0, unlinkat(store.src_fd, "artifact", 0));
+    artifact_store_collect_garbage(store.root_fd);
+    struct stat st;
+    TEST_ASSERT_NOT_EQUAL(
+        0, fstatat(store.store_fd, key.name, &st, AT_SYMLINK_NOFOLLOW)
+    );
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    test_store_cleanup(&store);
+}
+
+#endif
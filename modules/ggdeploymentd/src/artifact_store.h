@@ -0,0 +1,48 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef GGDEPLOYMENTD_ARTIFACT_STORE_H
+#define GGDEPLOYMENTD_ARTIFACT_STORE_H
+
+#include <gg/error.h>
+#include <gg/types.h>
+#include <sys/types.h>
+
+// Artifacts with a known SHA-256 digest are kept in a content-addressed store
+// under packages/artifacts-sha256, named by hex digest, and hardlinked into
+// the per-version artifact directories. The hardlink count of a stored
+// artifact is its reference count.
+
+/// Opens the content-addressed artifact store, creating it if needed.
+GgError artifact_store_open(int root_path_fd, int *store_fd);
+
+/// Places the stored artifact with a given SHA-256 digest at dest_dir_fd/name.
+///
+/// The stored file is hardlinked if it is read-only, and has the requested
+/// mode without write permission and the requested ownership. Otherwise it is
+/// cloned or copied with the requested mode and ownership. Pass -1 for uid and
+/// gid to accept any ownership.
+///
+/// @return GG_ERR_NOENTRY if no artifact with the digest is stored.
+GgError artifact_store_checkout(
+    int store_fd,
+    GgBuffer digest,
+    int dest_dir_fd,
+    GgBuffer name,
+    mode_t mode,
+    uid_t uid,
+    gid_t gid
+);
+
+/// Adds the verified artifact at src_dir_fd/name to the store. The artifact is
+/// hardlinked and made read-only; its ownership must not be changed afterwards.
+GgError artifact_store_add(
+    int store_fd, GgBuffer digest, int src_dir_fd, GgBuffer name
+);
+
+/// Removes stored artifacts that are no longer linked from any component
+/// version's artifact directory.
+void artifact_store_collect_garbage(int root_path_fd);
+
+#endif
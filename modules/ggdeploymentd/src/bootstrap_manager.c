@@ -6,6 +6,7 @@
 #include "deployment_model.h"
 #include "deployment_queue.h"
 #include "stale_component.h"
+#include "systemd_units.h"
 #include <assert.h>
 #include <fcntl.h>
 #include <gg/arena.h>
@@ -22,8 +23,8 @@
 #include <limits.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
-#include <stdlib.h>
 
 bool component_bootstrap_phase_completed(GgBuffer component_name) {
     // check config to see if component bootstrap steps have already been
@@ -444,7 +445,8 @@ GgError process_bootstrap_phase(
     GgBufVec *bootstrap_comp_name_buf_vec,
     GglDeployment *deployment
 ) {
-    int bootstrap_component_count = 0;
+    size_t first_bootstrap_component
+        = bootstrap_comp_name_buf_vec->buf_list.len;
     GG_MAP_FOREACH (component, components) {
         GgBuffer component_name = gg_kv_key(*component);
 
@@ -486,11 +488,7 @@ GgError process_bootstrap_phase(
                     component_name.data
                 );
             } else { // relevant bootstrap service file exists
-                GG_CLEANUP(cleanup_close, fd);
-                ret = disable_and_unlink_service(&component_name, BOOTSTRAP);
-                if (ret != GG_ERR_OK) {
-                    return ret;
-                }
+                (void) gg_close(fd);
                 GG_LOGI(
                     "Found bootstrap service file for %.*s. Processing.",
                     (int) component_name.len,
@@ -507,126 +505,63 @@ GgError process_bootstrap_phase(
                     );
                     return ret;
                 }
-                bootstrap_component_count++;
-
-                // initiate link command for 'bootstrap'
-                static uint8_t link_command_buf[PATH_MAX];
-                GgByteVec link_command_vec = GG_BYTE_VEC(link_command_buf);
-                ret = gg_byte_vec_append(
-                    &link_command_vec, GG_STR("systemctl link ")
-                );
-                gg_byte_vec_chain_append(
-                    &ret, &link_command_vec, bootstrap_service_file_path_vec.buf
-                );
-                gg_byte_vec_chain_push(&ret, &link_command_vec, '\0');
-                if (ret != GG_ERR_OK) {
-                    GG_LOGE(
-                        "Failed to create systemctl link command for:%.*s",
-                        (int) bootstrap_service_file_path_vec.buf.len,
-                        bootstrap_service_file_path_vec.buf.data
-                    );
-                    return ret;
-                }
+            }
+        }
+    }
 
-                GG_LOGD(
-                    "Command to execute: %.*s",
-                    (int) link_command_vec.buf.len,
-                    link_command_vec.buf.data
-                );
+    GgBufList bootstrap_components = {
+        .bufs = &bootstrap_comp_name_buf_vec->buf_list
+                     .bufs[first_bootstrap_component],
+        .len = bootstrap_comp_name_buf_vec->buf_list.len
+            - first_bootstrap_component,
+    };
+    size_t bootstrap_component_count = bootstrap_components.len;
 
-                // NOLINTBEGIN(concurrency-mt-unsafe)
-                int system_ret = system((char *) link_command_vec.buf.data);
-                if (WIFEXITED(system_ret)) {
-                    if (WEXITSTATUS(system_ret) != 0) {
-                        GG_LOGE(
-                            "systemctl link failed for:%.*s",
-                            (int) bootstrap_service_file_path_vec.buf.len,
-                            bootstrap_service_file_path_vec.buf.data
-                        );
-                        return ret;
-                    }
-                    GG_LOGI(
-                        "systemctl link exited for %.*s with child status %d\n",
-                        (int) bootstrap_service_file_path_vec.buf.len,
-                        bootstrap_service_file_path_vec.buf.data,
-                        WEXITSTATUS(system_ret)
-                    );
-                } else {
-                    GG_LOGE(
-                        "systemctl link did not exit normally for %.*s",
-                        (int) bootstrap_service_file_path_vec.buf.len,
-                        bootstrap_service_file_path_vec.buf.data
-                    );
-                    return ret;
-                }
-
-                // initiate start command for 'bootstrap'
-                static uint8_t start_command_buf[PATH_MAX];
-                GgByteVec start_command_vec = GG_BYTE_VEC(start_command_buf);
-                ret = gg_byte_vec_append(
-                    &start_command_vec, GG_STR("systemctl start ")
-                );
-                gg_byte_vec_chain_append(
-                    &ret, &start_command_vec, GG_STR("ggl.")
-                );
-                gg_byte_vec_chain_append(
-                    &ret, &start_command_vec, component_name
-                );
-                gg_byte_vec_chain_append(
-                    &ret, &start_command_vec, GG_STR(".bootstrap.service\0")
-                );
+    if (bootstrap_component_count > 0) {
+        // Replace and link all bootstrap services with one reload.
+        GgError ret
+            = disable_and_unlink_services(bootstrap_components, BOOTSTRAP);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        ret = systemd_units_link(root_path, bootstrap_components, BOOTSTRAP);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        ret = systemd_daemon_reload();
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
 
-                GG_LOGD(
-                    "Command to execute: %.*s",
-                    (int) start_command_vec.buf.len,
-                    start_command_vec.buf.data
-                );
-                if (ret != GG_ERR_OK) {
-                    GG_LOGE(
-                        "Failed to create systemctl start command for %.*s",
-                        (int) bootstrap_service_file_path_vec.buf.len,
-                        bootstrap_service_file_path_vec.buf.data
-                    );
-                    return ret;
-                }
+    for (size_t i = 0; i < bootstrap_components.len; i++) {
+        GgBuffer component_name = bootstrap_components.bufs[i];
+        GgObject *component_version = NULL;
+        if (!gg_map_get(components, component_name, &component_version)) {
+            return GG_ERR_FAILURE;
+        }
 
-                // save component to config to avoid rerunning bootstrap steps
-                ret = save_component_info(
-                    component_name,
-                    gg_obj_into_buf(*gg_kv_val(component)),
-                    GG_STR("bootstrap")
-                );
-                if (ret != GG_ERR_OK) {
-                    GG_LOGE(
-                        "Failed to save component info to config after completing bootstrap steps."
-                    );
-                    return ret;
-                }
+        // save component to config to avoid rerunning bootstrap steps
+        GgError ret = save_component_info(
+            component_name,
+            gg_obj_into_buf(*component_version),
+            GG_STR("bootstrap")
+        );
+        if (ret != GG_ERR_OK) {
+            GG_LOGE(
+                "Failed to save component info to config after completing bootstrap steps."
+            );
+            return ret;
+        }
 
-                system_ret = system((char *) start_command_vec.buf.data);
-                // NOLINTEND(concurrency-mt-unsafe)
-                if (WIFEXITED(system_ret)) {
-                    if (WEXITSTATUS(system_ret) != 0) {
-                        GG_LOGE(
-                            "systemctl start failed for%.*s",
-                            (int) bootstrap_service_file_path_vec.buf.len,
-                            bootstrap_service_file_path_vec.buf.data
-                        );
-                        return ret;
-                    }
-                    GG_LOGI(
-                        "systemctl start exited with child status %d\n",
-                        WEXITSTATUS(system_ret)
-                    );
-                } else {
-                    GG_LOGE(
-                        "systemctl start did not exit normally for %.*s",
-                        (int) bootstrap_service_file_path_vec.buf.len,
-                        bootstrap_service_file_path_vec.buf.data
-                    );
-                    return ret;
-                }
-            }
+        ret = systemd_unit_start(component_name, BOOTSTRAP, true);
+        if (ret != GG_ERR_OK) {
+            GG_LOGE(
+                "Failed to start bootstrap service for %.*s.",
+                (int) component_name.len,
+                component_name.data
+            );
+            return ret;
         }
     }
 
@@ -639,18 +574,9 @@ GgError process_bootstrap_phase(
         }
 
         GG_LOGI("Rebooting device for bootstrap.");
-        // NOLINTNEXTLINE(concurrency-mt-unsafe)
-        int system_ret = system("systemctl reboot");
-        if (WIFEXITED(system_ret)) {
-            if (WEXITSTATUS(system_ret) != 0) {
-                GG_LOGE("systemctl reboot failed");
-            }
-            GG_LOGI(
-                "systemctl reboot exited with child status %d\n",
-                WEXITSTATUS(system_ret)
-            );
-        } else {
-            GG_LOGE("systemctl reboot did not exit normally");
+        ret = systemd_reboot();
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Failed to request reboot.");
         }
     }
 
@@ -12,7 +12,6 @@
 #include <gg/types.h>
 #include <gg/vector.h>
 #include <ggl/core_bus/server.h>
-#include <systemd/sd-daemon.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -27,7 +26,7 @@ static GgError create_local_deployment(
     GgByteVec id = GG_BYTE_VEC((uint8_t[36]) { 0 });
 
     GgError ret = ggl_deployment_enqueue(
-        params, &id, (GgBuffer) { 0 }, LOCAL_DEPLOYMENT
+        params, &id, (GgBuffer) { 0 }, LOCAL_DEPLOYMENT, NULL
     );
     if (ret != GG_ERR_OK) {
         return ret;
@@ -40,12 +39,6 @@ static GgError create_local_deployment(
 void ggdeploymentd_start_server(void) {
     GG_LOGI("Starting ggdeploymentd core bus server.");
 
-    int notify_ret = sd_notify(0, "READY=1");
-    if (notify_ret < 0) {
-        GG_LOGE("Failed to send sd_notify (errno=%d).", -notify_ret);
-        return;
-    }
-
     GglRpcMethodDesc handlers[] = { { GG_STR("create_local_deployment"),
                                       false,
                                       create_local_deployment,
@@ -0,0 +1,306 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "component_fingerprint.h"
+#include <gg/arena.h>
+#include <gg/buffer.h>
+#include <gg/error.h>
+#include <gg/io.h>
+#include <gg/json_encode.h>
+#include <gg/log.h>
+#include <gg/map.h>
+#include <gg/object.h>
+#include <gg/types.h>
+#include <ggl/core_bus/gg_config.h>
+#include <ggl/digest.h>
+#include <ggl/nucleus/constants.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FINGERPRINT_HEX_LEN (COMPONENT_FINGERPRINT_DIGEST_LEN * 2)
+
+#define FINGERPRINT_KEY_PATH(component_name) \
+    GG_BUF_LIST( \
+        GG_STR("services"), \
+        GG_STR("DeploymentService"), \
+        GG_STR("componentFingerprints"), \
+        component_name \
+    )
+
+static GgError digest_write(void *ctx, GgBuffer buf) {
+    GglDigest *digest_context = ctx;
+    return ggl_digest_update(*digest_context, buf);
+}
+
+// Length-prefixed so adjacent fields cannot run into each other
+static GgError digest_field(GglDigest digest_context, GgBuffer field) {
+    uint8_t len_bytes[8];
+    uint64_t len = field.len;
+    for (size_t i = 0; i < sizeof(len_bytes); i++) {
+        len_bytes[i] = (uint8_t) (len >> (8 * i));
+    }
+    GgError ret = ggl_digest_update(digest_context, GG_BUF(len_bytes));
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    return ggl_digest_update(digest_context, field);
+}
+
+static GgError digest_object(GglDigest digest_context, GgObject obj) {
+    return gg_json_encode(
+        obj, (GgWriter) { .write = digest_write, .ctx = &digest_context }
+    );
+}
+
+static GgError digest_final(
+    GglDigest digest_context, uint8_t (*out)[COMPONENT_FINGERPRINT_DIGEST_LEN]
+) {
+    GgBuffer digest = GG_BUF(*out);
+    return ggl_digest_sha256_final(digest_context, &digest);
+}
+
+GgError component_fingerprint_recipe(
+    GglDigest digest_context,
+    GgBuffer version,
+    GgObject recipe,
+    ComponentFingerprint *fingerprint
+) {
+    GgError ret = ggl_digest_sha256_init(digest_context);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = digest_field(digest_context, version);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = digest_object(digest_context, recipe);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    return digest_final(digest_context, &fingerprint->recipe);
+}
+
+GgError component_fingerprint_component(
+    GglDigest digest_context,
+    GgBuffer component_name,
+    GgBuffer user,
+    GgBuffer group,
+    GgBuffer root_path,
+    GgBuffer recipe_runner_path,
+    ComponentFingerprint *fingerprint
+) {
+    static uint8_t config_mem[GGL_COMPONENT_RECIPE_MAX_LEN];
+    GgArena alloc = gg_arena_init(GG_BUF(config_mem));
+    GgObject config = GG_OBJ_NULL;
+    GgError ret = ggl_gg_config_read(
+        GG_BUF_LIST(
+            GG_STR("services"), component_name, GG_STR("configuration")
+        ),
+        &alloc,
+        &config
+    );
+    if ((ret != GG_ERR_OK) && (ret != GG_ERR_NOENTRY)) {
+        GG_LOGW(
+            "Failed to read configuration of %.*s for its fingerprint.",
+            (int) component_name.len,
+            component_name.data
+        );
+        return ret;
+    }
+
+    ret = ggl_digest_sha256_init(digest_context);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    GgBuffer fields[] = {
+        GG_BUF(fingerprint->recipe), user, group, root_path, recipe_runner_path,
+    };
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        ret = digest_field(digest_context, fields[i]);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    ret = digest_object(digest_context, config);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    return digest_final(digest_context, &fingerprint->component);
+}
+
+static GgError hex_to_digest(
+    GgBuffer hex, uint8_t (*digest)[COMPONENT_FINGERPRINT_DIGEST_LEN]
+) {
+    if (hex.len != FINGERPRINT_HEX_LEN) {
+        return GG_ERR_PARSE;
+    }
+    GgBuffer decoded = GG_BUF(*digest);
+    return ggl_digest_hex_decode(hex, &decoded);
+}
+
+GgError component_fingerprint_load(
+    GgBuffer component_name, ComponentFingerprint *fingerprint
+) {
+    uint8_t mem[256];
+    GgArena alloc = gg_arena_init(GG_BUF(mem));
+    GgObject obj;
+    GgError ret = ggl_gg_config_read(
+        FINGERPRINT_KEY_PATH(component_name), &alloc, &obj
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    if (gg_obj_type(obj) != GG_TYPE_MAP) {
+        return GG_ERR_PARSE;
+    }
+
+    GgObject *recipe_obj;
+    GgObject *component_obj;
+    ret = gg_map_validate(
+        gg_obj_into_map(obj),
+        GG_MAP_SCHEMA(
+            { GG_STR("recipe"), GG_REQUIRED, GG_TYPE_BUF, &recipe_obj },
+            { GG_STR("component"), GG_REQUIRED, GG_TYPE_BUF, &component_obj },
+        )
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    ret = hex_to_digest(gg_obj_into_buf(*recipe_obj), &fingerprint->recipe);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    return hex_to_digest(
+        gg_obj_into_buf(*component_obj), &fingerprint->component
+    );
+}
+
+GgError component_fingerprint_save(
+    GgBuffer component_name, const ComponentFingerprint *fingerprint
+) {
+    uint8_t recipe_hex_mem[FINGERPRINT_HEX_LEN];
+    uint8_t component_hex_mem[FINGERPRINT_HEX_LEN];
+    GgBuffer recipe_hex = GG_BUF(recipe_hex_mem);
+    GgBuffer component_hex = GG_BUF(component_hex_mem);
+    GgError ret
+        = ggl_digest_hex_encode(GG_BUF(fingerprint->recipe), &recipe_hex);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = ggl_digest_hex_encode(GG_BUF(fingerprint->component), &component_hex);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    ret = ggl_gg_config_write(
+        FINGERPRINT_KEY_PATH(component_name),
+        gg_obj_map(GG_MAP(
+            gg_kv(GG_STR("recipe"), gg_obj_buf(recipe_hex)),
+            gg_kv(GG_STR("component"), gg_obj_buf(component_hex))
+        )),
+        &(int64_t) { 0 }
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGW(
+            "Failed to save fingerprint of %.*s.",
+            (int) component_name.len,
+            component_name.data
+        );
+    }
+    return ret;
+}
+
+void component_fingerprint_delete(GgBuffer component_name) {
+    (void) ggl_gg_config_delete(FINGERPRINT_KEY_PATH(component_name));
+}
+
+bool component_fingerprint_recipe_changed(
+    const ComponentFingerprint *saved, const ComponentFingerprint *current
+) {
+    // Without a saved fingerprint, only the version is known to differ
+    if (saved == NULL) {
+        return false;
+    }
+    return (current == NULL)
+        || (memcmp(saved->recipe, current->recipe, sizeof(saved->recipe))
+            != 0);
+}
+
+bool component_fingerprint_unchanged(
+    const ComponentFingerprint *saved, const ComponentFingerprint *current
+) {
+    if ((saved == NULL) || (current == NULL)) {
+        return false;
+    }
+    return memcmp(
+               saved->component, current->component, sizeof(saved->component)
+           )
+        == 0;
+}
+
+#ifdef GG_SDK_TESTING
+
+#include <gg/test.h>
+#include <unity.h>
+
+GG_TEST_DEFINE(component_fingerprint_hex_round_trip) {
+    uint8_t digest[COMPONENT_FINGERPRINT_DIGEST_LEN] = { 0x00, 0x01, 0xAB };
+    digest[COMPONENT_FINGERPRINT_DIGEST_LEN - 1] = 0xFF;
+    uint8_t hex_mem[FINGERPRINT_HEX_LEN];
+    GgBuffer hex = GG_BUF(hex_mem);
+    GG_TEST_ASSERT_OK(ggl_digest_hex_encode(GG_BUF(digest), &hex));
+
+    uint8_t decoded[COMPONENT_FINGERPRINT_DIGEST_LEN];
+    GG_TEST_ASSERT_OK(hex_to_digest(hex, &decoded));
+    TEST_ASSERT_EQUAL_MEMORY(digest, decoded, sizeof(digest));
+
+    hex_mem[0] = 'g';
+    GG_TEST_ASSERT_BAD(hex_to_digest(hex, &decoded));
+    GG_TEST_ASSERT_BAD(hex_to_digest(GG_STR("00"), &decoded));
+}
+
+static ComponentFingerprint test_fingerprint(
+    uint8_t recipe, uint8_t component
+) {
+    ComponentFingerprint fingerprint = { 0 };
+    fingerprint.recipe[0] = recipe;
+    fingerprint.component[0] = component;
+    return fingerprint;
+}
+
+GG_TEST_DEFINE(component_fingerprint_unchanged_is_skipped) {
+    ComponentFingerprint saved = test_fingerprint(1, 2);
+    ComponentFingerprint current = test_fingerprint(1, 2);
+    TEST_ASSERT_FALSE(component_fingerprint_recipe_changed(&saved, &current));
+    TEST_ASSERT_TRUE(component_fingerprint_unchanged(&saved, &current));
+}
+
+GG_TEST_DEFINE(component_fingerprint_changed_is_redeployed) {
+    ComponentFingerprint saved = test_fingerprint(1, 2);
+
+    // Configuration or unit inputs changed
+    ComponentFingerprint current = test_fingerprint(1, 3);
+    TEST_ASSERT_FALSE(component_fingerprint_recipe_changed(&saved, &current));
+    TEST_ASSERT_FALSE(component_fingerprint_unchanged(&saved, &current));
+
+    // Recipe changed, so artifacts are fetched again
+    current = test_fingerprint(4, 5);
+    TEST_ASSERT_TRUE(component_fingerprint_recipe_changed(&saved, &current));
+    TEST_ASSERT_FALSE(component_fingerprint_unchanged(&saved, &current));
+
+    // Fingerprint could not be computed
+    TEST_ASSERT_TRUE(component_fingerprint_recipe_changed(&saved, NULL));
+    TEST_ASSERT_FALSE(component_fingerprint_unchanged(&saved, NULL));
+}
+
+GG_TEST_DEFINE(component_fingerprint_none_saved) {
+    ComponentFingerprint current = test_fingerprint(1, 2);
+    TEST_ASSERT_FALSE(component_fingerprint_recipe_changed(NULL, &current));
+    TEST_ASSERT_FALSE(component_fingerprint_unchanged(NULL, &current));
+}
+
+#endif
@@ -0,0 +1,74 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef GGDEPLOYMENTD_COMPONENT_FINGERPRINT_H
+#define GGDEPLOYMENTD_COMPONENT_FINGERPRINT_H
+
+#include <gg/error.h>
+#include <gg/types.h>
+#include <ggl/digest.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// A deployed component is described by its version and recipe (which lists
+// its artifact digests), its merged configuration, and the user and paths its
+// units are generated for. Digests of these are saved after each successful
+// deployment so that unchanged components can be left alone by the next one.
+
+#define COMPONENT_FINGERPRINT_DIGEST_LEN 32
+
+typedef struct {
+    /// Digest of the version and recipe.
+    uint8_t recipe[COMPONENT_FINGERPRINT_DIGEST_LEN];
+    /// Digest of the recipe digest, merged configuration, and unit inputs.
+    uint8_t component[COMPONENT_FINGERPRINT_DIGEST_LEN];
+} ComponentFingerprint;
+
+/// Computes the recipe part of a fingerprint.
+GgError component_fingerprint_recipe(
+    GglDigest digest_context,
+    GgBuffer version,
+    GgObject recipe,
+    ComponentFingerprint *fingerprint
+);
+
+/// Computes the component part of a fingerprint from the recipe part and the
+/// component's configuration as currently merged in ggconfigd.
+GgError component_fingerprint_component(
+    GglDigest digest_context,
+    GgBuffer component_name,
+    GgBuffer user,
+    GgBuffer group,
+    GgBuffer root_path,
+    GgBuffer recipe_runner_path,
+    ComponentFingerprint *fingerprint
+);
+
+/// Reads the fingerprint saved by the last successful deployment.
+/// Returns GG_ERR_NOENTRY if none was saved.
+GgError component_fingerprint_load(
+    GgBuffer component_name, ComponentFingerprint *fingerprint
+);
+
+GgError component_fingerprint_save(
+    GgBuffer component_name, const ComponentFingerprint *fingerprint
+);
+
+void component_fingerprint_delete(GgBuffer component_name);
+
+/// Whether a component's artifacts must be fetched again even though its
+/// version is unchanged. saved is NULL if no fingerprint was saved, and current
+/// is NULL if it could not be computed.
+bool component_fingerprint_recipe_changed(
+    const ComponentFingerprint *saved, const ComponentFingerprint *current
+);
+
+/// Whether a component is unchanged since the last successful deployment, so
+/// that it can be left untouched while it is running. Arguments are as for
+/// component_fingerprint_recipe_changed().
+bool component_fingerprint_unchanged(
+    const ComponentFingerprint *saved, const ComponentFingerprint *current
+);
+
+#endif
@@ -0,0 +1,278 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "component_index.h"
+#include "component_store.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <gg/arena.h>
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/file.h>
+#include <gg/log.h>
+#include <ggl/semver.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef COMPONENT_INDEX_MAX_RECIPES
+#define COMPONENT_INDEX_MAX_RECIPES 1024
+#endif
+
+// Power of two, at least twice the recipe limit to keep probe chains short
+#define COMPONENT_INDEX_TABLE_SIZE (2 * COMPONENT_INDEX_MAX_RECIPES)
+
+// Room for names and versions of all recipes
+#define COMPONENT_INDEX_POOL_SIZE (COMPONENT_INDEX_MAX_RECIPES * 128)
+
+typedef struct {
+    GgBuffer name;
+    GgBuffer version;
+    GglSemver semver;
+} IndexedRecipe;
+
+typedef struct {
+    GgBuffer name;
+    uint32_t first;
+    uint32_t count;
+} IndexedComponent;
+
+static IndexedRecipe recipes[COMPONENT_INDEX_MAX_RECIPES];
+static size_t recipe_count;
+static IndexedComponent components[COMPONENT_INDEX_TABLE_SIZE];
+static uint8_t pool_mem[COMPONENT_INDEX_POOL_SIZE];
+
+static bool index_valid = false;
+static struct stat indexed_dir;
+
+static size_t hash_name(GgBuffer name) {
+    // FNV-1a
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < name.len; i++) {
+        hash ^= name.data[i];
+        hash *= 16777619U;
+    }
+    return hash & (COMPONENT_INDEX_TABLE_SIZE - 1);
+}
+
+static int compare_names(GgBuffer a, GgBuffer b) {
+    size_t len = (a.len < b.len) ? a.len : b.len;
+    int cmp = (len == 0) ? 0 : memcmp(a.data, b.data, len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (a.len > b.len) - (a.len < b.len);
+}
+
+static int compare_recipes(const void *a, const void *b) {
+    const IndexedRecipe *lhs = a;
+    const IndexedRecipe *rhs = b;
+    int cmp = compare_names(lhs->name, rhs->name);
+    if (cmp == 0) {
+        cmp = ggl_semver_compare(&lhs->semver, &rhs->semver);
+    }
+    if (cmp == 0) {
+        // Versions differing only in build metadata
+        cmp = compare_names(lhs->version, rhs->version);
+    }
+    return cmp;
+}
+
+static GgError add_recipe(GgArena *pool, GgBuffer name, GgBuffer version) {
+    if (recipe_count == COMPONENT_INDEX_MAX_RECIPES) {
+        GG_LOGE("Too many recipes to index the local component store.");
+        return GG_ERR_NOMEM;
+    }
+    uint8_t *name_mem = GG_ARENA_ALLOCN(pool, uint8_t, name.len);
+    uint8_t *version_mem = GG_ARENA_ALLOCN(pool, uint8_t, version.len);
+    if ((name_mem == NULL) || (version_mem == NULL)) {
+        GG_LOGE("Insufficient memory to index the local component store.");
+        return GG_ERR_NOMEM;
+    }
+    memcpy(name_mem, name.data, name.len);
+    memcpy(version_mem, version.data, version.len);
+    IndexedRecipe *recipe = &recipes[recipe_count];
+    *recipe = (IndexedRecipe) {
+        .name = { .data = name_mem, .len = name.len },
+        .version = { .data = version_mem, .len = version.len },
+    };
+    if (ggl_semver_parse(recipe->version, &recipe->semver) != GG_ERR_OK) {
+        GG_LOGW(
+            "Skipping recipe for %.*s with invalid version %.*s.",
+            (int) name.len,
+            name.data,
+            (int) version.len,
+            version.data
+        );
+        return GG_ERR_OK;
+    }
+    recipe_count += 1;
+    return GG_ERR_OK;
+}
+
+static GgError read_recipe_dir(int recipe_dir_fd, GgArena *pool) {
+    // fdopendir takes ownership, so use a new descriptor
+    int dir_fd;
+    GgError ret
+        = gg_dir_openat(recipe_dir_fd, GG_STR("."), O_RDONLY, false, &dir_fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    DIR *dir = fdopendir(dir_fd);
+    if (dir == NULL) {
+        GG_LOGE("Failed to open recipe directory.");
+        (void) gg_close(dir_fd);
+        return GG_ERR_FAILURE;
+    }
+    GG_CLEANUP(cleanup_closedir, dir);
+
+    uint8_t name_mem[NAME_MAX];
+    uint8_t version_mem[NAME_MAX];
+    struct dirent *entry = NULL;
+    while (true) {
+        GgBuffer name = GG_BUF(name_mem);
+        GgBuffer version = GG_BUF(version_mem);
+        ret = iterate_over_components(dir, &name, &version, &entry);
+        if (ret == GG_ERR_NOENTRY) {
+            return GG_ERR_OK;
+        }
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        if ((name.len == 0) || (version.len == 0)) {
+            continue;
+        }
+        ret = add_recipe(pool, name, version);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+}
+
+static GgError build_index(int recipe_dir_fd) {
+    recipe_count = 0;
+    memset(components, 0, sizeof(components));
+    GgArena pool = gg_arena_init(GG_BUF(pool_mem));
+
+    GgError ret = read_recipe_dir(recipe_dir_fd, &pool);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    qsort(recipes, recipe_count, sizeof(recipes[0]), compare_recipes);
+
+    // Drop duplicates (a version stored with several extensions) and group
+    // each component's versions into one table entry.
+    size_t kept = 0;
+    for (size_t i = 0; i < recipe_count; i++) {
+        if ((kept > 0)
+            && (compare_recipes(&recipes[kept - 1], &recipes[i]) == 0)) {
+            continue;
+        }
+        recipes[kept] = recipes[i];
+        GgBuffer name = recipes[kept].name;
+        size_t slot = hash_name(name);
+        while ((components[slot].name.data != NULL)
+               && !gg_buffer_eq(components[slot].name, name)) {
+            slot = (slot + 1) & (COMPONENT_INDEX_TABLE_SIZE - 1);
+        }
+        if (components[slot].name.data == NULL) {
+            components[slot] = (IndexedComponent) {
+                .name = name,
+                .first = (uint32_t) kept,
+            };
+        }
+        components[slot].count += 1;
+        kept += 1;
+    }
+    recipe_count = kept;
+
+    GG_LOGD("Indexed %zu local component recipes.", recipe_count);
+    return GG_ERR_OK;
+}
+
+GgError component_index_refresh(int recipe_dir_fd) {
+    struct stat dir_info;
+    if (fstat(recipe_dir_fd, &dir_info) != 0) {
+        GG_LOGE("Failed to stat recipe directory.");
+        return GG_ERR_FAILURE;
+    }
+
+    if (index_valid && (dir_info.st_dev == indexed_dir.st_dev)
+        && (dir_info.st_ino == indexed_dir.st_ino)
+        && (dir_info.st_mtim.tv_sec == indexed_dir.st_mtim.tv_sec)
+        && (dir_info.st_mtim.tv_nsec == indexed_dir.st_mtim.tv_nsec)) {
+        return GG_ERR_OK;
+    }
+
+    index_valid = false;
+    GgError ret = build_index(recipe_dir_fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    indexed_dir = dir_info;
+    index_valid = true;
+    return GG_ERR_OK;
+}
+
+void component_index_invalidate(void) {
+    index_valid = false;
+}
+
+static const IndexedComponent *lookup_component(GgBuffer name) {
+    size_t slot = hash_name(name);
+    while (components[slot].name.data != NULL) {
+        if (gg_buffer_eq(components[slot].name, name)) {
+            return &components[slot];
+        }
+        slot = (slot + 1) & (COMPONENT_INDEX_TABLE_SIZE - 1);
+    }
+    return NULL;
+}
+
+GgError component_index_find(
+    GgBuffer component_name, const GglSemverRange *range, GgBuffer *version
+) {
+    if (!index_valid) {
+        return GG_ERR_FAILURE;
+    }
+    const IndexedComponent *component = lookup_component(component_name);
+    if (component == NULL) {
+        return GG_ERR_NOENTRY;
+    }
+    const IndexedRecipe *versions = &recipes[component->first];
+
+    // Binary search past versions above the range's upper bound, then check
+    // the rest from the highest down so the newest match wins.
+    size_t end = component->count;
+    GglSemver bound;
+    bool inclusive;
+    if (ggl_semver_range_upper_bound(range, &bound, &inclusive)) {
+        size_t low = 0;
+        size_t high = component->count;
+        while (low < high) {
+            size_t mid = low + ((high - low) / 2);
+            int cmp = ggl_semver_compare(&versions[mid].semver, &bound);
+            if ((cmp < 0) || (inclusive && (cmp == 0))) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        end = low;
+    }
+
+    for (size_t i = end; i > 0; i--) {
+        if (ggl_semver_range_matches(range, &versions[i - 1].semver)) {
+            *version = versions[i - 1].version;
+            return GG_ERR_OK;
+        }
+    }
+    return GG_ERR_NOENTRY;
+}
@@ -0,0 +1,29 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef GGDEPLOYMENTD_COMPONENT_INDEX_H
+#define GGDEPLOYMENTD_COMPONENT_INDEX_H
+
+#include <gg/error.h>
+#include <gg/types.h>
+#include <ggl/semver.h>
+
+// In-memory index of the recipes in the local component store, mapping each
+// component name to its stored versions in ascending order. The index is
+// rebuilt when the recipe directory changes. Not thread-safe.
+
+/// Rebuilds the index from the recipe directory if it was invalidated or the
+/// directory was modified since it was built.
+GgError component_index_refresh(int recipe_dir_fd);
+
+/// Forces a rebuild on next refresh; call after adding or removing recipes.
+void component_index_invalidate(void);
+
+/// Finds the highest indexed version of a component in range. version points
+/// into the index, which is valid until the next refresh.
+GgError component_index_find(
+    GgBuffer component_name, const GglSemverRange *range, GgBuffer *version
+);
+
+#endif
@@ -6,6 +6,7 @@
 #include "deployment_handler.h"
 #include <gg/arena.h>
 #include <gg/buffer.h>
+#include <gg/cleanup.h>
 #include <gg/error.h>
 #include <gg/flags.h>
 #include <gg/log.h>
@@ -14,6 +15,7 @@
 #include <gg/types.h>
 #include <gg/utils.h>
 #include <ggl/core_bus/client.h>
+#include <ggl/core_bus/gg_config.h>
 #include <ggl/core_bus/gg_healthd.h>
 #include <inttypes.h>
 #include <pthread.h>
@@ -21,6 +23,8 @@
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
 // Seconds to wait before (re)attempting a subscription, and the poll interval
 // used to notice that the subscription dropped.
 #define RESUBSCRIBE_BACKOFF_SECONDS 5
@@ -29,6 +33,19 @@
 // and observed by the supervisor thread to trigger a re-subscribe.
 static atomic_bool subscription_closed;
 
+// Default time to collect state changes into one fleet status update, used if
+// fleetStatus/componentStatusDebounceMs is not configured.
+#define DEFAULT_DEBOUNCE_MS 1000
+
+// Max configurable debounce window.
+#define MAX_DEBOUNCE_MS 60000
+
+// State changes seen since the last forward. Set by on_state_change and
+// consumed by the forwarder thread.
+static pthread_mutex_t pending_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pending_cond = PTHREAD_COND_INITIALIZER;
+static size_t pending_changes = 0;
+
 // Forwards a component status change to the fleet status service. FSS gathers
 // the full component list itself; we only need to trigger a PARTIAL update.
 static void forward_to_fleet_status(void) {
@@ -101,16 +118,116 @@ static GgError on_state_change(void *ctx, uint32_t handle, GgObject data) {
     }
 
     GG_LOGD(
-        "Forwarding component state change to fleet status service: %.*s -> %.*s.",
+        "Queueing component state change for fleet status service: %.*s -> %.*s.",
         (int) component_name.len,
         component_name.data,
         (int) status.len,
         status.data
     );
-    forward_to_fleet_status();
+    {
+        GG_MTX_SCOPE_GUARD(&pending_mtx);
+        pending_changes += 1;
+        pthread_cond_signal(&pending_cond);
+    }
     return GG_ERR_OK;
 }
 
+static int64_t get_debounce_ms(void) {
+    uint8_t config_mem[32] = { 0 };
+    GgArena alloc = gg_arena_init(GG_BUF(config_mem));
+    GgObject debounce_obj;
+    GgError ret = ggl_gg_config_read(
+        GG_BUF_LIST(
+            GG_STR("services"),
+            GG_STR("aws.greengrass.NucleusLite"),
+            GG_STR("configuration"),
+            GG_STR("fleetStatus"),
+            GG_STR("componentStatusDebounceMs")
+        ),
+        &alloc,
+        &debounce_obj
+    );
+    if (ret != GG_ERR_OK) {
+        return DEFAULT_DEBOUNCE_MS;
+    }
+
+    int64_t debounce_ms = -1;
+    if (gg_obj_type(debounce_obj) == GG_TYPE_I64) {
+        debounce_ms = gg_obj_into_i64(debounce_obj);
+    } else if (gg_obj_type(debounce_obj) == GG_TYPE_BUF) {
+        if (gg_str_to_int64(gg_obj_into_buf(debounce_obj), &debounce_ms)
+            != GG_ERR_OK) {
+            debounce_ms = -1;
+        }
+    }
+    if ((debounce_ms < 0) || (debounce_ms > MAX_DEBOUNCE_MS)) {
+        GG_LOGW(
+            "Invalid componentStatusDebounceMs; using %d ms.",
+            DEFAULT_DEBOUNCE_MS
+        );
+        return DEFAULT_DEBOUNCE_MS;
+    }
+    return debounce_ms;
+}
+
+// Waits for a state change, then collects further changes for the debounce
+// window so that a burst (boot, deployment) results in one fleet status update.
+// The window is read from config for each burst, so changes apply without a
+// restart.
+static void *forwarder_thread(void *ctx) {
+    (void) ctx;
+
+    int64_t prev_debounce_ms = -1;
+
+    while (true) {
+        {
+            GG_MTX_SCOPE_GUARD(&pending_mtx);
+            while (pending_changes == 0) {
+                pthread_cond_wait(&pending_cond, &pending_mtx);
+            }
+        }
+
+        int64_t debounce_ms = get_debounce_ms();
+        if (debounce_ms != prev_debounce_ms) {
+            GG_LOGD(
+                "Forwarding component state changes every %" PRId64
+                " ms at most.",
+                debounce_ms
+            );
+            prev_debounce_ms = debounce_ms;
+        }
+
+        if (debounce_ms > 0) {
+            (void) gg_sleep_ms(debounce_ms);
+        }
+
+        size_t changes;
+        {
+            GG_MTX_SCOPE_GUARD(&pending_mtx);
+            changes = pending_changes;
+            pending_changes = 0;
+        }
+
+        // A deployment may have started during the window; it sends its own
+        // status update when done.
+        if (ggl_deployment_in_progress()) {
+            GG_LOGD(
+                "Deployment in progress; not forwarding %zu state changes.",
+                changes
+            );
+            continue;
+        }
+
+        GG_LOGD(
+            "Forwarding %zu component state changes to fleet status service.",
+            changes
+        );
+        forward_to_fleet_status();
+    }
+
+    return NULL;
+}
+
 static void on_close(void *ctx, uint32_t handle) {
     (void) ctx;
     (void) handle;
@@ -159,8 +276,19 @@ static void *listener_thread(void *ctx) {
 }
 
 void ggl_start_component_status_listener(void) {
+    pthread_t forwarder_ptid;
+    int sys_ret
+        = pthread_create(&forwarder_ptid, NULL, forwarder_thread, NULL);
+    if (sys_ret != 0) {
+        GG_LOGE(
+            "Failed to start component status forwarder thread: %d.", sys_ret
+        );
+        return;
+    }
+    pthread_detach(forwarder_ptid);
+
     pthread_t ptid;
-    int sys_ret = pthread_create(&ptid, NULL, listener_thread, NULL);
+    sys_ret = pthread_create(&ptid, NULL, listener_thread, NULL);
     if (sys_ret != 0) {
         GG_LOGE(
             "Failed to start component status listener thread: %d.", sys_ret
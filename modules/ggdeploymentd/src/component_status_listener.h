@@ -9,6 +9,8 @@
 /// lifecycle state changes and forwards them to the fleet status service (as a
 /// COMPONENT_STATUS_CHANGE trigger) whenever no deployment is in progress. The
 /// supervisor re-subscribes if the subscription drops (e.g. gghealthd restart).
+/// Changes are collected for fleetStatus/componentStatusDebounceMs (default
+/// 1000) before forwarding, so a burst of changes sends one update.
 void ggl_start_component_status_listener(void);
 
 #endif
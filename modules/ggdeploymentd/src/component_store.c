@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "component_store.h"
+#include "component_index.h"
 #include <assert.h>
 #include <dirent.h>
 #include <fcntl.h>
@@ -43,19 +44,27 @@ static GgError update_root_path(void) {
     return GG_ERR_OK;
 }
 
-GgError get_recipe_dir_fd(int *recipe_fd) {
+GgError get_root_path_fd(int *root_path_fd) {
     GgError ret = update_root_path();
     if (ret != GG_ERR_OK) {
         GG_LOGE("Failed to retrieve root path.");
         return GG_ERR_FAILURE;
     }
 
-    int root_path_fd;
-    ret = gg_dir_open(root_path, O_PATH, false, &root_path_fd);
+    ret = gg_dir_open(root_path, O_PATH, false, root_path_fd);
     if (ret != GG_ERR_OK) {
         GG_LOGE("Failed to open root_path.");
         return GG_ERR_FAILURE;
     }
+    return GG_ERR_OK;
+}
+
+GgError get_recipe_dir_fd(int *recipe_fd) {
+    int root_path_fd;
+    GgError ret = get_root_path_fd(&root_path_fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
     GG_CLEANUP(cleanup_close, root_path_fd);
 
     int recipe_dir_fd;
@@ -146,20 +155,12 @@ GgError iterate_over_components(
     return GG_ERR_NOENTRY;
 }
 
-GgError find_available_component(
-    GgBuffer component_name, GgBuffer requirement, GgBuffer *version
+static GgError scan_for_component(
+    int recipe_dir_fd,
+    GgBuffer component_name,
+    const GglSemverRange *range,
+    GgBuffer *version
 ) {
-    GG_LOGT(
-        "Searching for component %.*s",
-        (int) component_name.len,
-        component_name.data
-    );
-    int recipe_dir_fd;
-    GgError ret = get_recipe_dir_fd(&recipe_dir_fd);
-    if (ret != GG_ERR_OK) {
-        return ret;
-    }
-
     // iterate through recipes in the directory
     DIR *dir = fdopendir(recipe_dir_fd);
     if (dir == NULL) {
@@ -176,26 +177,94 @@ GgError find_available_component(
     uint8_t version_array[NAME_MAX];
     GgBuffer version_buffer = { .data = version_array, .len = 0 };
 
-    do {
-        ret = iterate_over_components(
+    // Keep the highest matching version seen
+    bool found = false;
+    GglSemver best = { 0 };
+    uint8_t best_array[NAME_MAX];
+    GgBuffer best_version = { .data = best_array, .len = 0 };
+
+    while (true) {
+        GgError ret = iterate_over_components(
             dir, &component_name_buffer, &version_buffer, &entry
         );
-
+        if (ret == GG_ERR_NOENTRY) {
+            break;
+        }
         if (ret != GG_ERR_OK) {
             return ret;
         }
 
         assert(entry != NULL);
 
-        if (gg_buffer_eq(component_name, component_name_buffer)
-            && is_in_range(version_buffer, requirement)) {
-            assert(version_buffer.len <= NAME_MAX);
-            memcpy(version->data, version_buffer.data, version_buffer.len);
-            version->len = version_buffer.len;
-            return GG_ERR_OK;
+        GglSemver candidate;
+        if (!gg_buffer_eq(component_name, component_name_buffer)
+            || (ggl_semver_parse(version_buffer, &candidate) != GG_ERR_OK)
+            || !ggl_semver_range_matches(range, &candidate)) {
+            continue;
         }
-    } while (true);
+        if (found && (ggl_semver_compare(&candidate, &best) <= 0)) {
+            continue;
+        }
+        memcpy(best_array, version_buffer.data, version_buffer.len);
+        best_version.len = version_buffer.len;
+        // Re-parse so the pre-release refers to the saved copy
+        (void) ggl_semver_parse(best_version, &best);
+        found = true;
+    }
 
-    // component meeting version requirements not found
-    return GG_ERR_NOENTRY;
+    if (!found) {
+        // component meeting version requirements not found
+        return GG_ERR_NOENTRY;
+    }
+    assert(best_version.len <= NAME_MAX);
+    memcpy(version->data, best_version.data, best_version.len);
+    version->len = best_version.len;
+    return GG_ERR_OK;
+}
+
+GgError find_available_component(
+    GgBuffer component_name, GgBuffer requirement, GgBuffer *version
+) {
+    GG_LOGT(
+        "Searching for component %.*s",
+        (int) component_name.len,
+        component_name.data
+    );
+    static GglSemverRange range;
+    GgError ret = ggl_semver_range_compile(requirement, &range);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE(
+            "Invalid version requirement %.*s for component %.*s.",
+            (int) requirement.len,
+            requirement.data,
+            (int) component_name.len,
+            component_name.data
+        );
+        return ret;
+    }
+
+    int recipe_dir_fd;
+    ret = get_recipe_dir_fd(&recipe_dir_fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    ret = component_index_refresh(recipe_dir_fd);
+    if (ret != GG_ERR_OK) {
+        GG_LOGW("Failed to index local recipes, falling back to a scan.");
+        return scan_for_component(
+            recipe_dir_fd, component_name, &range, version
+        );
+    }
+    (void) gg_close(recipe_dir_fd);
+
+    GgBuffer found;
+    ret = component_index_find(component_name, &range, &found);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    assert(found.len <= NAME_MAX);
+    memcpy(version->data, found.data, found.len);
+    version->len = found.len;
+    return GG_ERR_OK;
 }
@@ -9,6 +9,8 @@
 #include <gg/error.h>
 #include <gg/types.h>
 
+GgError get_root_path_fd(int *root_path_fd);
+
 GgError get_recipe_dir_fd(int *recipe_fd);
 
 GgError iterate_over_components(
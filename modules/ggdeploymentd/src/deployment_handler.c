@@ -5,8 +5,11 @@
 #include "deployment_handler.h"
 #include "access_control_validation.h"
 #include "artifact_permission.h"
+#include "artifact_store.h"
 #include "bootstrap_manager.h"
 #include "component_config.h"
+#include "component_fingerprint.h"
+#include "component_index.h"
 #include "component_manager.h"
 #include "credential_endpoint_validation.h"
 #include "deployment_model.h"
@@ -15,6 +18,7 @@
 #include "iotcored_instance.h"
 #include "priv_io.h"
 #include "stale_component.h"
+#include "systemd_units.h"
 #include <assert.h>
 #include <dirent.h>
 #include <errno.h>
@@ -66,6 +70,10 @@
 #define DEPLOYMENT_TARGET_NAME_MAX_CHARS 128
 #define MAX_DEPLOYMENT_TARGETS 100
 #define MQTT_CONNECTIVITY_CHECK_TIMEOUT_SECONDS 60
+#define MAX_COMPONENTS_TO_RESOLVE 64
+#define MAX_PENDING_COMPONENTS 64
+// Components per ResolveComponentCandidates request
+#define RESOLVE_CANDIDATES_BATCH_MAX 8
 
 static struct DeploymentConfiguration {
     char data_endpoint[128];
@@ -210,6 +218,36 @@ static GgError get_posix_user(char **posix_user) {
     return GG_ERR_OK;
 }
 
+// Copies posixUser ("user" or "user:group") into mem and splits it. The group
+// defaults to the user.
+static GgError get_run_as_user_group(
+    GgBuffer mem, char **user, char **group
+) {
+    char *posix_user = NULL;
+    GgError ret = get_posix_user(&posix_user);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    size_t len = strlen(posix_user);
+    if (len < 1) {
+        GG_LOGE("Run with default posix user is not set.");
+        return GG_ERR_INVALID;
+    }
+    if (len >= mem.len) {
+        return GG_ERR_NOMEM;
+    }
+    memcpy(mem.data, posix_user, len + 1);
+
+    *user = (char *) mem.data;
+    *group = *user;
+    char *colon = strchr(*user, ':');
+    if (colon != NULL) {
+        *colon = '\0';
+        *group = &colon[1];
+    }
+    return GG_ERR_OK;
+}
+
 static GgError get_data_endpoint(GgByteVec *endpoint) {
     GgMap params = GG_MAP(gg_kv(
         GG_STR("key_path"),
@@ -426,10 +464,8 @@ typedef struct {
     GgBuffer host;
     GgBuffer file_path;
     SigV4Details sigv4_details;
-
-    // reset response_data for next attempt
-    GgError (*retry_cleanup_fn)(void *);
-    void *response_data;
+    int artifact_fd;
+    GglDownloadResume *resume;
 
     // Needed to propagate errors when retrying is impossible.
     GgError err;
@@ -443,20 +479,17 @@ static GgError retry_download_wrapper(void *ctx) {
         retry_ctx->url_for_sigv4_download,
         retry_ctx->host,
         retry_ctx->file_path,
-        *(int *) retry_ctx->response_data,
+        retry_ctx->artifact_fd,
+        retry_ctx->resume,
         retry_ctx->sigv4_details,
         &http_response_code
     );
     if (http_response_code == (uint16_t) 403) {
-        GgError err = retry_ctx->retry_cleanup_fn(retry_ctx->response_data);
+        // Content received so far is kept; the next attempt resumes from it.
         GG_LOGE(
             "Artifact download attempt failed with HTTP %d. Retrying with backoff.",
             http_response_code
         );
-        if (err != GG_ERR_OK) {
-            retry_ctx->err = err;
-            return GG_ERR_OK;
-        }
         return GG_ERR_FAILURE;
     }
     if (ret != GG_ERR_OK) {
@@ -469,32 +502,12 @@ static GgError retry_download_wrapper(void *ctx) {
     return GG_ERR_OK;
 }
 
-// TODO: Consider refactoring to close and reopen the file instead of
-// truncating in place.
-static GgError truncate_s3_file_on_failure(void *response_data) {
-    int fd = *(int *) response_data;
-
-    int ret;
-    do {
-        ret = ftruncate(fd, 0);
-    } while ((ret == -1) && (errno == EINTR));
-
-    if (ret == -1) {
-        GG_LOGE("Failed to truncate fd for write (errno=%d).", errno);
-        return GG_ERR_FAILURE;
-    }
-    if (lseek(fd, 0, SEEK_SET) == -1) {
-        GG_LOGE("Failed to seek fd to beginning (errno=%d).", errno);
-        return GG_ERR_FAILURE;
-    }
-    return GG_ERR_OK;
-}
-
 static GgError retryable_download_request(
     const char *url_for_sigv4_download,
     GgBuffer host,
     GgBuffer file_path,
     int artifact_fd,
+    GglDownloadResume *resume,
     SigV4Details sigv4_details
 ) {
     DownloadRequestRetryCtx ctx
@@ -502,8 +515,8 @@ static GgError retryable_download_request(
             .host = host,
             .file_path = file_path,
             .sigv4_details = sigv4_details,
-            .response_data = (void *) &artifact_fd,
-            .retry_cleanup_fn = truncate_s3_file_on_failure,
+            .artifact_fd = artifact_fd,
+            .resume = resume,
             .err = GG_ERR_OK };
 
     GgError ret
@@ -522,7 +535,8 @@ static GgError download_s3_artifact(
     GgBuffer scratch_buffer,
     GglUriInfo uri_info,
     TesCredentials credentials,
-    int artifact_fd
+    int artifact_fd,
+    GglDownloadResume *resume
 ) {
     GgByteVec url_vec = gg_byte_vec_init(scratch_buffer);
     GgError error = GG_ERR_OK;
@@ -550,6 +564,7 @@ static GgError download_s3_artifact(
         (GgBuffer) { .data = &scratch_buffer.data[end_loc],
                      .len = file_name_end - end_loc },
         artifact_fd,
+        resume,
         sigv4_from_tes(credentials, GG_STR("s3"))
     );
 }
@@ -559,7 +574,8 @@ static GgError download_greengrass_artifact(
     GgBuffer component_arn,
     GgBuffer uri_path,
     CertificateDetails credentials,
-    int artifact_fd
+    int artifact_fd,
+    GglDownloadResume *resume
 ) {
     // For holding a presigned S3 URL
     static uint8_t response_data[2000];
@@ -623,7 +639,9 @@ static GgError download_greengrass_artifact(
 
     GG_LOGI("Getting presigned S3 URL artifact");
 
-    return generic_download((const char *) (presigned_url.data), artifact_fd);
+    return generic_download(
+        (const char *) (presigned_url.data), artifact_fd, resume
+    );
 }
 
 // Get the unarchive type: NONE or ZIP
@@ -708,6 +726,233 @@ static void recursive_chown(int dir_fd, uid_t uid, gid_t gid) {
     closedir(dir);
 }
 
+// Artifacts are downloaded to <name>.part, with the entity tag of the partial
+// content in <name>.part.etag, and renamed once complete. Partial downloads
+// persist across restarts and are resumed by the next attempt.
+typedef struct {
+    int dir_fd;
+    char partial_name[PATH_MAX];
+    char etag_name[PATH_MAX];
+} PartialArtifact;
+
+static GgError partial_artifact_init(
+    int dir_fd, GgBuffer file, PartialArtifact *partial
+) {
+    partial->dir_fd = dir_fd;
+    int len = snprintf(
+        partial->partial_name,
+        sizeof(partial->partial_name),
+        "%.*s.part",
+        (int) file.len,
+        file.data
+    );
+    if ((len < 0) || ((size_t) len >= sizeof(partial->partial_name))) {
+        return GG_ERR_NOMEM;
+    }
+    len = snprintf(
+        partial->etag_name,
+        sizeof(partial->etag_name),
+        "%.*s.part.etag",
+        (int) file.len,
+        file.data
+    );
+    if ((len < 0) || ((size_t) len >= sizeof(partial->etag_name))) {
+        return GG_ERR_NOMEM;
+    }
+    return GG_ERR_OK;
+}
+
+static void persist_partial_artifact_etag(void *ctx, GgBuffer etag) {
+    PartialArtifact *partial = (PartialArtifact *) ctx;
+    if (etag.len == 0) {
+        if ((unlinkat(partial->dir_fd, partial->etag_name, 0) != 0)
+            && (errno != ENOENT)) {
+            GG_LOGW(
+                "Failed to remove %s (errno=%d).", partial->etag_name, errno
+            );
+        }
+        return;
+    }
+
+    int etag_fd = -1;
+    GgError ret = gg_file_openat(
+        partial->dir_fd,
+        gg_buffer_from_null_term(partial->etag_name),
+        O_CREAT | O_WRONLY | O_TRUNC,
+        0644,
+        &etag_fd
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGW("Failed to open %s for write.", partial->etag_name);
+        return;
+    }
+    GG_CLEANUP(cleanup_close, etag_fd);
+    ret = gg_file_write(etag_fd, etag);
+    if (ret == GG_ERR_OK) {
+        ret = gg_fsync(etag_fd);
+    }
+    if (ret != GG_ERR_OK) {
+        GG_LOGW("Failed to persist %s.", partial->etag_name);
+    }
+}
+
+static void partial_artifact_remove(PartialArtifact *partial) {
+    (void) unlinkat(partial->dir_fd, partial->partial_name, 0);
+    (void) unlinkat(partial->dir_fd, partial->etag_name, 0);
+}
+
+// Loads the resume state for a partial artifact, adding its existing content
+// to the digest. The fd offset is left at the end of the existing content.
+static GgError partial_artifact_load(
+    PartialArtifact *partial, int partial_fd, GglDownloadResume *resume
+) {
+    if (resume->digest.ctx != NULL) {
+        GgError ret = ggl_digest_sha256_init(resume->digest);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+
+    off_t size = lseek(partial_fd, 0, SEEK_END);
+    if (size == -1) {
+        GG_LOGE("Failed to seek partial artifact (errno=%d).", errno);
+        return GG_ERR_FAILURE;
+    }
+    if (size == 0) {
+        return GG_ERR_OK;
+    }
+
+    GgBuffer etag = gg_byte_vec_remaining_capacity(resume->etag);
+    GgError ret = gg_file_read_path_at(
+        partial->dir_fd, gg_buffer_from_null_term(partial->etag_name), &etag
+    );
+    if ((ret != GG_ERR_OK) || (etag.len == 0)) {
+        // Download restarts from the beginning without a validator.
+        return GG_ERR_OK;
+    }
+    resume->etag.buf.len = etag.len;
+
+    GG_LOGI(
+        "Found %lld bytes of partially downloaded %s.",
+        (long long) size,
+        partial->partial_name
+    );
+    if (resume->digest.ctx != NULL) {
+        return ggl_digest_update_from_fd(resume->digest, partial_fd, size);
+    }
+    return GG_ERR_OK;
+}
+
+// Downloads an artifact into component_store_fd, resuming any partial download
+// of it, and verifies its SHA-256 digest if expected_digest is not NULL.
+static GgError download_artifact(
+    GgBuffer scratch_buffer,
+    GgBuffer component_arn,
+    TesCredentials tes_creds,
+    CertificateDetails iot_creds,
+    GglUriInfo info,
+    int component_store_fd,
+    mode_t file_mode,
+    const GgBuffer *expected_digest,
+    GglDigest digest_context
+) {
+    PartialArtifact partial;
+    GgError err
+        = partial_artifact_init(component_store_fd, info.file, &partial);
+    if (err != GG_ERR_OK) {
+        GG_LOGE("Artifact file name too long.");
+        return err;
+    }
+
+    int artifact_fd = -1;
+    err = gg_file_openat(
+        component_store_fd,
+        gg_buffer_from_null_term(partial.partial_name),
+        O_CREAT | O_RDWR,
+        file_mode,
+        &artifact_fd
+    );
+    if (err != GG_ERR_OK) {
+        GG_LOGE("Failed to create artifact file for write.");
+        return err;
+    }
+    GG_CLEANUP(cleanup_close, artifact_fd);
+
+    uint8_t etag_mem[256];
+    GglDownloadResume resume
+        = { .etag = GG_BYTE_VEC(etag_mem),
+            .digest = (expected_digest != NULL) ? digest_context
+                                                : (GglDigest) { 0 },
+            .etag_changed = persist_partial_artifact_etag,
+            .etag_changed_ctx = &partial };
+    err = partial_artifact_load(&partial, artifact_fd, &resume);
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+
+    if (gg_buffer_eq(GG_STR("s3"), info.scheme)) {
+        err = download_s3_artifact(
+            scratch_buffer, info, tes_creds, artifact_fd, &resume
+        );
+    } else if (gg_buffer_eq(GG_STR("greengrass"), info.scheme)) {
+        err = download_greengrass_artifact(
+            scratch_buffer,
+            component_arn,
+            info.path,
+            iot_creds,
+            artifact_fd,
+            &resume
+        );
+    } else {
+        GG_LOGE("Unknown artifact URI scheme");
+        err = GG_ERR_PARSE;
+    }
+
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+
+    err = gg_fsync(artifact_fd);
+    if (err != GG_ERR_OK) {
+        GG_LOGE("Artifact fsync failed.");
+        return err;
+    }
+
+    // verify SHA256 digest, streamed while downloading
+    if (expected_digest != NULL) {
+        GG_LOGD("Verifying artifact digest");
+        err = ggl_digest_sha256_verify(digest_context, *expected_digest);
+        if (err != GG_ERR_OK) {
+            partial_artifact_remove(&partial);
+            return err;
+        }
+    }
+
+    char artifact_name[PATH_MAX];
+    snprintf(
+        artifact_name,
+        sizeof(artifact_name),
+        "%.*s",
+        (int) info.file.len,
+        (char *) info.file.data
+    );
+    if (renameat(
+            component_store_fd,
+            partial.partial_name,
+            component_store_fd,
+            artifact_name
+        )
+        != 0) {
+        GG_LOGE(
+            "Failed to move downloaded artifact into place (errno=%d).", errno
+        );
+        return GG_ERR_FAILURE;
+    }
+    (void) unlinkat(component_store_fd, partial.etag_name, 0);
+
+    return GG_ERR_OK;
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 static GgError get_recipe_artifacts(
     GgBuffer component_arn,
@@ -716,6 +961,7 @@ static GgError get_recipe_artifacts(
     GgMap recipe,
     int component_store_fd,
     int component_archive_store_fd,
+    int artifact_store_fd,
     GglDigest digest_context
 ) {
     GgList artifacts = { 0 };
@@ -889,56 +1135,78 @@ static GgError get_recipe_artifacts(
             mode
                 = artifact_permission_to_mode(gg_obj_into_map(*permission_obj));
         }
-        int artifact_fd = -1;
-        err = gg_file_openat(
-            component_store_fd,
-            info.file,
-            O_CREAT | O_WRONLY | O_TRUNC,
-            needs_unarchive ? 0644 : mode,
-            &artifact_fd
-        );
-        if (err != GG_ERR_OK) {
-            GG_LOGE("Failed to create artifact file for write.");
-            return err;
+        uid_t store_uid = chown_artifacts ? chown_uid : (uid_t) -1;
+        gid_t store_gid = chown_artifacts ? chown_gid : (gid_t) -1;
+        mode_t file_mode = needs_unarchive ? 0644 : mode;
+        bool from_store = false;
+        if (needs_verification) {
+            err = artifact_store_checkout(
+                artifact_store_fd,
+                expected_digest,
+                component_store_fd,
+                info.file,
+                file_mode,
+                store_uid,
+                store_gid
+            );
+            if (err == GG_ERR_OK) {
+                GG_LOGI(
+                    "Artifact %.*s found in artifact store; skipping download.",
+                    (int) info.file.len,
+                    info.file.data
+                );
+                from_store = true;
+            } else if (err != GG_ERR_NOENTRY) {
+                GG_LOGW("Failed to use artifact store; downloading artifact.");
+            }
         }
-        GG_CLEANUP(cleanup_close, artifact_fd);
 
-        if (gg_buffer_eq(GG_STR("s3"), info.scheme)) {
-            err = download_s3_artifact(
-                GG_BUF(decode_buffer), info, tes_creds, artifact_fd
-            );
-        } else if (gg_buffer_eq(GG_STR("greengrass"), info.scheme)) {
-            err = download_greengrass_artifact(
+        if (!from_store) {
+            err = download_artifact(
                 GG_BUF(decode_buffer),
                 component_arn,
-                info.path,
+                tes_creds,
                 iot_creds,
-                artifact_fd
-            );
-        } else {
-            GG_LOGE("Unknown artifact URI scheme");
-            err = GG_ERR_PARSE;
-        }
-
-        if (err != GG_ERR_OK) {
-            return err;
-        }
-
-        err = gg_fsync(artifact_fd);
-        if (err != GG_ERR_OK) {
-            GG_LOGE("Artifact fsync failed.");
-            return err;
-        }
-
-        // verify SHA256 digest
-        if (needs_verification) {
-            GG_LOGD("Verifying artifact digest");
-            err = ggl_verify_sha256_digest(
-                component_store_fd, info.file, expected_digest, digest_context
+                info,
+                component_store_fd,
+                file_mode,
+                needs_verification ? &expected_digest : NULL,
+                digest_context
             );
             if (err != GG_ERR_OK) {
                 return err;
             }
+            // Change ownership of artifact to posixUser:ggcore. This must
+            // happen before the artifact is shared through the store; stored
+            // artifacts are checked out with the requested owner.
+            if (chown_artifacts) {
+                char artifact_name[PATH_MAX];
+                snprintf(
+                    artifact_name,
+                    sizeof(artifact_name),
+                    "%.*s",
+                    (int) info.file.len,
+                    (char *) info.file.data
+                );
+                if (fchownat(
+                        component_store_fd,
+                        artifact_name,
+                        chown_uid,
+                        chown_gid,
+                        AT_SYMLINK_NOFOLLOW
+                    )
+                    != 0) {
+                    GG_LOGW("Failed to chown artifact %s", artifact_name);
+                }
+            }
+            if (needs_verification) {
+                (void) artifact_store_add(
+                    artifact_store_fd,
+                    expected_digest,
+                    component_store_fd,
+                    info.file
+                );
+            }
         }
 
         // Unarchive the ZIP file if needed
@@ -951,60 +1219,40 @@ static GgError get_recipe_artifacts(
             }
         }
 
-        // Change ownership of artifact to posixUser:ggcore
-        if (chown_artifacts) {
+        // Change ownership of unarchived artifacts to posixUser:ggcore
+        if (chown_artifacts && needs_unarchive) {
             char artifact_name[PATH_MAX];
+            GgBuffer dest = info.file;
+            if (gg_buffer_has_suffix(info.file, GG_STR(".zip"))) {
+                dest = gg_buffer_substr(
+                    info.file, 0, info.file.len - (sizeof(".zip") - 1U)
+                );
+            }
             snprintf(
                 artifact_name,
                 sizeof(artifact_name),
                 "%.*s",
-                (int) info.file.len,
-                (char *) info.file.data
+                (int) dest.len,
+                (char *) dest.data
             );
             if (fchownat(
-                    component_store_fd,
+                    component_archive_store_fd,
                     artifact_name,
                     chown_uid,
                     chown_gid,
                     AT_SYMLINK_NOFOLLOW
                 )
                 != 0) {
-                GG_LOGW("Failed to chown artifact %s", artifact_name);
+                GG_LOGW("Failed to chown unarchived dir %s", artifact_name);
             }
-
-            if (needs_unarchive) {
-                GgBuffer dest = info.file;
-                if (gg_buffer_has_suffix(info.file, GG_STR(".zip"))) {
-                    dest = gg_buffer_substr(
-                        info.file, 0, info.file.len - (sizeof(".zip") - 1U)
-                    );
-                }
-                snprintf(
-                    artifact_name,
-                    sizeof(artifact_name),
-                    "%.*s",
-                    (int) dest.len,
-                    (char *) dest.data
-                );
-                if (fchownat(
-                        component_archive_store_fd,
-                        artifact_name,
-                        chown_uid,
-                        chown_gid,
-                        AT_SYMLINK_NOFOLLOW
-                    )
-                    != 0) {
-                    GG_LOGW("Failed to chown unarchived dir %s", artifact_name);
-                }
-                int sub_fd = openat(
-                    component_archive_store_fd,
-                    artifact_name,
-                    O_RDONLY | O_DIRECTORY | O_CLOEXEC
-                );
-                if (sub_fd >= 0) {
-                    recursive_chown(sub_fd, chown_uid, chown_gid);
-                    close(sub_fd);
-                }
+            int sub_fd = openat(
+                component_archive_store_fd,
+                artifact_name,
+                O_RDONLY | O_DIRECTORY | O_CLOEXEC
+            );
+            if (sub_fd >= 0) {
+                recursive_chown(sub_fd, chown_uid, chown_gid);
+                close(sub_fd);
             }
         }
     }
@@ -1107,11 +1355,9 @@ static GgError get_device_thing_groups(GgBuffer *response) {
 }
 
 static GgError generate_resolve_component_candidates_body(
-    GgBuffer component_name,
-    GgBuffer component_requirements,
-    GgByteVec *body_vec,
-    GgArena *alloc
+    GgMap components, GgByteVec *body_vec, GgArena *alloc
 ) {
+    assert(components.len <= RESOLVE_CANDIDATES_BATCH_MAX);
     GgObject architecture_detail_read_value;
     GgError ret = ggl_gg_config_read(
         GG_BUF_LIST(
@@ -1165,18 +1411,24 @@ static GgError generate_resolve_component_candidates_body(
         gg_kv(GG_STR("attributes"), gg_obj_map(platform_attributes))
     );
 
-    GgMap version_requirements_map = GG_MAP(
-        gg_kv(GG_STR("requirements"), gg_obj_buf(component_requirements))
-    );
-
-    GgMap component_map = GG_MAP(
-        gg_kv(GG_STR("componentName"), gg_obj_buf(component_name)),
-        gg_kv(
-            GG_STR("versionRequirements"), gg_obj_map(version_requirements_map)
-        )
-    );
-
-    GgList candidates_list = GG_LIST(gg_obj_map(component_map));
+    GgKV requirement_kvs[RESOLVE_CANDIDATES_BATCH_MAX][1];
+    GgKV component_kvs[RESOLVE_CANDIDATES_BATCH_MAX][2];
+    GgObject candidates[RESOLVE_CANDIDATES_BATCH_MAX];
+    for (size_t i = 0; i < components.len; i++) {
+        GgKV *pair = &components.pairs[i];
+        requirement_kvs[i][0]
+            = gg_kv(GG_STR("requirements"), *gg_kv_val(pair));
+        component_kvs[i][0]
+            = gg_kv(GG_STR("componentName"), gg_obj_buf(gg_kv_key(*pair)));
+        component_kvs[i][1] = gg_kv(
+            GG_STR("versionRequirements"),
+            gg_obj_map((GgMap) { .pairs = requirement_kvs[i], .len = 1 })
+        );
+        candidates[i]
+            = gg_obj_map((GgMap) { .pairs = component_kvs[i], .len = 2 });
+    }
+    GgList candidates_list
+        = (GgList) { .items = candidates, .len = components.len };
 
     GgMap request_body = GG_MAP(
         gg_kv(GG_STR("componentCandidates"), gg_obj_list(candidates_list)),
@@ -1198,15 +1450,17 @@ static GgError generate_resolve_component_candidates_body(
     return GG_ERR_OK;
 }
 
-static GgError resolve_component_with_cloud(
-    GgBuffer component_name, GgBuffer version_requirements, GgBuffer *response
+/// Resolves a batch of components (name -> version requirement) in one
+/// ResolveComponentCandidates request.
+static GgError resolve_components_with_cloud(
+    GgMap components, GgBuffer *response
 ) {
-    static char resolve_candidates_body_buf[2048];
+    static char resolve_candidates_body_buf[8192];
     GgByteVec body_vec = GG_BYTE_VEC(resolve_candidates_body_buf);
     static uint8_t rcc_body_config_read_mem[128];
     GgArena rcc_alloc = gg_arena_init(GG_BUF(rcc_body_config_read_mem));
     GgError ret = generate_resolve_component_candidates_body(
-        component_name, version_requirements, &body_vec, &rcc_alloc
+        components, &body_vec, &rcc_alloc
     );
     if (ret != GG_ERR_OK) {
         GG_LOGE("Failed to generate body for resolveComponentCandidates call");
@@ -1270,7 +1524,7 @@ static GgError resolve_component_with_cloud(
     );
     if (ret != GG_ERR_OK) {
         GG_LOGE(
-            "Cloud resolution for the component failed with response %.*s.",
+            "Cloud resolution for the components failed with response %.*s.",
             (int) response->len,
             response->data
         );
@@ -1286,14 +1540,19 @@ static GgError resolve_component_with_cloud(
     return GG_ERR_OK;
 }
 
-static GgError parse_dataplane_response_and_save_recipe(
+/// Saves the recipes in a ResolveComponentCandidates response for a batch of
+/// components, writing the resolved version of components[i] to
+/// cloud_versions[i].
+static GgError parse_dataplane_response_and_save_recipes(
     GgBuffer dataplane_response,
     GglDeploymentHandlerThreadArgs *args,
-    GgBuffer *cloud_version
+    GgMap components,
+    GgBuffer *cloud_versions
 ) {
     GgObject json_candidates_response_obj;
     // TODO: Figure out a better size. This response can be big.
-    uint8_t candidates_response_mem[100 * sizeof(GgObject)];
+    static uint8_t candidates_response_mem
+        [RESOLVE_CANDIDATES_BATCH_MAX * 100 * sizeof(GgObject)];
     GgArena alloc = gg_arena_init(GG_BUF(candidates_response_mem));
     GgError ret = gg_json_decode_destructive(
         dataplane_response, &alloc, &json_candidates_response_obj
@@ -1325,18 +1584,13 @@ static GgError parse_dataplane_response_and_save_recipe(
         return ret;
     }
 
-    bool first_component = true;
+    for (size_t i = 0; i < components.len; i++) {
+        cloud_versions[i].len = 0;
+    }
+
     GG_LIST_FOREACH (
         resolved_version, gg_obj_into_list(*resolved_component_versions)
     ) {
-        if (!first_component) {
-            GG_LOGE(
-                "resolveComponentCandidates returned information for more than one component."
-            );
-            return GG_ERR_INVALID;
-        }
-        first_component = false;
-
         if (gg_obj_type(*resolved_version) != GG_TYPE_MAP) {
             GG_LOGE("Resolved version is not of type map.");
             return ret;
@@ -1381,6 +1635,23 @@ static GgError parse_dataplane_response_and_save_recipe(
             = gg_obj_into_buf(*cloud_component_version_obj);
         GgBuffer recipe_file_content = gg_obj_into_buf(*recipe_obj);
 
+        GgBuffer *cloud_version = NULL;
+        for (size_t i = 0; i < components.len; i++) {
+            if (gg_buffer_eq(
+                    gg_kv_key(components.pairs[i]), cloud_component_name
+                )) {
+                cloud_version = &cloud_versions[i];
+            }
+        }
+        if ((cloud_version == NULL) || (cloud_version->len != 0)) {
+            GG_LOGE(
+                "resolveComponentCandidates returned unexpected component %.*s.",
+                (int) cloud_component_name.len,
+                cloud_component_name.data
+            );
+            return GG_ERR_INVALID;
+        }
+
         assert(cloud_component_version.len <= NAME_MAX);
 
         memcpy(
@@ -1478,6 +1749,7 @@ static GgError parse_dataplane_response_and_save_recipe(
             }
         }
 
+        component_index_invalidate();
         GG_LOGD("Saved recipe under the name %s", recipe_name_vec.buf.data);
 
         ret = ggl_gg_config_write(
@@ -1493,6 +1765,17 @@ static GgError parse_dataplane_response_and_save_recipe(
         }
     }
 
+    for (size_t i = 0; i < components.len; i++) {
+        if (cloud_versions[i].len == 0) {
+            GG_LOGE(
+                "Cloud version resolution failed for component %.*s.",
+                (int) gg_kv_key(components.pairs[i]).len,
+                gg_kv_key(components.pairs[i]).data
+            );
+            return GG_ERR_FAILURE;
+        }
+    }
+
     return GG_ERR_OK;
 }
 
@@ -1550,25 +1833,157 @@ static GgError add_thing_groups_list_to_config(GgObject *thing_groups_list) {
     return GG_ERR_OK;
 }
 
-static GgError resolve_dependencies(
-    GgMap root_components,
-    GgBuffer thing_group_name,
-    GglDeploymentType deployment_type,
+/// Resolves a batch of components with the cloud, retrying them one at a time
+/// if the batched request fails.
+static GgError resolve_batch_with_cloud(
+    GgMap components,
     GglDeploymentHandlerThreadArgs *args,
-    GgArena *alloc,
-    GgKVVec *resolved_components_kv_vec,
-    bool *out_depends_on_token_exchange_service
+    GgBuffer *cloud_versions
 ) {
-    GgError ret;
-
-    // Built-in components (e.g. TokenExchangeService) are skipped below and
-    // never enter the resolved set. Report whether the device's merged
-    // dependency closure needs TES so the caller can keep its fleet
-    // configuration ARN in sync for gg-fleet-statusd reporting.
-    *out_depends_on_token_exchange_service = false;
+    static uint8_t response_buf[RESOLVE_CANDIDATES_BATCH_MAX * 16384];
+    GgBuffer response = GG_BUF(response_buf);
+    GgError ret = resolve_components_with_cloud(components, &response);
+    if ((ret != GG_ERR_OK) && (components.len > 1)) {
+        GG_LOGW(
+            "Batched cloud resolution failed. Resolving components individually."
+        );
+        for (size_t i = 0; i < components.len; i++) {
+            ret = resolve_batch_with_cloud(
+                (GgMap) { .pairs = &components.pairs[i], .len = 1 },
+                args,
+                &cloud_versions[i]
+            );
+            if (ret != GG_ERR_OK) {
+                return ret;
+            }
+        }
+        return GG_ERR_OK;
+    }
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    if (gg_buffer_eq(response, GG_STR("{}"))) {
+        GG_LOGI(
+            "Cloud version resolution failed for component %.*s.",
+            (int) gg_kv_key(components.pairs[0]).len,
+            gg_kv_key(components.pairs[0]).data
+        );
+        return GG_ERR_FAILURE;
+    }
+
+    return parse_dataplane_response_and_save_recipes(
+        response, args, components, cloud_versions
+    );
+}
+
+/// Resolves the version of each component in a dependency level and adds them
+/// to the resolved components. Local candidates are preferred; the rest are
+/// resolved with the cloud in batches. versions[i] is set to the version of
+/// level.pairs[i].
+static GgError resolve_component_level(
+    GgMap level,
+    GglDeploymentHandlerThreadArgs *args,
+    GgArena *alloc,
+    GgKVVec *resolved_components_kv_vec,
+    GgBuffer *versions
+) {
+    static uint8_t version_mem[MAX_COMPONENTS_TO_RESOLVE][NAME_MAX];
+    GgKV cloud_components[MAX_COMPONENTS_TO_RESOLVE];
+    GgBuffer cloud_versions[MAX_COMPONENTS_TO_RESOLVE];
+    size_t cloud_index[MAX_COMPONENTS_TO_RESOLVE];
+    size_t cloud_count = 0;
+
+    assert(level.len <= MAX_COMPONENTS_TO_RESOLVE);
+    for (size_t i = 0; i < level.len; i++) {
+        GgKV *pair = &level.pairs[i];
+        versions[i] = GG_BUF(version_mem[i]);
+        // We assume that we have not resolved a component yet if we are finding
+        // it in this map.
+        bool found_local_candidate = resolve_component_version(
+            gg_kv_key(*pair), gg_obj_into_buf(*gg_kv_val(pair)), &versions[i]
+        );
+        if (!found_local_candidate) {
+            cloud_components[cloud_count] = *pair;
+            cloud_versions[cloud_count] = GG_BUF(version_mem[i]);
+            cloud_index[cloud_count] = i;
+            cloud_count += 1;
+        }
+    }
+
+    // Resolve with cloud and download recipes
+    for (size_t start = 0; start < cloud_count;
+         start += RESOLVE_CANDIDATES_BATCH_MAX) {
+        size_t len = cloud_count - start;
+        if (len > RESOLVE_CANDIDATES_BATCH_MAX) {
+            len = RESOLVE_CANDIDATES_BATCH_MAX;
+        }
+        GG_LOGD("Resolving %zu components with the cloud.", len);
+        GgError ret = resolve_batch_with_cloud(
+            (GgMap) { .pairs = &cloud_components[start], .len = len },
+            args,
+            &cloud_versions[start]
+        );
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    for (size_t i = 0; i < cloud_count; i++) {
+        versions[cloud_index[i]] = cloud_versions[i];
+    }
+
+    // Add all of the level's components to the resolved components before
+    // reading their recipes, so requirements between components of the same
+    // level are checked against the resolved versions.
+    for (size_t i = 0; i < level.len; i++) {
+        GgBuffer name = gg_kv_key(level.pairs[i]);
+        if (!is_valid_semver(versions[i])) {
+            GG_LOGE(
+                "Resolved version for component %.*s is not a valid semantic "
+                "version.",
+                (int) name.len,
+                name.data
+            );
+            return GG_ERR_INVALID;
+        }
+
+        GgError ret = gg_arena_claim_buf(&versions[i], alloc);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+
+        ret = gg_kv_vec_push(
+            resolved_components_kv_vec, gg_kv(name, gg_obj_buf(versions[i]))
+        );
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Error while adding component to list of resolved component"
+            );
+            return ret;
+        }
+    }
+    return GG_ERR_OK;
+}
+
+static GgError resolve_dependencies(
+    GgMap root_components,
+    GgBuffer thing_group_name,
+    GglDeploymentType deployment_type,
+    GglDeploymentHandlerThreadArgs *args,
+    GgArena *alloc,
+    GgKVVec *resolved_components_kv_vec,
+    bool *out_depends_on_token_exchange_service
+) {
+    GgError ret;
+
+    // Built-in components (e.g. TokenExchangeService) are skipped below and
+    // never enter the resolved set. Report whether the device's merged
+    // dependency closure needs TES so the caller can keep its fleet
+    // configuration ARN in sync for gg-fleet-statusd reporting.
+    *out_depends_on_token_exchange_service = false;
 
     // TODO: Decide on size
-    GgKVVec components_to_resolve = GG_KV_VEC((GgKV[64]) { 0 });
+    GgKVVec components_to_resolve
+        = GG_KV_VEC((GgKV[MAX_COMPONENTS_TO_RESOLVE]) { 0 });
 
     static uint8_t version_requirements_mem[2048] = { 0 };
     GgArena version_requirements_alloc
@@ -1961,79 +2376,29 @@ static GgError resolve_dependencies(
         }
     }
 
+    // Components are resolved a dependency level at a time: those added while
+    // processing one level's recipes form the next level, which is resolved
+    // as a whole when the loop reaches it.
+    GgBuffer level_versions[MAX_COMPONENTS_TO_RESOLVE];
+    size_t level_start = 0;
+    size_t level_end = 0;
     GG_MAP_FOREACH (pair, components_to_resolve.map) {
-        GgBuffer pair_val = gg_obj_into_buf(*gg_kv_val(pair));
-
-        // We assume that we have not resolved a component yet if we are finding
-        // it in this map.
-        uint8_t resolved_version_arr[NAME_MAX];
-        GgBuffer resolved_version = GG_BUF(resolved_version_arr);
-        bool found_local_candidate = resolve_component_version(
-            gg_kv_key(*pair), pair_val, &resolved_version
-        );
-
-        if (!found_local_candidate) {
-            // Resolve with cloud and download recipe
-            static uint8_t resolve_component_candidates_response_buf[16384]
-                = { 0 };
-            GgBuffer resolve_component_candidates_response
-                = GG_BUF(resolve_component_candidates_response_buf);
-
-            ret = resolve_component_with_cloud(
-                gg_kv_key(*pair),
-                pair_val,
-                &resolve_component_candidates_response
-            );
-            if (ret != GG_ERR_OK) {
-                return ret;
-            }
-
-            bool is_empty_response = gg_buffer_eq(
-                resolve_component_candidates_response, GG_STR("{}")
-            );
-
-            if (is_empty_response) {
-                GG_LOGI(
-                    "Cloud version resolution failed for component %.*s.",
-                    (int) gg_kv_key(*pair).len,
-                    pair_val.data
-                );
-                return GG_ERR_FAILURE;
-            }
-
-            ret = parse_dataplane_response_and_save_recipe(
-                resolve_component_candidates_response, args, &resolved_version
+        size_t index = (size_t) (pair - components_to_resolve.map.pairs);
+        if (index == level_end) {
+            level_start = level_end;
+            level_end = components_to_resolve.map.len;
+            ret = resolve_component_level(
+                (GgMap) { .pairs = pair, .len = level_end - level_start },
+                args,
+                alloc,
+                resolved_components_kv_vec,
+                level_versions
             );
             if (ret != GG_ERR_OK) {
                 return ret;
             }
         }
-
-        if (!is_valid_semver(resolved_version)) {
-            GG_LOGE(
-                "Resolved version for component %.*s is not a valid semantic "
-                "version.",
-                (int) gg_kv_key(*pair).len,
-                gg_kv_key(*pair).data
-            );
-            return GG_ERR_INVALID;
-        }
-
-        // Add resolved component to list of resolved components
-        ret = gg_arena_claim_buf(&resolved_version, alloc);
-        if (ret != GG_ERR_OK) {
-            return ret;
-        }
-
-        ret = gg_kv_vec_push(
-            resolved_components_kv_vec,
-            gg_kv(gg_kv_key(*pair), gg_obj_buf(resolved_version))
-        );
-        if (ret != GG_ERR_OK) {
-            GG_LOGE("Error while adding component to list of resolved component"
-            );
-            return ret;
-        }
+        GgBuffer resolved_version = level_versions[index - level_start];
 
         // Find dependencies from recipe and add them to the list of components
         // to resolve. If the dependency is for a component that is already
@@ -2157,11 +2522,28 @@ static GgError resolve_dependencies(
                     return ret;
                 }
                 if (already_resolved_version != NULL) {
-                    bool meets_requirements = is_in_range(
-                        gg_obj_into_buf(*already_resolved_version),
-                        dep_version_requirement
+                    static GglSemverRange dep_range;
+                    GglSemver resolved_semver;
+                    ret = ggl_semver_range_compile(
+                        dep_version_requirement, &dep_range
                     );
-                    if (!meets_requirements) {
+                    if (ret == GG_ERR_OK) {
+                        ret = ggl_semver_parse(
+                            gg_obj_into_buf(*already_resolved_version),
+                            &resolved_semver
+                        );
+                    }
+                    if (ret != GG_ERR_OK) {
+                        GG_LOGE(
+                            "Failed to parse version requirement for dependency %.*s.",
+                            (int) gg_kv_key(*dependency).len,
+                            gg_kv_key(*dependency).data
+                        );
+                        return ret;
+                    }
+                    if (!ggl_semver_range_matches(
+                            &dep_range, &resolved_semver
+                        )) {
                         GG_LOGE(
                             "Already resolved component does not meet new dependency requirement, failing dependency resolution."
                         );
@@ -2189,13 +2571,10 @@ static GgError resolve_dependencies(
                     if (existing_requirements != NULL) {
                         uint8_t new_req_buf[PATH_MAX];
                         GgByteVec new_req_vec = GG_BYTE_VEC(new_req_buf);
-                        ret = gg_byte_vec_append(
-                            &new_req_vec,
-                            gg_obj_into_buf(*existing_requirements)
-                        );
-                        gg_byte_vec_chain_push(&ret, &new_req_vec, ' ');
-                        gg_byte_vec_chain_append(
-                            &ret, &new_req_vec, dep_version_requirement
+                        ret = ggl_semver_requirement_intersect(
+                            gg_obj_into_buf(*existing_requirements),
+                            dep_version_requirement,
+                            &new_req_vec
                         );
                         if (ret != GG_ERR_OK) {
                             GG_LOGE(
@@ -3018,6 +3397,130 @@ static GgError validate_endpoint_switch_deployment(
     return GG_ERR_OK;
 }
 
+// Fingerprints of the components processed by the current deployment, saved
+// once it succeeds. Names reference the resolved component map.
+static GgBuffer recorded_fingerprint_names[64];
+static ComponentFingerprint recorded_fingerprints[64];
+static size_t recorded_fingerprints_len = 0;
+
+static void record_fingerprint(
+    GgBuffer component_name, const ComponentFingerprint *fingerprint
+) {
+    size_t capacity = sizeof(recorded_fingerprints)
+        / sizeof(recorded_fingerprints[0]);
+    if (recorded_fingerprints_len >= capacity) {
+        GG_LOGW(
+            "Not saving fingerprint of %.*s; too many components.",
+            (int) component_name.len,
+            component_name.data
+        );
+        return;
+    }
+    recorded_fingerprint_names[recorded_fingerprints_len] = component_name;
+    recorded_fingerprints[recorded_fingerprints_len] = *fingerprint;
+    recorded_fingerprints_len += 1;
+}
+
+static void save_recorded_fingerprints(void) {
+    for (size_t i = 0; i < recorded_fingerprints_len; i++) {
+        (void) component_fingerprint_save(
+            recorded_fingerprint_names[i], &recorded_fingerprints[i]
+        );
+    }
+    recorded_fingerprints_len = 0;
+}
+
+static bool component_is_active(GgBuffer component_name) {
+    GgArena component_status_alloc
+        = gg_arena_init(GG_BUF((uint8_t[NAME_MAX]) { 0 }));
+    GgBuffer component_status;
+    GgError ret = ggl_gghealthd_retrieve_component_status(
+        component_name, &component_status_alloc, &component_status
+    );
+    if (ret != GG_ERR_OK) {
+        return false;
+    }
+    return gg_buffer_eq(component_status, GG_STR("RUNNING"))
+        || gg_buffer_eq(component_status, GG_STR("FINISHED"));
+}
+
+typedef struct {
+    GgKV component;
+    /// Whether unit files need to be generated for the component
+    bool convert;
+    /// Whether the component changed apart from its unit files
+    bool changed;
+} PendingComponent;
+
+typedef struct {
+    PendingComponent components[MAX_PENDING_COMPONENTS];
+    size_t len;
+} PendingComponents;
+
+static GgError pending_component_push(
+    PendingComponents *pending,
+    GgKVVec *units_to_convert,
+    GgKV component,
+    bool convert,
+    bool changed
+) {
+    if (pending->len >= MAX_PENDING_COMPONENTS) {
+        GG_LOGE(
+            "Too many components to process %.*s.",
+            (int) gg_kv_key(component).len,
+            gg_kv_key(component).data
+        );
+        return GG_ERR_NOMEM;
+    }
+    if (convert) {
+        GgError ret = gg_kv_vec_push(units_to_convert, component);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    pending->components[pending->len] = (PendingComponent) {
+        .component = component, .convert = convert, .changed = changed
+    };
+    pending->len += 1;
+    return GG_ERR_OK;
+}
+
+/// Adds a component to the deployment unless it is unchanged and already
+/// running, in which case it is recorded as completed.
+static GgError queue_component_if_needed(
+    GgKVVec *components_to_deploy, GgKV component, bool changed
+) {
+    if (!changed && component_is_active(gg_kv_key(component))) {
+        GG_LOGD(
+            "Component %.*s is already running. Will not redeploy.",
+            (int) gg_kv_key(component).len,
+            gg_kv_key(component).data
+        );
+        // save as a deployed component in case of bootstrap
+        return save_component_info(
+            gg_kv_key(component),
+            gg_obj_into_buf(*gg_kv_val(&component)),
+            GG_STR("completed")
+        );
+    }
+
+    GgError ret = gg_kv_vec_push(components_to_deploy, component);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE(
+            "Failed to add component info for %.*s to deployment vector.",
+            (int) gg_kv_key(component).len,
+            gg_kv_key(component).data
+        );
+        return ret;
+    }
+    GG_LOGD(
+        "Added %.*s to list of components that need to be processed.",
+        (int) gg_kv_key(component).len,
+        gg_kv_key(component).data
+    );
+    return GG_ERR_OK;
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 static void handle_deployment(
     GglDeployment *deployment,
@@ -3026,6 +3529,7 @@ static void handle_deployment(
     bool *deployment_succeeded
 ) {
     int root_path_fd = args->root_path_fd;
+    recorded_fingerprints_len = 0;
 
     // Validate IoT endpoint deployment before any state changes
     bool is_endpoint_switch = false;
@@ -3093,6 +3597,7 @@ static void handle_deployment(
             GG_LOGE("Failed to copy recipes.");
             return;
         }
+        component_index_invalidate();
     }
 
     if (deployment->artifacts_directory_path.len != 0) {
@@ -3210,6 +3715,14 @@ static void handle_deployment(
     }
     GG_CLEANUP(cleanup_close, artifact_archive_fd);
 
+    int artifact_cas_fd = -1;
+    ret = artifact_store_open(args->root_path_fd, &artifact_cas_fd);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to open content-addressed artifact store.");
+        return;
+    }
+    GG_CLEANUP(cleanup_close, artifact_cas_fd);
+
     GglDigest digest_context = ggl_new_digest(&ret);
     if (ret != GG_ERR_OK) {
         return;
@@ -3220,6 +3733,36 @@ static void handle_deployment(
     // the deployment
     GgKVVec components_to_deploy = GG_KV_VEC((GgKV[64]) { 0 });
 
+    // Components in deployment order, and those of them needing unit files
+    static PendingComponents pending;
+    pending.len = 0;
+    GgKVVec units_to_convert = GG_KV_VEC((GgKV[MAX_PENDING_COMPONENTS]) { 0 });
+    static Recipe2UnitArgs recipe2unit_args;
+    memset(&recipe2unit_args, 0, sizeof(Recipe2UnitArgs));
+
+    static uint8_t recipe_runner_path_buf[PATH_MAX];
+    GgByteVec recipe_runner_path_vec = GG_BYTE_VEC(recipe_runner_path_buf);
+    ret = gg_byte_vec_append(
+        &recipe_runner_path_vec,
+        gg_buffer_from_null_term((char *) args->bin_path)
+    );
+    gg_byte_vec_chain_append(
+        &ret, &recipe_runner_path_vec, GG_STR("recipe-runner")
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to create recipe runner path.");
+        return;
+    }
+
+    // Resolved once into memory owned here, as get_posix_user's buffer is
+    // reused while processing components, and units are generated after the
+    // loop. Only components needing units require it.
+    static uint8_t run_as_mem[129];
+    char *posix_user = NULL;
+    char *group = NULL;
+    GgError run_as_ret
+        = get_run_as_user_group(GG_BUF(run_as_mem), &posix_user, &group);
+
     GG_MAP_FOREACH (pair, resolved_components_kv_vec.map) {
         GgBuffer pair_val = gg_obj_into_buf(*gg_kv_val(pair));
 
@@ -3255,15 +3798,10 @@ static void handle_deployment(
                 (int) gg_kv_key(*pair).len,
                 gg_kv_key(*pair).data
             );
-            ret = gg_kv_vec_push(
-                &components_to_deploy, gg_kv(gg_kv_key(*pair), *gg_kv_val(pair))
+            ret = pending_component_push(
+                &pending, &units_to_convert, *pair, false, true
             );
             if (ret != GG_ERR_OK) {
-                GG_LOGE(
-                    "Failed to add component info for %.*s to deployment vector.",
-                    (int) gg_kv_key(*pair).len,
-                    gg_kv_key(*pair).data
-                );
                 return;
             }
             continue;
@@ -3334,6 +3872,21 @@ static void handle_deployment(
             }
         }
 
+        ComponentFingerprint fingerprint;
+        ComponentFingerprint saved_fingerprint;
+        bool fingerprint_saved
+            = component_fingerprint_load(gg_kv_key(*pair), &saved_fingerprint)
+            == GG_ERR_OK;
+        bool fingerprint_valid
+            = component_fingerprint_recipe(
+                  digest_context, pair_val, recipe_obj, &fingerprint
+              )
+            == GG_ERR_OK;
+        bool recipe_changed = component_fingerprint_recipe_changed(
+            fingerprint_saved ? &saved_fingerprint : NULL,
+            fingerprint_valid ? &fingerprint : NULL
+        );
+
         static uint8_t component_arn_buffer[256];
         alloc = gg_arena_init(GG_BUF(component_arn_buffer));
         GgBuffer component_arn;
@@ -3348,11 +3901,9 @@ static void handle_deployment(
             GG_LOGW(
                 "Failed to retrieve arn. Assuming recipe artifacts are found on-disk."
             );
-        } else if (!component_updated) {
-            // TODO: Check artifact hashes to see if artifacts have changed/need
-            // to be redownloaded
+        } else if (!component_updated && !recipe_changed) {
             GG_LOGD(
-                "Not retrieving component artifacts as the version has not changed."
+                "Not retrieving component artifacts as the version and recipe have not changed."
             );
         } else if (!tes_creds_retrieved) {
             if (deployment->type != LOCAL_DEPLOYMENT) {
@@ -3374,6 +3925,7 @@ static void handle_deployment(
                 gg_obj_into_map(recipe_obj),
                 component_artifacts_fd,
                 component_archive_dir_fd,
+                artifact_cas_fd,
                 digest_context
             );
             if (ret != GG_ERR_OK) {
@@ -3543,52 +4095,51 @@ static void handle_deployment(
             continue;
         }
 
-        static uint8_t recipe_runner_path_buf[PATH_MAX];
-        GgByteVec recipe_runner_path_vec = GG_BYTE_VEC(recipe_runner_path_buf);
-        ret = gg_byte_vec_append(
-            &recipe_runner_path_vec,
-            gg_buffer_from_null_term((char *) args->bin_path)
-        );
-        gg_byte_vec_chain_append(
-            &ret, &recipe_runner_path_vec, GG_STR("recipe-runner")
-        );
-        if (ret != GG_ERR_OK) {
-            GG_LOGE("Failed to create recipe runner path.");
+        if (run_as_ret != GG_ERR_OK) {
+            GG_LOGE("Failed to get posix_user.");
             return;
         }
 
-        char *posix_user = NULL;
-        ret = get_posix_user(&posix_user);
-        if (ret != GG_ERR_OK) {
-            GG_LOGE("Failed to get posix_user.");
-            return;
+        if (fingerprint_valid) {
+            ret = component_fingerprint_component(
+                digest_context,
+                gg_kv_key(*pair),
+                gg_buffer_from_null_term(posix_user),
+                gg_buffer_from_null_term(group),
+                args->root_path,
+                recipe_runner_path_vec.buf,
+                &fingerprint
+            );
+            fingerprint_valid = ret == GG_ERR_OK;
         }
-        if (strlen(posix_user) < 1) {
-            GG_LOGE("Run with default posix user is not set.");
-            return;
+        bool fingerprint_unchanged = component_fingerprint_unchanged(
+            fingerprint_saved ? &saved_fingerprint : NULL,
+            fingerprint_valid ? &fingerprint : NULL
+        );
+        if (fingerprint_valid) {
+            record_fingerprint(gg_kv_key(*pair), &fingerprint);
         }
-        bool colon_found = false;
-        char *group;
-        for (size_t j = 0; j < strlen(posix_user); j++) {
-            if (posix_user[j] == ':') {
-                posix_user[j] = '\0';
-                colon_found = true;
-                group = &posix_user[j + 1];
-                break;
+
+        // Units and artifacts of an unchanged, running component are already
+        // in place, so leave it untouched.
+        if (fingerprint_unchanged && component_is_active(gg_kv_key(*pair))) {
+            GG_LOGD(
+                "Component %.*s is unchanged and running. Will not redeploy.",
+                (int) gg_kv_key(*pair).len,
+                gg_kv_key(*pair).data
+            );
+            // save as a deployed component in case of bootstrap
+            ret = save_component_info(
+                gg_kv_key(*pair), pair_val, GG_STR("completed")
+            );
+            if (ret != GG_ERR_OK) {
+                return;
             }
-        }
-        if (!colon_found) {
-            group = posix_user;
+            continue;
         }
 
-        static Recipe2UnitArgs recipe2unit_args;
-        memset(&recipe2unit_args, 0, sizeof(Recipe2UnitArgs));
         recipe2unit_args.user = posix_user;
         recipe2unit_args.group = group;
-
-        recipe2unit_args.component_name = gg_kv_key(*pair);
-        recipe2unit_args.component_version = pair_val;
-
         memcpy(
             recipe2unit_args.recipe_runner_path,
             recipe_runner_path_vec.buf.data,
@@ -3599,110 +4150,44 @@ static void handle_deployment(
         );
         recipe2unit_args.root_path_fd = root_path_fd;
 
-        GgObject recipe_buff_obj;
-        GgObject *component_name;
-        static uint8_t unit_convert_alloc_mem[GGL_COMPONENT_RECIPE_MAX_LEN];
-        GgArena unit_convert_alloc
-            = gg_arena_init(GG_BUF(unit_convert_alloc_mem));
-        HasPhase phases = { 0 };
-        GgError err = convert_to_unit(
-            &recipe2unit_args,
-            &unit_convert_alloc,
-            &recipe_buff_obj,
-            &component_name,
-            &phases
+        // A changed unit file (e.g. a new run-as user) needs the component's
+        // services relinked and restarted even if its version did not change.
+        // The fingerprint covers version and configuration; without a saved
+        // one, fall back to checking them directly.
+        bool component_changed = (fingerprint_saved && fingerprint_valid)
+            ? !fingerprint_unchanged
+            : (component_updated
+               || is_component_config_updated(deployment, gg_kv_key(*pair)));
+        ret = pending_component_push(
+            &pending, &units_to_convert, *pair, true, component_changed
         );
-
-        if (err != GG_ERR_OK) {
+        if (ret != GG_ERR_OK) {
             return;
         }
+    }
 
-        if (component_updated
-            || is_component_config_updated(deployment, gg_kv_key(*pair))) {
-            ret = gg_kv_vec_push(
-                &components_to_deploy, gg_kv(gg_kv_key(*pair), *gg_kv_val(pair))
-            );
-            if (ret != GG_ERR_OK) {
-                GG_LOGE(
-                    "Failed to add component info for %.*s to deployment vector.",
-                    (int) gg_kv_key(*pair).len,
-                    gg_kv_key(*pair).data
-                );
-                return;
-            }
-            GG_LOGD(
-                "Added %.*s to list of components that need to be processed.",
-                (int) gg_kv_key(*pair).len,
-                gg_kv_key(*pair).data
-            );
-        } else {
-            // component already exists, check its lifecycle state
-            GgArena component_status_alloc
-                = gg_arena_init(GG_BUF((uint8_t[NAME_MAX]) { 0 }));
-            GgBuffer component_status;
-            ret = ggl_gghealthd_retrieve_component_status(
-                gg_kv_key(*pair), &component_status_alloc, &component_status
-            );
-
-            if (ret != GG_ERR_OK) {
-                GG_LOGD(
-                    "Failed to retrieve health status for %.*s. Redeploying component.",
-                    (int) gg_kv_key(*pair).len,
-                    gg_kv_key(*pair).data
-                );
-                ret = gg_kv_vec_push(
-                    &components_to_deploy,
-                    gg_kv(gg_kv_key(*pair), *gg_kv_val(pair))
-                );
-                if (ret != GG_ERR_OK) {
-                    GG_LOGE(
-                        "Failed to add component info for %.*s to deployment vector.",
-                        (int) gg_kv_key(*pair).len,
-                        gg_kv_key(*pair).data
-                    );
-                    return;
-                }
-                GG_LOGD(
-                    "Added %.*s to list of components that need to be processed.",
-                    (int) gg_kv_key(*pair).len,
-                    gg_kv_key(*pair).data
-                );
-            }
+    // Units of different components are independent, so generate them in
+    // one batch across worker threads.
+    static HasPhase phases[MAX_PENDING_COMPONENTS];
+    if (units_to_convert.map.len > 0) {
+        ret = convert_to_units(&recipe2unit_args, units_to_convert.map, phases);
+        if (ret != GG_ERR_OK) {
+            return;
+        }
+    }
 
-            // Skip redeploying components in a RUNNING state
-            if (gg_buffer_eq(component_status, GG_STR("RUNNING"))
-                || gg_buffer_eq(component_status, GG_STR("FINISHED"))) {
-                GG_LOGD(
-                    "Component %.*s is already running. Will not redeploy.",
-                    (int) gg_kv_key(*pair).len,
-                    gg_kv_key(*pair).data
-                );
-                // save as a deployed component in case of bootstrap
-                ret = save_component_info(
-                    gg_kv_key(*pair), pair_val, GG_STR("completed")
-                );
-                if (ret != GG_ERR_OK) {
-                    return;
-                }
-            } else {
-                ret = gg_kv_vec_push(
-                    &components_to_deploy,
-                    gg_kv(gg_kv_key(*pair), *gg_kv_val(pair))
-                );
-                if (ret != GG_ERR_OK) {
-                    GG_LOGE(
-                        "Failed to add component info for %.*s to deployment vector.",
-                        (int) gg_kv_key(*pair).len,
-                        gg_kv_key(*pair).data
-                    );
-                    return;
-                }
-                GG_LOGD(
-                    "Added %.*s to list of components that need to be processed.",
-                    (int) gg_kv_key(*pair).len,
-                    gg_kv_key(*pair).data
-                );
-            }
+    size_t converted = 0;
+    for (size_t i = 0; i < pending.len; i++) {
+        bool changed = pending.components[i].changed;
+        if (pending.components[i].convert) {
+            changed = changed || phases[converted].units_changed;
+            converted++;
+        }
+        ret = queue_component_if_needed(
+            &components_to_deploy, pending.components[i].component, changed
+        );
+        if (ret != GG_ERR_OK) {
+            return;
         }
     }
 
@@ -3774,8 +4259,7 @@ static void handle_deployment(
                         component_name.data
                     );
                 } else { // relevant install service file exists
-                    GG_CLEANUP(cleanup_close, fd);
-                    (void) disable_and_unlink_service(&component_name, INSTALL);
+                    (void) gg_close(fd);
                     // add relevant component name into the vector
                     ret = gg_buf_vec_push(
                         &install_comp_name_buf_vec, component_name
@@ -3786,121 +4270,41 @@ static void handle_deployment(
                         );
                         return;
                     }
-
-                    // initiate link command for 'install'
-                    static uint8_t link_command_buf[PATH_MAX];
-                    GgByteVec link_command_vec = GG_BYTE_VEC(link_command_buf);
-                    ret = gg_byte_vec_append(
-                        &link_command_vec, GG_STR("systemctl link ")
-                    );
-                    gg_byte_vec_chain_append(
-                        &ret,
-                        &link_command_vec,
-                        install_service_file_path_vec.buf
-                    );
-                    gg_byte_vec_chain_push(&ret, &link_command_vec, '\0');
-                    if (ret != GG_ERR_OK) {
-                        GG_LOGE(
-                            "Failed to create systemctl link command for:%.*s",
-                            (int) install_service_file_path_vec.buf.len,
-                            install_service_file_path_vec.buf.data
-                        );
-                        return;
-                    }
-
-                    GG_LOGD(
-                        "Command to execute: %.*s",
-                        (int) link_command_vec.buf.len,
-                        link_command_vec.buf.data
-                    );
-
-                    // NOLINTBEGIN(concurrency-mt-unsafe)
-                    int system_ret = system((char *) link_command_vec.buf.data);
-                    if (WIFEXITED(system_ret)) {
-                        if (WEXITSTATUS(system_ret) != 0) {
-                            GG_LOGE(
-                                "systemctl link failed for:%.*s",
-                                (int) install_service_file_path_vec.buf.len,
-                                install_service_file_path_vec.buf.data
-                            );
-                            return;
-                        }
-                        GG_LOGI(
-                            "systemctl link exited for %.*s with child status %d\n",
-                            (int) install_service_file_path_vec.buf.len,
-                            install_service_file_path_vec.buf.data,
-                            WEXITSTATUS(system_ret)
-                        );
-                    } else {
-                        GG_LOGE(
-                            "systemctl link did not exit normally for %.*s",
-                            (int) install_service_file_path_vec.buf.len,
-                            install_service_file_path_vec.buf.data
-                        );
-                        return;
-                    }
-
-                    // initiate start command for 'install' (non-blocking to
-                    // allow wait_for_phase_status to handle retries via
-                    // gghealthd)
-                    static uint8_t start_command_buf[PATH_MAX];
-                    GgByteVec start_command_vec
-                        = GG_BYTE_VEC(start_command_buf);
-                    ret = gg_byte_vec_append(
-                        &start_command_vec,
-                        GG_STR("systemctl start --no-block ")
-                    );
-                    gg_byte_vec_chain_append(
-                        &ret, &start_command_vec, GG_STR("ggl.")
-                    );
-                    gg_byte_vec_chain_append(
-                        &ret, &start_command_vec, component_name
-                    );
-                    gg_byte_vec_chain_append(
-                        &ret, &start_command_vec, GG_STR(".install.service\0")
-                    );
-
-                    GG_LOGD(
-                        "Command to execute: %.*s",
-                        (int) start_command_vec.buf.len,
-                        start_command_vec.buf.data
-                    );
-                    if (ret != GG_ERR_OK) {
-                        GG_LOGE(
-                            "Failed to create systemctl start command for %.*s",
-                            (int) install_service_file_path_vec.buf.len,
-                            install_service_file_path_vec.buf.data
-                        );
-                        return;
-                    }
-
-                    system_ret = system((char *) start_command_vec.buf.data);
-                    // NOLINTEND(concurrency-mt-unsafe)
-                    if (WIFEXITED(system_ret)) {
-                        if (WEXITSTATUS(system_ret) != 0) {
-                            GG_LOGE(
-                                "systemctl start --no-block failed for %.*s",
-                                (int) install_service_file_path_vec.buf.len,
-                                install_service_file_path_vec.buf.data
-                            );
-                            return;
-                        }
-                        GG_LOGI(
-                            "systemctl start --no-block exited with child status %d\n",
-                            WEXITSTATUS(system_ret)
-                        );
-                    } else {
-                        GG_LOGE(
-                            "systemctl start --no-block did not exit normally for %.*s",
-                            (int) install_service_file_path_vec.buf.len,
-                            install_service_file_path_vec.buf.data
-                        );
-                        return;
-                    }
                 }
             }
         }
 
+        // Replace and link all install services with one reload, then queue
+        // their starts without blocking to allow wait_for_phase_status to
+        // handle retries via gghealthd.
+        GgBufList install_components = install_comp_name_buf_vec.buf_list;
+        if (install_components.len > 0) {
+            (void) disable_and_unlink_services(install_components, INSTALL);
+            ret = systemd_units_link(
+                args->root_path, install_components, INSTALL
+            );
+            if (ret != GG_ERR_OK) {
+                return;
+            }
+            ret = systemd_daemon_reload();
+            if (ret != GG_ERR_OK) {
+                return;
+            }
+        }
+        for (size_t i = 0; i < install_components.len; i++) {
+            ret = systemd_unit_start(
+                install_components.bufs[i], INSTALL, false
+            );
+            if (ret != GG_ERR_OK) {
+                GG_LOGE(
+                    "Failed to start install service for %.*s.",
+                    (int) install_components.bufs[i].len,
+                    install_components.bufs[i].data
+                );
+                return;
+            }
+        }
+
         // wait for all the install status
         ret = wait_for_phase_status(
             install_comp_name_buf_vec, GG_STR("install")
@@ -3909,10 +4313,14 @@ static void handle_deployment(
             return;
         }
 
+        // collect all component names that have relevant run or startup
+        // service files
+        static GgBuffer run_comp_name_buf[MAX_COMP_NAME_BUF_SIZE];
+        GgBufVec run_comp_name_buf_vec = GG_BUF_VEC(run_comp_name_buf);
+
         // process all run or startup files after install only
         GG_MAP_FOREACH (component, components_to_deploy.map) {
             GgBuffer component_name = gg_kv_key(*component);
-            GgBuffer component_version = gg_obj_into_buf(*gg_kv_val(component));
 
             static uint8_t service_file_path_buf[PATH_MAX];
             GgByteVec service_file_path_vec
@@ -3940,84 +4348,41 @@ static void handle_deployment(
                         component_name.data
                     );
                 } else {
-                    GG_CLEANUP(cleanup_close, fd);
-                    (void
-                    ) disable_and_unlink_service(&component_name, RUN_STARTUP);
-                    // run link command
-                    static uint8_t link_command_buf[PATH_MAX];
-                    GgByteVec link_command_vec = GG_BYTE_VEC(link_command_buf);
-                    ret = gg_byte_vec_append(
-                        &link_command_vec, GG_STR("systemctl link ")
-                    );
-                    gg_byte_vec_chain_append(
-                        &ret, &link_command_vec, service_file_path_vec.buf
-                    );
-                    gg_byte_vec_chain_push(&ret, &link_command_vec, '\0');
-                    if (ret != GG_ERR_OK) {
-                        GG_LOGE("Failed to create systemctl link command.");
-                        return;
-                    }
-
-                    GG_LOGD(
-                        "Command to execute: %.*s",
-                        (int) link_command_vec.buf.len,
-                        link_command_vec.buf.data
-                    );
-
-                    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-                    int system_ret = system((char *) link_command_vec.buf.data);
-                    if (WIFEXITED(system_ret)) {
-                        if (WEXITSTATUS(system_ret) != 0) {
-                            GG_LOGE("systemctl link command failed");
-                            return;
-                        }
-                        GG_LOGI(
-                            "systemctl link exited with child status %d\n",
-                            WEXITSTATUS(system_ret)
-                        );
-                    } else {
-                        GG_LOGE("systemctl link did not exit normally");
-                        return;
-                    }
-
-                    // run enable command
-                    static uint8_t enable_command_buf[PATH_MAX];
-                    GgByteVec enable_command_vec
-                        = GG_BYTE_VEC(enable_command_buf);
-                    ret = gg_byte_vec_append(
-                        &enable_command_vec, GG_STR("systemctl enable ")
-                    );
-                    gg_byte_vec_chain_append(
-                        &ret, &enable_command_vec, service_file_path_vec.buf
+                    (void) gg_close(fd);
+                    ret = gg_buf_vec_push(
+                        &run_comp_name_buf_vec, component_name
                     );
-                    gg_byte_vec_chain_push(&ret, &enable_command_vec, '\0');
                     if (ret != GG_ERR_OK) {
-                        GG_LOGE("Failed to create systemctl enable command.");
-                        return;
-                    }
-                    GG_LOGD(
-                        "Command to execute: %.*s",
-                        (int) enable_command_vec.buf.len,
-                        enable_command_vec.buf.data
-                    );
-
-                    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-                    system_ret = system((char *) enable_command_vec.buf.data);
-                    if (WIFEXITED(system_ret)) {
-                        if (WEXITSTATUS(system_ret) != 0) {
-                            GG_LOGE("systemctl enable failed");
-                            return;
-                        }
-                        GG_LOGI(
-                            "systemctl enable exited with child status %d\n",
-                            WEXITSTATUS(system_ret)
+                        GG_LOGE(
+                            "Failed to add the run component name into vector"
                         );
-                    } else {
-                        GG_LOGE("systemctl enable did not exit normally");
                         return;
                     }
                 }
             }
+        }
+
+        // Replace, link and enable all run services in one call each.
+        GgBufList run_components = run_comp_name_buf_vec.buf_list;
+        if (run_components.len > 0) {
+            (void) disable_and_unlink_services(run_components, RUN_STARTUP);
+            ret = systemd_units_link(
+                args->root_path, run_components, RUN_STARTUP
+            );
+            if (ret != GG_ERR_OK) {
+                return;
+            }
+            ret = systemd_units_enable(
+                args->root_path, run_components, RUN_STARTUP
+            );
+            if (ret != GG_ERR_OK) {
+                return;
+            }
+        }
+
+        GG_MAP_FOREACH (component, components_to_deploy.map) {
+            GgBuffer component_name = gg_kv_key(*component);
+            GgBuffer component_version = gg_obj_into_buf(*gg_kv_val(component));
 
             // save as a deployed component in case of bootstrap
             ret = save_component_info(
@@ -4028,39 +4393,15 @@ static void handle_deployment(
             }
         }
 
-        // run daemon-reload command once all the files are linked
-        static uint8_t reload_command_buf[PATH_MAX];
-        GgByteVec reload_command_vec = GG_BYTE_VEC(reload_command_buf);
-        ret = gg_byte_vec_append(
-            &reload_command_vec, GG_STR("systemctl daemon-reload\0")
-        );
+        // reload once all the files are linked
+        ret = systemd_daemon_reload();
         if (ret != GG_ERR_OK) {
-            GG_LOGE("Failed to create systemctl daemon-reload command.");
-            return;
-        }
-        // NOLINTNEXTLINE(concurrency-mt-unsafe)
-        int system_ret = system((char *) reload_command_vec.buf.data);
-        if (WIFEXITED(system_ret)) {
-            if (WEXITSTATUS(system_ret) != 0) {
-                GG_LOGE("systemctl daemon-reload failed");
-                return;
-            }
-            GG_LOGI(
-                "systemctl daemon-reload exited with child status %d\n",
-                WEXITSTATUS(system_ret)
-            );
-        } else {
-            GG_LOGE("systemctl daemon-reload did not exit normally");
             return;
         }
     }
 
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    int system_ret = system("systemctl reset-failed");
-    (void) (system_ret);
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    system_ret = system("systemctl start greengrass-lite.target");
-    (void) (system_ret);
+    (void) systemd_reset_failed();
+    (void) systemd_start_greengrass_target();
 
     ret = wait_for_deployment_status(resolved_components_kv_vec.map);
     if (ret != GG_ERR_OK) {
@@ -4076,6 +4417,12 @@ static void handle_deployment(
     if (ret != GG_ERR_OK) {
         GG_LOGE("Error while cleaning up stale components after deployment.");
     }
+    if (ctx->removed_components != NULL) {
+        GgBufList removed = ctx->removed_components->buf_list;
+        for (size_t i = 0; i < removed.len; i++) {
+            component_fingerprint_delete(removed.bufs[i]);
+        }
+    }
 
     if (is_endpoint_switch) {
         GG_LOGD("Verifying MQTT reconnection after config merge.");
@@ -4119,6 +4466,8 @@ static void handle_deployment(
         }
     }
 
+    save_recorded_fingerprints();
+
     *deployment_succeeded = true;
 }
 
@@ -30,29 +30,160 @@
 #define DEPLOYMENT_MEM_SIZE 5000
 #endif
 
+// Times a queued cloud deployment may be passed over by local deployments
+// before it runs in order.
+#ifndef DEPLOYMENT_MAX_LOCAL_SKIPS
+#define DEPLOYMENT_MAX_LOCAL_SKIPS 3
+#endif
+
 #ifndef MAX_LOCAL_COMPONENTS
 #define MAX_LOCAL_COMPONENTS 64
 #endif
 
+// Documents share a pool sized for DEPLOYMENT_MEM_SIZE bytes per queue slot,
+// so a single large deployment can use more than one slot's share.
+#define DEPLOYMENT_MEM_BLOCK_SIZE 256
+#define DEPLOYMENT_MEM_BLOCKS \
+    ((DEPLOYMENT_QUEUE_SIZE * DEPLOYMENT_MEM_SIZE) / DEPLOYMENT_MEM_BLOCK_SIZE)
+
 static GglDeployment deployments[DEPLOYMENT_QUEUE_SIZE];
-static uint8_t deployment_mem[DEPLOYMENT_QUEUE_SIZE][DEPLOYMENT_MEM_SIZE];
-static size_t queue_index = 0;
-static size_t queue_count = 0;
+static bool slot_used[DEPLOYMENT_QUEUE_SIZE];
+// Enqueue order; coalesced deployments keep their original position
+static uint64_t slot_seq[DEPLOYMENT_QUEUE_SIZE];
+// Local deployments dequeued ahead of a queued cloud deployment
+static size_t slot_skips[DEPLOYMENT_QUEUE_SIZE];
+static size_t slot_mem_first[DEPLOYMENT_QUEUE_SIZE];
+static size_t slot_mem_blocks[DEPLOYMENT_QUEUE_SIZE];
+static uint64_t next_seq = 0;
+
+static uint8_t deployment_mem[DEPLOYMENT_MEM_BLOCKS][DEPLOYMENT_MEM_BLOCK_SIZE];
+static bool mem_block_used[DEPLOYMENT_MEM_BLOCKS];
 
 static pthread_mutex_t queue_mtx = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t notify_cond = PTHREAD_COND_INITIALIZER;
 
 static bool get_matching_deployment(GgBuffer deployment_id, size_t *index) {
-    for (size_t i = 0; i < queue_count; i++) {
-        size_t index_i = (queue_index + i) % DEPLOYMENT_QUEUE_SIZE;
-        if (gg_buffer_eq(deployment_id, deployments[index_i].deployment_id)) {
-            *index = index_i;
+    for (size_t i = 0; i < DEPLOYMENT_QUEUE_SIZE; i++) {
+        if (slot_used[i]
+            && gg_buffer_eq(deployment_id, deployments[i].deployment_id)) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Finds a queued deployment that a new one for the same thing group
+/// supersedes. Local deployments are applied on top of each other, so only
+/// cloud deployments are coalesced.
+static bool get_superseded_deployment(const GglDeployment *new, size_t *index) {
+    if (new->type != THING_GROUP_DEPLOYMENT) {
+        return false;
+    }
+    for (size_t i = 0; i < DEPLOYMENT_QUEUE_SIZE; i++) {
+        if (slot_used[i] && (deployments[i].state == GGL_DEPLOYMENT_QUEUED)
+            && (deployments[i].type == THING_GROUP_DEPLOYMENT)
+            && gg_buffer_eq(new->thing_group, deployments[i].thing_group)) {
+            *index = i;
             return true;
         }
     }
     return false;
 }
 
+static bool get_free_slot(size_t *index) {
+    for (size_t i = 0; i < DEPLOYMENT_QUEUE_SIZE; i++) {
+        if (!slot_used[i]) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void release_slot_mem(size_t index) {
+    for (size_t i = 0; i < slot_mem_blocks[index]; i++) {
+        mem_block_used[slot_mem_first[index] + i] = false;
+    }
+    slot_mem_blocks[index] = 0;
+}
+
+/// Copies a deployment into the largest free run of pool blocks, keeping only
+/// the blocks it used.
+static GgError store_deployment(GglDeployment *deployment, size_t index) {
+    size_t best_first = 0;
+    size_t best_len = 0;
+    size_t run_len = 0;
+    for (size_t i = 0; i < DEPLOYMENT_MEM_BLOCKS; i++) {
+        run_len = mem_block_used[i] ? 0 : run_len + 1;
+        if (run_len > best_len) {
+            best_len = run_len;
+            best_first = i + 1 - run_len;
+        }
+    }
+
+    GgArena alloc = gg_arena_init((GgBuffer) {
+        .data = deployment_mem[best_first],
+        .len = best_len * DEPLOYMENT_MEM_BLOCK_SIZE,
+    });
+    GgError ret = deep_copy_deployment(deployment, &alloc);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    size_t blocks = (alloc.index + DEPLOYMENT_MEM_BLOCK_SIZE - 1)
+        / DEPLOYMENT_MEM_BLOCK_SIZE;
+    for (size_t i = 0; i < blocks; i++) {
+        mem_block_used[best_first + i] = true;
+    }
+    slot_mem_first[index] = best_first;
+    slot_mem_blocks[index] = blocks;
+    return GG_ERR_OK;
+}
+
+/// Local deployments are requested by someone on the device and run ahead of
+/// cloud deployments, unless the cloud deployment has already been passed over
+/// DEPLOYMENT_MAX_LOCAL_SKIPS times. Otherwise deployments run in order.
+static bool runs_before(size_t a, size_t b) {
+    bool a_local = deployments[a].type == LOCAL_DEPLOYMENT;
+    bool b_local = deployments[b].type == LOCAL_DEPLOYMENT;
+    if (a_local != b_local) {
+        size_t cloud = a_local ? b : a;
+        if (slot_skips[cloud] < DEPLOYMENT_MAX_LOCAL_SKIPS) {
+            return a_local;
+        }
+    }
+    return slot_seq[a] < slot_seq[b];
+}
+
+static bool get_next_deployment(size_t *index) {
+    bool found = false;
+    for (size_t i = 0; i < DEPLOYMENT_QUEUE_SIZE; i++) {
+        if (!slot_used[i] || (deployments[i].state != GGL_DEPLOYMENT_QUEUED)) {
+            continue;
+        }
+        if (!found || runs_before(i, *index)) {
+            *index = i;
+            found = true;
+        }
+    }
+    return found;
+}
+
+/// Counts a local deployment starting ahead of older cloud deployments.
+static void note_skipped_deployments(size_t index) {
+    if (deployments[index].type != LOCAL_DEPLOYMENT) {
+        return;
+    }
+    for (size_t i = 0; i < DEPLOYMENT_QUEUE_SIZE; i++) {
+        if (slot_used[i] && (deployments[i].state == GGL_DEPLOYMENT_QUEUED)
+            && (deployments[i].type != LOCAL_DEPLOYMENT)
+            && (slot_seq[i] < slot_seq[index])) {
+            slot_skips[i] += 1;
+        }
+    }
+}
+
 static GgError null_terminate_buffer(GgBuffer *buf, GgArena *alloc) {
     if (buf->len == 0) {
         *buf = GG_STR("");
@@ -571,7 +702,8 @@ GgError ggl_deployment_enqueue(
     GgMap deployment_doc,
     GgByteVec *id,
     GgBuffer iot_job_id,
-    GglDeploymentType type
+    GglDeploymentType type,
+    GgByteVec *superseded_job_id
 ) {
     GG_MTX_SCOPE_GUARD(&queue_mtx);
 
@@ -613,23 +745,50 @@ GgError ggl_deployment_enqueue(
             return GG_ERR_OK;
         }
         GG_LOGI("Replacing existing deployment in queue.");
+    } else if (get_superseded_deployment(&new, &index)) {
+        GG_LOGI(
+            "Deployment supersedes queued deployment %.*s for thing group %.*s.",
+            (int) deployments[index].deployment_id.len,
+            deployments[index].deployment_id.data,
+            (int) new.thing_group.len,
+            new.thing_group.data
+        );
+        GgBuffer old_job_id = deployments[index].iot_job_id;
+        if ((superseded_job_id != NULL) && (old_job_id.len > 0)
+            && !gg_buffer_eq(old_job_id, new.iot_job_id)) {
+            // Copied before the slot's memory is reused below
+            ret = gg_byte_vec_append(superseded_job_id, old_job_id);
+            if (ret != GG_ERR_OK) {
+                GG_LOGW("Superseded job ID too long to report.");
+            }
+        }
+        exists = true;
     } else {
-        if (queue_count >= DEPLOYMENT_QUEUE_SIZE) {
+        if (!get_free_slot(&index)) {
             return GG_ERR_BUSY;
         }
 
         GG_LOGD("Adding a new deployment to the queue.");
-        index = (queue_index + queue_count) % DEPLOYMENT_QUEUE_SIZE;
-        queue_count += 1;
+        slot_seq[index] = next_seq;
+        slot_skips[index] = 0;
+        next_seq += 1;
     }
 
-    GgArena alloc = gg_arena_init(GG_BUF(deployment_mem[index]));
-    ret = deep_copy_deployment(&new, &alloc);
+    // The new document does not reference the replaced one, so its memory can
+    // be reused for the copy.
+    release_slot_mem(index);
+    ret = store_deployment(&new, index);
     if (ret != GG_ERR_OK) {
-        return ret;
+        GG_LOGE("Insufficient queue memory for deployment.");
+        if (exists) {
+            GG_LOGW("Dropping replaced deployment from the queue.");
+            slot_used[index] = false;
+        }
+        return GG_ERR_BUSY;
     }
 
     deployments[index] = new;
+    slot_used[index] = true;
 
     pthread_cond_signal(&notify_cond);
 
@@ -639,12 +798,14 @@ GgError ggl_deployment_enqueue(
 GgError ggl_deployment_dequeue(GglDeployment **deployment) {
     GG_MTX_SCOPE_GUARD(&queue_mtx);
 
-    while (queue_count == 0) {
+    size_t index = 0;
+    while (!get_next_deployment(&index)) {
         pthread_cond_wait(&notify_cond, &queue_mtx);
     }
 
-    deployments[queue_index].state = GGL_DEPLOYMENT_IN_PROGRESS;
-    *deployment = &deployments[queue_index];
+    note_skipped_deployments(index);
+    deployments[index].state = GGL_DEPLOYMENT_IN_PROGRESS;
+    *deployment = &deployments[index];
 
     GG_LOGD("Set a deployment to in progress.");
 
@@ -654,13 +815,119 @@ GgError ggl_deployment_dequeue(GglDeployment **deployment) {
 void ggl_deployment_release(GglDeployment *deployment) {
     GG_MTX_SCOPE_GUARD(&queue_mtx);
 
-    assert(gg_buffer_eq(
-        deployment->deployment_id, deployments[queue_index].deployment_id
-    ));
-    (void) deployment;
+    for (size_t i = 0; i < DEPLOYMENT_QUEUE_SIZE; i++) {
+        if (&deployments[i] == deployment) {
+            assert(slot_used[i]);
+            GG_LOGD("Removing deployment from queue.");
+            release_slot_mem(i);
+            slot_used[i] = false;
+            return;
+        }
+    }
+
+    // Resumed bootstrap deployments are not stored in the queue
+    GG_LOGD("Released deployment was not queued.");
+}
+
+#ifdef GG_SDK_TESTING
+
+#include <gg/test.h>
+#include <unity.h>
+
+static void test_queue_reset(void) {
+    for (size_t i = 0; i < DEPLOYMENT_QUEUE_SIZE; i++) {
+        slot_used[i] = false;
+        slot_skips[i] = 0;
+    }
+    next_seq = 0;
+}
+
+static size_t test_queue_push(
+    GglDeploymentType type, GgBuffer thing_group, GgBuffer iot_job_id
+) {
+    size_t index = 0;
+    TEST_ASSERT_TRUE(get_free_slot(&index));
+    deployments[index] = (GglDeployment) {
+        .type = type,
+        .thing_group = thing_group,
+        .iot_job_id = iot_job_id,
+        .state = GGL_DEPLOYMENT_QUEUED,
+    };
+    slot_used[index] = true;
+    slot_seq[index] = next_seq;
+    slot_skips[index] = 0;
+    next_seq += 1;
+    return index;
+}
+
+static size_t test_queue_pop(void) {
+    size_t index = 0;
+    TEST_ASSERT_TRUE(get_next_deployment(&index));
+    note_skipped_deployments(index);
+    slot_used[index] = false;
+    return index;
+}
 
-    GG_LOGD("Removing deployment from queue.");
+GG_TEST_DEFINE(deployment_queue_supersedes_same_thing_group) {
+    test_queue_reset();
+    size_t first = test_queue_push(
+        THING_GROUP_DEPLOYMENT, GG_STR("group-a"), GG_STR("job-1")
+    );
+    (void) test_queue_push(
+        THING_GROUP_DEPLOYMENT, GG_STR("group-b"), GG_STR("job-2")
+    );
 
-    queue_count -= 1;
-    queue_index = (queue_index + 1) % DEPLOYMENT_QUEUE_SIZE;
+    GglDeployment new = { .type = THING_GROUP_DEPLOYMENT,
+                          .thing_group = GG_STR("group-a") };
+    size_t index = 0;
+    TEST_ASSERT_TRUE(get_superseded_deployment(&new, &index));
+    TEST_ASSERT_EQUAL(first, index);
+
+    // Only queued deployments are replaced
+    deployments[first].state = GGL_DEPLOYMENT_IN_PROGRESS;
+    TEST_ASSERT_FALSE(get_superseded_deployment(&new, &index));
+
+    // Local deployments are never coalesced
+    new.type = LOCAL_DEPLOYMENT;
+    deployments[first].state = GGL_DEPLOYMENT_QUEUED;
+    TEST_ASSERT_FALSE(get_superseded_deployment(&new, &index));
+
+    new.type = THING_GROUP_DEPLOYMENT;
+    new.thing_group = GG_STR("group-c");
+    TEST_ASSERT_FALSE(get_superseded_deployment(&new, &index));
 }
+
+GG_TEST_DEFINE(deployment_queue_local_runs_first) {
+    test_queue_reset();
+    size_t cloud = test_queue_push(
+        THING_GROUP_DEPLOYMENT, GG_STR("group-a"), GG_STR("job-1")
+    );
+    size_t local_1
+        = test_queue_push(LOCAL_DEPLOYMENT, GG_STR("LOCAL"), GG_STR(""));
+    size_t local_2
+        = test_queue_push(LOCAL_DEPLOYMENT, GG_STR("LOCAL"), GG_STR(""));
+
+    TEST_ASSERT_EQUAL(local_1, test_queue_pop());
+    TEST_ASSERT_EQUAL(local_2, test_queue_pop());
+    TEST_ASSERT_EQUAL(cloud, test_queue_pop());
+
+    size_t index = 0;
+    TEST_ASSERT_FALSE(get_next_deployment(&index));
+}
+
+GG_TEST_DEFINE(deployment_queue_cloud_not_starved) {
+    test_queue_reset();
+    size_t cloud = test_queue_push(
+        THING_GROUP_DEPLOYMENT, GG_STR("group-a"), GG_STR("job-1")
+    );
+    for (size_t i = 0; i < DEPLOYMENT_MAX_LOCAL_SKIPS; i++) {
+        size_t local
+            = test_queue_push(LOCAL_DEPLOYMENT, GG_STR("LOCAL"), GG_STR(""));
+        TEST_ASSERT_EQUAL(local, test_queue_pop());
+    }
+
+    (void) test_queue_push(LOCAL_DEPLOYMENT, GG_STR("LOCAL"), GG_STR(""));
+    TEST_ASSERT_EQUAL(cloud, test_queue_pop());
+}
+
+#endif
@@ -13,16 +13,24 @@
 
 /// Attempts to add a deployment into the queue.
 ///
-/// If the deployment ID does not exist already in the queue, then add the
-/// deployment to the end of the queue. If there is an existing deployment in
-/// the queue with the same ID, then replace it if the deployment is in a
-/// replaceable state. Otherwise, do not add the deployment to the queue and
-/// return an error.
+/// If there is an existing deployment in the queue with the same ID, then
+/// replace it if the deployment is in a replaceable state. A cloud deployment
+/// also replaces a queued cloud deployment for the same thing group, taking
+/// its place in the queue. Otherwise, add the deployment to the end of the
+/// queue. Local deployments are dequeued before cloud deployments, unless a
+/// cloud deployment has already waited behind several local ones.
+///
+/// If the replaced cloud deployment has a different IoT job, its job ID is
+/// appended to superseded_job_id (if not NULL) so that the caller can report
+/// the job as no longer being processed.
+///
+/// Returns GG_ERR_BUSY if the queue or its document memory is full.
 GgError ggl_deployment_enqueue(
     GgMap deployment_doc,
     GgByteVec *id,
     GgBuffer iot_job_id,
-    GglDeploymentType type
+    GglDeploymentType type,
+    GgByteVec *superseded_job_id
 );
 
 /// Get the deployment queue for the next deployment.
@@ -220,8 +220,12 @@ static bool reject_is_permanent(GgObject result) {
         || gg_buffer_eq(code, GG_STR("TerminalStateReached"));
 }
 
-static GgError update_job_to(
-    GgBuffer job_id, GgBuffer job_status, GgBuffer socket_name
+static GgError call_update_job(
+    GgBuffer job_id,
+    GgBuffer job_status,
+    GgBuffer socket_name,
+    GgArena *alloc,
+    GgObject *result
 ) {
     GgBuffer topic = GG_BUF((uint8_t[256]) { 0 });
     GgError ret = create_update_job_topic(thing_name_buf, job_id, &topic);
@@ -229,11 +233,6 @@ static GgError update_job_to(
         return ret;
     }
 
-    // The pending-status slot is only tracked for the primary MQTT socket.
-    // The endpoint-switch path uses a temporary "iotcoreddeploy" socket with
-    // its own retry; persisting that would later flush via the wrong account.
-    bool track_pending = gg_buffer_eq(socket_name, GG_STR("aws_iot_mqtt"));
-
     // expectedVersion omitted to avoid VersionMismatch errors on MQTT
     // reconnect races; only one ggdeploymentd updates a given job.
     GgObject payload_object = gg_obj_map(GG_MAP(
@@ -241,13 +240,26 @@ static GgError update_job_to(
         gg_kv(GG_STR("clientToken"), gg_obj_buf(GG_STR("jobs-nucleus-lite")))
     ));
 
+    return ggl_aws_iot_call(
+        socket_name, topic, payload_object, false, alloc, result
+    );
+}
+
+static GgError update_job_to(
+    GgBuffer job_id, GgBuffer job_status, GgBuffer socket_name
+) {
+    // The pending-status slot is only tracked for the primary MQTT socket.
+    // The endpoint-switch path uses a temporary "iotcoreddeploy" socket with
+    // its own retry; persisting that would later flush via the wrong account.
+    bool track_pending = gg_buffer_eq(socket_name, GG_STR("aws_iot_mqtt"));
+
     // Holds the decoded /accepted or /rejected response. Sized to fit a
     // rejection's executionState payload so the reject code can be classified.
     static uint8_t response_scratch[1024];
     GgArena call_alloc = gg_arena_init(GG_BUF(response_scratch));
     GgObject result = { 0 };
-    ret = ggl_aws_iot_call(
-        socket_name, topic, payload_object, false, &call_alloc, &result
+    GgError ret = call_update_job(
+        job_id, job_status, socket_name, &call_alloc, &result
     );
     if (ret != GG_ERR_OK) {
         GG_LOGE("Failed to publish on update job topic.");
@@ -299,6 +311,30 @@ static GgError update_job(GgBuffer job_id, GgBuffer job_status) {
     return update_job_to(job_id, job_status, GG_STR("aws_iot_mqtt"));
 }
 
+// A queued job replaced by a newer one for the same thing group never runs, so
+// it is moved to a terminal state. This does not affect the current job's
+// pending status or its saved bootstrap job ID.
+static void reject_superseded_job(GgBuffer job_id) {
+    GG_LOGI(
+        "Rejecting job %.*s superseded before it started.",
+        (int) job_id.len,
+        job_id.data
+    );
+    uint8_t response_mem[1024];
+    GgArena call_alloc = gg_arena_init(GG_BUF(response_mem));
+    GgObject result = { 0 };
+    GgError ret = call_update_job(
+        job_id, GG_STR("REJECTED"), GG_STR("aws_iot_mqtt"), &call_alloc, &result
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGW(
+            "Failed to report superseded job %.*s.",
+            (int) job_id.len,
+            job_id.data
+        );
+    }
+}
+
 static GgError describe_next_job(void *ctx) {
     (void) ctx;
     GG_LOGD("Requesting next job information.");
@@ -381,12 +417,17 @@ static GgError enqueue_job(
     }
 
     GgByteVec deployment_id_vec = GG_BYTE_VEC((uint8_t[64]) { 0 });
+    GgByteVec superseded_job_id = GG_BYTE_VEC((uint8_t[64]) { 0 });
 
     // TODO: backoff algorithm
     int64_t retries = 1;
     while (
         (ret = ggl_deployment_enqueue(
-             deployment_doc, &deployment_id_vec, job_id, THING_GROUP_DEPLOYMENT
+             deployment_doc,
+             &deployment_id_vec,
+             job_id,
+             THING_GROUP_DEPLOYMENT,
+             &superseded_job_id
          ))
         == GG_ERR_BUSY
     ) {
@@ -403,6 +444,10 @@ static GgError enqueue_job(
     // hint, so this is a no-op when nothing is pending.
     (void) status_keeper_clear();
 
+    if (superseded_job_id.buf.len > 0) {
+        reject_superseded_job(superseded_job_id.buf);
+    }
+
     if (ret != GG_ERR_OK) {
         (void) update_job(job_id, GG_STR("FAILURE"));
     }
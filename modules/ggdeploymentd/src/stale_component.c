@@ -1,7 +1,9 @@
 
 #include "stale_component.h"
+#include "artifact_store.h"
 #include "component_store.h"
 #include "deployment_model.h"
+#include "systemd_units.h"
 #include <assert.h>
 #include <dirent.h>
 #include <errno.h>
@@ -19,10 +21,10 @@
 #include <ggl/docker_artifact_cleanup.h>
 #include <limits.h>
 #include <string.h>
+#include <unistd.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <stdlib.h>
 
 // Forward declare structure for use in the function below.
 struct stat;
@@ -175,6 +177,25 @@ static GgError delete_component_recipe(
             root_path->capacity - INDEX_BEFORE_FILE_EXTENTION
         );
     }
+
+    // Remove the compiled form of the recipe, if any.
+    if (err == GG_ERR_OK) {
+        root_path->buf.len = INDEX_BEFORE_ADDITION;
+        err = gg_byte_vec_append(
+            root_path, GG_STR("/packages/compiled-recipes/")
+        );
+        gg_byte_vec_chain_append(&err, root_path, component_name);
+        gg_byte_vec_chain_append(&err, root_path, GG_STR("-"));
+        gg_byte_vec_chain_append(&err, root_path, version_number);
+        gg_byte_vec_chain_append(&err, root_path, GG_STR(".ggrc"));
+        gg_byte_vec_chain_push(&err, root_path, '\0');
+        if (err == GG_ERR_OK) {
+            (void) remove((char *) root_path->buf.data);
+        } else {
+            GG_LOGE("Failed to create a delete-compiled-recipe path string.");
+        }
+    }
+
     // We should reset the index regardless of the error code in case caller
     // does not exit.
     root_path->buf.len = INDEX_BEFORE_ADDITION;
@@ -329,184 +350,49 @@ static GgError delete_recipe_script_and_service_files(GgBuffer *component_name
     return ret;
 }
 
-// NOLINTNEXTLINE(readability-function-cognitive-complexity)
-GgError disable_and_unlink_service(
-    GgBuffer *component_name, PhaseSelection phase
-) {
-    static uint8_t command_array[PATH_MAX];
-    GgByteVec command_vec = GG_BYTE_VEC(command_array);
-
-    GgError ret = gg_byte_vec_append(&command_vec, GG_STR("systemctl stop "));
-    gg_byte_vec_chain_append(&ret, &command_vec, GG_STR("ggl."));
-    gg_byte_vec_chain_append(&ret, &command_vec, *component_name);
-    if (phase == INSTALL) {
-        gg_byte_vec_chain_append(&ret, &command_vec, GG_STR(".install"));
-    } else if (phase == BOOTSTRAP) {
-        gg_byte_vec_chain_append(&ret, &command_vec, GG_STR(".bootstrap"));
-    } else {
-        // Incase of startup/run nothing to append
-        assert(phase == RUN_STARTUP);
-    }
-    gg_byte_vec_chain_append(&ret, &command_vec, GG_STR(".service"));
-    gg_byte_vec_chain_push(&ret, &command_vec, '\0');
-    if (ret != GG_ERR_OK) {
-        GG_LOGE("Failed to create systemctl stop command.");
-        return ret;
-    }
-
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    int system_ret = system((char *) command_vec.buf.data);
-    if (WIFEXITED(system_ret)) {
-        if (WEXITSTATUS(system_ret) != 0) {
-            GG_LOGD("systemctl stop failed");
-        }
-        GG_LOGI(
-            "systemctl stop exited with child status %d\n",
-            WEXITSTATUS(system_ret)
-        );
-    } else {
-        GG_LOGE("systemctl stop did not exit normally");
-    }
-
-    memset(command_array, 0, sizeof(command_array));
-    command_vec.buf.len = 0;
-
-    ret = gg_byte_vec_append(&command_vec, GG_STR("systemctl disable "));
-    gg_byte_vec_chain_append(&ret, &command_vec, GG_STR("ggl."));
-    gg_byte_vec_chain_append(&ret, &command_vec, *component_name);
-    gg_byte_vec_chain_append(&ret, &command_vec, GG_STR(".service"));
-    gg_byte_vec_chain_push(&ret, &command_vec, '\0');
-    if (ret != GG_ERR_OK) {
-        GG_LOGE("Failed to create systemctl disable command.");
-        return ret;
-    }
-
-    // TODO: replace system call with platform independent function.
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    system_ret = system((char *) command_vec.buf.data);
-    if (WIFEXITED(system_ret)) {
-        if (WEXITSTATUS(system_ret) != 0) {
-            GG_LOGD("systemctl disable failed");
-        }
-        GG_LOGI(
-            "systemctl disable exited with child status %d\n",
-            WEXITSTATUS(system_ret)
-        );
-    } else {
-        GG_LOGE("systemctl disable did not exit normally");
+static void unlink_system_service_link(const char *dir, GgBuffer component) {
+    static uint8_t path_mem[PATH_MAX];
+    GgByteVec path = GG_BYTE_VEC(path_mem);
+    GgError ret
+        = gg_byte_vec_append(&path, gg_buffer_from_null_term((char *) dir));
+    if (ret == GG_ERR_OK) {
+        ret = systemd_unit_name(component, RUN_STARTUP, &path);
     }
-
-    memset(command_array, 0, sizeof(command_array));
-    command_vec.buf.len = 0;
-
-    // TODO: replace this with a better approach such as 'unlink'.
-    ret = gg_byte_vec_append(&command_vec, GG_STR("rm /etc/systemd/system/"));
-    gg_byte_vec_chain_append(&ret, &command_vec, GG_STR("ggl."));
-    gg_byte_vec_chain_append(&ret, &command_vec, *component_name);
-    gg_byte_vec_chain_append(&ret, &command_vec, GG_STR(".service"));
-    gg_byte_vec_chain_push(&ret, &command_vec, '\0');
     if (ret != GG_ERR_OK) {
-        GG_LOGE("Failed to create rm /etc/systemd/system/[service] command.");
-        return ret;
+        GG_LOGE("Failed to create service link path.");
+        return;
     }
-
-    // TODO: replace system call with platform independent function.
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    system_ret = system((char *) command_vec.buf.data);
-    if (WIFEXITED(system_ret)) {
-        if (WEXITSTATUS(system_ret) != 0) {
-            GG_LOGD("removing symlink failed");
-        }
-        GG_LOGI(
-            "rm /etc/systemd/system/[service] exited with child status %d\n",
-            WEXITSTATUS(system_ret)
-        );
-    } else {
-        GG_LOGE("rm /etc/systemd/system/[service] did not exit normally");
-    }
-
-    memset(command_array, 0, sizeof(command_array));
-    command_vec.buf.len = 0;
-
-    // TODO: replace this with a better approach such as 'unlink'.
-    ret = gg_byte_vec_append(
-        &command_vec, GG_STR("rm /usr/lib/systemd/system/")
-    );
-    gg_byte_vec_chain_append(&ret, &command_vec, GG_STR("ggl."));
-    gg_byte_vec_chain_append(&ret, &command_vec, *component_name);
-    gg_byte_vec_chain_append(&ret, &command_vec, GG_STR(".service"));
-    gg_byte_vec_chain_push(&ret, &command_vec, '\0');
-    if (ret != GG_ERR_OK) {
-        GG_LOGE("Failed to create rm /usr/lib/systemd/system/[service] command."
-        );
-        return ret;
+    if ((unlink((char *) path_mem) != 0) && (errno != ENOENT)) {
+        GG_LOGD("Failed to remove %s (errno=%d).", path_mem, errno);
     }
+}
 
-    // TODO: replace system call with platform independent function.
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    system_ret = system((char *) command_vec.buf.data);
-    if (WIFEXITED(system_ret)) {
-        if (WEXITSTATUS(system_ret) != 0) {
-            GG_LOGD("removing symlink failed");
-        }
-        GG_LOGI(
-            "rm /usr/lib/systemd/system/[service] exited with child status %d\n",
-            WEXITSTATUS(system_ret)
+// Stops the phase services and removes the run service links without
+// reloading systemd.
+static void stop_and_unlink_services(
+    GgBufList component_names, PhaseSelection phase
+) {
+    (void) systemd_units_stop(component_names, phase);
+    (void) systemd_units_disable(component_names, RUN_STARTUP);
+    for (size_t i = 0; i < component_names.len; i++) {
+        unlink_system_service_link(
+            "/etc/systemd/system/", component_names.bufs[i]
         );
-    } else {
-        GG_LOGE("rm /usr/lib/systemd/system/[service] did not exit normally");
-    }
-
-    memset(command_array, 0, sizeof(command_array));
-    command_vec.buf.len = 0;
-
-    ret = gg_byte_vec_append(&command_vec, GG_STR("systemctl daemon-reload"));
-    gg_byte_vec_chain_push(&ret, &command_vec, '\0');
-    if (ret != GG_ERR_OK) {
-        GG_LOGE("Failed to create systemctl daemon-reload command.");
-        return ret;
-    }
-
-    // TODO: replace system call with platform independent function.
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    system_ret = system((char *) command_vec.buf.data);
-    if (WIFEXITED(system_ret)) {
-        if (WEXITSTATUS(system_ret) != 0) {
-            GG_LOGE("systemctl daemon-reload failed");
-        }
-        GG_LOGI(
-            "systemctl daemon-reload exited with child status %d\n",
-            WEXITSTATUS(system_ret)
+        unlink_system_service_link(
+            "/usr/lib/systemd/system/", component_names.bufs[i]
         );
-    } else {
-        GG_LOGE("systemctl daemon-reload did not exit normally");
-    }
-
-    memset(command_array, 0, sizeof(command_array));
-    command_vec.buf.len = 0;
-
-    ret = gg_byte_vec_append(&command_vec, GG_STR("systemctl reset-failed"));
-    gg_byte_vec_chain_push(&ret, &command_vec, '\0');
-    if (ret != GG_ERR_OK) {
-        GG_LOGE("Failed to create systemctl reset-failed command.");
-        return ret;
     }
+}
 
-    // TODO: replace system call with platform independent function.
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    system_ret = system((char *) command_vec.buf.data);
-    if (WIFEXITED(system_ret)) {
-        if (WEXITSTATUS(system_ret) != 0) {
-            GG_LOGE("systemctl reset-failed failed");
-        }
-        GG_LOGI(
-            "systemctl reset-failed exited with child status %d\n",
-            WEXITSTATUS(system_ret)
-        );
-    } else {
-        GG_LOGE("systemctl reset-failed did not exit normally");
+GgError disable_and_unlink_services(
+    GgBufList component_names, PhaseSelection phase
+) {
+    if (component_names.len == 0) {
+        return GG_ERR_OK;
     }
-
+    stop_and_unlink_services(component_names, phase);
+    (void) systemd_daemon_reload();
+    (void) systemd_reset_failed();
     return GG_ERR_OK;
 }
 
@@ -585,6 +471,7 @@ GgError cleanup_stale_versions(
     uint8_t version_array[NAME_MAX];
     GgBuffer version_buffer_iterator = { .data = version_array, .len = 0 };
 
+    bool units_removed = false;
     while (true) {
         ret = iterate_over_components(
             dir,
@@ -645,16 +532,14 @@ GgError cleanup_stale_versions(
                 removed_components_out
             );
 
-            // Also stop any running service for this component.
-            (void) disable_and_unlink_service(
-                &component_name_buffer_iterator, RUN_STARTUP
-            );
-            (void) disable_and_unlink_service(
-                &component_name_buffer_iterator, INSTALL
-            );
-            (void) disable_and_unlink_service(
-                &component_name_buffer_iterator, BOOTSTRAP
-            );
+            // Also stop any running service for this component. systemd is
+            // reloaded once after all removals.
+            GgBufList removed_name
+                = { .bufs = &component_name_buffer_iterator, .len = 1 };
+            stop_and_unlink_services(removed_name, RUN_STARTUP);
+            stop_and_unlink_services(removed_name, INSTALL);
+            stop_and_unlink_services(removed_name, BOOTSTRAP);
+            units_removed = true;
 
             // Also delete the .script.install and .script.run and .service
             // files.
@@ -664,5 +549,17 @@ GgError cleanup_stale_versions(
         }
     }
 
+    if (units_removed) {
+        (void) systemd_daemon_reload();
+        (void) systemd_reset_failed();
+    }
+
+    // Stored artifacts only linked from deleted versions can now be removed.
+    int root_path_fd;
+    if (get_root_path_fd(&root_path_fd) == GG_ERR_OK) {
+        artifact_store_collect_garbage(root_path_fd);
+        (void) gg_close(root_path_fd);
+    }
+
     return GG_ERR_OK;
 }
@@ -6,8 +6,10 @@
 #include <gg/types.h>
 #include <gg/vector.h>
 
-GgError disable_and_unlink_service(
-    GgBuffer *component_name, PhaseSelection phase
+/// Stops the phase service of each component, disables and removes the links
+/// of their run services, and reloads systemd once.
+GgError disable_and_unlink_services(
+    GgBufList component_names, PhaseSelection phase
 );
 
 /// Iterates installed component recipes and removes any whose name+version is
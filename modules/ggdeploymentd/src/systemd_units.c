@@ -0,0 +1,495 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "systemd_units.h"
+#include "deployment_model.h"
+#include <assert.h>
+#include <errno.h>
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/log.h>
+#include <gg/types.h>
+#include <gg/vector.h>
+#include <limits.h>
+#include <string.h>
+#include <systemd/sd-bus.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SYSTEMD_DESTINATION "org.freedesktop.systemd1"
+#define SYSTEMD_PATH "/org/freedesktop/systemd1"
+#define MANAGER_INTERFACE "org.freedesktop.systemd1.Manager"
+
+// Stop jobs waited on concurrently.
+#define JOB_BATCH_SIZE 32
+#define JOB_PATH_MAX 128
+
+static GgError translate_dbus_error(int error) {
+    switch (error) {
+    case -ENOTCONN:
+    case -ECONNRESET:
+        return GG_ERR_NOCONN;
+    case -ENOMEM:
+        return GG_ERR_NOMEM;
+    case -ENOENT:
+        return GG_ERR_NOENTRY;
+    default:
+        return GG_ERR_FAILURE;
+    }
+}
+
+// bus must be freed via sd_bus_unrefp
+static GgError open_systemd_bus(sd_bus **bus) {
+    int ret = sd_bus_default_system(bus);
+    if (ret < 0) {
+        GG_LOGE("Unable to open default system bus (errno=%d).", -ret);
+        *bus = NULL;
+        return translate_dbus_error(ret);
+    }
+    return GG_ERR_OK;
+}
+
+GgError systemd_unit_name(
+    GgBuffer component_name, PhaseSelection phase, GgByteVec *unit
+) {
+    GgError ret = gg_byte_vec_append(unit, GG_STR("ggl."));
+    gg_byte_vec_chain_append(&ret, unit, component_name);
+    if (phase == INSTALL) {
+        gg_byte_vec_chain_append(&ret, unit, GG_STR(".install"));
+    } else if (phase == BOOTSTRAP) {
+        gg_byte_vec_chain_append(&ret, unit, GG_STR(".bootstrap"));
+    } else {
+        assert(phase == RUN_STARTUP);
+    }
+    gg_byte_vec_chain_append(&ret, unit, GG_STR(".service"));
+    gg_byte_vec_chain_push(&ret, unit, '\0');
+    return ret;
+}
+
+static GgError append_unit_files(
+    sd_bus_message *msg,
+    GgBuffer root_path,
+    GgBufList component_names,
+    PhaseSelection phase
+) {
+    int ret = sd_bus_message_open_container(msg, 'a', "s");
+    for (size_t i = 0; (ret >= 0) && (i < component_names.len); i++) {
+        uint8_t unit_mem[PATH_MAX];
+        GgByteVec unit = GG_BYTE_VEC(unit_mem);
+        GgError err = GG_ERR_OK;
+        if (root_path.len != 0) {
+            gg_byte_vec_chain_append(&err, &unit, root_path);
+            gg_byte_vec_chain_push(&err, &unit, '/');
+        }
+        if (err == GG_ERR_OK) {
+            err = systemd_unit_name(component_names.bufs[i], phase, &unit);
+        }
+        if (err != GG_ERR_OK) {
+            GG_LOGE(
+                "Unit file path too long for %.*s.",
+                (int) component_names.bufs[i].len,
+                component_names.bufs[i].data
+            );
+            return err;
+        }
+        ret = sd_bus_message_append_basic(msg, 's', unit_mem);
+    }
+    if (ret >= 0) {
+        ret = sd_bus_message_close_container(msg);
+    }
+    if (ret < 0) {
+        GG_LOGE("Failed to build unit file list (errno=%d).", -ret);
+        return translate_dbus_error(ret);
+    }
+    return GG_ERR_OK;
+}
+
+/// Calls one of the Manager *UnitFiles methods, which take a list of unit
+/// files followed by the `runtime` flag and, except for disable, `force`.
+static GgError call_unit_files_method(
+    const char *method,
+    GgBuffer root_path,
+    GgBufList component_names,
+    PhaseSelection phase,
+    bool has_force
+) {
+    if (component_names.len == 0) {
+        return GG_ERR_OK;
+    }
+
+    sd_bus *bus = NULL;
+    GgError err = open_systemd_bus(&bus);
+    GG_CLEANUP(sd_bus_unrefp, bus);
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+
+    sd_bus_message *msg = NULL;
+    int ret = sd_bus_message_new_method_call(
+        bus, &msg, SYSTEMD_DESTINATION, SYSTEMD_PATH, MANAGER_INTERFACE, method
+    );
+    GG_CLEANUP(sd_bus_message_unrefp, msg);
+    if (ret < 0) {
+        GG_LOGE("Failed to create %s call (errno=%d).", method, -ret);
+        return translate_dbus_error(ret);
+    }
+
+    err = append_unit_files(msg, root_path, component_names, phase);
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+
+    int runtime = false;
+    int force = true;
+    ret = has_force ? sd_bus_message_append(msg, "bb", runtime, force)
+                    : sd_bus_message_append(msg, "b", runtime);
+    if (ret < 0) {
+        GG_LOGE("Failed to append %s arguments (errno=%d).", method, -ret);
+        return translate_dbus_error(ret);
+    }
+
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message *reply = NULL;
+    ret = sd_bus_call(bus, msg, 0, &error, &reply);
+    GG_CLEANUP(sd_bus_error_free, error);
+    GG_CLEANUP(sd_bus_message_unrefp, reply);
+    if (ret < 0) {
+        GG_LOGE(
+            "systemd %s failed for %zu unit(s) (errno=%d) (name=%s) (message=%s)",
+            method,
+            component_names.len,
+            -ret,
+            error.name,
+            error.message
+        );
+        return translate_dbus_error(ret);
+    }
+
+    GG_LOGI(
+        "systemd %s completed for %zu unit(s).", method, component_names.len
+    );
+    return GG_ERR_OK;
+}
+
+GgError systemd_units_link(
+    GgBuffer root_path, GgBufList component_names, PhaseSelection phase
+) {
+    return call_unit_files_method(
+        "LinkUnitFiles", root_path, component_names, phase, true
+    );
+}
+
+GgError systemd_units_enable(
+    GgBuffer root_path, GgBufList component_names, PhaseSelection phase
+) {
+    return call_unit_files_method(
+        "EnableUnitFiles", root_path, component_names, phase, true
+    );
+}
+
+GgError systemd_units_disable(
+    GgBufList component_names, PhaseSelection phase
+) {
+    return call_unit_files_method(
+        "DisableUnitFiles", (GgBuffer) { 0 }, component_names, phase, false
+    );
+}
+
+static GgError call_manager_method(const char *method) {
+    sd_bus *bus = NULL;
+    GgError err = open_systemd_bus(&bus);
+    GG_CLEANUP(sd_bus_unrefp, bus);
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message *reply = NULL;
+    int ret = sd_bus_call_method(
+        bus,
+        SYSTEMD_DESTINATION,
+        SYSTEMD_PATH,
+        MANAGER_INTERFACE,
+        method,
+        &error,
+        &reply,
+        NULL
+    );
+    GG_CLEANUP(sd_bus_error_free, error);
+    GG_CLEANUP(sd_bus_message_unrefp, reply);
+    if (ret < 0) {
+        GG_LOGE(
+            "systemd %s failed (errno=%d) (name=%s) (message=%s)",
+            method,
+            -ret,
+            error.name,
+            error.message
+        );
+        return translate_dbus_error(ret);
+    }
+    return GG_ERR_OK;
+}
+
+GgError systemd_daemon_reload(void) {
+    return call_manager_method("Reload");
+}
+
+GgError systemd_reset_failed(void) {
+    return call_manager_method("ResetFailed");
+}
+
+typedef struct {
+    char job_paths[JOB_BATCH_SIZE][JOB_PATH_MAX];
+    size_t job_count;
+    size_t remaining;
+    /// Set if any job finished with a result other than `done`.
+    bool failed;
+} JobWaitCtx;
+
+static int job_removed_handler(
+    sd_bus_message *msg, void *userdata, sd_bus_error *ret_error
+) {
+    (void) ret_error;
+    JobWaitCtx *ctx = userdata;
+    uint32_t id = 0;
+    const char *path = NULL;
+    const char *unit = NULL;
+    const char *result = NULL;
+    int ret = sd_bus_message_read(msg, "uoss", &id, &path, &unit, &result);
+    if (ret < 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < ctx->job_count; i++) {
+        if ((ctx->job_paths[i][0] != '\0')
+            && (strcmp(ctx->job_paths[i], path) == 0)) {
+            if (strcmp(result, "done") == 0) {
+                GG_LOGD("Job for %s finished.", unit);
+            } else {
+                GG_LOGE("Job for %s finished with result %s.", unit, result);
+                ctx->failed = true;
+            }
+            ctx->job_paths[i][0] = '\0';
+            ctx->remaining--;
+            break;
+        }
+    }
+    return 0;
+}
+
+/// Queues a start or stop job for a unit. If ctx is non-NULL, the job is
+/// added to the jobs ctx waits on.
+static GgError queue_unit_job(
+    sd_bus *bus,
+    const char *method,
+    const char *unit,
+    const char *mode,
+    JobWaitCtx *ctx
+) {
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message *reply = NULL;
+    int ret = sd_bus_call_method(
+        bus,
+        SYSTEMD_DESTINATION,
+        SYSTEMD_PATH,
+        MANAGER_INTERFACE,
+        method,
+        &error,
+        &reply,
+        "ss",
+        unit,
+        mode
+    );
+    GG_CLEANUP(sd_bus_error_free, error);
+    GG_CLEANUP(sd_bus_message_unrefp, reply);
+    if (ret < 0) {
+        GG_LOGD(
+            "systemd %s failed for %s (errno=%d) (name=%s) (message=%s)",
+            method,
+            unit,
+            -ret,
+            error.name,
+            error.message
+        );
+        return translate_dbus_error(ret);
+    }
+
+    const char *job_path = NULL;
+    ret = sd_bus_message_read_basic(reply, 'o', &job_path);
+    if (ret < 0) {
+        GG_LOGE("Failed to read job path for %s (errno=%d).", unit, -ret);
+        return translate_dbus_error(ret);
+    }
+    GG_LOGD("Queued %s job %s for %s.", method, job_path, unit);
+
+    if (ctx != NULL) {
+        assert(ctx->job_count < JOB_BATCH_SIZE);
+        size_t len = strlen(job_path);
+        if (len >= JOB_PATH_MAX) {
+            return GG_ERR_RANGE;
+        }
+        memcpy(ctx->job_paths[ctx->job_count], job_path, len + 1);
+        ctx->job_count++;
+        ctx->remaining++;
+    }
+    return GG_ERR_OK;
+}
+
+static GgError wait_for_jobs(sd_bus *bus, JobWaitCtx *ctx) {
+    while (ctx->remaining > 0) {
+        int ret = sd_bus_process(bus, NULL);
+        if (ret > 0) {
+            continue;
+        }
+        if (ret >= 0) {
+            ret = sd_bus_wait(bus, UINT64_MAX);
+        }
+        if (ret < 0) {
+            GG_LOGE("Failed waiting for systemd jobs (errno=%d).", -ret);
+            return translate_dbus_error(ret);
+        }
+    }
+    return GG_ERR_OK;
+}
+
+/// Job signals are only broadcast while a client is subscribed. A failure is
+/// not fatal as the connection may already be subscribed.
+static void subscribe_job_signals(sd_bus *bus, const char *method) {
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    int ret = sd_bus_call_method(
+        bus,
+        SYSTEMD_DESTINATION,
+        SYSTEMD_PATH,
+        MANAGER_INTERFACE,
+        method,
+        &error,
+        NULL,
+        NULL
+    );
+    GG_CLEANUP(sd_bus_error_free, error);
+    if (ret < 0) {
+        GG_LOGD(
+            "systemd %s failed (errno=%d) (name=%s).", method, -ret, error.name
+        );
+    }
+}
+
+/// Runs queued jobs to completion. Units are processed in batches of
+/// JOB_BATCH_SIZE so that jobs in a batch run concurrently.
+static GgError run_unit_jobs(
+    const char *method,
+    const char *mode,
+    GgBufList component_names,
+    PhaseSelection phase,
+    bool ignore_missing
+) {
+    if (component_names.len == 0) {
+        return GG_ERR_OK;
+    }
+
+    sd_bus *bus = NULL;
+    GgError err = open_systemd_bus(&bus);
+    GG_CLEANUP(sd_bus_unrefp, bus);
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+
+    JobWaitCtx ctx = { 0 };
+    sd_bus_slot *slot = NULL;
+    int ret = sd_bus_match_signal(
+        bus,
+        &slot,
+        SYSTEMD_DESTINATION,
+        SYSTEMD_PATH,
+        MANAGER_INTERFACE,
+        "JobRemoved",
+        job_removed_handler,
+        &ctx
+    );
+    GG_CLEANUP(sd_bus_slot_unrefp, slot);
+    if (ret < 0) {
+        GG_LOGE("Failed to match systemd JobRemoved (errno=%d).", -ret);
+        return translate_dbus_error(ret);
+    }
+    subscribe_job_signals(bus, "Subscribe");
+
+    for (size_t start = 0; (err == GG_ERR_OK) && (start < component_names.len);
+         start += JOB_BATCH_SIZE) {
+        ctx = (JobWaitCtx) { 0 };
+        for (size_t i = start;
+             (i < component_names.len) && (i < start + JOB_BATCH_SIZE);
+             i++) {
+            uint8_t unit_mem[PATH_MAX];
+            GgByteVec unit = GG_BYTE_VEC(unit_mem);
+            err = systemd_unit_name(component_names.bufs[i], phase, &unit);
+            if (err != GG_ERR_OK) {
+                break;
+            }
+            err = queue_unit_job(bus, method, (char *) unit_mem, mode, &ctx);
+            if (ignore_missing && (err != GG_ERR_OK)) {
+                err = GG_ERR_OK;
+            }
+            if (err != GG_ERR_OK) {
+                break;
+            }
+        }
+        GgError wait_err = wait_for_jobs(bus, &ctx);
+        if (err == GG_ERR_OK) {
+            err = wait_err;
+        }
+        if ((err == GG_ERR_OK) && ctx.failed) {
+            err = GG_ERR_FAILURE;
+        }
+    }
+
+    subscribe_job_signals(bus, "Unsubscribe");
+    return err;
+}
+
+GgError systemd_units_stop(GgBufList component_names, PhaseSelection phase) {
+    return run_unit_jobs("StopUnit", "replace", component_names, phase, true);
+}
+
+GgError systemd_unit_start(
+    GgBuffer component_name, PhaseSelection phase, bool wait
+) {
+    GgBufList names = { .bufs = &component_name, .len = 1 };
+    if (wait) {
+        return run_unit_jobs("StartUnit", "replace", names, phase, false);
+    }
+
+    uint8_t unit_mem[PATH_MAX];
+    GgByteVec unit = GG_BYTE_VEC(unit_mem);
+    GgError err = systemd_unit_name(component_name, phase, &unit);
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+
+    sd_bus *bus = NULL;
+    err = open_systemd_bus(&bus);
+    GG_CLEANUP(sd_bus_unrefp, bus);
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+    return queue_unit_job(bus, "StartUnit", (char *) unit_mem, "replace", NULL);
+}
+
+static GgError start_unit_by_name(const char *unit, const char *mode) {
+    sd_bus *bus = NULL;
+    GgError err = open_systemd_bus(&bus);
+    GG_CLEANUP(sd_bus_unrefp, bus);
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+    return queue_unit_job(bus, "StartUnit", unit, mode, NULL);
+}
+
+GgError systemd_start_greengrass_target(void) {
+    return start_unit_by_name("greengrass-lite.target", "replace");
+}
+
+GgError systemd_reboot(void) {
+    return start_unit_by_name("reboot.target", "replace-irreversibly");
+}
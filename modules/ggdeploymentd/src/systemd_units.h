@@ -0,0 +1,59 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef GGDEPLOYMENTD_SYSTEMD_UNITS_H
+#define GGDEPLOYMENTD_SYSTEMD_UNITS_H
+
+#include "deployment_model.h"
+#include <gg/error.h>
+#include <gg/types.h>
+#include <gg/vector.h>
+#include <stdbool.h>
+
+// Component service management through the systemd D-Bus API. Functions
+// taking a list of component names act on the `ggl.<name>[.<phase>].service`
+// unit of each in a single systemd call. Unit file changes are not visible to
+// systemd until systemd_daemon_reload is called.
+
+/// Writes the null-terminated unit name for a component phase to unit.
+GgError systemd_unit_name(
+    GgBuffer component_name, PhaseSelection phase, GgByteVec *unit
+);
+
+/// Equivalent to `systemctl link <root_path>/<unit>...`.
+GgError systemd_units_link(
+    GgBuffer root_path, GgBufList component_names, PhaseSelection phase
+);
+
+/// Equivalent to `systemctl enable <root_path>/<unit>...`.
+GgError systemd_units_enable(
+    GgBuffer root_path, GgBufList component_names, PhaseSelection phase
+);
+
+/// Equivalent to `systemctl disable <unit>...`.
+GgError systemd_units_disable(GgBufList component_names, PhaseSelection phase);
+
+/// Equivalent to `systemctl stop <unit>...`; waits for all stop jobs.
+/// Units that are not loaded are skipped. Fails if any stop job fails.
+GgError systemd_units_stop(GgBufList component_names, PhaseSelection phase);
+
+/// Equivalent to `systemctl start <unit>`, or with `--no-block` if wait is
+/// false. When waiting, fails if the start job does not complete successfully.
+GgError systemd_unit_start(
+    GgBuffer component_name, PhaseSelection phase, bool wait
+);
+
+/// Equivalent to `systemctl start greengrass-lite.target`.
+GgError systemd_start_greengrass_target(void);
+
+/// Equivalent to `systemctl daemon-reload`.
+GgError systemd_daemon_reload(void);
+
+/// Equivalent to `systemctl reset-failed`.
+GgError systemd_reset_failed(void);
+
+/// Equivalent to `systemctl reboot`.
+GgError systemd_reboot(void);
+
+#endif
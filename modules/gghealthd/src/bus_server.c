@@ -5,13 +5,16 @@
 #include "health.h"
 #include "subscriptions.h"
 #include <bus_server.h>
+#include <gg/arena.h>
 #include <gg/buffer.h>
 #include <gg/error.h>
 #include <gg/flags.h>
+#include <gg/list.h>
 #include <gg/log.h>
 #include <gg/map.h>
 #include <gg/object.h>
 #include <gg/types.h>
+#include <gg/vector.h>
 #include <ggl/core_bus/server.h>
 #include <ggl/nucleus/constants.h>
 #include <stdbool.h>
@@ -20,6 +23,9 @@
 
 #define LIFECYCLE_STATE_MAX_LEN (sizeof("INSTALLED") - 1U)
 
+// Bounded in practice by GGL_COREBUS_MAX_MSG_LEN of the response.
+#define GET_STATUSES_MAX_COMPONENTS 256
+
 static GgError get_status(void *ctx, GgMap params, uint32_t handle) {
     (void) ctx;
     GgObject *component_name_obj;
@@ -63,6 +69,52 @@ static GgError get_status(void *ctx, GgMap params, uint32_t handle) {
     return GG_ERR_OK;
 }
 
+static GgError get_statuses(void *ctx, GgMap params, uint32_t handle) {
+    (void) ctx;
+    GgObject *component_names_obj = NULL;
+    GgError ret = gg_map_validate(
+        params,
+        GG_MAP_SCHEMA({ GG_STR("component_names"),
+                        GG_OPTIONAL,
+                        GG_TYPE_LIST,
+                        &component_names_obj })
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("get_statuses received invalid arguments.");
+        return GG_ERR_INVALID;
+    }
+
+    GgList component_names = { 0 };
+    if (component_names_obj != NULL) {
+        component_names = gg_obj_into_list(*component_names_obj);
+        ret = gg_list_type_check(component_names, GG_TYPE_BUF);
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("`component_names` must be a list of buffers.");
+            return GG_ERR_INVALID;
+        }
+    }
+
+    // Holds the configured component names when none are requested
+    static uint8_t component_list_mem[GET_STATUSES_MAX_COMPONENTS
+                                      * (sizeof(GgObject)
+                                         + GGL_COMPONENT_NAME_MAX_LEN)];
+    GgArena alloc = gg_arena_init(GG_BUF(component_list_mem));
+    static GgKV status_pairs[GET_STATUSES_MAX_COMPONENTS];
+    GgKVVec statuses = GG_KV_VEC(status_pairs);
+    GgError error = gghealthd_get_statuses(
+        (component_names_obj != NULL) ? &component_names : NULL,
+        &alloc,
+        &statuses
+    );
+    if (error != GG_ERR_OK) {
+        return error;
+    }
+
+    GG_LOGD("Reporting status of %zu components.", statuses.map.len);
+    ggl_respond(handle, gg_obj_map(statuses.map));
+    return GG_ERR_OK;
+}
+
 static GgError update_status(void *ctx, GgMap params, uint32_t handle) {
     (void) ctx;
     GgObject *component_name_obj;
@@ -220,6 +272,7 @@ GgError run_gghealthd(void) {
     }
     static GglRpcMethodDesc handlers[]
         = { { GG_STR("get_status"), false, get_status, NULL },
+            { GG_STR("get_statuses"), false, get_statuses, NULL },
             { GG_STR("update_status"), false, update_status, NULL },
             { GG_STR("get_health"), false, get_health, NULL },
             { GG_STR("restart_component"), false, restart_component, NULL },
@@ -5,6 +5,7 @@
 #include "health.h"
 #include "bus_client.h"
 #include "sd_bus.h"
+#include "state_cache.h"
 #include "subscriptions.h"
 #include <assert.h>
 #include <gg/arena.h>
@@ -19,8 +20,8 @@
 #include <ggl/nucleus/constants.h>
 #include <ggl/process.h>
 #include <systemd/sd-bus.h>
-#include <systemd/sd-daemon.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -31,11 +32,25 @@ GgError gghealthd_get_status(GgBuffer component_name, GgBuffer *status) {
         return GG_ERR_RANGE;
     }
 
+    bool is_self = gg_buffer_eq(component_name, GG_STR("gghealthd"));
+    if (!is_self) {
+        // Cached states belong to loaded component units; units of removed
+        // components are unloaded, which drops their state.
+        if (state_cache_get(component_name, status)) {
+            return GG_ERR_OK;
+        }
+        // only relay lifecycle state for configured components
+        GgError err = verify_component_exists(component_name);
+        if (err != GG_ERR_OK) {
+            return err;
+        }
+    }
+
     sd_bus *bus = NULL;
     GgError err = open_bus(&bus);
     GG_CLEANUP(sd_bus_unrefp, bus);
 
-    if (gg_buffer_eq(component_name, GG_STR("gghealthd"))) {
+    if (is_self) {
         if (err == GG_ERR_OK) {
             *status = GG_STR("RUNNING");
         } else if (err == GG_ERR_NOCONN) {
@@ -52,18 +67,13 @@ GgError gghealthd_get_status(GgBuffer component_name, GgBuffer *status) {
         return err;
     }
 
-    // only relay lifecycle state for configured components
-    err = verify_component_exists(component_name);
-    if (err != GG_ERR_OK) {
-        return err;
-    }
-
     uint8_t qualified_name[SERVICE_NAME_MAX_LEN + 1] = { 0 };
     err = get_service_name(component_name, &GG_BUF(qualified_name));
     if (err != GG_ERR_OK) {
         return GG_ERR_FAILURE;
     }
 
+    uint64_t generation = state_cache_generation();
     sd_bus_message *reply = NULL;
     const char *unit_path = NULL;
     err = get_unit_path(bus, (char *) qualified_name, &reply, &unit_path);
@@ -71,7 +81,253 @@ GgError gghealthd_get_status(GgBuffer component_name, GgBuffer *status) {
         return GG_ERR_FAILURE;
     }
     GG_CLEANUP(sd_bus_message_unrefp, reply);
-    return get_lifecycle_state(bus, unit_path, status);
+    err = get_lifecycle_state(bus, unit_path, status);
+    if (err != GG_ERR_OK) {
+        return err;
+    }
+    // Later changes arrive as PropertiesChanged signals.
+    state_cache_set(component_name, *status, generation);
+    return GG_ERR_OK;
+}
+
+// Upper bound on units returned by one ListUnitsByPatterns call; includes
+// install and bootstrap phase units.
+#define GGHEALTHD_MAX_LISTED_UNITS 256
+
+typedef struct {
+    GgBuffer id;
+    const char *active_state;
+    const char *unit_path;
+} ListedUnit;
+
+// Strings in units point into reply, which must outlive them.
+static GgError list_component_units(
+    sd_bus *bus, sd_bus_message **reply, ListedUnit *units, size_t *units_len
+) {
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    int ret = sd_bus_call_method(
+        bus,
+        DEFAULT_DESTINATION,
+        DEFAULT_PATH,
+        MANAGER_INTERFACE,
+        "ListUnitsByPatterns",
+        &error,
+        reply,
+        "asas",
+        0,
+        1,
+        SERVICE_PREFIX "*" SERVICE_SUFFIX
+    );
+    GG_CLEANUP(sd_bus_error_free, error);
+    if (ret < 0) {
+        GG_LOGE(
+            "Unable to list component units (errno=%d) (name=%s) (message=%s)",
+            -ret,
+            error.name,
+            error.message
+        );
+        return translate_dbus_call_error(ret);
+    }
+
+    ret = sd_bus_message_enter_container(*reply, 'a', "(ssssssouso)");
+    if (ret < 0) {
+        GG_LOGE("Invalid ListUnitsByPatterns reply (errno=%d)", -ret);
+        return GG_ERR_FAILURE;
+    }
+
+    size_t len = 0;
+    while (true) {
+        const char *id = NULL;
+        const char *active_state = NULL;
+        const char *unit_path = NULL;
+        ret = sd_bus_message_read(
+            *reply,
+            "(ssssssouso)",
+            &id,
+            NULL,
+            NULL,
+            &active_state,
+            NULL,
+            NULL,
+            &unit_path,
+            NULL,
+            NULL,
+            NULL
+        );
+        if (ret < 0) {
+            GG_LOGE("Invalid ListUnitsByPatterns reply (errno=%d)", -ret);
+            return GG_ERR_FAILURE;
+        }
+        if (ret == 0) {
+            break;
+        }
+        if (len == GGHEALTHD_MAX_LISTED_UNITS) {
+            GG_LOGW("Too many component units; remaining looked up singly.");
+            break;
+        }
+        units[len] = (ListedUnit) {
+            .id = gg_buffer_from_null_term((char *) id),
+            .active_state = active_state,
+            .unit_path = unit_path,
+        };
+        len += 1;
+    }
+
+    *units_len = len;
+    return GG_ERR_OK;
+}
+
+static const ListedUnit *find_component_unit(
+    const ListedUnit *units, size_t units_len, GgBuffer component_name
+) {
+    size_t id_len
+        = SERVICE_PREFIX_LEN + component_name.len + SERVICE_SUFFIX_LEN;
+    for (size_t i = 0; i < units_len; i++) {
+        GgBuffer id = units[i].id;
+        if ((id.len != id_len)
+            || !gg_buffer_has_prefix(id, GG_STR(SERVICE_PREFIX))
+            || !gg_buffer_has_suffix(id, GG_STR(SERVICE_SUFFIX))) {
+            continue;
+        }
+        GgBuffer name = gg_buffer_substr(
+            id, SERVICE_PREFIX_LEN, id.len - SERVICE_SUFFIX_LEN
+        );
+        if (gg_buffer_eq(name, component_name)) {
+            return &units[i];
+        }
+    }
+    return NULL;
+}
+
+// units were listed at cache generation `generation`. Components not taken
+// from the configuration and not cached are checked to still be configured,
+// as in gghealthd_get_status.
+static GgError lookup_listed_status(
+    sd_bus *bus,
+    const ListedUnit *units,
+    size_t units_len,
+    uint64_t generation,
+    bool configured,
+    GgBuffer component_name,
+    GgBuffer *status
+) {
+    if (gg_buffer_eq(component_name, GG_STR("gghealthd"))) {
+        return gghealthd_get_status(component_name, status);
+    }
+    if (state_cache_get(component_name, status)) {
+        return GG_ERR_OK;
+    }
+    if (!configured) {
+        GgError err = verify_component_exists(component_name);
+        if (err != GG_ERR_OK) {
+            return err;
+        }
+    }
+    const ListedUnit *unit
+        = find_component_unit(units, units_len, component_name);
+    if (unit == NULL) {
+        // Unit not loaded or not listed; report as gghealthd_get_status would
+        return gghealthd_get_status(component_name, status);
+    }
+    GgError err = get_lifecycle_state_from_active_state(
+        bus, unit->unit_path, (char *) unit->active_state, status
+    );
+    if (err == GG_ERR_OK) {
+        state_cache_set(component_name, *status, generation);
+    }
+    return err;
+}
+
+// Whether the unit listing can be skipped, as every component's state is
+// already cached.
+static bool all_states_cached(GgList names) {
+    GG_LIST_FOREACH (name_obj, names) {
+        if (gg_obj_type(*name_obj) != GG_TYPE_BUF) {
+            continue;
+        }
+        GgBuffer component_name = gg_obj_into_buf(*name_obj);
+        GgBuffer status;
+        if (!gg_buffer_eq(component_name, GG_STR("gghealthd"))
+            && !state_cache_get(component_name, &status)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+GgError gghealthd_get_statuses(
+    const GgList *component_names, GgArena *alloc, GgKVVec *statuses
+) {
+    assert((alloc != NULL) && (statuses != NULL));
+
+    GgList names;
+    if (component_names != NULL) {
+        names = *component_names;
+    } else {
+        GgError err = get_root_component_list(alloc, &names);
+        if (err != GG_ERR_OK) {
+            GG_LOGE("Failed to get component list.");
+            return err;
+        }
+    }
+
+    sd_bus *bus = NULL;
+    GG_CLEANUP(sd_bus_unrefp, bus);
+    static ListedUnit units[GGHEALTHD_MAX_LISTED_UNITS];
+    size_t units_len = 0;
+    uint64_t generation = state_cache_generation();
+    sd_bus_message *reply = NULL;
+    GG_CLEANUP(sd_bus_message_unrefp, reply);
+    GgError err;
+
+    if (!all_states_cached(names)) {
+        err = open_bus(&bus);
+        if (err != GG_ERR_OK) {
+            return err;
+        }
+        err = list_component_units(bus, &reply, units, &units_len);
+        if (err != GG_ERR_OK) {
+            // Components are still looked up individually below.
+            units_len = 0;
+        }
+    }
+
+    GG_LIST_FOREACH (name_obj, names) {
+        if (gg_obj_type(*name_obj) != GG_TYPE_BUF) {
+            GG_LOGE("Component name must be a buffer.");
+            return GG_ERR_INVALID;
+        }
+        GgBuffer component_name = gg_obj_into_buf(*name_obj);
+
+        GgBuffer status = { 0 };
+        err = lookup_listed_status(
+            bus,
+            units,
+            units_len,
+            generation,
+            component_names == NULL,
+            component_name,
+            &status
+        );
+        if (err != GG_ERR_OK) {
+            GG_LOGD(
+                "No lifecycle state for %.*s.",
+                (int) component_name.len,
+                component_name.data
+            );
+            continue;
+        }
+
+        err = gg_kv_vec_push(
+            statuses, gg_kv(component_name, gg_obj_buf(status))
+        );
+        if (err != GG_ERR_OK) {
+            GG_LOGE("Too many components for status response.");
+            return err;
+        }
+    }
+
+    return GG_ERR_OK;
 }
 
 GgError gghealthd_update_status(GgBuffer component_name, GgBuffer status) {
@@ -270,11 +526,6 @@ static void reset_failed_components(void) {
 
 GgError gghealthd_init(void) {
     reset_failed_components();
-    int notify_ret = sd_notify(0, "READY=1");
-    if (notify_ret < 0) {
-        GG_LOGE("Failed to send sd_notify (errno=%d).", -notify_ret);
-        return GG_ERR_FATAL;
-    }
     init_health_events();
     return GG_ERR_OK;
 }
@@ -5,14 +5,24 @@
 #ifndef GGHEALTHD_HEALTH_H
 #define GGHEALTHD_HEALTH_H
 
+#include <gg/arena.h>
 #include <gg/error.h>
 #include <gg/types.h>
+#include <gg/vector.h>
 
 GgError gghealthd_init(void);
 
 // get status from native orchestrator or local database
 GgError gghealthd_get_status(GgBuffer component_name, GgBuffer *status);
 
+// get status of each listed component, or of every root component if
+// component_names is NULL, from a single unit listing. Components without a
+// state are omitted. Names not taken from component_names are allocated in
+// alloc.
+GgError gghealthd_get_statuses(
+    const GgList *component_names, GgArena *alloc, GgKVVec *statuses
+);
+
 // update status (with GG component lifecycle state) in
 // native orchestrator or local database
 GgError gghealthd_update_status(GgBuffer component_name, GgBuffer status);
@@ -328,6 +328,18 @@ GgError get_lifecycle_state(
     if (err != GG_ERR_OK) {
         return err;
     }
+    return get_lifecycle_state_from_active_state(
+        bus, unit_path, active_state, state
+    );
+}
+
+GgError get_lifecycle_state_from_active_state(
+    sd_bus *bus, const char *unit_path, char *active_state, GgBuffer *state
+) {
+    assert(
+        (bus != NULL) && (unit_path != NULL) && (active_state != NULL)
+        && (state != NULL)
+    );
     const GgMap STATUS_MAP = GG_MAP(
         gg_kv(GG_STR("activating"), gg_obj_buf(GG_STR("STARTING"))),
         gg_kv(GG_STR("active"), gg_obj_buf(GG_STR("RUNNING"))),
@@ -354,8 +366,7 @@ GgError get_lifecycle_state(
     }
 
     // disambiguate `failed` and `inactive`
-    err = get_component_result(bus, unit_path, state);
-    return err;
+    return get_component_result(bus, unit_path, state);
 }
 
 void reset_restart_counters(sd_bus *bus, const char *qualified_name) {
@@ -54,6 +54,11 @@ GgError get_lifecycle_state(
     sd_bus *bus, const char *unit_path, GgBuffer *state
 );
 
+// As get_lifecycle_state, for a unit whose ActiveState is already known.
+GgError get_lifecycle_state_from_active_state(
+    sd_bus *bus, const char *unit_path, char *active_state, GgBuffer *state
+);
+
 NONNULL(2)
 GgError restart_component(sd_bus *bus, const char *qualified_name);
 
@@ -0,0 +1,208 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "state_cache.h"
+#include <gg/buffer.h>
+#include <gg/log.h>
+#include <ggl/nucleus/constants.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef GGHEALTHD_STATE_CACHE_SIZE
+#define GGHEALTHD_STATE_CACHE_SIZE 256
+#endif
+
+// Open-addressed table with linear probing. Invalidated entries keep their
+// name and lose their state, so probe chains are never broken and no
+// tombstones are needed; the table is cleared if it fills up.
+typedef struct {
+    uint8_t name[GGL_COMPONENT_NAME_MAX_LEN];
+    size_t name_len;
+    GgBuffer state;
+    // Generation of the entry's last invalidation
+    uint64_t generation;
+} StateCacheEntry;
+
+static StateCacheEntry entries[GGHEALTHD_STATE_CACHE_SIZE];
+static size_t entry_count;
+
+// Incremented on every invalidation and clear
+static uint64_t current_generation;
+static uint64_t cleared_generation;
+
+static size_t hash_name(GgBuffer name) {
+    // FNV-1a
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < name.len; i++) {
+        hash ^= name.data[i];
+        hash *= 16777619U;
+    }
+    return hash % GGHEALTHD_STATE_CACHE_SIZE;
+}
+
+static GgBuffer entry_name(const StateCacheEntry *entry) {
+    return (GgBuffer) { .data = (uint8_t *) entry->name,
+                        .len = entry->name_len };
+}
+
+// Returns the entry for name, or the empty entry where it would be inserted.
+// Returns NULL if the name is absent and the table is full.
+static StateCacheEntry *find_entry(GgBuffer name) {
+    size_t index = hash_name(name);
+    for (size_t i = 0; i < GGHEALTHD_STATE_CACHE_SIZE; i++) {
+        StateCacheEntry *entry = &entries[index];
+        if ((entry->name_len == 0)
+            || gg_buffer_eq(entry_name(entry), name)) {
+            return entry;
+        }
+        index = (index + 1) % GGHEALTHD_STATE_CACHE_SIZE;
+    }
+    return NULL;
+}
+
+bool state_cache_get(GgBuffer component_name, GgBuffer *state) {
+    if ((component_name.len == 0)
+        || (component_name.len > GGL_COMPONENT_NAME_MAX_LEN)) {
+        return false;
+    }
+    StateCacheEntry *entry = find_entry(component_name);
+    if ((entry == NULL) || (entry->name_len == 0)
+        || (entry->state.data == NULL)) {
+        return false;
+    }
+    *state = entry->state;
+    return true;
+}
+
+// Returns NULL if the table had to be cleared to make room.
+static StateCacheEntry *insert_entry(GgBuffer component_name) {
+    StateCacheEntry *entry = find_entry(component_name);
+    if ((entry == NULL)
+        || ((entry->name_len == 0)
+            && (entry_count + 1 >= GGHEALTHD_STATE_CACHE_SIZE))) {
+        GG_LOGD("Component state cache full; clearing.");
+        state_cache_clear();
+        return NULL;
+    }
+    if (entry->name_len == 0) {
+        memcpy(entry->name, component_name.data, component_name.len);
+        entry->name_len = component_name.len;
+        entry->generation = 0;
+        entry_count++;
+    }
+    return entry;
+}
+
+uint64_t state_cache_generation(void) {
+    return current_generation;
+}
+
+void state_cache_set(
+    GgBuffer component_name, GgBuffer state, uint64_t generation
+) {
+    if ((component_name.len == 0)
+        || (component_name.len > GGL_COMPONENT_NAME_MAX_LEN)) {
+        return;
+    }
+    if (cleared_generation > generation) {
+        return;
+    }
+    StateCacheEntry *entry = insert_entry(component_name);
+    if (entry == NULL) {
+        return;
+    }
+    if (entry->generation > generation) {
+        GG_LOGD(
+            "State of %.*s changed while it was read; not caching.",
+            (int) component_name.len,
+            component_name.data
+        );
+        return;
+    }
+    entry->state = state;
+}
+
+void state_cache_invalidate(GgBuffer component_name) {
+    if ((component_name.len == 0)
+        || (component_name.len > GGL_COMPONENT_NAME_MAX_LEN)) {
+        return;
+    }
+    // Recorded even for uncached components, as a read may be in progress
+    StateCacheEntry *entry = insert_entry(component_name);
+    if (entry != NULL) {
+        entry->state = (GgBuffer) { 0 };
+        entry->generation = ++current_generation;
+    }
+}
+
+void state_cache_clear(void) {
+    memset(entries, 0, sizeof(entries));
+    entry_count = 0;
+    cleared_generation = ++current_generation;
+}
+
+#ifdef GG_SDK_TESTING
+
+#include <gg/test.h>
+#include <unity.h>
+#include <stdio.h>
+
+GG_TEST_DEFINE(state_cache_set_and_invalidate) {
+    state_cache_clear();
+    GgBuffer state;
+    TEST_ASSERT_FALSE(state_cache_get(GG_STR("comp"), &state));
+
+    uint64_t generation = state_cache_generation();
+    state_cache_set(GG_STR("comp"), GG_STR("RUNNING"), generation);
+    TEST_ASSERT_TRUE(state_cache_get(GG_STR("comp"), &state));
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("RUNNING"), state));
+    TEST_ASSERT_FALSE(state_cache_get(GG_STR("other"), &state));
+
+    state_cache_invalidate(GG_STR("comp"));
+    TEST_ASSERT_FALSE(state_cache_get(GG_STR("comp"), &state));
+}
+
+GG_TEST_DEFINE(state_cache_drops_state_read_before_invalidation) {
+    state_cache_clear();
+    GgBuffer state;
+
+    // Invalidated while the state was being read
+    uint64_t generation = state_cache_generation();
+    state_cache_invalidate(GG_STR("comp"));
+    state_cache_set(GG_STR("comp"), GG_STR("STARTING"), generation);
+    TEST_ASSERT_FALSE(state_cache_get(GG_STR("comp"), &state));
+
+    // Cleared while the state was being read
+    generation = state_cache_generation();
+    state_cache_clear();
+    state_cache_set(GG_STR("comp"), GG_STR("STARTING"), generation);
+    TEST_ASSERT_FALSE(state_cache_get(GG_STR("comp"), &state));
+
+    // Other components' invalidations do not matter
+    generation = state_cache_generation();
+    state_cache_invalidate(GG_STR("other"));
+    state_cache_set(GG_STR("comp"), GG_STR("RUNNING"), generation);
+    TEST_ASSERT_TRUE(state_cache_get(GG_STR("comp"), &state));
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("RUNNING"), state));
+}
+
+GG_TEST_DEFINE(state_cache_clears_when_full) {
+    state_cache_clear();
+    uint8_t name_mem[16];
+    GgBuffer name = GG_STR("");
+    for (size_t i = 0; i < GGHEALTHD_STATE_CACHE_SIZE * 2U; i++) {
+        int len = snprintf((char *) name_mem, sizeof(name_mem), "c%zu", i);
+        name = (GgBuffer) { .data = name_mem, .len = (size_t) len };
+        state_cache_set(name, GG_STR("RUNNING"), state_cache_generation());
+    }
+    TEST_ASSERT_TRUE(entry_count < GGHEALTHD_STATE_CACHE_SIZE);
+
+    GgBuffer state;
+    state_cache_set(name, GG_STR("RUNNING"), state_cache_generation());
+    TEST_ASSERT_TRUE(state_cache_get(name, &state));
+}
+
+#endif
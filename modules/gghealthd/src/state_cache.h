@@ -0,0 +1,39 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef GGHEALTHD_STATE_CACHE_H
+#define GGHEALTHD_STATE_CACHE_H
+
+#include <gg/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Component lifecycle states, kept current from systemd PropertiesChanged
+// signals so that status queries do not need D-Bus round trips. Keys are
+// component names as used for service names (including `.install` and
+// `.bootstrap` suffixes). States must have static storage duration.
+//
+// Accessed only from the socket-server thread (core-bus handlers and the
+// sd_event callback), so no locking is needed.
+
+/// Returns true and sets state if the component's state is cached.
+bool state_cache_get(GgBuffer component_name, GgBuffer *state);
+
+/// Returns the cache generation, to be taken before reading a state from
+/// systemd and passed to state_cache_set.
+uint64_t state_cache_generation(void);
+
+/// Caches a state read from systemd, unless the component was invalidated or
+/// the cache cleared after `generation` was taken.
+void state_cache_set(
+    GgBuffer component_name, GgBuffer state, uint64_t generation
+);
+
+/// Drops the cached state for a component, if any.
+void state_cache_invalidate(GgBuffer component_name);
+
+/// Drops all cached states.
+void state_cache_clear(void);
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "subscriptions.h"
 #include "sd_bus.h"
+#include "state_cache.h"
 #include <assert.h>
 #include <errno.h>
 #include <gg/buffer.h>
@@ -111,10 +112,12 @@ static int properties_changed_handler(
     GG_LOGD("Properties changed for %s", unit_path);
 
     GgBuffer status = GG_STR("");
+    uint64_t generation = state_cache_generation();
     GgError ret = get_lifecycle_state(bus, unit_path, &status);
     if (ret != GG_ERR_OK) {
         return -1;
     }
+    state_cache_set(component_name, status, generation);
 
     // RUNNING, FINISHED, BROKEN,  terminal states
     if (is_terminal_state(status)) {
@@ -257,13 +260,17 @@ static int global_properties_changed_handler(
     (void) user_data;
     (void) ret_error;
 
-    if (broadcast_handle == 0) {
-        // no subscriber; nothing to fan out to
+    const char *unit_path = sd_bus_message_get_path(m);
+    if (unit_path == NULL) {
         return 0;
     }
 
-    const char *unit_path = sd_bus_message_get_path(m);
-    if (unit_path == NULL) {
+    // Skip other units without a D-Bus round trip; in unit object paths the
+    // `ggl.` prefix is escaped as `ggl_2e`.
+    if (!gg_buffer_has_prefix(
+            gg_buffer_from_null_term((char *) unit_path),
+            GG_STR(DEFAULT_PATH "/unit/ggl_2e")
+        )) {
         return 0;
     }
 
@@ -298,9 +305,22 @@ static int global_properties_changed_handler(
         return 0;
     }
 
+    // The state read below is current, so earlier reads still in flight must
+    // not be cached over it.
+    state_cache_invalidate(component_name);
+    uint64_t generation = state_cache_generation();
+
     GgBuffer status = GG_STR("");
     ret = get_lifecycle_state(bus, unit_path, &status);
     if (ret != GG_ERR_OK) {
+        state_cache_invalidate(component_name);
+        return 0;
+    }
+    // The state cache is kept current even with no broadcast subscriber.
+    state_cache_set(component_name, status, generation);
+
+    if (broadcast_handle == 0) {
+        // no subscriber; nothing to fan out to
         return 0;
     }
 
@@ -326,6 +346,47 @@ static int global_properties_changed_handler(
     return 0;
 }
 
+// Kept referenced for the lifetime of the process so the matches stay
+// installed.
+static sd_bus_slot *unit_removed_match_slot;
+static sd_bus_slot *reloading_match_slot;
+
+// Unloaded units lose their state; the next query reloads it from systemd.
+static int unit_removed_handler(
+    sd_bus_message *m, void *user_data, sd_bus_error *ret_error
+) {
+    (void) user_data;
+    (void) ret_error;
+    const char *unit_id = NULL;
+    if (sd_bus_message_read_basic(m, 's', &unit_id) < 0) {
+        return 0;
+    }
+    GgBuffer id = gg_buffer_from_null_term((char *) unit_id);
+    if ((id.len <= SERVICE_PREFIX_LEN + SERVICE_SUFFIX_LEN)
+        || !gg_buffer_has_prefix(id, GG_STR(SERVICE_PREFIX))
+        || !gg_buffer_has_suffix(id, GG_STR(SERVICE_SUFFIX))) {
+        return 0;
+    }
+    state_cache_invalidate(
+        gg_buffer_substr(id, SERVICE_PREFIX_LEN, id.len - SERVICE_SUFFIX_LEN)
+    );
+    return 0;
+}
+
+// Unit files may have changed across a daemon-reload.
+static int reloading_handler(
+    sd_bus_message *m, void *user_data, sd_bus_error *ret_error
+) {
+    (void) user_data;
+    (void) ret_error;
+    int active = 0;
+    if ((sd_bus_message_read_basic(m, 'b', &active) >= 0) && !active) {
+        GG_LOGD("systemd reloaded; clearing component state cache.");
+        state_cache_clear();
+    }
+    return 0;
+}
+
 void init_health_events(void) {
     while (true) {
         GgError ret = open_bus(&global_bus);
@@ -398,6 +459,33 @@ void init_health_events(void) {
         );
     }
 
+    sd_ret = sd_bus_match_signal(
+        global_bus,
+        &unit_removed_match_slot,
+        DEFAULT_DESTINATION,
+        DEFAULT_PATH,
+        MANAGER_INTERFACE,
+        "UnitRemoved",
+        unit_removed_handler,
+        NULL
+    );
+    if (sd_ret < 0) {
+        GG_LOGE("Failed to register UnitRemoved match (errno=%d).", -sd_ret);
+    }
+    sd_ret = sd_bus_match_signal(
+        global_bus,
+        &reloading_match_slot,
+        DEFAULT_DESTINATION,
+        DEFAULT_PATH,
+        MANAGER_INTERFACE,
+        "Reloading",
+        reloading_handler,
+        NULL
+    );
+    if (sd_ret < 0) {
+        GG_LOGE("Failed to register Reloading match (errno=%d).", -sd_ret);
+    }
+
     // TODO: replace with setting up a larger epoll
     sd_event_ctx = e;
     ggl_socket_server_ext_fd = sd_event_get_fd(e);
@@ -18,10 +18,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#define GGL_IPC_MAX_SUBSCRIPTIONS GGL_COREBUS_CLIENT_MAX_SUBSCRIPTIONS
+#define GGL_IPC_MAX_SUBSCRIPTIONS GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS
 
 static_assert(
-    GGL_IPC_MAX_SUBSCRIPTIONS <= GGL_COREBUS_CLIENT_MAX_SUBSCRIPTIONS,
+    GGL_IPC_MAX_SUBSCRIPTIONS <= GGL_COREBUS_CLIENT_MAX_MUX_SUBSCRIPTIONS,
     "IPC subscription maximum exceeds core bus maximum."
 );
 
@@ -151,7 +151,7 @@ static void subscription_on_close(void *ctx, uint32_t recv_handle) {
     slot->close_requested = true;
     slot->core_closed = true;
 
-    // ggl_subscribe may invoke this callback before returning the handle. Keep
+    // ggl_subscribe_mux may invoke this callback before returning the handle. Keep
     // the slot reserved until the binding call no longer holds its pointer.
     if (!slot->binding) {
         reset_sub_slot(slot);
@@ -175,8 +175,9 @@ GgError ggl_ipc_bind_subscription(
         return ret;
     }
 
+    // Forwarded subscriptions share one core-bus connection per daemon
     uint32_t recv_handle = 0;
-    ret = ggl_subscribe(
+    ret = ggl_subscribe_mux(
         interface,
         method,
         params,
@@ -21,7 +21,7 @@ typedef GgError (*GglIpcSubscribeCallback)(
     GgArena *arena
 );
 
-/// Wrapper around ggl_subscribe for IPC handlers.
+/// Wrapper around ggl_subscribe_mux for IPC handlers.
 ///
 /// `ctx` is an optional per-subscription context passed to `on_response` on
 /// each event. Caller-owned context must remain valid until the subscription is
@@ -5,6 +5,8 @@
 #include "../../ipc_error.h"
 #include "../../ipc_server.h"
 #include "../../ipc_service.h"
+#include "../config/config_path_object.h"
+#include <assert.h>
 #include <gg/arena.h>
 #include <gg/buffer.h>
 #include <gg/error.h>
@@ -13,16 +15,23 @@
 #include <gg/map.h>
 #include <gg/object.h>
 #include <gg/types.h>
+#include <gg/vector.h>
 #include <ggl/core_bus/gg_config.h>
+#include <stddef.h>
 #include <stdint.h>
 
 static GglIpcOperationHandler handle_get_system_config;
+static GglIpcOperationHandler handle_get_runner_environment;
 
 static GglIpcOperation operations[] = {
     {
         GG_STR("aws.greengrass.private#GetSystemConfig"),
         handle_get_system_config,
     },
+    {
+        GG_STR("aws.greengrass.private#GetRunnerEnvironment"),
+        handle_get_runner_environment,
+    },
 };
 
 GglIpcService ggl_ipc_service_private = {
@@ -74,3 +83,192 @@ GgError handle_get_system_config(
         GG_MAP(gg_kv(GG_STR("value"), read_value))
     );
 }
+
+/// Reads an optional string value. Leaves value empty if it is not set.
+static GgError read_optional_str(
+    GgBufList key_path, GgArena *alloc, GgBuffer *value
+) {
+    *value = (GgBuffer) { 0 };
+    GgError ret = ggl_gg_config_read_str(key_path, alloc, value);
+    if (ret == GG_ERR_NOENTRY) {
+        *value = (GgBuffer) { 0 };
+        return GG_ERR_OK;
+    }
+    return ret;
+}
+
+/// Gets a string value from a config map. Leaves value empty if it is not set.
+static GgError get_optional_str(GgMap map, GgBuffer key, GgBuffer *value) {
+    *value = (GgBuffer) { 0 };
+    GgObject *obj;
+    if (!gg_map_get(map, key, &obj)) {
+        return GG_ERR_OK;
+    }
+    if (gg_obj_type(*obj) != GG_TYPE_BUF) {
+        GG_LOGE(
+            "Configuration value %.*s is not a string.",
+            (int) key.len,
+            key.data
+        );
+        return GG_ERR_CONFIG;
+    }
+    *value = gg_obj_into_buf(*obj);
+    return GG_ERR_OK;
+}
+
+// Reads everything recipe-runner needs to set up a component's environment,
+// so it can do so with one IPC call instead of one per value. Values that are
+// not configured are omitted from the response.
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+static GgError read_runner_environment(GgArena *alloc, GgKVVec *env) {
+    GgObject system_obj;
+    GgError ret
+        = ggl_gg_config_read(GG_BUF_LIST(GG_STR("system")), alloc, &system_obj);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to read the system configuration.");
+        return ret;
+    }
+    if (gg_obj_type(system_obj) != GG_TYPE_MAP) {
+        GG_LOGE("System configuration is not a map.");
+        return GG_ERR_CONFIG;
+    }
+    GgMap system = gg_obj_into_map(system_obj);
+
+    GgBuffer root_ca_path;
+    GgBuffer thing_name;
+    GgBuffer root_path;
+    ret = get_optional_str(system, GG_STR("rootCaPath"), &root_ca_path);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = get_optional_str(system, GG_STR("thingName"), &thing_name);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = get_optional_str(system, GG_STR("rootPath"), &root_path);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    GgBuffer nucleus = GG_STR("aws.greengrass.Nucleus");
+    const GglConfigComponentAlias *alias = ggl_config_component_alias(nucleus);
+    if (alias != NULL) {
+        nucleus = alias->storage_name;
+    }
+
+    GgBuffer aws_region;
+    ret = read_optional_str(
+        GG_BUF_LIST(
+            GG_STR("services"),
+            nucleus,
+            GG_STR("configuration"),
+            GG_STR("awsRegion")
+        ),
+        alloc,
+        &aws_region
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to read awsRegion from the configuration.");
+        return ret;
+    }
+
+    GgBuffer proxy_url;
+    ret = read_optional_str(
+        GG_BUF_LIST(
+            GG_STR("services"),
+            nucleus,
+            GG_STR("configuration"),
+            GG_STR("networkProxy"),
+            GG_STR("proxy"),
+            GG_STR("url")
+        ),
+        alloc,
+        &proxy_url
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to read the network proxy url from the configuration.");
+        return ret;
+    }
+
+    GgBuffer no_proxy;
+    ret = read_optional_str(
+        GG_BUF_LIST(
+            GG_STR("services"),
+            nucleus,
+            GG_STR("configuration"),
+            GG_STR("networkProxy"),
+            GG_STR("noProxyAddresses")
+        ),
+        alloc,
+        &no_proxy
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to read noProxyAddresses from the configuration.");
+        return ret;
+    }
+
+    GgBuffer tes_port;
+    ret = read_optional_str(
+        GG_BUF_LIST(
+            GG_STR("services"),
+            GG_STR("aws.greengrass.TokenExchangeService"),
+            GG_STR("configuration"),
+            GG_STR("port")
+        ),
+        alloc,
+        &tes_port
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to read the TES port from the configuration.");
+        return ret;
+    }
+
+    GgBuffer keys[] = {
+        GG_STR("rootCaPath"), GG_STR("thingName"),
+        GG_STR("rootPath"),   GG_STR("awsRegion"),
+        GG_STR("proxyUrl"),   GG_STR("noProxyAddresses"),
+        GG_STR("tesPort"),
+    };
+    GgBuffer values[] = {
+        root_ca_path, thing_name, root_path, aws_region,
+        proxy_url,    no_proxy,   tes_port,
+    };
+    static_assert(
+        sizeof(keys) / sizeof(keys[0]) == sizeof(values) / sizeof(values[0]),
+        "Runner environment keys and values must match."
+    );
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        if (values[i].len == 0) {
+            continue;
+        }
+        ret = gg_kv_vec_push(env, gg_kv(keys[i], gg_obj_buf(values[i])));
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    return GG_ERR_OK;
+}
+
+GgError handle_get_runner_environment(
+    const GglIpcOperationInfo *info,
+    GgMap args,
+    uint32_t handle,
+    int32_t stream_id,
+    GglIpcError *ipc_error,
+    GgArena *alloc
+) {
+    (void) info;
+    (void) args;
+
+    GgKV env_mem[7];
+    GgKVVec env = GG_KV_VEC(env_mem);
+    GgError ret = read_runner_environment(alloc, &env);
+    if (ret != GG_ERR_OK) {
+        *ipc_error = (GglIpcError
+        ) { .error_code = GGL_IPC_ERR_SERVICE_ERROR,
+            .message = GG_STR("Failed to read the runner environment.") };
+        return ret;
+    }
+
+    return ggl_ipc_response_send(handle, stream_id, GG_STR(""), env.map);
+}
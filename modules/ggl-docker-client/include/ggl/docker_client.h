@@ -12,15 +12,23 @@
 #include <ggl/uri.h>
 #include <stdbool.h>
 
+//! Images are managed through the Docker Engine API on the daemon's unix
+//! socket, falling back to the docker CLI if the socket can't be reached.
+
 GgError ggl_docker_check_server(void);
 GgError ggl_docker_pull(GgBuffer image_name);
 GgError ggl_docker_remove(GgBuffer image_name);
+/// Remove images with as few `docker rmi` calls as possible.
+/// Images that do not exist are ignored.
+GgError ggl_docker_remove_images(GgBufList image_names);
 GgError ggl_docker_check_image(GgBuffer image_name);
+/// Keep credentials for Engine API pulls from `registry`, and log the docker
+/// CLI in to it.
 GgError ggl_docker_credentials_store(
     GgBuffer registry, GgBuffer username, GgBuffer secret
 );
 
-/// Request credentials from ECR and pipe them to `docker login`
+/// Request credentials from ECR and store them
 GgError ggl_docker_credentials_ecr_retrieve(
     GglDockerUriInfo ecr_registry, SigV4Details sigv4_details
 );
@@ -21,8 +21,14 @@
 #include <string.h>
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/// Maximum number of docker images removed with one component version.
+#ifndef GGL_DOCKER_CLEANUP_MAX_IMAGES
+#define GGL_DOCKER_CLEANUP_MAX_IMAGES 32
+#endif
+
 static uint8_t recipe_buf[8192];
 static pthread_mutex_t recipe_mtx = PTHREAD_MUTEX_INITIALIZER;
 
@@ -79,21 +85,17 @@ static bool docker_uri_equals(GglDockerUriInfo lhs, GglDockerUriInfo rhs) {
     return false;
 }
 
-static GgError docker_artifact_exists(
+typedef GgError (*DockerUriCallback)(void *ctx, GgBuffer image_name);
+
+/// Calls cb with each docker image in a component version's recipe.
+/// Image names are only valid during the callback.
+static GgError for_each_docker_image(
     int root_path_fd,
-    GglDockerUriInfo image_uri,
     GgBuffer component_name,
     GgBuffer component_version,
-    bool *exists
+    DockerUriCallback cb,
+    void *ctx
 ) {
-    GG_LOGT(
-        "Checking if %.*s-%.*s contains image",
-        (int) component_name.len,
-        component_name.data,
-        (int) component_version.len,
-        component_version.data
-    );
-    GG_MTX_SCOPE_GUARD(&recipe_mtx);
     GgArena recipe_arena = gg_arena_init(GG_BUF(recipe_buf));
     GgObject recipe_obj;
 
@@ -139,32 +141,95 @@ static GgError docker_artifact_exists(
             continue;
         }
 
-        GglDockerUriInfo artifact_uri;
-        ret = gg_docker_uri_parse(uri, &artifact_uri);
+        ret = cb(ctx, uri);
         if (ret != GG_ERR_OK) {
-            continue;
-        }
-        if (docker_uri_equals(image_uri, artifact_uri)) {
-            *exists = true;
-            return GG_ERR_OK;
+            return ret;
         }
     }
 
-    *exists = false;
     return GG_ERR_OK;
 }
 
-static GgError ggl_docker_remove_if_unused(
+typedef struct {
+    GgBuffer name;
+    GglDockerUriInfo uri;
+    bool referenced;
+} CleanupCandidate;
+
+typedef struct {
+    CleanupCandidate *items;
+    size_t len;
+    size_t capacity;
+    GgArena *name_alloc;
+} CleanupCandidates;
+
+static GgError add_candidate(void *ctx, GgBuffer image_name) {
+    CleanupCandidates *candidates = ctx;
+    if (candidates->len == candidates->capacity) {
+        GG_LOGW(
+            "Too many docker images to clean up; skipping %.*s.",
+            (int) image_name.len,
+            image_name.data
+        );
+        return GG_ERR_OK;
+    }
+
+    GgError ret = gg_arena_claim_buf(&image_name, candidates->name_alloc);
+    if (ret != GG_ERR_OK) {
+        GG_LOGW("Insufficient memory to clean up all docker images.");
+        return GG_ERR_OK;
+    }
+    GglDockerUriInfo uri;
+    ret = gg_docker_uri_parse(image_name, &uri);
+    if (ret != GG_ERR_OK) {
+        return GG_ERR_OK;
+    }
+
+    GG_LOGT(
+        "Preparing to remove %.*s if it's unused",
+        (int) image_name.len,
+        image_name.data
+    );
+    candidates->items[candidates->len] = (CleanupCandidate) {
+        .name = image_name,
+        .uri = uri,
+    };
+    candidates->len += 1;
+    return GG_ERR_OK;
+}
+
+static GgError mark_referenced(void *ctx, GgBuffer image_name) {
+    CleanupCandidates *candidates = ctx;
+    GglDockerUriInfo uri;
+    if (gg_docker_uri_parse(image_name, &uri) != GG_ERR_OK) {
+        return GG_ERR_OK;
+    }
+    for (size_t i = 0; i < candidates->len; i++) {
+        if (!candidates->items[i].referenced
+            && docker_uri_equals(candidates->items[i].uri, uri)) {
+            candidates->items[i].referenced = true;
+        }
+    }
+    return GG_ERR_OK;
+}
+
+static bool all_referenced(const CleanupCandidates *candidates) {
+    for (size_t i = 0; i < candidates->len; i++) {
+        if (!candidates->items[i].referenced) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Marks candidates used by any other deployed component version.
+/// Reads each deployed recipe once.
+static GgError mark_referenced_images(
     int root_path_fd,
-    GgBuffer image_name,
     GgBuffer component_name,
-    GgBuffer component_version
+    GgBuffer component_version,
+    CleanupCandidates *candidates
 ) {
-    GG_LOGT("Remove if unused");
-    if (component_name.len == 0) {
-        return GG_ERR_INVALID;
-    }
-
     GgBuffer component_list_memory = GG_BUF((uint8_t[4096]) { 0 });
     GgArena component_list_alloc = gg_arena_init(component_list_memory);
 
@@ -180,12 +245,6 @@ static GgError ggl_docker_remove_if_unused(
         return GG_ERR_FAILURE;
     }
 
-    GglDockerUriInfo image_uri;
-    ret = gg_docker_uri_parse(image_name, &image_uri);
-    if (ret != GG_ERR_OK) {
-        return GG_ERR_FAILURE;
-    }
-
     GG_LIST_FOREACH (component, components) {
         GgBuffer other_component_name = gg_obj_into_buf(*component);
         GG_LOGT(
@@ -196,7 +255,9 @@ static GgError ggl_docker_remove_if_unused(
         GgArena version_alloc = gg_arena_init(GG_BUF((uint8_t[256]) { 0 }));
         GgBuffer other_component_version;
         ret = ggl_gg_config_read_str(
-            GG_BUF_LIST(GG_STR("services"), component_name, GG_STR("version")),
+            GG_BUF_LIST(
+                GG_STR("services"), other_component_name, GG_STR("version")
+            ),
             &version_alloc,
             &other_component_version
         );
@@ -209,110 +270,68 @@ static GgError ggl_docker_remove_if_unused(
             continue;
         }
 
-        bool exists = false;
-
-        ret = docker_artifact_exists(
+        ret = for_each_docker_image(
             root_path_fd,
-            image_uri,
             other_component_name,
             other_component_version,
-            &exists
+            mark_referenced,
+            candidates
         );
         if (ret != GG_ERR_OK) {
             return GG_ERR_FAILURE;
         }
-        if (exists) {
+        if (all_referenced(candidates)) {
             return GG_ERR_OK;
         }
     }
 
-    return ggl_docker_remove(image_name);
+    return GG_ERR_OK;
 }
 
-/// Process the i'th artifact of the component
-/// Keeps at most one component's recipe in memory.
-static bool ggl_docker_artifact_cleanup_step(
-    int root_path_fd,
-    GgBuffer component_name,
-    GgBuffer component_version,
-    size_t i
+void ggl_docker_artifact_cleanup(
+    int root_path_fd, GgBuffer component_name, GgBuffer component_version
 ) {
-    static uint8_t image_name_buf[4096];
-    GgArena image_arena = gg_arena_init(GG_BUF(image_name_buf));
-    GgBuffer image_name;
-
-    {
-        GG_MTX_SCOPE_GUARD(&recipe_mtx);
-
-        GgArena recipe_arena = gg_arena_init(GG_BUF(recipe_buf));
-        GgObject recipe;
-        GgError ret = ggl_recipe_get_from_file(
-            root_path_fd,
-            component_name,
-            component_version,
-            &recipe_arena,
-            &recipe
-        );
-        if ((ret != GG_ERR_OK) || (gg_obj_type(recipe) != GG_TYPE_MAP)) {
-            return false;
-        }
-        GgList artifacts;
-        ret = ggl_get_recipe_artifacts_for_platform(
-            gg_obj_into_map(recipe), &artifacts
-        );
-        if (ret != GG_ERR_OK) {
-            GG_LOGT("Couldn't get recipe artifacts");
-            return false;
-        }
-
-        if (artifacts.len <= i) {
-            GG_LOGT("Reached end of artifacts (%zu <= %zu)", artifacts.len, i);
-            return false;
-        }
+    if (component_name.len == 0) {
+        return;
+    }
 
-        GgObject *uri_obj = NULL;
-        if (!gg_map_get(
-                gg_obj_into_map(artifacts.items[i]), GG_STR("Uri"), &uri_obj
-            )) {
-            GG_LOGT("No URI");
-            return true;
-        }
-        if (gg_obj_type(*uri_obj) != GG_TYPE_BUF) {
-            GG_LOGT("URI not a buffer");
-            return true;
-        }
+    GG_MTX_SCOPE_GUARD(&recipe_mtx);
 
-        image_name = gg_obj_into_buf(*uri_obj);
-        if (!gg_buffer_remove_prefix(&image_name, GG_STR("docker:"))) {
-            GG_LOGT("URI not docker");
-            return true;
-        }
-        GG_LOGT(
-            "Preparing to remove %.*s if it's unused",
-            (int) image_name.len,
-            image_name.data
-        );
+    static uint8_t image_name_buf[4096];
+    static CleanupCandidate candidate_mem[GGL_DOCKER_CLEANUP_MAX_IMAGES];
+    GgArena image_arena = gg_arena_init(GG_BUF(image_name_buf));
+    CleanupCandidates candidates = {
+        .items = candidate_mem,
+        .capacity = GGL_DOCKER_CLEANUP_MAX_IMAGES,
+        .name_alloc = &image_arena,
+    };
 
-        ret = gg_arena_claim_buf(&image_name, &image_arena);
-        if (ret != GG_ERR_OK) {
-            return true;
-        }
+    GgError ret = for_each_docker_image(
+        root_path_fd,
+        component_name,
+        component_version,
+        add_candidate,
+        &candidates
+    );
+    if ((ret != GG_ERR_OK) || (candidates.len == 0)) {
+        return;
     }
 
-    (void) ggl_docker_remove_if_unused(
-        root_path_fd, image_name, component_name, component_version
+    ret = mark_referenced_images(
+        root_path_fd, component_name, component_version, &candidates
     );
-    return true;
-}
+    if (ret != GG_ERR_OK) {
+        return;
+    }
 
-void ggl_docker_artifact_cleanup(
-    int root_path_fd, GgBuffer component_name, GgBuffer component_version
-) {
-    size_t i = 0;
-    while (ggl_docker_artifact_cleanup_step(
-        root_path_fd, component_name, component_version, i
-    )) {
-        GG_LOGT("Finished step %zu", i);
-        ++i;
+    GgBuffer unused_mem[GGL_DOCKER_CLEANUP_MAX_IMAGES];
+    GgBufList unused = { .bufs = unused_mem, .len = 0 };
+    for (size_t i = 0; i < candidates.len; i++) {
+        if (!candidates.items[i].referenced) {
+            unused_mem[unused.len] = candidates.items[i].name;
+            unused.len += 1;
+        }
     }
+
+    (void) ggl_docker_remove_images(unused);
 }
@@ -3,6 +3,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include "docker_engine.h"
+#include <assert.h>
 #include <fcntl.h>
 #include <gg/arena.h>
 #include <gg/base64.h>
@@ -12,6 +14,7 @@
 #include <gg/file.h>
 #include <gg/flags.h>
 #include <gg/json_decode.h>
+#include <gg/json_encode.h>
 #include <gg/list.h>
 #include <gg/log.h>
 #include <gg/map.h>
@@ -24,9 +27,11 @@
 #include <ggl/process.h>
 #include <ggl/uri.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 static GgError redirect_output_setup(void *ctx) {
@@ -105,7 +110,149 @@ GgError ggl_docker_check_server(void) {
     return err;
 }
 
+/// The max number of registries with credentials kept for the Engine API
+#define DOCKER_MAX_REGISTRY_AUTHS (4U)
+
+/// The max length of an encoded X-Registry-Auth header value
+#define DOCKER_MAX_REGISTRY_AUTH_LEN (8192U)
+
+#define DOCKER_MAX_REGISTRY_LEN (256U)
+
+typedef struct {
+    uint8_t registry[DOCKER_MAX_REGISTRY_LEN];
+    size_t registry_len;
+    uint8_t auth[DOCKER_MAX_REGISTRY_AUTH_LEN];
+    size_t auth_len;
+} RegistryAuth;
+
+// Credentials for pulls through the Engine API, which has no login state
+static RegistryAuth registry_auths[DOCKER_MAX_REGISTRY_AUTHS];
+static size_t registry_auths_len = 0;
+static size_t registry_auths_next = 0;
+static pthread_mutex_t registry_auths_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static GgBuffer registry_host(GgBuffer registry) {
+    GgBuffer host = registry;
+    (void) gg_buffer_remove_prefix(&host, GG_STR("https://"));
+    while ((host.len > 0) && (host.data[host.len - 1] == '/')) {
+        host.len -= 1;
+    }
+    return host;
+}
+
+/// Copies the X-Registry-Auth value for the image's registry into auth_mem.
+/// Returns an empty buffer if no credentials were stored for it.
+static GgBuffer find_registry_auth(GgBuffer image_name, GgBuffer auth_mem) {
+    GglDockerUriInfo info = { 0 };
+    if (gg_docker_uri_parse(image_name, &info) != GG_ERR_OK) {
+        return GG_STR("");
+    }
+
+    GG_MTX_SCOPE_GUARD(&registry_auths_mtx);
+    for (size_t i = 0; i < registry_auths_len; i++) {
+        RegistryAuth *entry = &registry_auths[i];
+        GgBuffer registry = { .data = entry->registry,
+                              .len = entry->registry_len };
+        if (gg_buffer_eq(registry, registry_host(info.registry))
+            && (entry->auth_len <= auth_mem.len)) {
+            memcpy(auth_mem.data, entry->auth, entry->auth_len);
+            return gg_buffer_substr(auth_mem, 0, entry->auth_len);
+        }
+    }
+    return GG_STR("");
+}
+
+/// Encodes credentials as the base64url JSON the Engine API expects.
+static GgError encode_registry_auth(
+    GgBuffer registry, GgBuffer username, GgBuffer secret, RegistryAuth *entry
+) {
+    static uint8_t json_mem[DOCKER_MAX_REGISTRY_AUTH_LEN];
+    GgByteVec json = GG_BYTE_VEC(json_mem);
+    GgError ret = gg_json_encode(
+        gg_obj_map(GG_MAP(
+            gg_kv(GG_STR("username"), gg_obj_buf(username)),
+            gg_kv(GG_STR("password"), gg_obj_buf(secret)),
+            gg_kv(GG_STR("serveraddress"), gg_obj_buf(registry))
+        )),
+        gg_byte_vec_writer(&json)
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    GgArena alloc = gg_arena_init(GG_BUF(entry->auth));
+    GgBuffer auth;
+    ret = gg_base64_encode(json.buf, &alloc, &auth);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    for (size_t i = 0; i < auth.len; i++) {
+        if (auth.data[i] == '+') {
+            auth.data[i] = '-';
+        } else if (auth.data[i] == '/') {
+            auth.data[i] = '_';
+        }
+    }
+    memmove(entry->auth, auth.data, auth.len);
+    entry->auth_len = auth.len;
+    return GG_ERR_OK;
+}
+
+static GgError save_registry_auth(
+    GgBuffer registry, GgBuffer username, GgBuffer secret
+) {
+    GgBuffer host = registry_host(registry);
+    if (host.len > DOCKER_MAX_REGISTRY_LEN) {
+        GG_LOGE("Registry name too long.");
+        return GG_ERR_INVALID;
+    }
+
+    GG_MTX_SCOPE_GUARD(&registry_auths_mtx);
+    size_t index = registry_auths_len;
+    for (size_t i = 0; i < registry_auths_len; i++) {
+        GgBuffer saved = { .data = registry_auths[i].registry,
+                           .len = registry_auths[i].registry_len };
+        if (gg_buffer_eq(saved, host)) {
+            index = i;
+            break;
+        }
+    }
+    if (index == DOCKER_MAX_REGISTRY_AUTHS) {
+        // Replace the oldest entry
+        index = registry_auths_next;
+        registry_auths_next = (registry_auths_next + 1)
+            % DOCKER_MAX_REGISTRY_AUTHS;
+    }
+
+    RegistryAuth *entry = &registry_auths[index];
+    GgError ret = encode_registry_auth(host, username, secret, entry);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Docker credentials too long.");
+        entry->registry_len = 0;
+        return ret;
+    }
+    memcpy(entry->registry, host.data, host.len);
+    entry->registry_len = host.len;
+    if (index == registry_auths_len) {
+        registry_auths_len += 1;
+    }
+    return GG_ERR_OK;
+}
+
 GgError ggl_docker_pull(GgBuffer image_name) {
+    uint8_t auth_mem[DOCKER_MAX_REGISTRY_AUTH_LEN];
+    GgBuffer auth = find_registry_auth(image_name, GG_BUF(auth_mem));
+
+    GG_LOGD("Pulling %.*s", (int) image_name.len, image_name.data);
+    GgError ret = ggl_docker_engine_pull(image_name, auth);
+    if (ret != GG_ERR_NOCONN) {
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("docker image pull failed.");
+            return GG_ERR_FAILURE;
+        }
+        return GG_ERR_OK;
+    }
+
     char image_null_term[DOCKER_MAX_IMAGE_LEN + 1U] = { 0 };
     if (image_name.len > DOCKER_MAX_IMAGE_LEN) {
         GG_LOGE("Docker image name too long.");
@@ -113,7 +260,6 @@ GgError ggl_docker_pull(GgBuffer image_name) {
     }
     memcpy(image_null_term, image_name.data, image_name.len);
 
-    GG_LOGD("Pulling %.*s", (int) image_name.len, image_name.data);
     const char *args[] = { "docker", "pull", "-q", image_null_term, NULL };
     GgError err = ggl_process_call(args, NULL);
     if (err != GG_ERR_OK) {
@@ -123,21 +269,15 @@ GgError ggl_docker_pull(GgBuffer image_name) {
     return GG_ERR_OK;
 }
 
-GgError ggl_docker_remove(GgBuffer image_name) {
-    char image_null_term[DOCKER_MAX_IMAGE_LEN + 1U] = { 0 };
-    if (image_name.len > DOCKER_MAX_IMAGE_LEN) {
-        GG_LOGE("Docker image name too long.");
-        return GG_ERR_INVALID;
-    }
-    GG_LOGD("Removing docker image '%s'", image_null_term);
-
-    memcpy(image_null_term, image_name.data, image_name.len);
-    const char *args[] = { "docker", "rmi", image_null_term, NULL };
+/// The max number of images removed by one `docker rmi`
+#define DOCKER_MAX_REMOVE_IMAGES (32U)
 
+static GgError run_docker_rmi(const char **args) {
     uint8_t output_bytes[512U] = { 0 };
     GgByteVec output = GG_BYTE_VEC(output_bytes);
     GgError err = run_with_output(args, &output);
     if (err != GG_ERR_OK) {
+        // Other images in the batch are still removed
         size_t start = 0;
         if (gg_buffer_contains(output.buf, GG_STR("No such image"), &start)) {
             GG_LOGD("Image was not found to delete.");
@@ -151,6 +291,71 @@ GgError ggl_docker_remove(GgBuffer image_name) {
     return GG_ERR_OK;
 }
 
+static GgError cli_remove_images(GgBufList image_names) {
+    uint8_t names_mem[2U * (DOCKER_MAX_IMAGE_LEN + 1U)];
+    GgArena names_alloc = gg_arena_init(GG_BUF(names_mem));
+    const char *args[DOCKER_MAX_REMOVE_IMAGES + 3U] = { "docker", "rmi" };
+    size_t args_len = 2;
+    GgError ret = GG_ERR_OK;
+
+    for (size_t i = 0; i < image_names.len; i++) {
+        GgBuffer image_name = image_names.bufs[i];
+        if (image_name.len > DOCKER_MAX_IMAGE_LEN) {
+            GG_LOGE("Docker image name too long.");
+            ret = GG_ERR_INVALID;
+            continue;
+        }
+
+        char *name = GG_ARENA_ALLOCN(&names_alloc, char, image_name.len + 1U);
+        if ((name == NULL) || (args_len == DOCKER_MAX_REMOVE_IMAGES + 2U)) {
+            // Batch is full; remove it before continuing
+            args[args_len] = NULL;
+            if (run_docker_rmi(args) != GG_ERR_OK) {
+                ret = GG_ERR_FAILURE;
+            }
+            names_alloc = gg_arena_init(GG_BUF(names_mem));
+            args_len = 2;
+            name = GG_ARENA_ALLOCN(&names_alloc, char, image_name.len + 1U);
+            assert(name != NULL);
+        }
+        memcpy(name, image_name.data, image_name.len);
+        name[image_name.len] = '\0';
+        GG_LOGD("Removing docker image '%s'", name);
+        args[args_len] = name;
+        args_len += 1;
+    }
+
+    if (args_len > 2) {
+        args[args_len] = NULL;
+        if (run_docker_rmi(args) != GG_ERR_OK) {
+            ret = GG_ERR_FAILURE;
+        }
+    }
+    return ret;
+}
+
+GgError ggl_docker_remove_images(GgBufList image_names) {
+    GgError ret = GG_ERR_OK;
+    for (size_t i = 0; i < image_names.len; i++) {
+        GgError err = ggl_docker_engine_remove(image_names.bufs[i]);
+        if (err == GG_ERR_NOCONN) {
+            err = cli_remove_images((GgBufList) {
+                .bufs = &image_names.bufs[i],
+                .len = image_names.len - i,
+            });
+            return (err != GG_ERR_OK) ? err : ret;
+        }
+        if (err != GG_ERR_OK) {
+            ret = GG_ERR_FAILURE;
+        }
+    }
+    return ret;
+}
+
+GgError ggl_docker_remove(GgBuffer image_name) {
+    return ggl_docker_remove_images(GG_BUF_LIST(image_name));
+}
+
 GgError ggl_docker_check_image(GgBuffer image_name) {
     char image_null_term[DOCKER_MAX_IMAGE_LEN + 1U] = { 0 };
     if (image_name.len > DOCKER_MAX_IMAGE_LEN) {
@@ -161,6 +366,11 @@ GgError ggl_docker_check_image(GgBuffer image_name) {
 
     GG_LOGD("Finding docker image '%s'", image_null_term);
 
+    GgError ret = ggl_docker_engine_inspect_image(image_name);
+    if (ret != GG_ERR_NOCONN) {
+        return ret;
+    }
+
     const char *args[]
         = { "docker", "image", "ls", "-q", image_null_term, NULL };
 
@@ -205,6 +415,13 @@ GgError ggl_docker_credentials_store(
     memcpy(registry_buf, registry.data, registry.len);
     memcpy(username_buf, username.data, username.len);
 
+    // Engine API pulls pass the credentials with each request. The CLI login
+    // is still done as component lifecycle scripts may use the docker CLI.
+    GgError ret = save_registry_auth(registry, username, secret);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
     const char *const ARGS[] = { "docker",     "login",      registry_buf,
                                  "--username", username_buf, "--password-stdin",
                                  NULL };
@@ -369,6 +586,60 @@ bool ggl_docker_is_uri_private_ecr(GglDockerUriInfo docker_uri) {
 #include <gg/test.h>
 #include <unity.h>
 
+GG_TEST_DEFINE(registry_auth_saved_per_registry) {
+    GG_TEST_ASSERT_OK(save_registry_auth(
+        GG_STR("https://123456789012.dkr.ecr.us-east-1.amazonaws.com/"),
+        GG_STR("AWS"),
+        GG_STR("secret")
+    ));
+
+    uint8_t auth_mem[DOCKER_MAX_REGISTRY_AUTH_LEN];
+    GgBuffer auth = find_registry_auth(
+        GG_STR("123456789012.dkr.ecr.us-east-1.amazonaws.com/app:1.0"),
+        GG_BUF(auth_mem)
+    );
+    TEST_ASSERT_TRUE(auth.len > 0);
+
+    // base64url back to base64
+    for (size_t i = 0; i < auth.len; i++) {
+        if (auth.data[i] == '-') {
+            auth.data[i] = '+';
+        } else if (auth.data[i] == '_') {
+            auth.data[i] = '/';
+        }
+    }
+    TEST_ASSERT_TRUE(gg_base64_decode_in_place(&auth));
+
+    uint8_t arena_mem[256];
+    GgArena arena = gg_arena_init(GG_BUF(arena_mem));
+    GgObject obj;
+    GG_TEST_ASSERT_OK(gg_json_decode_destructive(auth, &arena, &obj));
+    GgObject *username;
+    GgObject *password;
+    GgObject *server;
+    GG_TEST_ASSERT_OK(gg_map_validate(
+        gg_obj_into_map(obj),
+        GG_MAP_SCHEMA(
+            { GG_STR("username"), GG_REQUIRED, GG_TYPE_BUF, &username },
+            { GG_STR("password"), GG_REQUIRED, GG_TYPE_BUF, &password },
+            { GG_STR("serveraddress"), GG_REQUIRED, GG_TYPE_BUF, &server },
+        )
+    ));
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("AWS"), gg_obj_into_buf(*username)));
+    TEST_ASSERT_TRUE(
+        gg_buffer_eq(GG_STR("secret"), gg_obj_into_buf(*password))
+    );
+    TEST_ASSERT_TRUE(gg_buffer_eq(
+        GG_STR("123456789012.dkr.ecr.us-east-1.amazonaws.com"),
+        gg_obj_into_buf(*server)
+    ));
+
+    auth = find_registry_auth(
+        GG_STR("docker.io/library/app"), GG_BUF(auth_mem)
+    );
+    TEST_ASSERT_EQUAL_size_t(0, auth.len);
+}
+
 GG_TEST_DEFINE(is_private_ecr_true) {
     GglDockerUriInfo info = {
         .registry = GG_STR("123456789012.dkr.ecr.us-east-1.amazonaws.com"),
@@ -0,0 +1,746 @@
+/* aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "docker_engine.h"
+#include <gg/arena.h>
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/file.h>
+#include <gg/json_decode.h>
+#include <gg/log.h>
+#include <gg/map.h>
+#include <gg/object.h>
+#include <gg/socket.h>
+#include <gg/types.h>
+#include <gg/vector.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define DOCKER_ENGINE_DEFAULT_SOCKET "/var/run/docker.sock"
+
+/// The max length of a request's line and headers
+#define DOCKER_ENGINE_MAX_REQUEST_LEN (16384U)
+
+/// The max length of a pull progress message
+#define DOCKER_ENGINE_MAX_PROGRESS_LEN (2048U)
+
+typedef struct {
+    int fd;
+    uint8_t buf[4096];
+    size_t start;
+    size_t end;
+} EngineReader;
+
+typedef struct {
+    uint16_t status;
+    bool chunked;
+    bool has_length;
+    size_t content_length;
+} EngineResponse;
+
+typedef GgError (*EngineBodyCallback)(void *ctx, GgBuffer data);
+
+static GgError engine_connect(int *fd) {
+    GgBuffer path = GG_STR(DOCKER_ENGINE_DEFAULT_SOCKET);
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    char *docker_host = getenv("DOCKER_HOST");
+    if (docker_host != NULL) {
+        path = gg_buffer_from_null_term(docker_host);
+        if (!gg_buffer_remove_prefix(&path, GG_STR("unix://"))) {
+            GG_LOGD("DOCKER_HOST is not a unix socket.");
+            return GG_ERR_NOCONN;
+        }
+    }
+
+    GgError ret = gg_connect(path, fd);
+    if (ret != GG_ERR_OK) {
+        GG_LOGD(
+            "Could not connect to Docker Engine at %.*s.",
+            (int) path.len,
+            path.data
+        );
+        return GG_ERR_NOCONN;
+    }
+    return GG_ERR_OK;
+}
+
+/// Image names are used in the request path and query unescaped.
+static bool is_valid_image_name(GgBuffer image_name) {
+    if (image_name.len == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < image_name.len; i++) {
+        uint8_t c = image_name.data[i];
+        bool valid = ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'))
+            || ((c >= '0') && (c <= '9')) || (c == '.') || (c == '_')
+            || (c == '-') || (c == '/') || (c == ':') || (c == '@');
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static GgError engine_send_request(
+    int fd, GgBuffer method, GgBufList path, GgBufList headers
+) {
+    uint8_t request_mem[DOCKER_ENGINE_MAX_REQUEST_LEN];
+    GgByteVec request = GG_BYTE_VEC(request_mem);
+
+    GgError ret = gg_byte_vec_append(&request, method);
+    gg_byte_vec_chain_push(&ret, &request, ' ');
+    for (size_t i = 0; i < path.len; i++) {
+        gg_byte_vec_chain_append(&ret, &request, path.bufs[i]);
+    }
+    gg_byte_vec_chain_append(
+        &ret,
+        &request,
+        GG_STR(" HTTP/1.1\r\n"
+               "Host: docker\r\n"
+               "Connection: close\r\n"
+               "Content-Length: 0\r\n")
+    );
+    for (size_t i = 0; i < headers.len; i++) {
+        gg_byte_vec_chain_append(&ret, &request, headers.bufs[i]);
+    }
+    gg_byte_vec_chain_append(&ret, &request, GG_STR("\r\n"));
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Docker Engine request too long.");
+        return ret;
+    }
+
+    return gg_socket_write(fd, request.buf);
+}
+
+static GgError reader_fill(EngineReader *reader) {
+    if (reader->start > 0) {
+        memmove(
+            reader->buf,
+            &reader->buf[reader->start],
+            reader->end - reader->start
+        );
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end == sizeof(reader->buf)) {
+        GG_LOGE("Docker Engine response line too long.");
+        return GG_ERR_NOMEM;
+    }
+
+    GgBuffer space = { .data = &reader->buf[reader->end],
+                       .len = sizeof(reader->buf) - reader->end };
+    GgError ret = gg_file_read(reader->fd, &space);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    if (space.len == 0) {
+        return GG_ERR_NODATA;
+    }
+    reader->end += space.len;
+    return GG_ERR_OK;
+}
+
+/// Reads a CRLF-terminated line. The line is valid until the next read.
+static GgError reader_line(EngineReader *reader, GgBuffer *line) {
+    // Bytes after start already searched, relative to start
+    size_t searched = 0;
+    while (true) {
+        for (size_t i = reader->start + searched; i + 1 < reader->end; i++) {
+            if ((reader->buf[i] == '\r') && (reader->buf[i + 1] == '\n')) {
+                *line = (GgBuffer) { .data = &reader->buf[reader->start],
+                                     .len = i - reader->start };
+                reader->start = i + 2;
+                return GG_ERR_OK;
+            }
+        }
+        if (reader->end > reader->start) {
+            searched = reader->end - reader->start - 1;
+        }
+        GgError ret = reader_fill(reader);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+}
+
+/// Reads up to max bytes. The data is valid until the next read.
+static GgError reader_take(EngineReader *reader, size_t max, GgBuffer *data) {
+    if (reader->start == reader->end) {
+        GgError ret = reader_fill(reader);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    size_t available = reader->end - reader->start;
+    size_t len = (available < max) ? available : max;
+    *data = (GgBuffer) { .data = &reader->buf[reader->start], .len = len };
+    reader->start += len;
+    return GG_ERR_OK;
+}
+
+static bool header_name_eq(GgBuffer name, GgBuffer expected) {
+    if (name.len != expected.len) {
+        return false;
+    }
+    for (size_t i = 0; i < name.len; i++) {
+        uint8_t c = name.data[i];
+        if ((c >= 'A') && (c <= 'Z')) {
+            c = (uint8_t) (c - 'A' + 'a');
+        }
+        if (c != expected.data[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static GgError parse_size(GgBuffer text, unsigned base, size_t *value) {
+    if (text.len == 0) {
+        return GG_ERR_PARSE;
+    }
+    size_t result = 0;
+    for (size_t i = 0; i < text.len; i++) {
+        uint8_t c = text.data[i];
+        unsigned digit;
+        if ((c >= '0') && (c <= '9')) {
+            digit = (unsigned) (c - '0');
+        } else if ((base == 16) && (c >= 'a') && (c <= 'f')) {
+            digit = (unsigned) (c - 'a' + 10);
+        } else if ((base == 16) && (c >= 'A') && (c <= 'F')) {
+            digit = (unsigned) (c - 'A' + 10);
+        } else {
+            return GG_ERR_PARSE;
+        }
+        if (result > (SIZE_MAX - digit) / base) {
+            return GG_ERR_RANGE;
+        }
+        result = (result * base) + digit;
+    }
+    *value = result;
+    return GG_ERR_OK;
+}
+
+static GgBuffer trim_spaces(GgBuffer buf) {
+    while ((buf.len > 0) && ((buf.data[0] == ' ') || (buf.data[0] == '\t'))) {
+        buf = gg_buffer_substr(buf, 1, SIZE_MAX);
+    }
+    while ((buf.len > 0)
+           && ((buf.data[buf.len - 1] == ' ')
+               || (buf.data[buf.len - 1] == '\t'))) {
+        buf.len -= 1;
+    }
+    return buf;
+}
+
+static GgError read_response_head(
+    EngineReader *reader, EngineResponse *response
+) {
+    *response = (EngineResponse) { 0 };
+
+    GgBuffer line;
+    GgError ret = reader_line(reader, &line);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    // HTTP/1.1 200 OK
+    size_t status = 0;
+    if ((line.len < 12) || !gg_buffer_has_prefix(line, GG_STR("HTTP/1."))
+        || (parse_size(gg_buffer_substr(line, 9, 12), 10, &status)
+            != GG_ERR_OK)) {
+        GG_LOGE("Invalid Docker Engine response status line.");
+        return GG_ERR_PARSE;
+    }
+    response->status = (uint16_t) status;
+
+    while (true) {
+        ret = reader_line(reader, &line);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        if (line.len == 0) {
+            return GG_ERR_OK;
+        }
+
+        size_t colon;
+        if (!gg_buffer_contains(line, GG_STR(":"), &colon)) {
+            continue;
+        }
+        GgBuffer name = gg_buffer_substr(line, 0, colon);
+        GgBuffer value
+            = trim_spaces(gg_buffer_substr(line, colon + 1, SIZE_MAX));
+
+        if (header_name_eq(name, GG_STR("transfer-encoding"))) {
+            size_t pos;
+            response->chunked
+                = gg_buffer_contains(value, GG_STR("chunked"), &pos);
+        } else if (header_name_eq(name, GG_STR("content-length"))) {
+            ret = parse_size(value, 10, &response->content_length);
+            if (ret != GG_ERR_OK) {
+                GG_LOGE("Invalid Docker Engine response length.");
+                return ret;
+            }
+            response->has_length = true;
+        }
+    }
+}
+
+static GgError read_body_bytes(
+    EngineReader *reader, size_t len, EngineBodyCallback cb, void *ctx
+) {
+    while (len > 0) {
+        GgBuffer data;
+        GgError ret = reader_take(reader, len, &data);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        len -= data.len;
+        if (cb != NULL) {
+            ret = cb(ctx, data);
+            if (ret != GG_ERR_OK) {
+                return ret;
+            }
+        }
+    }
+    return GG_ERR_OK;
+}
+
+/// Streams the response body to cb, which may be NULL to discard it.
+static GgError read_response_body(
+    EngineReader *reader,
+    const EngineResponse *response,
+    EngineBodyCallback cb,
+    void *ctx
+) {
+    if (response->chunked) {
+        while (true) {
+            GgBuffer line;
+            GgError ret = reader_line(reader, &line);
+            if (ret != GG_ERR_OK) {
+                return ret;
+            }
+            size_t ext;
+            if (gg_buffer_contains(line, GG_STR(";"), &ext)) {
+                line = gg_buffer_substr(line, 0, ext);
+            }
+            size_t chunk_len;
+            ret = parse_size(trim_spaces(line), 16, &chunk_len);
+            if (ret != GG_ERR_OK) {
+                GG_LOGE("Invalid Docker Engine response chunk.");
+                return ret;
+            }
+            if (chunk_len == 0) {
+                // Skip trailers
+                do {
+                    ret = reader_line(reader, &line);
+                } while ((ret == GG_ERR_OK) && (line.len > 0));
+                return ret;
+            }
+            ret = read_body_bytes(reader, chunk_len, cb, ctx);
+            if (ret != GG_ERR_OK) {
+                return ret;
+            }
+            ret = reader_line(reader, &line);
+            if (ret != GG_ERR_OK) {
+                return ret;
+            }
+        }
+    }
+
+    if (response->has_length) {
+        return read_body_bytes(reader, response->content_length, cb, ctx);
+    }
+
+    // Body ends when the connection is closed
+    while (true) {
+        GgBuffer data;
+        GgError ret = reader_take(reader, SIZE_MAX, &data);
+        if (ret == GG_ERR_NODATA) {
+            return GG_ERR_OK;
+        }
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        if (cb != NULL) {
+            ret = cb(ctx, data);
+            if (ret != GG_ERR_OK) {
+                return ret;
+            }
+        }
+    }
+}
+
+static GgError collect_body(void *ctx, GgBuffer data) {
+    GgByteVec *body = ctx;
+    GgBuffer remaining = gg_byte_vec_remaining_capacity(*body);
+    (void) gg_byte_vec_append(body, gg_buffer_substr(data, 0, remaining.len));
+    return GG_ERR_OK;
+}
+
+/// Logs the error message from an error response body.
+static void log_error_response(
+    EngineReader *reader, const EngineResponse *response, const char *action
+) {
+    uint8_t body_mem[512];
+    GgByteVec body = GG_BYTE_VEC(body_mem);
+    (void) read_response_body(reader, response, collect_body, &body);
+    GG_LOGE(
+        "Docker Engine %s failed (HTTP %u): %.*s",
+        action,
+        (unsigned) response->status,
+        (int) body.buf.len,
+        body.buf.data
+    );
+}
+
+/// Connects and sends a request, then reads the response head.
+static GgError engine_call(
+    EngineReader *reader,
+    GgBuffer method,
+    GgBufList path,
+    GgBufList headers,
+    EngineResponse *response
+) {
+    GgError ret = engine_connect(&reader->fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    reader->start = 0;
+    reader->end = 0;
+
+    ret = engine_send_request(reader->fd, method, path, headers);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to send Docker Engine request.");
+        return GG_ERR_FAILURE;
+    }
+
+    ret = read_response_head(reader, response);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to read Docker Engine response.");
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+GgError ggl_docker_engine_inspect_image(GgBuffer image_name) {
+    if (!is_valid_image_name(image_name)) {
+        GG_LOGE("Invalid docker image name.");
+        return GG_ERR_INVALID;
+    }
+
+    EngineReader reader;
+    EngineResponse response;
+    GgError ret = engine_call(
+        &reader,
+        GG_STR("GET"),
+        GG_BUF_LIST(GG_STR("/images/"), image_name, GG_STR("/json")),
+        (GgBufList) { 0 },
+        &response
+    );
+    if (ret == GG_ERR_NOCONN) {
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, reader.fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    if (response.status == 404U) {
+        return GG_ERR_NOENTRY;
+    }
+    if (response.status != 200U) {
+        log_error_response(&reader, &response, "image inspect");
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+typedef struct {
+    GgByteVec line;
+    bool overflow;
+    bool failed;
+} PullProgress;
+
+static void handle_progress_message(PullProgress *progress, GgBuffer line) {
+    uint8_t arena_mem[DOCKER_ENGINE_MAX_PROGRESS_LEN];
+    GgArena arena = gg_arena_init(GG_BUF(arena_mem));
+    GgObject message;
+    GgError ret = gg_json_decode_destructive(line, &arena, &message);
+    if ((ret != GG_ERR_OK) || (gg_obj_type(message) != GG_TYPE_MAP)) {
+        return;
+    }
+
+    GgObject *error_obj = NULL;
+    GgObject *status_obj = NULL;
+    GgObject *id_obj = NULL;
+    ret = gg_map_validate(
+        gg_obj_into_map(message),
+        GG_MAP_SCHEMA(
+            { GG_STR("error"), GG_OPTIONAL, GG_TYPE_BUF, &error_obj },
+            { GG_STR("status"), GG_OPTIONAL, GG_TYPE_BUF, &status_obj },
+            { GG_STR("id"), GG_OPTIONAL, GG_TYPE_BUF, &id_obj },
+        )
+    );
+    if (ret != GG_ERR_OK) {
+        return;
+    }
+
+    if (error_obj != NULL) {
+        GgBuffer error = gg_obj_into_buf(*error_obj);
+        GG_LOGE("docker pull failed: %.*s", (int) error.len, error.data);
+        progress->failed = true;
+        return;
+    }
+    if (status_obj != NULL) {
+        GgBuffer status = gg_obj_into_buf(*status_obj);
+        GgBuffer id = (id_obj != NULL) ? gg_obj_into_buf(*id_obj) : GG_STR("");
+        GG_LOGD(
+            "docker pull: %.*s %.*s",
+            (int) id.len,
+            id.data,
+            (int) status.len,
+            status.data
+        );
+    }
+}
+
+/// Splits the streamed body into newline-delimited JSON messages.
+static GgError pull_progress_data(void *ctx, GgBuffer data) {
+    PullProgress *progress = ctx;
+    for (size_t i = 0; i < data.len; i++) {
+        if (data.data[i] != '\n') {
+            if (gg_byte_vec_push(&progress->line, data.data[i]) != GG_ERR_OK) {
+                progress->overflow = true;
+            }
+            continue;
+        }
+        if (!progress->overflow) {
+            handle_progress_message(progress, progress->line.buf);
+        }
+        progress->line.buf.len = 0;
+        progress->overflow = false;
+    }
+    return GG_ERR_OK;
+}
+
+/// Splits an image reference into the repository and its tag or digest.
+/// The Engine API pulls every tag of a repository if no tag is given, so an
+/// untagged reference defaults to `latest` as with `docker pull`.
+static void split_image_reference(
+    GgBuffer image_name, GgBuffer *repository, GgBuffer *tag
+) {
+    for (size_t i = 0; i < image_name.len; i++) {
+        if (image_name.data[i] == '@') {
+            *repository = gg_buffer_substr(image_name, 0, i);
+            *tag = gg_buffer_substr(image_name, i + 1, image_name.len);
+            return;
+        }
+    }
+
+    // A colon before the last slash separates a registry port, not a tag
+    for (size_t i = image_name.len; i > 0; i--) {
+        uint8_t c = image_name.data[i - 1];
+        if (c == '/') {
+            break;
+        }
+        if (c == ':') {
+            *repository = gg_buffer_substr(image_name, 0, i - 1);
+            *tag = gg_buffer_substr(image_name, i, image_name.len);
+            return;
+        }
+    }
+
+    *repository = image_name;
+    *tag = GG_STR("latest");
+}
+
+GgError ggl_docker_engine_pull(GgBuffer image_name, GgBuffer registry_auth) {
+    if (!is_valid_image_name(image_name)) {
+        GG_LOGE("Invalid docker image name.");
+        return GG_ERR_INVALID;
+    }
+
+    GgBuffer repository;
+    GgBuffer tag;
+    split_image_reference(image_name, &repository, &tag);
+
+    GgBuffer auth_headers[3] = { GG_STR("X-Registry-Auth: "),
+                                 registry_auth,
+                                 GG_STR("\r\n") };
+    GgBufList headers = { .bufs = auth_headers,
+                          .len = (registry_auth.len > 0) ? 3 : 0 };
+
+    EngineReader reader;
+    EngineResponse response;
+    GgError ret = engine_call(
+        &reader,
+        GG_STR("POST"),
+        GG_BUF_LIST(
+            GG_STR("/images/create?fromImage="),
+            repository,
+            GG_STR("&tag="),
+            tag
+        ),
+        headers,
+        &response
+    );
+    if (ret == GG_ERR_NOCONN) {
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, reader.fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    if (response.status != 200U) {
+        log_error_response(&reader, &response, "image pull");
+        return GG_ERR_FAILURE;
+    }
+
+    // Errors after the pull starts are reported in the progress stream
+    uint8_t line_mem[DOCKER_ENGINE_MAX_PROGRESS_LEN];
+    PullProgress progress = { .line = GG_BYTE_VEC(line_mem) };
+    ret = read_response_body(&reader, &response, pull_progress_data, &progress);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to read docker pull progress.");
+        return GG_ERR_FAILURE;
+    }
+    if (progress.line.buf.len > 0) {
+        handle_progress_message(&progress, progress.line.buf);
+    }
+    return progress.failed ? GG_ERR_FAILURE : GG_ERR_OK;
+}
+
+GgError ggl_docker_engine_remove(GgBuffer image_name) {
+    if (!is_valid_image_name(image_name)) {
+        GG_LOGE("Invalid docker image name.");
+        return GG_ERR_INVALID;
+    }
+
+    EngineReader reader;
+    EngineResponse response;
+    GgError ret = engine_call(
+        &reader,
+        GG_STR("DELETE"),
+        GG_BUF_LIST(GG_STR("/images/"), image_name),
+        (GgBufList) { 0 },
+        &response
+    );
+    if (ret == GG_ERR_NOCONN) {
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, reader.fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    if (response.status == 404U) {
+        GG_LOGD("Image was not found to delete.");
+        return GG_ERR_OK;
+    }
+    if (response.status != 200U) {
+        log_error_response(&reader, &response, "image remove");
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+#ifdef GG_SDK_TESTING
+
+#include <gg/test.h>
+#include <sys/socket.h>
+#include <unity.h>
+
+static EngineReader test_reader;
+
+static void test_reader_init(GgBuffer response) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    GG_TEST_ASSERT_OK(gg_socket_write(fds[1], response));
+    (void) gg_close(fds[1]);
+    test_reader = (EngineReader) { .fd = fds[0] };
+}
+
+GG_TEST_DEFINE(docker_engine_chunked_progress) {
+    test_reader_init(GG_STR(
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "19\r\n{\"status\":\"Pulling\",\"id\":\r\n"
+        "7\r\n\"a1\"}\n{\r\n"
+        "12\r\n\"error\":\"denied\"}\n\r\n"
+        "0\r\n\r\n"
+    ));
+    GG_CLEANUP(cleanup_close, test_reader.fd);
+
+    EngineResponse response;
+    GG_TEST_ASSERT_OK(read_response_head(&test_reader, &response));
+    TEST_ASSERT_EQUAL_UINT16(200, response.status);
+    TEST_ASSERT_TRUE(response.chunked);
+
+    uint8_t line_mem[64];
+    PullProgress progress = { .line = GG_BYTE_VEC(line_mem) };
+    GG_TEST_ASSERT_OK(read_response_body(
+        &test_reader, &response, pull_progress_data, &progress
+    ));
+    TEST_ASSERT_TRUE(progress.failed);
+}
+
+GG_TEST_DEFINE(docker_engine_image_reference) {
+    GgBuffer repository;
+    GgBuffer tag;
+
+    split_image_reference(GG_STR("ubuntu"), &repository, &tag);
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("ubuntu"), repository));
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("latest"), tag));
+
+    split_image_reference(
+        GG_STR("registry.local:5000/ns/app"), &repository, &tag
+    );
+    TEST_ASSERT_TRUE(
+        gg_buffer_eq(GG_STR("registry.local:5000/ns/app"), repository)
+    );
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("latest"), tag));
+
+    split_image_reference(
+        GG_STR("registry.local:5000/app:1.2"), &repository, &tag
+    );
+    TEST_ASSERT_TRUE(
+        gg_buffer_eq(GG_STR("registry.local:5000/app"), repository)
+    );
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("1.2"), tag));
+
+    split_image_reference(GG_STR("app@sha256:ab12"), &repository, &tag);
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("app"), repository));
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("sha256:ab12"), tag));
+}
+
+GG_TEST_DEFINE(docker_engine_content_length) {
+    test_reader_init(GG_STR(
+        "HTTP/1.1 404 Not Found\r\n"
+        "content-length: 5\r\n"
+        "\r\n"
+        "nopeX"
+    ));
+    GG_CLEANUP(cleanup_close, test_reader.fd);
+
+    EngineResponse response;
+    GG_TEST_ASSERT_OK(read_response_head(&test_reader, &response));
+    TEST_ASSERT_EQUAL_UINT16(404, response.status);
+    TEST_ASSERT_FALSE(response.chunked);
+
+    uint8_t body_mem[16];
+    GgByteVec body = GG_BYTE_VEC(body_mem);
+    GG_TEST_ASSERT_OK(
+        read_response_body(&test_reader, &response, collect_body, &body)
+    );
+    TEST_ASSERT_TRUE(gg_buffer_eq(GG_STR("nopeX"), body.buf));
+}
+
+#endif
@@ -0,0 +1,27 @@
+/* aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef GGL_DOCKER_ENGINE_H
+#define GGL_DOCKER_ENGINE_H
+
+//! Docker Engine API client over the daemon's unix socket.
+//! The socket is `/var/run/docker.sock` unless DOCKER_HOST names a unix
+//! socket. All functions return GG_ERR_NOCONN if the daemon can't be reached
+//! this way, so that callers can fall back to the docker CLI.
+
+#include <gg/error.h>
+#include <gg/types.h>
+
+/// Returns GG_ERR_NOENTRY if the image is not present.
+GgError ggl_docker_engine_inspect_image(GgBuffer image_name);
+
+/// Pull an image, logging progress as it is streamed.
+/// registry_auth is the X-Registry-Auth header value, or empty.
+GgError ggl_docker_engine_pull(GgBuffer image_name, GgBuffer registry_auth);
+
+/// Remove an image. Succeeds if the image does not exist.
+GgError ggl_docker_engine_remove(GgBuffer image_name);
+
+#endif
@@ -8,6 +8,7 @@
 #include <gg/error.h>
 #include <gg/types.h>
 #include <openssl/types.h>
+#include <sys/types.h>
 
 typedef struct GglDigest {
     EVP_MD_CTX *ctx;
@@ -31,6 +32,45 @@ GgError ggl_verify_sha256_digest(
     int dirfd, GgBuffer path, GgBuffer expected_digest, GglDigest digest_context
 );
 
+/// @brief Starts a streaming SHA256 digest.
+///
+/// Any data previously added to digest_context is discarded.
+GgError ggl_digest_sha256_init(GglDigest digest_context);
+
+/// @brief Adds data to a streaming digest started by ggl_digest_sha256_init().
+GgError ggl_digest_update(GglDigest digest_context, GgBuffer data);
+
+/// @brief Adds the first len bytes of a file to a streaming digest.
+///
+/// @param[in] fd file open for read; its offset is not modified.
+/// @param[in] len number of bytes to read from the start of the file.
+GgError ggl_digest_update_from_fd(GglDigest digest_context, int fd, off_t len);
+
+/// @brief Finishes a streaming digest and compares it to an expected SHA256.
+GgError ggl_digest_sha256_verify(
+    GglDigest digest_context, GgBuffer expected_digest
+);
+
+/// @brief Finishes a streaming digest and writes the SHA256 to digest.
+///
+/// @param[in,out] digest buffer with room for 32 bytes; len is set to the
+/// digest length.
+GgError ggl_digest_sha256_final(GglDigest digest_context, GgBuffer *digest);
+
+/// @brief Writes the lowercase hex encoding of a digest.
+///
+/// @param[in,out] hex buffer with room for twice digest.len bytes; len is set
+/// to the encoded length.
+GgError ggl_digest_hex_encode(GgBuffer digest, GgBuffer *hex);
+
+/// @brief Decodes a digest written by ggl_digest_hex_encode().
+///
+/// @param[in,out] digest buffer with room for hex.len / 2 bytes; len is set to
+/// the decoded length.
+///
+/// @return GG_ERR_PARSE if hex is not lowercase hex of even length.
+GgError ggl_digest_hex_decode(GgBuffer hex, GgBuffer *digest);
+
 void ggl_free_digest(GglDigest *digest_context);
 
 #endif
@@ -7,6 +7,8 @@
 
 #include <gg/error.h>
 #include <gg/types.h>
+#include <gg/vector.h>
+#include <ggl/digest.h>
 #include <stdint.h>
 
 typedef struct CertificateDetails {
@@ -31,6 +33,26 @@ typedef struct SigV4Details {
     GgBuffer session_token;
 } SigV4Details;
 
+/// State carried across attempts of a resumable download.
+///
+/// A download into a file descriptor whose offset is non-zero continues from
+/// that offset with a Range request, as long as an entity tag is known for the
+/// bytes already written. Otherwise the file is truncated and the download
+/// starts from the beginning.
+typedef struct GglDownloadResume {
+    /// Entity tag of the content in the file. Sent as If-Range when resuming,
+    /// and updated from each response. Must have capacity for the tag.
+    GgByteVec etag;
+    /// Streaming SHA256 digest of the content in the file. The caller must
+    /// start it and add any content already before the fd offset. Updated
+    /// with every byte written, and restarted if the file is truncated.
+    /// Ignored if ctx is NULL.
+    GglDigest digest;
+    /// Called when etag changes, so that it can be persisted. May be NULL.
+    void (*etag_changed)(void *ctx, GgBuffer etag);
+    void *etag_changed_ctx;
+} GglDownloadResume;
+
 /// @brief Fetches temporary AWS credentials.
 ///
 /// @param[in] url_for_token The aws IoT credentials endpoint URL.
@@ -65,6 +87,8 @@ GgError fetch_token(
 /// @param[in] url_for_generic_download The URL from which to fetch the content.
 /// @param[in] fd The file descriptor where the downloaded content should be
 /// written to.
+/// @param[inout] resume Resume state for interrupted downloads, or NULL to
+/// restart from the beginning of the file on failure.
 ///
 /// This function makes a GET request to the specified URL to download the
 /// content.The downloaded content is then saved to the file specified by the
@@ -76,13 +100,17 @@ GgError fetch_token(
 ///          provided `url_for_generic_download` and `fd` are valid.
 ///
 /// @return error code on failure, GG_ERR_OK on success
-GgError generic_download(const char *url_for_generic_download, int fd);
+GgError generic_download(
+    const char *url_for_generic_download, int fd, GglDownloadResume *resume
+);
 
 /// @brief Downloads the content from the specified URL and saves it to the
 /// given file path. Uses temporary credentials.
 ///
 /// @param[in] url_for_generic_download The URL from which to fetch the content.
 /// @param[in] file File open for write in which response will be written to.
+/// @param[inout] resume Resume state for interrupted downloads, or NULL to
+/// restart from the beginning of the file on failure.
 /// @param[in] sigv4_details The sigv4 details used for REST API authentication
 /// @param[out] http_response_code Returns the response code from the request,
 /// the default value is 400 (BAD REQUEST)
@@ -101,6 +129,7 @@ GgError sigv4_download(
     GgBuffer host,
     GgBuffer file_path,
     int fd,
+    GglDownloadResume *resume,
     SigV4Details sigv4_details,
     uint16_t *http_response_code
 );
@@ -56,13 +56,15 @@ GgError fetch_token(
     return error;
 }
 
-GgError generic_download(const char *url_for_generic_download, int fd) {
+GgError generic_download(
+    const char *url_for_generic_download, int fd, GglDownloadResume *resume
+) {
     GG_LOGI("downloading content from %s", url_for_generic_download);
 
     CurlData curl_data = { 0 };
     GgError error = gghttplib_init_curl(&curl_data, url_for_generic_download);
     if (error == GG_ERR_OK) {
-        error = gghttplib_process_request_with_fd(&curl_data, fd);
+        error = gghttplib_process_request_with_fd(&curl_data, fd, resume);
     }
 
     long http_status_code = 0;
@@ -78,6 +80,7 @@ GgError sigv4_download(
     GgBuffer host,
     GgBuffer file_path,
     int fd,
+    GglDownloadResume *resume,
     SigV4Details sigv4_details,
     uint16_t *http_response_code
 ) {
@@ -148,7 +151,7 @@ GgError sigv4_download(
     }
 
     if (error == GG_ERR_OK) {
-        error = gghttplib_process_request_with_fd(&curl_data, fd);
+        error = gghttplib_process_request_with_fd(&curl_data, fd, resume);
     }
 
     long http_status_code = 0;
@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <fcntl.h>
 #include <gg/buffer.h>
 #include <gg/cleanup.h>
@@ -9,6 +10,8 @@
 #include <openssl/evp.h>
 #include <openssl/sha.h>
 #include <openssl/types.h>
+#include <sys/types.h>
+#include <unistd.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -24,6 +27,99 @@ GglDigest ggl_new_digest(GgError *error) {
     return (GglDigest) { .ctx = ctx };
 }
 
+GgError ggl_digest_sha256_init(GglDigest digest_context) {
+    if (digest_context.ctx == NULL) {
+        return GG_ERR_INVALID;
+    }
+    if (!EVP_DigestInit(digest_context.ctx, EVP_sha256())) {
+        GG_LOGE("OpenSSL message digest init failed.");
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+GgError ggl_digest_update(GglDigest digest_context, GgBuffer data) {
+    if (digest_context.ctx == NULL) {
+        return GG_ERR_INVALID;
+    }
+    if (!EVP_DigestUpdate(digest_context.ctx, data.data, data.len)) {
+        GG_LOGE("OpenSSL digest update failed.");
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+GgError ggl_digest_update_from_fd(GglDigest digest_context, int fd, off_t len) {
+    uint8_t read_buffer[4096];
+    off_t offset = 0;
+    while (offset < len) {
+        size_t chunk_len = sizeof(read_buffer);
+        if ((off_t) chunk_len > len - offset) {
+            chunk_len = (size_t) (len - offset);
+        }
+        ssize_t bytes_read = pread(fd, read_buffer, chunk_len, offset);
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            GG_LOGE("Failed to read from file (errno=%d).", errno);
+            return GG_ERR_FAILURE;
+        }
+        if (bytes_read == 0) {
+            GG_LOGE("File ended before expected length.");
+            return GG_ERR_FAILURE;
+        }
+        GgError ret = ggl_digest_update(
+            digest_context,
+            (GgBuffer) { .data = read_buffer, .len = (size_t) bytes_read }
+        );
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        offset += bytes_read;
+    }
+    return GG_ERR_OK;
+}
+
+GgError ggl_digest_sha256_verify(
+    GglDigest digest_context, GgBuffer expected_digest
+) {
+    if (digest_context.ctx == NULL) {
+        return GG_ERR_INVALID;
+    }
+
+    uint8_t digest_buffer[SHA256_DIGEST_LENGTH];
+    unsigned int size = sizeof(digest_buffer);
+    if (!EVP_DigestFinal(digest_context.ctx, digest_buffer, &size)) {
+        GG_LOGE("OpenSSL digest finalize failed.");
+        return GG_ERR_FAILURE;
+    }
+
+    if (!gg_buffer_eq(
+            (GgBuffer) { .data = digest_buffer, .len = size }, expected_digest
+        )) {
+        GG_LOGE("Failed to verify digest.");
+        return GG_ERR_FAILURE;
+    }
+
+    return GG_ERR_OK;
+}
+
+GgError ggl_digest_sha256_final(GglDigest digest_context, GgBuffer *digest) {
+    if ((digest_context.ctx == NULL) || (digest->len < SHA256_DIGEST_LENGTH)) {
+        return GG_ERR_INVALID;
+    }
+
+    unsigned int size = SHA256_DIGEST_LENGTH;
+    if (!EVP_DigestFinal(digest_context.ctx, digest->data, &size)) {
+        GG_LOGE("OpenSSL digest finalize failed.");
+        return GG_ERR_FAILURE;
+    }
+    digest->len = size;
+
+    return GG_ERR_OK;
+}
+
 GgError ggl_verify_sha256_digest(
     int dirfd, GgBuffer path, GgBuffer expected_digest, GglDigest digest_context
 ) {
@@ -33,18 +129,15 @@ GgError ggl_verify_sha256_digest(
         return ret;
     }
     GG_CLEANUP(cleanup_close, file_fd);
-    if (digest_context.ctx == NULL) {
-        return GG_ERR_INVALID;
-    }
-    EVP_MD_CTX *ctx = digest_context.ctx;
-    if (!EVP_DigestInit(ctx, EVP_sha256())) {
-        GG_LOGE("OpenSSL message digest init failed.");
-        return GG_ERR_FAILURE;
+
+    ret = ggl_digest_sha256_init(digest_context);
+    if (ret != GG_ERR_OK) {
+        return ret;
     }
 
-    uint8_t digest_buffer[SHA256_DIGEST_LENGTH];
+    uint8_t read_buffer[4096];
     for (;;) {
-        GgBuffer chunk = GG_BUF(digest_buffer);
+        GgBuffer chunk = GG_BUF(read_buffer);
         ret = gg_file_read(file_fd, &chunk);
         if (chunk.len == 0) {
             break;
@@ -53,25 +146,60 @@ GgError ggl_verify_sha256_digest(
             GG_LOGE("Failed to read from file.");
             break;
         }
-        if (!EVP_DigestUpdate(ctx, chunk.data, chunk.len)) {
-            GG_LOGE("OpenSSL digest update failed.");
-            return GG_ERR_FAILURE;
+        ret = ggl_digest_update(digest_context, chunk);
+        if (ret != GG_ERR_OK) {
+            return ret;
         }
     }
 
-    unsigned int size = sizeof(digest_buffer);
-    if (!EVP_DigestFinal(ctx, digest_buffer, &size)) {
-        GG_LOGE("OpenSSL digest finalize failed.");
-        return GG_ERR_FAILURE;
+    return ggl_digest_sha256_verify(digest_context, expected_digest);
+}
+
+GgError ggl_digest_hex_encode(GgBuffer digest, GgBuffer *hex) {
+    if (hex->len / 2 < digest.len) {
+        return GG_ERR_NOMEM;
+    }
+    static const char HEX[] = "0123456789abcdef";
+    for (size_t i = 0; i < digest.len; i++) {
+        hex->data[i * 2] = (uint8_t) HEX[digest.data[i] >> 4];
+        hex->data[(i * 2) + 1] = (uint8_t) HEX[digest.data[i] & 0xFU];
     }
+    hex->len = digest.len * 2;
+    return GG_ERR_OK;
+}
 
-    if (!gg_buffer_eq(
-            (GgBuffer) { .data = digest_buffer, .len = size }, expected_digest
-        )) {
-        GG_LOGE("Failed to verify digest.");
-        return GG_ERR_FAILURE;
+static GgError hex_nibble(uint8_t c, uint8_t *nibble) {
+    if ((c >= '0') && (c <= '9')) {
+        *nibble = (uint8_t) (c - '0');
+    } else if ((c >= 'a') && (c <= 'f')) {
+        *nibble = (uint8_t) (c - 'a' + 10);
+    } else {
+        return GG_ERR_PARSE;
     }
+    return GG_ERR_OK;
+}
 
+GgError ggl_digest_hex_decode(GgBuffer hex, GgBuffer *digest) {
+    if ((hex.len % 2) != 0) {
+        return GG_ERR_PARSE;
+    }
+    if (digest->len < hex.len / 2) {
+        return GG_ERR_NOMEM;
+    }
+    for (size_t i = 0; i < hex.len / 2; i++) {
+        uint8_t high;
+        uint8_t low;
+        GgError ret = hex_nibble(hex.data[i * 2], &high);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        ret = hex_nibble(hex.data[(i * 2) + 1], &low);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        digest->data[i] = (uint8_t) ((high << 4) | low);
+    }
+    digest->len = hex.len / 2;
     return GG_ERR_OK;
 }
 
@@ -15,6 +15,7 @@
 #include <gg/log.h>
 #include <gg/vector.h>
 #include <ggl/core_bus/gg_config.h>
+#include <ggl/digest.h>
 #include <ggl/http.h>
 #include <limits.h>
 #include <openssl/evp.h>
@@ -24,6 +25,7 @@
 #include <openssl/x509.h>
 #include <pthread.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <stdbool.h>
@@ -109,6 +111,8 @@ typedef struct CurlRequestRetryCtx {
 
     // reset response_data for next attempt
     GgError (*retry_fn)(void *);
+    // additional responses to retry for response_data; may be NULL
+    bool (*can_retry_response)(void *);
     void *response_data;
 
     // Needed to propagate errors when retrying is impossible.
@@ -121,9 +125,23 @@ static GgError clear_buffer(void *response_data) {
     return GG_ERR_OK;
 }
 
-static GgError truncate_file(void *response_data) {
-    int fd = *(int *) response_data;
-
+typedef struct FdResponseCtx {
+    CurlData *curl_data;
+    int fd;
+    GglDownloadResume *resume;
+    // File offset the current attempt started writing at.
+    off_t start_offset;
+    // Entity tag of the current response, committed once headers complete.
+    GgByteVec response_etag;
+    uint8_t response_etag_mem[256];
+    // Whether the current response's Content-Range starts at start_offset.
+    bool range_matches;
+    // Set when the partial content cannot be resumed; the next attempt
+    // starts from the beginning.
+    bool restart;
+} FdResponseCtx;
+
+static GgError truncate_file(int fd) {
     int ret;
     do {
         ret = ftruncate(fd, 0);
@@ -140,12 +158,176 @@ static GgError truncate_file(void *response_data) {
     return GG_ERR_OK;
 }
 
+// The content must be durable before an entity tag describing it is
+// persisted, or a resumed download could extend lost or torn content.
+static void set_resume_etag(FdResponseCtx *ctx, GgBuffer etag) {
+    GglDownloadResume *resume = ctx->resume;
+    if (gg_buffer_eq(resume->etag.buf, etag)) {
+        return;
+    }
+    if ((etag.len > 0) && (fsync(ctx->fd) != 0)) {
+        GG_LOGW(
+            "Failed to sync partial download (errno=%d); download will not be resumable.",
+            errno
+        );
+        etag = GG_STR("");
+    }
+    resume->etag.buf.len = 0;
+    GgError ret = gg_byte_vec_append(&resume->etag, etag);
+    if (ret != GG_ERR_OK) {
+        GG_LOGW("Entity tag too long; download will not be resumable.");
+        resume->etag.buf.len = 0;
+    }
+    if (resume->etag_changed != NULL) {
+        resume->etag_changed(resume->etag_changed_ctx, resume->etag.buf);
+    }
+}
+
+// Discards the partially downloaded content.
+static GgError restart_fd_download(FdResponseCtx *ctx) {
+    GgError ret = truncate_file(ctx->fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ctx->start_offset = 0;
+    if (ctx->resume == NULL) {
+        return GG_ERR_OK;
+    }
+    set_resume_etag(ctx, GG_STR(""));
+    if (ctx->resume->digest.ctx != NULL) {
+        return ggl_digest_sha256_init(ctx->resume->digest);
+    }
+    return GG_ERR_OK;
+}
+
+// Requests the remaining content with Range and If-Range headers.
+static GgError set_fd_request_range(FdResponseCtx *ctx) {
+    CurlData *curl_data = ctx->curl_data;
+    if (curl_data->attempt_headers_list != NULL) {
+        curl_slist_free_all(curl_data->attempt_headers_list);
+        curl_data->attempt_headers_list = NULL;
+    }
+
+    if (ctx->start_offset == 0) {
+        CURLcode curl_error
+            = curl_easy_setopt(curl_data->curl, CURLOPT_RANGE, NULL);
+        if (curl_error == CURLE_OK) {
+            curl_error = curl_easy_setopt(
+                curl_data->curl, CURLOPT_HTTPHEADER, curl_data->headers_list
+            );
+        }
+        return translate_curl_code(curl_error);
+    }
+
+    char range[32];
+    snprintf(range, sizeof(range), "%lld-", (long long) ctx->start_offset);
+
+    char if_range[512];
+    GgByteVec if_range_vec = GG_BYTE_VEC(if_range);
+    GgError ret = gg_byte_vec_append(&if_range_vec, GG_STR("If-Range: "));
+    gg_byte_vec_chain_append(&ret, &if_range_vec, ctx->resume->etag.buf);
+    gg_byte_vec_chain_push(&ret, &if_range_vec, '\0');
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    struct curl_slist *list = NULL;
+    for (struct curl_slist *header = curl_data->headers_list; header != NULL;
+         header = header->next) {
+        struct curl_slist *new_head = curl_slist_append(list, header->data);
+        if (new_head == NULL) {
+            curl_slist_free_all(list);
+            return GG_ERR_NOMEM;
+        }
+        list = new_head;
+    }
+    struct curl_slist *new_head = curl_slist_append(list, if_range);
+    if (new_head == NULL) {
+        curl_slist_free_all(list);
+        return GG_ERR_NOMEM;
+    }
+    curl_data->attempt_headers_list = new_head;
+
+    CURLcode curl_error
+        = curl_easy_setopt(curl_data->curl, CURLOPT_RANGE, range);
+    if (curl_error == CURLE_OK) {
+        curl_error = curl_easy_setopt(
+            curl_data->curl,
+            CURLOPT_HTTPHEADER,
+            curl_data->attempt_headers_list
+        );
+    }
+    return translate_curl_code(curl_error);
+}
+
+// A range the server does not satisfy (416), or answers with content from a
+// different offset, is retried from the beginning.
+static bool fd_needs_restart(void *response_data) {
+    FdResponseCtx *ctx = (FdResponseCtx *) response_data;
+    if ((ctx->resume == NULL) || (ctx->start_offset == 0)) {
+        return false;
+    }
+    if (ctx->restart) {
+        return true;
+    }
+    long http_status_code = 0;
+    curl_easy_getinfo(
+        ctx->curl_data->curl, CURLINFO_HTTP_CODE, &http_status_code
+    );
+    if (http_status_code == 416) {
+        GG_LOGW("Server rejected download range; restarting download.");
+        ctx->restart = true;
+    }
+    return ctx->restart;
+}
+
+static GgError prepare_fd_attempt(void *response_data) {
+    FdResponseCtx *ctx = (FdResponseCtx *) response_data;
+    ctx->response_etag.buf.len = 0;
+    ctx->range_matches = false;
+
+    if (ctx->resume == NULL) {
+        ctx->start_offset = 0;
+        return truncate_file(ctx->fd);
+    }
+
+    off_t offset = lseek(ctx->fd, 0, SEEK_CUR);
+    if (offset == -1) {
+        GG_LOGE("Failed to get fd offset (errno=%d).", errno);
+        return GG_ERR_FAILURE;
+    }
+    ctx->start_offset = offset;
+
+    if (ctx->restart) {
+        ctx->restart = false;
+        GgError ret = restart_fd_download(ctx);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    } else if ((offset > 0) && (ctx->resume->etag.buf.len == 0)) {
+        GG_LOGD("No entity tag for partial download; restarting download.");
+        GgError ret = restart_fd_download(ctx);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+
+    if (ctx->start_offset > 0) {
+        GG_LOGI(
+            "Resuming download from byte %lld.", (long long) ctx->start_offset
+        );
+    }
+    return set_fd_request_range(ctx);
+}
+
 static GgError curl_request_retry_wrapper(void *ctx) {
     CurlRequestRetryCtx *retry_ctx = (CurlRequestRetryCtx *) ctx;
     CurlData *curl_data = retry_ctx->curl_data;
 
     CURLcode curl_error = curl_easy_perform(curl_data->curl);
-    if (can_retry(curl_error, curl_data)) {
+    if (can_retry(curl_error, curl_data)
+        || ((retry_ctx->can_retry_response != NULL)
+            && retry_ctx->can_retry_response(retry_ctx->response_data))) {
         GgError err = retry_ctx->retry_fn(retry_ctx->response_data);
         if (err != GG_ERR_OK) {
             retry_ctx->err = err;
@@ -204,11 +386,18 @@ static GgError do_curl_request(
     return GG_ERR_OK;
 }
 
-static GgError do_curl_request_fd(CurlData *curl_data, int fd) {
-    CurlRequestRetryCtx ctx = { .curl_data = curl_data,
-                                .response_data = (void *) &fd,
-                                .retry_fn = truncate_file,
+static GgError do_curl_request_fd(FdResponseCtx *fd_ctx) {
+    CurlRequestRetryCtx ctx = { .curl_data = fd_ctx->curl_data,
+                                .response_data = (void *) fd_ctx,
+                                .retry_fn = prepare_fd_attempt,
+                                .can_retry_response = fd_needs_restart,
                                 .err = GG_ERR_OK };
+    if (fd_ctx->resume != NULL) {
+        GgError ret = prepare_fd_attempt(fd_ctx);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
     GgError ret
         = gg_backoff(1000, 64000, 7, curl_request_retry_wrapper, (void *) &ctx);
     if (ret != GG_ERR_OK) {
@@ -265,16 +454,16 @@ static size_t write_response_to_buffer(
 ///
 /// This function is used as a callback by CURL to handle the response data
 /// received from an HTTP request. It write bytes received into the file
-/// descriptor.
+/// descriptor, and adds them to the resume digest if there is one.
 ///
 /// @param[in] response_data A pointer to the response data received from CURL.
 /// @param[in] size The size of each element in the response data.
 /// @param[in] nmemb The number of elements in the response data.
-/// @param[in] fd_void A pointer to a file descriptor
+/// @param[in] ctx_void A pointer to a FdResponseCtx
 ///
 /// @return The number of bytes written.
 static size_t write_response_to_fd(
-    void *response_data, size_t size, size_t nmemb, void *fd_void
+    void *response_data, size_t size, size_t nmemb, void *ctx_void
 ) {
     if (response_data == NULL) {
         return 0;
@@ -282,15 +471,136 @@ static size_t write_response_to_fd(
     size_t size_of_response_data = size * nmemb;
     GgBuffer response_buffer
         = (GgBuffer) { .data = response_data, .len = size_of_response_data };
-    assert(fd_void != NULL);
-    int *fd = (int *) fd_void;
-    GgError err = gg_file_write(*fd, response_buffer);
+    assert(ctx_void != NULL);
+    FdResponseCtx *ctx = (FdResponseCtx *) ctx_void;
+    GgError err = gg_file_write(ctx->fd, response_buffer);
     if (err != GG_ERR_OK) {
         return 0;
     }
+    if ((ctx->resume != NULL) && (ctx->resume->digest.ctx != NULL)) {
+        err = ggl_digest_update(ctx->resume->digest, response_buffer);
+        if (err != GG_ERR_OK) {
+            return 0;
+        }
+    }
     return size_of_response_data;
 }
 
+// Checks that a Content-Range value ("bytes <first>-<last>/<length>") starts
+// at offset.
+static bool content_range_starts_at(GgBuffer value, off_t offset) {
+    while ((value.len > 0)
+           && ((value.data[0] == ' ') || (value.data[0] == '\t'))) {
+        value = gg_buffer_substr(value, 1, SIZE_MAX);
+    }
+    if (!gg_buffer_has_prefix(value, GG_STR("bytes "))) {
+        return false;
+    }
+    value = gg_buffer_substr(value, sizeof("bytes ") - 1, SIZE_MAX);
+
+    uint64_t first = 0;
+    size_t digits = 0;
+    for (; (digits < value.len) && (value.data[digits] >= '0')
+         && (value.data[digits] <= '9');
+         digits++) {
+        if (first > (UINT64_MAX - 9) / 10) {
+            return false;
+        }
+        first = (first * 10) + (uint64_t) (value.data[digits] - '0');
+    }
+    if ((digits == 0) || (digits >= value.len)
+        || (value.data[digits] != '-')) {
+        return false;
+    }
+    return first == (uint64_t) offset;
+}
+
+/// @brief Callback function to handle HTTP response headers for a download to
+/// a file descriptor.
+///
+/// Records the entity tag of successful responses. Once headers are complete,
+/// discards any partial content if the server sent the full content instead of
+/// the requested range, and then commits the entity tag, so that a persisted
+/// entity tag never describes content it did not come from. A partial response
+/// whose Content-Range does not start at the requested offset is aborted and
+/// retried from the beginning.
+///
+/// @return The number of bytes handled.
+static size_t read_response_header_fd(
+    char *header, size_t size, size_t nitems, void *ctx_void
+) {
+    size_t header_len = size * nitems;
+    assert(ctx_void != NULL);
+    FdResponseCtx *ctx = (FdResponseCtx *) ctx_void;
+    if (ctx->resume == NULL) {
+        return header_len;
+    }
+
+    long http_status_code = 0;
+    curl_easy_getinfo(
+        ctx->curl_data->curl, CURLINFO_HTTP_CODE, &http_status_code
+    );
+    if ((http_status_code != 200) && (http_status_code != 206)) {
+        return header_len;
+    }
+
+    GgBuffer line = { .data = (uint8_t *) header, .len = header_len };
+    while ((line.len > 0)
+           && ((line.data[line.len - 1] == '\n')
+               || (line.data[line.len - 1] == '\r'))) {
+        line.len -= 1;
+    }
+
+    if (line.len == 0) {
+        if ((http_status_code == 206) && !ctx->range_matches) {
+            GG_LOGW("Server sent unexpected content range; aborting.");
+            ctx->restart = true;
+            return 0;
+        }
+        if ((http_status_code == 200) && (ctx->start_offset > 0)) {
+            GG_LOGI("Server sent full content; restarting download.");
+            if (restart_fd_download(ctx) != GG_ERR_OK) {
+                return 0;
+            }
+        }
+        set_resume_etag(ctx, ctx->response_etag.buf);
+        return header_len;
+    }
+
+    static const char CONTENT_RANGE_HEADER[] = "content-range:";
+    if ((line.len >= sizeof(CONTENT_RANGE_HEADER) - 1)
+        && (strncasecmp(
+                header, CONTENT_RANGE_HEADER, sizeof(CONTENT_RANGE_HEADER) - 1
+            )
+            == 0)) {
+        ctx->range_matches = content_range_starts_at(
+            gg_buffer_substr(line, sizeof(CONTENT_RANGE_HEADER) - 1, SIZE_MAX),
+            ctx->start_offset
+        );
+        return header_len;
+    }
+
+    static const char ETAG_HEADER[] = "etag:";
+    if ((line.len < sizeof(ETAG_HEADER) - 1)
+        || (strncasecmp(header, ETAG_HEADER, sizeof(ETAG_HEADER) - 1) != 0)) {
+        return header_len;
+    }
+    GgBuffer etag = gg_buffer_substr(line, sizeof(ETAG_HEADER) - 1, SIZE_MAX);
+    while ((etag.len > 0)
+           && ((etag.data[0] == ' ') || (etag.data[0] == '\t'))) {
+        etag = gg_buffer_substr(etag, 1, SIZE_MAX);
+    }
+    // If-Range requires a strong validator.
+    if (gg_buffer_has_prefix(etag, GG_STR("W/"))) {
+        return header_len;
+    }
+    ctx->response_etag.buf.len = 0;
+    if (gg_byte_vec_append(&ctx->response_etag, etag) != GG_ERR_OK) {
+        ctx->response_etag.buf.len = 0;
+    }
+    return header_len;
+}
+
 /// @brief Set HTTPS proxy configuration for curl requests if enabled or setup
 /// by the config.
 ///
@@ -447,17 +757,162 @@ static GgError set_curl_proxy_config(CurlData *curl_data) {
     return GG_ERR_OK;
 }
 
+// Requests share DNS, TLS session and connection caches through a curl share
+// handle, so repeated requests to the same host skip the TCP and TLS
+// handshakes. Client certificates are loaded through ssl_ctx_callback, which
+// curl cannot compare when matching connections, so each set of credentials
+// gets its own share handle.
+//
+// curl does not support concurrent transfers on a shared connection cache, so
+// a share handle is only attached by one request at a time. A request that
+// finds its share busy proceeds without one.
+
+#define CURL_SHARE_SLOTS 4
+#define CURL_SHARE_PATH_MAX 512
+
+typedef struct CurlShareSlot {
+    pthread_mutex_t busy;
+    CURLSH *share;
+    bool has_credentials;
+    char cert_path[CURL_SHARE_PATH_MAX];
+    char key_path[CURL_SHARE_PATH_MAX];
+} CurlShareSlot;
+
+static pthread_mutex_t share_slots_mtx = PTHREAD_MUTEX_INITIALIZER;
+static CurlShareSlot share_slots[CURL_SHARE_SLOTS];
+
+static bool share_slot_matches(
+    const CurlShareSlot *slot, const TpmCallbackData *creds
+) {
+    if (creds->cert_path == NULL) {
+        return !slot->has_credentials;
+    }
+    return slot->has_credentials
+        && (strcmp(slot->cert_path, creds->cert_path) == 0)
+        && (strcmp(slot->key_path, creds->key_path) == 0);
+}
+
+static CURLSH *create_curl_share(void) {
+    CURLSH *share = curl_share_init();
+    if (share == NULL) {
+        return NULL;
+    }
+    static const curl_lock_data SHARED_DATA[]
+        = { CURL_LOCK_DATA_DNS, CURL_LOCK_DATA_SSL_SESSION,
+            CURL_LOCK_DATA_CONNECT };
+    for (size_t i = 0; i < sizeof(SHARED_DATA) / sizeof(SHARED_DATA[0]);
+         i++) {
+        CURLSHcode err
+            = curl_share_setopt(share, CURLSHOPT_SHARE, SHARED_DATA[i]);
+        if (err != CURLSHE_OK) {
+            GG_LOGW(
+                "Failed to enable curl share data %d: %s.",
+                SHARED_DATA[i],
+                curl_share_strerror(err)
+            );
+        }
+    }
+    return share;
+}
+
+static CurlShareSlot *find_share_slot(const TpmCallbackData *creds) {
+    if ((creds->cert_path != NULL)
+        && ((creds->key_path == NULL)
+            || (strlen(creds->cert_path) >= CURL_SHARE_PATH_MAX)
+            || (strlen(creds->key_path) >= CURL_SHARE_PATH_MAX))) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&share_slots_mtx);
+    CurlShareSlot *found = NULL;
+    for (size_t i = 0; i < CURL_SHARE_SLOTS; i++) {
+        CurlShareSlot *slot = &share_slots[i];
+        if (slot->share == NULL) {
+            slot->share = create_curl_share();
+            if (slot->share == NULL) {
+                break;
+            }
+            pthread_mutex_init(&slot->busy, NULL);
+            slot->has_credentials = creds->cert_path != NULL;
+            if (slot->has_credentials) {
+                memcpy(
+                    slot->cert_path,
+                    creds->cert_path,
+                    strlen(creds->cert_path) + 1
+                );
+                memcpy(
+                    slot->key_path, creds->key_path, strlen(creds->key_path) + 1
+                );
+            }
+            found = slot;
+            break;
+        }
+        if (share_slot_matches(slot, creds)) {
+            found = slot;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&share_slots_mtx);
+    return found;
+}
+
+static void attach_curl_share(CurlData *curl_data) {
+    if (curl_data->share != NULL) {
+        return;
+    }
+    CurlShareSlot *slot = find_share_slot(&curl_data->tpm_data);
+    if (slot == NULL) {
+        GG_LOGD("No connection cache available for request.");
+        return;
+    }
+    if (pthread_mutex_trylock(&slot->busy) != 0) {
+        GG_LOGD("Connection cache busy; request will not reuse connections.");
+        return;
+    }
+    CURLcode err
+        = curl_easy_setopt(curl_data->curl, CURLOPT_SHARE, slot->share);
+    if (err != CURLE_OK) {
+        GG_LOGW(
+            "Failed to attach connection cache: %s.", curl_easy_strerror(err)
+        );
+        pthread_mutex_unlock(&slot->busy);
+        return;
+    }
+    curl_data->share = slot;
+}
+
+static void detach_curl_share(CurlData *curl_data) {
+    if (curl_data->share == NULL) {
+        return;
+    }
+    // Detach before releasing so cleanup of this handle does not touch the
+    // share while another request holds it.
+    curl_easy_setopt(curl_data->curl, CURLOPT_SHARE, NULL);
+    pthread_mutex_unlock(&curl_data->share->busy);
+    curl_data->share = NULL;
+}
+
 void gghttplib_destroy_curl(CurlData *curl_data) {
     assert(curl_data != NULL);
     if (curl_data->headers_list != NULL) {
         curl_slist_free_all(curl_data->headers_list);
         curl_data->headers_list = NULL;
     }
+    if (curl_data->attempt_headers_list != NULL) {
+        curl_slist_free_all(curl_data->attempt_headers_list);
+        curl_data->attempt_headers_list = NULL;
+    }
+    if (curl_data->curl != NULL) {
+        detach_curl_share(curl_data);
+    }
     curl_easy_cleanup(curl_data->curl);
 }
 
 GgError gghttplib_init_curl(CurlData *curl_data, const char *url) {
     curl_data->headers_list = NULL;
+    curl_data->attempt_headers_list = NULL;
+    curl_data->tpm_data = (TpmCallbackData) { 0 };
+    curl_data->share = NULL;
     curl_data->curl = curl_easy_init();
 
     if (curl_data->curl == NULL) {
@@ -652,6 +1107,8 @@ GgError gghttplib_process_request(
         return ret;
     }
 
+    attach_curl_share(curl_data);
+
     if (response_buffer != NULL) {
         curl_error = curl_easy_setopt(
             curl_data->curl, CURLOPT_WRITEFUNCTION, write_response_to_buffer
@@ -676,7 +1133,15 @@ GgError gghttplib_process_request(
     return ret;
 }
 
-GgError gghttplib_process_request_with_fd(CurlData *curl_data, int fd) {
+GgError gghttplib_process_request_with_fd(
+    CurlData *curl_data, int fd, GglDownloadResume *resume
+) {
+    FdResponseCtx ctx = { .curl_data = curl_data,
+                          .fd = fd,
+                          .resume = resume,
+                          .start_offset = 0 };
+    ctx.response_etag = GG_BYTE_VEC(ctx.response_etag_mem);
+
     CURLcode curl_error = curl_easy_setopt(
         curl_data->curl, CURLOPT_HTTPHEADER, curl_data->headers_list
     );
@@ -689,6 +1154,8 @@ GgError gghttplib_process_request_with_fd(CurlData *curl_data, int fd) {
         return ret;
     }
 
+    attach_curl_share(curl_data);
+
     curl_error = curl_easy_setopt(
         curl_data->curl, CURLOPT_WRITEFUNCTION, write_response_to_fd
     );
@@ -698,7 +1165,19 @@ GgError gghttplib_process_request_with_fd(CurlData *curl_data, int fd) {
 
     curl_error =
         // coverity[bad_sizeof]
-        curl_easy_setopt(curl_data->curl, CURLOPT_WRITEDATA, (void *) &fd);
+        curl_easy_setopt(curl_data->curl, CURLOPT_WRITEDATA, (void *) &ctx);
+    if (curl_error != CURLE_OK) {
+        return translate_curl_code(curl_error);
+    }
+    curl_error = curl_easy_setopt(
+        curl_data->curl, CURLOPT_HEADERFUNCTION, read_response_header_fd
+    );
+    if (curl_error != CURLE_OK) {
+        return translate_curl_code(curl_error);
+    }
+    curl_error =
+        // coverity[bad_sizeof]
+        curl_easy_setopt(curl_data->curl, CURLOPT_HEADERDATA, (void *) &ctx);
     if (curl_error != CURLE_OK) {
         return translate_curl_code(curl_error);
     }
@@ -707,5 +1186,5 @@ GgError gghttplib_process_request_with_fd(CurlData *curl_data, int fd) {
         return translate_curl_code(curl_error);
     }
 
-    return do_curl_request_fd(curl_data, fd);
+    return do_curl_request_fd(&ctx);
 }
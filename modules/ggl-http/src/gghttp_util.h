@@ -15,10 +15,16 @@ typedef struct TpmCallbackData {
     const char *cert_path;
 } TpmCallbackData;
 
+struct CurlShareSlot;
+
 typedef struct CurlData {
     CURL *curl;
     struct curl_slist *headers_list;
+    /// headers_list plus per-attempt headers, for resumed downloads.
+    struct curl_slist *attempt_headers_list;
     TpmCallbackData tpm_data;
+    /// Connection cache held for the duration of the request, if any.
+    struct CurlShareSlot *share;
 } CurlData;
 
 /**
@@ -102,8 +108,15 @@ GgError gghttplib_process_request(
 ///
 /// @param[in] curl_data A pointer to the CurlData struct containing the cURL
 /// handle and other request data.
+/// Writes start at the current offset of fd. If resume is not NULL, failed
+/// attempts are continued from the last written byte using Range and If-Range
+/// requests instead of being restarted.
+///
 /// @param[in] fd A file descriptor to the write the data to
+/// @param[inout] resume Resume state, or NULL
 /// @return A GgError for success status report
-GgError gghttplib_process_request_with_fd(CurlData *curl_data, int fd);
+GgError gghttplib_process_request_with_fd(
+    CurlData *curl_data, int fd, GglDownloadResume *resume
+);
 
 #endif
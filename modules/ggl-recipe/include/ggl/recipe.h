@@ -18,6 +18,9 @@ typedef struct GglRecipeVariable {
     GgBuffer key;
 } GglRecipeVariable;
 
+/// Loads the recipe for a component version into arena. Parsed recipes are
+/// cached on disk in compiled form, keyed by the recipe file's identity, so
+/// later loads of an unchanged recipe only copy and relocate the image.
 GgError ggl_recipe_get_from_file(
     int root_path_fd,
     GgBuffer component_name,
@@ -26,6 +29,9 @@ GgError ggl_recipe_get_from_file(
     GgObject *recipe
 );
 
+/// Selects a lifecycle phase's script, Setenv map, and run-as-root flag.
+/// out_timeout_value, if not NULL, must hold the memory to write the phase's
+/// Timeout into; it is set to the timeout, or left empty if there is none.
 GgError fetch_script_section(
     GgMap selected_lifecycle,
     GgBuffer selected_phase,
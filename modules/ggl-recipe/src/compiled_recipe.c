@@ -0,0 +1,455 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "compiled_recipe.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <gg/arena.h>
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/file.h>
+#include <gg/log.h>
+#include <gg/map.h>
+#include <gg/object.h>
+#include <gg/types.h>
+#include <gg/vector.h>
+#include <limits.h>
+#include <stdalign.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define COMPILED_RECIPE_MAGIC 0x43524747U // "GGRC"
+#define COMPILED_RECIPE_FORMAT_VERSION 1U
+#define COMPILED_RECIPE_EXT ".ggrc"
+
+// Deeper images are treated as corrupt, which also rejects cyclic images
+#define COMPILED_RECIPE_MAX_DEPTH 64U
+
+typedef struct {
+    uint32_t magic;
+    uint32_t format_version;
+    // The image is a copy of SDK objects, so is only valid for the same layout
+    uint16_t object_size;
+    uint16_t kv_size;
+    uint16_t pointer_size;
+    uint16_t reserved;
+    uint64_t source_dev;
+    uint64_t source_ino;
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+    int64_t source_size;
+    uint64_t image_len;
+} CompiledRecipeHeader;
+
+static_assert(
+    sizeof(CompiledRecipeHeader) % GGL_COMPILED_RECIPE_ALIGN == 0,
+    "Compiled recipe header must preserve image alignment."
+);
+
+// Rewrites the pointers of an image in mem. Pointers are taken relative to
+// `from` and made relative to `to`: storing converts addresses to offsets
+// (to == 0), and loading converts offsets to addresses (from == 0).
+typedef struct {
+    uint8_t *mem;
+    size_t len;
+    uintptr_t from;
+    uintptr_t to;
+} Relocation;
+
+void cleanup_file_mapping(GglFileMapping *mapping) {
+    if (mapping->addr != NULL) {
+        (void) munmap(mapping->addr, mapping->len);
+    }
+}
+
+static GgError relocate_range(
+    const Relocation *rel,
+    const void *ptr,
+    size_t size,
+    size_t alignment,
+    size_t *offset
+) {
+    uintptr_t off = (uintptr_t) ptr - rel->from;
+    if ((off > rel->len) || (size > rel->len - off)) {
+        if (size != 0) {
+            GG_LOGE("Compiled recipe references memory outside the image.");
+            return GG_ERR_PARSE;
+        }
+        // empty ranges may point anywhere
+        off = 0;
+    }
+    if ((size != 0) && (off % alignment != 0)) {
+        GG_LOGE("Compiled recipe references misaligned memory.");
+        return GG_ERR_PARSE;
+    }
+    *offset = off;
+    return GG_ERR_OK;
+}
+
+static GgError relocate_buf(const Relocation *rel, GgBuffer *buf) {
+    size_t off;
+    GgError ret = relocate_range(rel, buf->data, buf->len, 1, &off);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    buf->data = (uint8_t *) (rel->to + off);
+    return GG_ERR_OK;
+}
+
+static GgError relocate_obj(
+    const Relocation *rel, GgObject *obj, size_t depth
+);
+
+static GgError relocate_list(
+    const Relocation *rel, GgList *list, size_t depth
+) {
+    if (list->len > SIZE_MAX / sizeof(GgObject)) {
+        return GG_ERR_PARSE;
+    }
+    size_t off;
+    GgError ret = relocate_range(
+        rel, list->items, list->len * sizeof(GgObject), alignof(GgObject), &off
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    GgObject *items = (GgObject *) &rel->mem[off];
+    for (size_t i = 0; i < list->len; i++) {
+        ret = relocate_obj(rel, &items[i], depth + 1);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    list->items = (GgObject *) (rel->to + off);
+    return GG_ERR_OK;
+}
+
+static GgError relocate_map(const Relocation *rel, GgMap *map, size_t depth) {
+    if (map->len > SIZE_MAX / sizeof(GgKV)) {
+        return GG_ERR_PARSE;
+    }
+    size_t off;
+    GgError ret = relocate_range(
+        rel, map->pairs, map->len * sizeof(GgKV), alignof(GgKV), &off
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    GgKV *pairs = (GgKV *) &rel->mem[off];
+    for (size_t i = 0; i < map->len; i++) {
+        GgBuffer key = gg_kv_key(pairs[i]);
+        ret = relocate_buf(rel, &key);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        gg_kv_set_key(&pairs[i], key);
+        ret = relocate_obj(rel, gg_kv_val(&pairs[i]), depth + 1);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    map->pairs = (GgKV *) (rel->to + off);
+    return GG_ERR_OK;
+}
+
+static GgError relocate_obj(
+    const Relocation *rel, GgObject *obj, size_t depth
+) {
+    if (depth > COMPILED_RECIPE_MAX_DEPTH) {
+        GG_LOGE("Compiled recipe nested too deeply.");
+        return GG_ERR_PARSE;
+    }
+
+    GgError ret = GG_ERR_OK;
+    switch (gg_obj_type(*obj)) {
+    case GG_TYPE_BUF: {
+        GgBuffer buf = gg_obj_into_buf(*obj);
+        ret = relocate_buf(rel, &buf);
+        if (ret == GG_ERR_OK) {
+            *obj = gg_obj_buf(buf);
+        }
+        break;
+    }
+    case GG_TYPE_LIST: {
+        GgList list = gg_obj_into_list(*obj);
+        ret = relocate_list(rel, &list, depth);
+        if (ret == GG_ERR_OK) {
+            *obj = gg_obj_list(list);
+        }
+        break;
+    }
+    case GG_TYPE_MAP: {
+        GgMap map = gg_obj_into_map(*obj);
+        ret = relocate_map(rel, &map, depth);
+        if (ret == GG_ERR_OK) {
+            *obj = gg_obj_map(map);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return ret;
+}
+
+static CompiledRecipeHeader make_header(
+    const struct stat *source, size_t image_len
+) {
+    return (CompiledRecipeHeader) {
+        .magic = COMPILED_RECIPE_MAGIC,
+        .format_version = COMPILED_RECIPE_FORMAT_VERSION,
+        .object_size = sizeof(GgObject),
+        .kv_size = sizeof(GgKV),
+        .pointer_size = sizeof(void *),
+        .source_dev = (uint64_t) source->st_dev,
+        .source_ino = (uint64_t) source->st_ino,
+        .source_mtime_sec = (int64_t) source->st_mtim.tv_sec,
+        .source_mtime_nsec = (int64_t) source->st_mtim.tv_nsec,
+        .source_size = (int64_t) source->st_size,
+        .image_len = image_len,
+    };
+}
+
+static bool header_matches(
+    const CompiledRecipeHeader *header, const CompiledRecipeHeader *expected
+) {
+    return (header->magic == expected->magic)
+        && (header->format_version == expected->format_version)
+        && (header->object_size == expected->object_size)
+        && (header->kv_size == expected->kv_size)
+        && (header->pointer_size == expected->pointer_size)
+        && (header->source_dev == expected->source_dev)
+        && (header->source_ino == expected->source_ino)
+        && (header->source_mtime_sec == expected->source_mtime_sec)
+        && (header->source_mtime_nsec == expected->source_mtime_nsec)
+        && (header->source_size == expected->source_size)
+        && (header->image_len == expected->image_len);
+}
+
+GgError ggl_compiled_recipe_load(
+    int compiled_dir,
+    GgBuffer base_name,
+    const struct stat *source,
+    GgArena *arena,
+    GgObject *recipe
+) {
+    uint8_t path_mem[NAME_MAX + 1];
+    GgByteVec path = GG_BYTE_VEC(path_mem);
+    GgError ret = gg_byte_vec_append(&path, base_name);
+    gg_byte_vec_chain_append(&ret, &path, GG_STR(COMPILED_RECIPE_EXT));
+    if (ret != GG_ERR_OK) {
+        return GG_ERR_NOENTRY;
+    }
+
+    int fd;
+    ret = gg_file_openat(compiled_dir, path.buf, O_RDONLY | O_CLOEXEC, 0, &fd);
+    if (ret != GG_ERR_OK) {
+        return GG_ERR_NOENTRY;
+    }
+    GG_CLEANUP(cleanup_close, fd);
+
+    struct stat info;
+    if ((fstat(fd, &info) != 0)
+        || (info.st_size < (off_t) (sizeof(CompiledRecipeHeader)
+                                    + sizeof(GgObject)))) {
+        return GG_ERR_NOENTRY;
+    }
+
+    GglFileMapping mapping = { .len = (size_t) info.st_size };
+    void *addr = mmap(NULL, mapping.len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        return GG_ERR_NOENTRY;
+    }
+    mapping.addr = addr;
+    GG_CLEANUP(cleanup_file_mapping, mapping);
+
+    size_t image_len = mapping.len - sizeof(CompiledRecipeHeader);
+    CompiledRecipeHeader header;
+    memcpy(&header, addr, sizeof(header));
+    CompiledRecipeHeader expected = make_header(source, image_len);
+    if (!header_matches(&header, &expected)) {
+        GG_LOGD(
+            "Compiled recipe %.*s is stale.",
+            (int) base_name.len,
+            base_name.data
+        );
+        return GG_ERR_NOENTRY;
+    }
+
+    uint8_t *mem = gg_arena_alloc(arena, image_len, GGL_COMPILED_RECIPE_ALIGN);
+    if (mem == NULL) {
+        GG_LOGE("Insufficient memory to load compiled recipe.");
+        return GG_ERR_NOMEM;
+    }
+    memcpy(mem, &((uint8_t *) addr)[sizeof(header)], image_len);
+
+    Relocation rel
+        = { .mem = mem, .len = image_len, .from = 0, .to = (uintptr_t) mem };
+    ret = relocate_obj(&rel, (GgObject *) mem, 0);
+    if (ret != GG_ERR_OK) {
+        GG_LOGW(
+            "Ignoring invalid compiled recipe %.*s.",
+            (int) base_name.len,
+            base_name.data
+        );
+        (void) gg_arena_resize_last(arena, mem, image_len, 0);
+        return GG_ERR_NOENTRY;
+    }
+
+    *recipe = *(GgObject *) mem;
+    return GG_ERR_OK;
+}
+
+GgError ggl_compiled_recipe_store(
+    int compiled_dir,
+    GgBuffer base_name,
+    const struct stat *source,
+    GgBuffer image
+) {
+    uint8_t path_mem[NAME_MAX + 1];
+    GgByteVec path = GG_BYTE_VEC(path_mem);
+    GgError ret = gg_byte_vec_append(&path, base_name);
+    gg_byte_vec_chain_append(&ret, &path, GG_STR(COMPILED_RECIPE_EXT));
+    gg_byte_vec_chain_push(&ret, &path, '\0');
+
+    // Unique per process so concurrent writers do not interleave
+    uint8_t tmp_path_mem[NAME_MAX + 1];
+    GgByteVec tmp_path = GG_BYTE_VEC(tmp_path_mem);
+    gg_byte_vec_chain_append(&ret, &tmp_path, base_name);
+    char suffix[32];
+    int suffix_len
+        = snprintf(suffix, sizeof(suffix), ".%d.tmp", (int) getpid());
+    gg_byte_vec_chain_append(
+        &ret,
+        &tmp_path,
+        (GgBuffer) { .data = (uint8_t *) suffix, .len = (size_t) suffix_len }
+    );
+    gg_byte_vec_chain_push(&ret, &tmp_path, '\0');
+    if (ret != GG_ERR_OK) {
+        GG_LOGD("Compiled recipe path too long.");
+        return ret;
+    }
+
+    int fd;
+    ret = gg_file_openat(
+        compiled_dir,
+        gg_buffer_substr(tmp_path.buf, 0, tmp_path.buf.len - 1),
+        O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+        0644,
+        &fd
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, fd);
+
+    GglFileMapping mapping
+        = { .len = sizeof(CompiledRecipeHeader) + image.len };
+    void *addr = MAP_FAILED;
+    if (ftruncate(fd, (off_t) mapping.len) == 0) {
+        addr = mmap(
+            NULL, mapping.len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0
+        );
+    }
+    if (addr == MAP_FAILED) {
+        (void) unlinkat(compiled_dir, (char *) tmp_path.buf.data, 0);
+        return GG_ERR_FAILURE;
+    }
+    mapping.addr = addr;
+
+    CompiledRecipeHeader header = make_header(source, image.len);
+    uint8_t *mem = &((uint8_t *) addr)[sizeof(header)];
+    memcpy(addr, &header, sizeof(header));
+    memcpy(mem, image.data, image.len);
+
+    // Relocate the copy, leaving the caller's recipe intact
+    Relocation rel = { .mem = mem,
+                       .len = image.len,
+                       .from = (uintptr_t) image.data,
+                       .to = 0 };
+    ret = relocate_obj(&rel, (GgObject *) mem, 0);
+    cleanup_file_mapping(&mapping);
+    if (ret != GG_ERR_OK) {
+        (void) unlinkat(compiled_dir, (char *) tmp_path.buf.data, 0);
+        return ret;
+    }
+
+    if (renameat(
+            compiled_dir,
+            (char *) tmp_path.buf.data,
+            compiled_dir,
+            (char *) path.buf.data
+        )
+        != 0) {
+        (void) unlinkat(compiled_dir, (char *) tmp_path.buf.data, 0);
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+#ifdef GG_SDK_TESTING
+
+#include <gg/test.h>
+#include <unity.h>
+
+GG_TEST_DEFINE(compiled_recipe_relocation_round_trip) {
+    alignas(GGL_COMPILED_RECIPE_ALIGN) static uint8_t image_mem[1024];
+    GgArena image_arena = gg_arena_init(GG_BUF(image_mem));
+    GgObject *root = GG_ARENA_ALLOC(&image_arena, GgObject);
+    TEST_ASSERT_NOT_NULL(root);
+    *root = gg_obj_map(GG_MAP(
+        gg_kv(GG_STR("ComponentName"), gg_obj_buf(GG_STR("sample"))),
+        gg_kv(
+            GG_STR("Manifests"),
+            gg_obj_list(GG_LIST(gg_obj_i64(1), gg_obj_buf(GG_STR(""))))
+        )
+    ));
+    GG_TEST_ASSERT_OK(gg_arena_claim_obj(root, &image_arena));
+    size_t len = (size_t) (gg_arena_alloc_rest(&image_arena).data - image_mem);
+
+    alignas(GGL_COMPILED_RECIPE_ALIGN) static uint8_t moved[1024];
+    memcpy(moved, image_mem, len);
+    Relocation to_offsets = { .mem = moved,
+                              .len = len,
+                              .from = (uintptr_t) image_mem,
+                              .to = 0 };
+    GG_TEST_ASSERT_OK(relocate_obj(&to_offsets, (GgObject *) moved, 0));
+    Relocation to_addresses
+        = { .mem = moved, .len = len, .from = 0, .to = (uintptr_t) moved };
+    GG_TEST_ASSERT_OK(relocate_obj(&to_addresses, (GgObject *) moved, 0));
+
+    GgMap map = gg_obj_into_map(*(GgObject *) moved);
+    uint8_t *pairs = (uint8_t *) map.pairs;
+    TEST_ASSERT_TRUE((pairs >= moved) && (pairs < &moved[len]));
+    GgObject *name;
+    TEST_ASSERT_TRUE(gg_map_get(map, GG_STR("ComponentName"), &name));
+    GG_TEST_ASSERT_BUF_EQUAL(GG_STR("sample"), gg_obj_into_buf(*name));
+    GgObject *manifests;
+    TEST_ASSERT_TRUE(gg_map_get(map, GG_STR("Manifests"), &manifests));
+    GgList list = gg_obj_into_list(*manifests);
+    TEST_ASSERT_EQUAL(2, list.len);
+    TEST_ASSERT_EQUAL(1, gg_obj_into_i64(list.items[0]));
+}
+
+GG_TEST_DEFINE(compiled_recipe_relocation_rejects_out_of_range) {
+    alignas(GGL_COMPILED_RECIPE_ALIGN) static uint8_t image_mem[64];
+    GgObject *root = (GgObject *) image_mem;
+    *root = gg_obj_buf(
+        (GgBuffer) { .data = (uint8_t *) (uintptr_t) 4096, .len = 8 }
+    );
+    Relocation rel = { .mem = image_mem,
+                       .len = sizeof(image_mem),
+                       .from = 0,
+                       .to = (uintptr_t) image_mem };
+    GG_TEST_ASSERT_BAD(relocate_obj(&rel, root, 0));
+}
+
+#endif
@@ -0,0 +1,55 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef GGL_RECIPE_COMPILED_RECIPE_H
+#define GGL_RECIPE_COMPILED_RECIPE_H
+
+#include <gg/arena.h>
+#include <gg/error.h>
+#include <gg/types.h>
+#include <sys/stat.h>
+#include <stddef.h>
+
+// Compiled recipes are a relocatable image of the parsed recipe object, stored
+// under packages/compiled-recipes as <name>-<version>.ggrc. Each image records
+// the identity (device, inode, mtime and size) of the recipe file it was built
+// from and is only used while that identity matches.
+
+/// Directory for compiled recipes, relative to the root path.
+#define GGL_COMPILED_RECIPE_DIR "packages/compiled-recipes"
+
+/// Alignment of a compiled recipe image in memory.
+#define GGL_COMPILED_RECIPE_ALIGN 16U
+
+typedef struct {
+    void *addr;
+    size_t len;
+} GglFileMapping;
+
+/// Unmaps a mapping; for use with GG_CLEANUP. Unset mappings are ignored.
+void cleanup_file_mapping(GglFileMapping *mapping);
+
+/// Loads the compiled recipe for base_name into arena if it is current for
+/// the recipe file described by source. Returns GG_ERR_NOENTRY if there is no
+/// usable image.
+GgError ggl_compiled_recipe_load(
+    int compiled_dir,
+    GgBuffer base_name,
+    const struct stat *source,
+    GgArena *arena,
+    GgObject *recipe
+);
+
+/// Writes the recipe to disk as a compiled image. image is the contiguous
+/// memory holding the recipe object at its start and everything it references,
+/// aligned to GGL_COMPILED_RECIPE_ALIGN. The image is copied before being
+/// relocated and is not modified.
+GgError ggl_compiled_recipe_store(
+    int compiled_dir,
+    GgBuffer base_name,
+    const struct stat *source,
+    GgBuffer image
+);
+
+#endif
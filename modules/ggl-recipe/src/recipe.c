@@ -2,6 +2,7 @@
 // Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include "compiled_recipe.h"
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
@@ -23,13 +24,16 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 
 static GgError try_open_extension(
-    int recipe_dir, GgBuffer ext, GgByteVec name, GgBuffer *content
+    int recipe_dir, GgBuffer ext, GgByteVec name, int *fd
 ) {
     GgByteVec full = name;
     GgError ret = gg_byte_vec_push(&full, '.');
@@ -38,7 +42,7 @@ static GgError try_open_extension(
         return ret;
     }
 
-    return gg_file_read_path_at(recipe_dir, full.buf, content);
+    return gg_file_openat(recipe_dir, full.buf, O_RDONLY | O_CLOEXEC, 0, fd);
 }
 
 static GgError parse_requiresprivilege_section(
@@ -168,6 +172,7 @@ static GgError process_script_section_as_map(
     bool *is_root,
     GgBuffer *out_selected_script_as_buf,
     GgMap *out_set_env_as_map,
+    GgBuffer timeout_mem,
     GgBuffer *out_timeout_value
 ) {
     GgError ret
@@ -220,14 +225,22 @@ static GgError process_script_section_as_map(
             return GG_ERR_INVALID;
         }
 
-        static uint8_t timeout_mem[32];
-        int len = snprintf(
-            (char *) timeout_mem, sizeof(timeout_mem), "%" PRId64, timeout_i64
-        );
-
-        GgBuffer timeout_buf = { .data = timeout_mem, .len = (size_t) len };
         if (out_timeout_value != NULL) {
-            *out_timeout_value = timeout_buf;
+            int len = -1;
+            if (timeout_mem.len > 0) {
+                len = snprintf(
+                    (char *) timeout_mem.data,
+                    timeout_mem.len,
+                    "%" PRId64,
+                    timeout_i64
+                );
+            }
+            if ((len < 0) || ((size_t) len >= timeout_mem.len)) {
+                GG_LOGE("Not enough memory for timeout value.");
+                return GG_ERR_NOMEM;
+            }
+            *out_timeout_value
+                = gg_buffer_substr(timeout_mem, 0, (size_t) len);
         }
     }
 
@@ -242,6 +255,12 @@ GgError fetch_script_section(
     GgMap *out_set_env_as_map,
     GgBuffer *out_timeout_value
 ) {
+    GgBuffer timeout_mem = { 0 };
+    if (out_timeout_value != NULL) {
+        timeout_mem = *out_timeout_value;
+        *out_timeout_value = (GgBuffer) { 0 };
+    }
+
     GgObject *val;
     if (gg_map_get(selected_lifecycle, selected_phase, &val)) {
         if (gg_obj_type(*val) == GG_TYPE_BUF) {
@@ -252,6 +271,7 @@ GgError fetch_script_section(
                 is_root,
                 out_selected_script_as_buf,
                 out_set_env_as_map,
+                timeout_mem,
                 out_timeout_value
             );
             if (ret != GG_ERR_OK) {
@@ -613,16 +633,9 @@ GgError select_linux_manifest(
     return GG_ERR_OK;
 }
 
-GgError ggl_recipe_get_from_file(
-    int root_path_fd,
-    GgBuffer component_name,
-    GgBuffer component_version,
-    GgArena *arena,
-    GgObject *recipe
+static GgError open_recipe_file(
+    int root_path_fd, GgByteVec base_name, int *fd, bool *is_json
 ) {
-    static pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
-    GG_MTX_SCOPE_GUARD(&mtx);
-
     int recipe_dir;
     GgError ret = gg_dir_openat(
         root_path_fd, GG_STR("packages/recipes"), O_PATH, false, &recipe_dir
@@ -633,9 +646,105 @@ GgError ggl_recipe_get_from_file(
     }
     GG_CLEANUP(cleanup_close, recipe_dir);
 
-    static uint8_t file_name_mem[PATH_MAX];
+    *is_json = true;
+    ret = try_open_extension(recipe_dir, GG_STR("json"), base_name, fd);
+    if (ret == GG_ERR_OK) {
+        return GG_ERR_OK;
+    }
+
+    *is_json = false;
+    ret = try_open_extension(recipe_dir, GG_STR("yaml"), base_name, fd);
+    if (ret != GG_ERR_OK) {
+        ret = try_open_extension(recipe_dir, GG_STR("yml"), base_name, fd);
+    }
+    if (ret != GG_ERR_OK) {
+        GG_LOGE(
+            "Err %d could not open recipe file for: %.*s",
+            errno,
+            (int) base_name.buf.len,
+            base_name.buf.data
+        );
+    }
+    return ret;
+}
+
+// Parses the recipe into a contiguous image at the end of arena, so that it
+// can be stored as a compiled recipe.
+static GgError parse_recipe_file(
+    int fd,
+    size_t size,
+    bool is_json,
+    GgArena *arena,
+    GgObject *recipe,
+    GgBuffer *image
+) {
+    if (size == 0) {
+        GG_LOGE("Recipe file is empty.");
+        return GG_ERR_PARSE;
+    }
+
+    // Private writable mapping, as decoding modifies the content in place
+    GglFileMapping mapping = { .len = size };
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        GG_LOGE("Failed to map recipe file (errno=%d).", errno);
+        return GG_ERR_FAILURE;
+    }
+    mapping.addr = addr;
+    GG_CLEANUP(cleanup_file_mapping, mapping);
+    GgBuffer content = { .data = addr, .len = size };
+
+    GgBuffer rest = gg_arena_alloc_rest(arena);
+    size_t pad = (GGL_COMPILED_RECIPE_ALIGN
+                  - ((uintptr_t) rest.data % GGL_COMPILED_RECIPE_ALIGN))
+        % GGL_COMPILED_RECIPE_ALIGN;
+    if (rest.len < pad + sizeof(GgObject)) {
+        (void) gg_arena_resize_last(arena, rest.data, rest.len, 0);
+        return GG_ERR_NOMEM;
+    }
+    GgArena image_arena
+        = gg_arena_init(gg_buffer_substr(rest, pad, SIZE_MAX));
+    GgObject *root = GG_ARENA_ALLOC(&image_arena, GgObject);
+    assert(root == (GgObject *) &rest.data[pad]);
+
+    GgError ret;
+    if (is_json) {
+        ret = gg_json_decode_destructive(content, &image_arena, root);
+    } else {
+        ret = ggl_yaml_decode_destructive(content, &image_arena, root);
+    }
+    if (ret == GG_ERR_OK) {
+        ret = gg_arena_claim_obj(root, &image_arena);
+    }
+    if (ret != GG_ERR_OK) {
+        (void) gg_arena_resize_last(arena, rest.data, rest.len, 0);
+        return ret;
+    }
+
+    size_t used = (size_t) (gg_arena_alloc_rest(&image_arena).data - rest.data);
+    ret = gg_arena_resize_last(arena, rest.data, rest.len, used);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    *recipe = *root;
+    *image = gg_buffer_substr((GgBuffer) { .data = rest.data, .len = used },
+                              pad,
+                              SIZE_MAX);
+    return GG_ERR_OK;
+}
+
+GgError ggl_recipe_get_from_file(
+    int root_path_fd,
+    GgBuffer component_name,
+    GgBuffer component_version,
+    GgArena *arena,
+    GgObject *recipe
+) {
+    uint8_t file_name_mem[NAME_MAX];
     GgByteVec base_name = GG_BYTE_VEC(file_name_mem);
 
+    GgError ret = GG_ERR_OK;
     gg_byte_vec_chain_append(&ret, &base_name, component_name);
     gg_byte_vec_chain_push(&ret, &base_name, '-');
     gg_byte_vec_chain_append(&ret, &base_name, component_version);
@@ -644,41 +753,59 @@ GgError ggl_recipe_get_from_file(
         return ret;
     }
 
-    static uint8_t file_mem[8196];
-    GgBuffer content = GG_BUF(file_mem);
-    ret = try_open_extension(recipe_dir, GG_STR("json"), base_name, &content);
-    if (ret == GG_ERR_OK) {
-        ret = gg_json_decode_destructive(content, arena, recipe);
-        if (ret != GG_ERR_OK) {
-            return ret;
-        }
-    } else {
-        ret = try_open_extension(
-            recipe_dir, GG_STR("yaml"), base_name, &content
-        );
+    int fd;
+    bool is_json;
+    ret = open_recipe_file(root_path_fd, base_name, &fd, &is_json);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, fd);
 
-        if (ret != GG_ERR_OK) {
-            ret = try_open_extension(
-                recipe_dir, GG_STR("yml"), base_name, &content
-            );
-            if (ret != GG_ERR_OK) {
-                GG_LOGE(
-                    "Err %d could not open recipe file for: %.*s",
-                    errno,
-                    (int) base_name.buf.len,
-                    base_name.buf.data
-                );
-                return ret;
-            }
-        }
+    struct stat source;
+    if (fstat(fd, &source) != 0) {
+        GG_LOGE("Failed to stat recipe file (errno=%d).", errno);
+        return GG_ERR_FAILURE;
+    }
 
-        ret = ggl_yaml_decode_destructive(content, arena, recipe);
-        if (ret != GG_ERR_OK) {
+    // May fail if not permitted to create it; recipes are then always parsed
+    int compiled_dir = -1;
+    GgError compiled_ret = gg_dir_openat(
+        root_path_fd,
+        GG_STR(GGL_COMPILED_RECIPE_DIR),
+        O_PATH,
+        true,
+        &compiled_dir
+    );
+    if (compiled_ret == GG_ERR_OK) {
+        ret = ggl_compiled_recipe_load(
+            compiled_dir, base_name.buf, &source, arena, recipe
+        );
+        if (ret != GG_ERR_NOENTRY) {
+            (void) gg_close(compiled_dir);
             return ret;
         }
     }
 
-    return gg_arena_claim_obj(recipe, arena);
+    // The YAML decoder and compiled recipe writes are not reentrant
+    static pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+    GG_MTX_SCOPE_GUARD(&mtx);
+
+    GgBuffer image;
+    ret = parse_recipe_file(
+        fd, (size_t) source.st_size, is_json, arena, recipe, &image
+    );
+    if ((ret == GG_ERR_OK) && (compiled_ret == GG_ERR_OK)) {
+        GgError store_ret = ggl_compiled_recipe_store(
+            compiled_dir, base_name.buf, &source, image
+        );
+        if (store_ret != GG_ERR_OK) {
+            GG_LOGD("Failed to store compiled recipe.");
+        }
+    }
+    if (compiled_ret == GG_ERR_OK) {
+        (void) gg_close(compiled_dir);
+    }
+    return ret;
 }
 
 #ifdef GG_SDK_TESTING
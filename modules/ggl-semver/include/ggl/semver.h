@@ -5,11 +5,84 @@
 #ifndef GGL_SEMVER_H
 #define GGL_SEMVER_H
 
+#include <gg/error.h>
 #include <gg/types.h>
+#include <gg/vector.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#ifndef GGL_SEMVER_RANGE_MAX_COMPARATORS
+#define GGL_SEMVER_RANGE_MAX_COMPARATORS 32
+#endif
+
+#ifndef GGL_SEMVER_RANGE_MAX_SETS
+#define GGL_SEMVER_RANGE_MAX_SETS 8
+#endif
+
+/// A parsed version. Minor and patch may be omitted from the text, in which
+/// case they are 0. Build metadata is ignored.
+typedef struct {
+    uint64_t major;
+    uint64_t minor;
+    uint64_t patch;
+    /// Points into the parsed text; empty if not a pre-release.
+    GgBuffer prerelease;
+} GglSemver;
+
+typedef enum {
+    GGL_SEMVER_EQ,
+    GGL_SEMVER_LT,
+    GGL_SEMVER_LE,
+    GGL_SEMVER_GT,
+    GGL_SEMVER_GE,
+} GglSemverOp;
+
+typedef struct {
+    GglSemverOp op;
+    GglSemver version;
+} GglSemverComparator;
+
+/// A compiled version requirement: comparator sets separated by `||`, each a
+/// space-separated list of comparators that must all hold. An empty set
+/// matches every version. References the requirement text it was compiled
+/// from.
+typedef struct {
+    GglSemverComparator comparators[GGL_SEMVER_RANGE_MAX_COMPARATORS];
+    /// Number of comparators in each set, stored consecutively.
+    uint8_t set_lens[GGL_SEMVER_RANGE_MAX_SETS];
+    size_t set_count;
+} GglSemverRange;
+
+/// Returns true if version satisfies the requirement. Compiles the
+/// requirement on each call; use GglSemverRange to test many versions.
 bool is_in_range(GgBuffer version, GgBuffer requirements_range);
 
+/// Parses a version such as `1.2.3-rc.1`.
+GgError ggl_semver_parse(GgBuffer text, GglSemver *version);
+
+/// Compares by Semantic Versioning precedence; returns <0, 0, or >0.
+int ggl_semver_compare(const GglSemver *a, const GglSemver *b);
+
+/// Compiles a requirement such as `>=1.0.0 <2.0.0 || 3.0.0`.
+GgError ggl_semver_range_compile(GgBuffer requirement, GglSemverRange *range);
+
+/// Returns true if version satisfies any comparator set of the range.
+bool ggl_semver_range_matches(
+    const GglSemverRange *range, const GglSemver *version
+);
+
+/// Gets the highest version the range can match, if it has an upper bound.
+/// inclusive is set if bound itself can match.
+bool ggl_semver_range_upper_bound(
+    const GglSemverRange *range, GglSemver *bound, bool *inclusive
+);
+
+/// Writes a requirement matching versions that satisfy both a and b.
+GgError ggl_semver_requirement_intersect(
+    GgBuffer a, GgBuffer b, GgByteVec *out
+);
+
 /// Returns true if `version` is a well-formed Semantic Versioning 2.0.0
 /// string: `<major>.<minor>.<patch>[-<pre-release>][+<build>]`. Major, minor,
 /// and patch are non-negative integers without leading zeros; pre-release and
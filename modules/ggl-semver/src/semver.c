@@ -2,76 +2,17 @@
 // Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 // SPDX-License-Identifier: Apache-2.0
 
-#include <ctype.h>
 #include <gg/buffer.h>
 #include <gg/error.h>
 #include <gg/log.h>
 #include <gg/types.h>
 #include <gg/vector.h>
 #include <ggl/semver.h>
-#include <limits.h>
 #include <string.h>
-#include <sys/types.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-static bool process_version(
-    GgByteVec current_requirement, char *current_version
-) {
-    bool return_status = false;
-
-    if (current_requirement.buf.data[0] == '>') {
-        if (current_requirement.buf.data[1] == '=') {
-            if (strverscmp(
-                    current_version, (char *) &current_requirement.buf.data[2]
-                )
-                >= 0) {
-                return_status = true;
-            }
-
-        } else if (strverscmp(
-                       current_version,
-                       (char *) &current_requirement.buf.data[1]
-                   )
-                   > 0) {
-            return_status = true;
-        }
-
-    } else if (current_requirement.buf.data[0] == '<') {
-        if (current_requirement.buf.data[1] == '=') {
-            if (strverscmp(
-                    current_version, (char *) &current_requirement.buf.data[2]
-                )
-                <= 0) {
-                return_status = true;
-            }
-
-        } else if (strverscmp(
-                       current_version,
-                       (char *) &current_requirement.buf.data[1]
-                   )
-                   < 0) {
-            return_status = true;
-        }
-    } else if (((current_requirement.buf.data[0] == '=')
-                && (strverscmp(
-                        current_version,
-                        (char *) &current_requirement.buf.data[1]
-                    )
-                    == 0))
-               || ((isdigit(current_requirement.buf.data[0]))
-                   && (strverscmp(
-                           current_version,
-                           (char *) &current_requirement.buf.data[0]
-                       )
-                       == 0))) {
-        return_status = true;
-    } else {
-        return_status = false;
-    }
-    return return_status;
-}
-
 static bool is_digit_byte(uint8_t c) {
     return (c >= '0') && (c <= '9');
 }
@@ -174,66 +115,370 @@ bool is_valid_semver(GgBuffer version) {
     return i == version.len;
 }
 
-bool is_in_range(GgBuffer version, GgBuffer requirements_range) {
-    char *requirements_range_as_char = (char *) requirements_range.data;
+static GgError parse_number(GgBuffer text, size_t *i, uint64_t *value) {
+    size_t start = *i;
+    uint64_t result = 0;
+    while ((*i < text.len) && is_digit_byte(text.data[*i])) {
+        uint64_t digit = (uint64_t) (text.data[*i] - '0');
+        if (result > ((UINT64_MAX - digit) / 10)) {
+            return GG_ERR_RANGE;
+        }
+        result = (result * 10) + digit;
+        (*i)++;
+    }
+    if (*i == start) {
+        return GG_ERR_PARSE;
+    }
+    *value = result;
+    return GG_ERR_OK;
+}
 
-    static uint8_t work_mem_buffer[NAME_MAX];
-    GgByteVec work_mem_vec = GG_BYTE_VEC(work_mem_buffer);
+GgError ggl_semver_parse(GgBuffer text, GglSemver *version) {
+    GglSemver result = { 0 };
+    size_t i = 0;
 
-    static uint8_t current_version_buffer[NAME_MAX];
-    GgByteVec current_version_vec = GG_BYTE_VEC(current_version_buffer);
-    GgError ret = gg_byte_vec_append(&current_version_vec, version);
-    gg_byte_vec_chain_append(&ret, &current_version_vec, GG_STR("\0"));
+    GgError ret = parse_number(text, &i, &result.major);
     if (ret != GG_ERR_OK) {
-        GG_LOGE("Failed to copy information over");
+        return ret;
+    }
+    uint64_t *parts[] = { &result.minor, &result.patch };
+    for (size_t part = 0; part < 2; part++) {
+        if ((i >= text.len) || (text.data[i] != '.')) {
+            break;
+        }
+        i++;
+        ret = parse_number(text, &i, parts[part]);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+
+    if ((i < text.len) && (text.data[i] == '-')) {
+        i++;
+        size_t start = i;
+        while ((i < text.len) && (text.data[i] != '+')) {
+            i++;
+        }
+        if (i == start) {
+            return GG_ERR_PARSE;
+        }
+        result.prerelease = gg_buffer_substr(text, start, i);
+    }
+
+    // Anything left must be build metadata, which has no precedence
+    if ((i < text.len) && (text.data[i] != '+')) {
+        return GG_ERR_PARSE;
+    }
+
+    *version = result;
+    return GG_ERR_OK;
+}
+
+static int compare_u64(uint64_t a, uint64_t b) {
+    return (a > b) - (a < b);
+}
+
+static int compare_bytes(GgBuffer a, GgBuffer b) {
+    size_t len = (a.len < b.len) ? a.len : b.len;
+    int cmp = (len == 0) ? 0 : memcmp(a.data, b.data, len);
+    if (cmp != 0) {
+        return (cmp > 0) - (cmp < 0);
+    }
+    return compare_u64(a.len, b.len);
+}
+
+static bool is_numeric_identifier(GgBuffer id) {
+    for (size_t i = 0; i < id.len; i++) {
+        if (!is_digit_byte(id.data[i])) {
+            return false;
+        }
+    }
+    return id.len > 0;
+}
+
+static int compare_identifiers(GgBuffer a, GgBuffer b) {
+    bool a_numeric = is_numeric_identifier(a);
+    bool b_numeric = is_numeric_identifier(b);
+    if (a_numeric != b_numeric) {
+        // Numeric identifiers have lower precedence
+        return a_numeric ? -1 : 1;
+    }
+    if (a_numeric) {
+        // Compare as arbitrarily large numbers
+        while ((a.len > 1) && (a.data[0] == '0')) {
+            a = gg_buffer_substr(a, 1, SIZE_MAX);
+        }
+        while ((b.len > 1) && (b.data[0] == '0')) {
+            b = gg_buffer_substr(b, 1, SIZE_MAX);
+        }
+        if (a.len != b.len) {
+            return compare_u64(a.len, b.len);
+        }
+    }
+    return compare_bytes(a, b);
+}
+
+static GgBuffer next_identifier(GgBuffer *rest) {
+    size_t end = 0;
+    while ((end < rest->len) && (rest->data[end] != '.')) {
+        end++;
+    }
+    GgBuffer id = gg_buffer_substr(*rest, 0, end);
+    size_t next = (end < rest->len) ? end + 1 : end;
+    *rest = gg_buffer_substr(*rest, next, SIZE_MAX);
+    return id;
+}
+
+static int compare_prerelease(GgBuffer a, GgBuffer b) {
+    if ((a.len == 0) || (b.len == 0)) {
+        // A pre-release has lower precedence than its release
+        return (a.len == 0) - (b.len == 0);
+    }
+    while ((a.len > 0) && (b.len > 0)) {
+        int cmp = compare_identifiers(next_identifier(&a), next_identifier(&b));
+        if (cmp != 0) {
+            return cmp;
+        }
+    }
+    // A larger set of identifiers has higher precedence
+    return (a.len > 0) - (b.len > 0);
+}
+
+int ggl_semver_compare(const GglSemver *a, const GglSemver *b) {
+    int cmp = compare_u64(a->major, b->major);
+    if (cmp == 0) {
+        cmp = compare_u64(a->minor, b->minor);
+    }
+    if (cmp == 0) {
+        cmp = compare_u64(a->patch, b->patch);
+    }
+    if (cmp == 0) {
+        cmp = compare_prerelease(a->prerelease, b->prerelease);
+    }
+    return cmp;
+}
+
+static bool next_token(GgBuffer text, size_t *pos, GgBuffer *token) {
+    while ((*pos < text.len) && (text.data[*pos] == ' ')) {
+        (*pos)++;
+    }
+    if (*pos == text.len) {
         return false;
     }
+    size_t start = *pos;
+    while ((*pos < text.len) && (text.data[*pos] != ' ')) {
+        (*pos)++;
+    }
+    *token = gg_buffer_substr(text, start, *pos);
+    return true;
+}
 
-    for (ulong index = 0; index < requirements_range.len; index++) {
-        if (requirements_range_as_char[index] == ' ') {
-            // null terminating as strverscmp requires it
-            ret = gg_byte_vec_append(&work_mem_vec, GG_STR("\0"));
-            if (ret != GG_ERR_OK) {
-                GG_LOGE("Failed to copy information over");
-                return false;
-            }
-            bool result = process_version(
-                work_mem_vec, (char *) current_version_vec.buf.data
+static GglSemverOp parse_operator(GgBuffer *token) {
+    static const struct {
+        GgBuffer prefix;
+        GglSemverOp op;
+    } OPERATORS[] = {
+        { GG_STR(">="), GGL_SEMVER_GE }, { GG_STR("<="), GGL_SEMVER_LE },
+        { GG_STR(">"), GGL_SEMVER_GT },  { GG_STR("<"), GGL_SEMVER_LT },
+        { GG_STR("="), GGL_SEMVER_EQ },
+    };
+    for (size_t i = 0; i < sizeof(OPERATORS) / sizeof(OPERATORS[0]); i++) {
+        if (gg_buffer_has_prefix(*token, OPERATORS[i].prefix)) {
+            *token = gg_buffer_substr(
+                *token, OPERATORS[i].prefix.len, SIZE_MAX
             );
-            if (result == false) {
-                GG_LOGT("Requirement wasn't satisfied");
-                return false;
+            return OPERATORS[i].op;
+        }
+    }
+    return GGL_SEMVER_EQ;
+}
+
+GgError ggl_semver_range_compile(GgBuffer requirement, GglSemverRange *range) {
+    range->set_count = 1;
+    range->set_lens[0] = 0;
+    size_t count = 0;
+
+    size_t pos = 0;
+    GgBuffer token;
+    while (next_token(requirement, &pos, &token)) {
+        if (gg_buffer_eq(token, GG_STR("||"))) {
+            if (range->set_count == GGL_SEMVER_RANGE_MAX_SETS) {
+                return GG_ERR_NOMEM;
             }
-            // Rest once a value is parsed
-            work_mem_vec.buf.len = 0;
-            index++;
+            range->set_lens[range->set_count] = 0;
+            range->set_count += 1;
+            continue;
         }
-        ret = gg_byte_vec_append(
-            &work_mem_vec,
-            (GgBuffer) { (uint8_t *) &requirements_range_as_char[index], 1 }
-        );
+
+        GglSemverOp op = parse_operator(&token);
+        // Allow a space between the operator and the version
+        if ((token.len == 0) && !next_token(requirement, &pos, &token)) {
+            return GG_ERR_PARSE;
+        }
+
+        if ((count == GGL_SEMVER_RANGE_MAX_COMPARATORS)
+            || (range->set_lens[range->set_count - 1] == UINT8_MAX)) {
+            return GG_ERR_NOMEM;
+        }
+        GglSemverComparator *comparator = &range->comparators[count];
+        comparator->op = op;
+        GgError ret = ggl_semver_parse(token, &comparator->version);
         if (ret != GG_ERR_OK) {
-            GG_LOGE("Failed to copy information over");
-            return false;
+            return ret;
         }
+        count += 1;
+        range->set_lens[range->set_count - 1] += 1;
     }
+    return GG_ERR_OK;
+}
 
-    if (work_mem_vec.buf.len != 0) {
-        ret = gg_byte_vec_append(&work_mem_vec, GG_STR("\0"));
-        if (ret != GG_ERR_OK) {
-            GG_LOGE("Failed to copy information over");
+static bool comparator_matches(
+    const GglSemverComparator *comparator, const GglSemver *version
+) {
+    int cmp = ggl_semver_compare(version, &comparator->version);
+    switch (comparator->op) {
+    case GGL_SEMVER_EQ:
+        return cmp == 0;
+    case GGL_SEMVER_LT:
+        return cmp < 0;
+    case GGL_SEMVER_LE:
+        return cmp <= 0;
+    case GGL_SEMVER_GT:
+        return cmp > 0;
+    case GGL_SEMVER_GE:
+        return cmp >= 0;
+    }
+    return false;
+}
+
+bool ggl_semver_range_matches(
+    const GglSemverRange *range, const GglSemver *version
+) {
+    const GglSemverComparator *set = range->comparators;
+    for (size_t i = 0; i < range->set_count; i++) {
+        bool matches = true;
+        for (size_t j = 0; (j < range->set_lens[i]) && matches; j++) {
+            matches = comparator_matches(&set[j], version);
+        }
+        if (matches) {
+            return true;
+        }
+        set = &set[range->set_lens[i]];
+    }
+    return false;
+}
+
+bool ggl_semver_range_upper_bound(
+    const GglSemverRange *range, GglSemver *bound, bool *inclusive
+) {
+    bool found = false;
+    const GglSemverComparator *set = range->comparators;
+    for (size_t i = 0; i < range->set_count; i++) {
+        // Lowest upper bound within the set
+        bool set_found = false;
+        GglSemver set_bound = { 0 };
+        bool set_inclusive = false;
+        for (size_t j = 0; j < range->set_lens[i]; j++) {
+            GglSemverOp op = set[j].op;
+            if ((op == GGL_SEMVER_GT) || (op == GGL_SEMVER_GE)) {
+                continue;
+            }
+            bool term_inclusive = op != GGL_SEMVER_LT;
+            int cmp = set_found
+                ? ggl_semver_compare(&set[j].version, &set_bound)
+                : -1;
+            if ((cmp < 0) || ((cmp == 0) && !term_inclusive)) {
+                set_bound = set[j].version;
+                set_inclusive = term_inclusive;
+                set_found = true;
+            }
+        }
+        if (!set_found) {
             return false;
         }
-        bool result = process_version(
-            work_mem_vec, (char *) current_version_vec.buf.data
-        );
-        if (result == false) {
-            GG_LOGT("Requirement wasn't satisfied");
-            return result;
+        set = &set[range->set_lens[i]];
+
+        // Highest bound across sets
+        int cmp = found ? ggl_semver_compare(&set_bound, bound) : 1;
+        if ((cmp > 0) || ((cmp == 0) && set_inclusive)) {
+            *bound = set_bound;
+            *inclusive = set_inclusive;
+            found = true;
         }
     }
+    return found;
+}
 
-    return true;
+// Gets the next comparator set's text and whether another set follows.
+static GgBuffer next_set(GgBuffer text, size_t *pos, bool *more) {
+    *more = false;
+    size_t start = text.len;
+    size_t end = text.len;
+    GgBuffer token;
+    while (next_token(text, pos, &token)) {
+        if (gg_buffer_eq(token, GG_STR("||"))) {
+            *more = true;
+            break;
+        }
+        if (start == text.len) {
+            start = *pos - token.len;
+        }
+        end = *pos;
+    }
+    if (start == text.len) {
+        return GG_STR("");
+    }
+    return gg_buffer_substr(text, start, end);
+}
+
+GgError ggl_semver_requirement_intersect(
+    GgBuffer a, GgBuffer b, GgByteVec *out
+) {
+    // (a1 || a2) && (b1 || b2) == a1 b1 || a1 b2 || a2 b1 || a2 b2
+    GgError ret = GG_ERR_OK;
+    bool first = true;
+    size_t pos_a = 0;
+    bool more_a = true;
+    while (more_a) {
+        GgBuffer set_a = next_set(a, &pos_a, &more_a);
+        size_t pos_b = 0;
+        bool more_b = true;
+        while (more_b) {
+            GgBuffer set_b = next_set(b, &pos_b, &more_b);
+            if (!first) {
+                gg_byte_vec_chain_append(&ret, out, GG_STR(" || "));
+            }
+            first = false;
+            gg_byte_vec_chain_append(&ret, out, set_a);
+            if ((set_a.len > 0) && (set_b.len > 0)) {
+                gg_byte_vec_chain_push(&ret, out, ' ');
+            }
+            gg_byte_vec_chain_append(&ret, out, set_b);
+        }
+    }
+    return ret;
+}
+
+bool is_in_range(GgBuffer version, GgBuffer requirements_range) {
+    GglSemver parsed_version;
+    GgError ret = ggl_semver_parse(version, &parsed_version);
+    if (ret != GG_ERR_OK) {
+        GG_LOGT("Version %.*s is not valid.", (int) version.len, version.data);
+        return false;
+    }
+
+    GglSemverRange range;
+    ret = ggl_semver_range_compile(requirements_range, &range);
+    if (ret != GG_ERR_OK) {
+        GG_LOGW(
+            "Failed to parse version requirement %.*s.",
+            (int) requirements_range.len,
+            requirements_range.data
+        );
+        return false;
+    }
+
+    return ggl_semver_range_matches(&range, &parsed_version);
 }
 
 #ifdef GG_SDK_TESTING
@@ -298,4 +543,56 @@ GG_TEST_DEFINE(semver_valid_rejects_malformed) {
     TEST_ASSERT_FALSE(is_valid_semver(GG_STR("1.2.3\nfoo")));
 }
 
+GG_TEST_DEFINE(semver_prerelease_precedence) {
+    TEST_ASSERT_TRUE(is_in_range(GG_STR("1.0.0-rc.1"), GG_STR("<1.0.0")));
+    TEST_ASSERT_TRUE(is_in_range(GG_STR("1.0.0-rc.10"), GG_STR(">1.0.0-rc.9")));
+    TEST_ASSERT_TRUE(is_in_range(GG_STR("1.0.0-rc.1"), GG_STR(">1.0.0-rc")));
+    TEST_ASSERT_TRUE(is_in_range(GG_STR("1.0.0-beta"), GG_STR(">1.0.0-9")));
+    TEST_ASSERT_TRUE(is_in_range(GG_STR("1.0.0+build.1"), GG_STR("=1.0.0")));
+}
+
+GG_TEST_DEFINE(semver_comparator_sets) {
+    GgBuffer requirement = GG_STR(">=1.0.0 <2.0.0 || >= 3.1 || 0.5.0");
+    TEST_ASSERT_TRUE(is_in_range(GG_STR("1.9.9"), requirement));
+    TEST_ASSERT_FALSE(is_in_range(GG_STR("2.0.0"), requirement));
+    TEST_ASSERT_TRUE(is_in_range(GG_STR("3.1.0"), requirement));
+    TEST_ASSERT_TRUE(is_in_range(GG_STR("0.5.0"), requirement));
+    TEST_ASSERT_TRUE(is_in_range(GG_STR("0.1.0"), GG_STR("")));
+    TEST_ASSERT_FALSE(is_in_range(GG_STR("1.0.0"), GG_STR(">=x")));
+}
+
+GG_TEST_DEFINE(semver_range_upper_bound) {
+    GglSemverRange range;
+    GglSemver bound;
+    bool inclusive;
+    TEST_ASSERT_EQUAL(
+        GG_ERR_OK,
+        ggl_semver_range_compile(
+            GG_STR(">=1.0.0 <2.0.0 <=3.0.0 || 1.5.0"), &range
+        )
+    );
+    TEST_ASSERT_TRUE(ggl_semver_range_upper_bound(&range, &bound, &inclusive));
+    TEST_ASSERT_TRUE(bound.major == 2);
+    TEST_ASSERT_FALSE(inclusive);
+
+    TEST_ASSERT_EQUAL(
+        GG_ERR_OK, ggl_semver_range_compile(GG_STR("<1.0.0 || >2.0.0"), &range)
+    );
+    TEST_ASSERT_FALSE(ggl_semver_range_upper_bound(&range, &bound, &inclusive));
+}
+
+GG_TEST_DEFINE(semver_requirement_intersect) {
+    uint8_t out_mem[128];
+    GgByteVec out = GG_BYTE_VEC(out_mem);
+    TEST_ASSERT_EQUAL(
+        GG_ERR_OK,
+        ggl_semver_requirement_intersect(
+            GG_STR(">=1.0.0 || 3.0.0"), GG_STR("<2.0.0"), &out
+        )
+    );
+    GG_TEST_ASSERT_BUF_EQUAL(
+        GG_STR(">=1.0.0 <2.0.0 || 3.0.0 <2.0.0"), out.buf
+    );
+}
+
 #endif
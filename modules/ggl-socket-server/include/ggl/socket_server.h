@@ -15,6 +15,7 @@
 
 /// Run a server listening on `path`.
 /// If `socket_name` is set, systemd-style socket activation will be attempted.
+/// Readiness is reported to systemd once the socket is listening.
 /// `client_ready` will be called when more data is available or if the client
 /// closes the socket.
 /// If `client_ready` returns an error, the connection will be cleaned up.
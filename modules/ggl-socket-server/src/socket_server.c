@@ -22,6 +22,7 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/un.h>
+#include <systemd/sd-daemon.h>
 #include <unistd.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -363,6 +364,13 @@ GgError ggl_socket_server_listen(
         }
     }
 
+    // Clients can connect from here on. This is a no-op unless the service
+    // is run with Type=notify.
+    int notify_ret = sd_notify(0, "READY=1");
+    if (notify_ret < 0) {
+        GG_LOGW("Failed to send sd_notify (errno=%d).", -notify_ret);
+    }
+
     SocketServerCtx server_ctx = {
         .pool = pool,
         .epoll_fd = epoll_fd,
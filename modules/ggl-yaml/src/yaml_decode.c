@@ -2,8 +2,8 @@
 // Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 // SPDX-License-Identifier: Apache-2.0
 
-#include <assert.h>
 #include <gg/arena.h>
+#include <gg/buffer.h>
 #include <gg/cleanup.h>
 #include <gg/error.h>
 #include <gg/log.h>
@@ -13,201 +13,300 @@
 #include <ggl/yaml_decode.h>
 #include <pthread.h>
 #include <string.h>
-#include <sys/types.h>
 #include <yaml.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-static GgError yaml_to_obj(
-    yaml_document_t *document, yaml_node_t *node, GgArena *arena, GgObject *obj
-);
+// Maximum number of decoded items of unfinished collections held at once.
+#ifndef GGL_YAML_MAX_PENDING_ITEMS
+#define GGL_YAML_MAX_PENDING_ITEMS 2048
+#endif
 
-static GgError yaml_node_to_buf(yaml_node_t *node, GgBuffer *buf) {
-    assert(node != NULL);
-    assert(node->type == YAML_SCALAR_NODE);
+#ifndef GGL_YAML_MAX_ANCHORS
+#define GGL_YAML_MAX_ANCHORS 64
+#endif
 
-    uint8_t *value = node->data.scalar.value;
-    size_t len = strlen((char *) value);
+#define GGL_YAML_ANCHOR_NAME_MEM 2048
+
+typedef struct {
+    bool is_map;
+    // Index of the collection's first item in pending_items
+    size_t start;
+    // Index of the collection's anchor, or SIZE_MAX if none
+    size_t anchor;
+} YamlFrame;
+
+typedef struct {
+    GgBuffer name;
+    GgObject obj;
+    bool complete;
+} YamlAnchor;
+
+typedef struct {
+    // Decoded scalars are copied into the already parsed part of buf
+    GgBuffer buf;
+    size_t buf_used;
+    // NULL if only validating
+    GgArena *arena;
+    bool have_root;
+    GgObject root;
+} YamlDecoder;
+
+// Collections are decoded by collecting their items here until the end event,
+// then moving them into an array of the final size in the arena. Only used
+// while holding the decode mutex.
+static GgObject pending_items[GGL_YAML_MAX_PENDING_ITEMS];
+static size_t pending_len;
+static YamlFrame frames[GG_MAX_OBJECT_DEPTH];
+static size_t depth;
+static YamlAnchor anchors[GGL_YAML_MAX_ANCHORS];
+static size_t anchor_count;
+static uint8_t anchor_name_mem[GGL_YAML_ANCHOR_NAME_MEM];
+static size_t anchor_name_used;
+
+static bool expecting_key(void) {
+    if (depth == 0) {
+        return false;
+    }
+    const YamlFrame *frame = &frames[depth - 1];
+    return frame->is_map && (((pending_len - frame->start) % 2) == 0);
+}
 
-    if (buf != NULL) {
-        *buf = (GgBuffer) { .data = value, .len = len };
+static GgError add_anchor(uint8_t *anchor, size_t *index) {
+    *index = SIZE_MAX;
+    if (anchor == NULL) {
+        return GG_ERR_OK;
+    }
+    size_t len = strlen((char *) anchor);
+    if ((anchor_count == GGL_YAML_MAX_ANCHORS)
+        || (len > (GGL_YAML_ANCHOR_NAME_MEM - anchor_name_used))) {
+        GG_LOGE("Too many yaml anchors.");
+        return GG_ERR_NOMEM;
     }
+    uint8_t *name = &anchor_name_mem[anchor_name_used];
+    memcpy(name, anchor, len);
+    anchor_name_used += len;
+    anchors[anchor_count] = (YamlAnchor) {
+        .name = { .data = name, .len = len },
+        .complete = false,
+    };
+    *index = anchor_count;
+    anchor_count += 1;
     return GG_ERR_OK;
 }
 
-static GgError yaml_scalar_to_obj(yaml_node_t *node, GgObject *obj) {
-    assert(node != NULL);
-    assert(node->type == YAML_SCALAR_NODE);
-
-    GgBuffer result;
-    GgError ret = yaml_node_to_buf(node, &result);
-    if (ret != GG_ERR_OK) {
-        return ret;
+static void complete_anchor(size_t index, GgObject obj) {
+    if (index != SIZE_MAX) {
+        anchors[index].obj = obj;
+        anchors[index].complete = true;
     }
+}
 
-    if (obj != NULL) {
-        *obj = gg_obj_buf(result);
+static GgError find_anchor(uint8_t *anchor, GgObject *obj) {
+    GgBuffer name = gg_buffer_from_null_term((char *) anchor);
+    // Latest definition wins if an anchor is redefined
+    for (size_t i = anchor_count; i > 0; i--) {
+        if (gg_buffer_eq(anchors[i - 1].name, name)) {
+            if (!anchors[i - 1].complete) {
+                GG_LOGE("Yaml alias refers to its own node.");
+                return GG_ERR_PARSE;
+            }
+            *obj = anchors[i - 1].obj;
+            return GG_ERR_OK;
+        }
     }
-    return GG_ERR_OK;
+    GG_LOGE("Yaml alias to undefined anchor %.*s.", (int) name.len, name.data);
+    return GG_ERR_PARSE;
 }
 
-// NOLINTNEXTLINE(misc-no-recursion)
-static GgError yaml_mapping_to_obj(
-    yaml_document_t *document, yaml_node_t *node, GgArena *arena, GgObject *obj
-) {
-    assert(document != NULL);
-    assert(node != NULL);
-    assert(node->type == YAML_MAPPING_NODE);
-    assert(arena != NULL);
-
-    if (node->data.mapping.pairs.top < node->data.mapping.pairs.start) {
-        GG_LOGE("Unexpected result from libyaml.");
+static GgError add_value(YamlDecoder *ctx, GgObject value) {
+    if (expecting_key() && (gg_obj_type(value) != GG_TYPE_BUF)) {
+        GG_LOGE("Yaml mapping key not a scalar.");
         return GG_ERR_FAILURE;
     }
-
-    size_t len = (size_t) (node->data.mapping.pairs.top
-                           - node->data.mapping.pairs.start);
-
-    if (len == 0) {
-        if (obj != NULL) {
-            *obj = gg_obj_map((GgMap) { 0 });
-        }
+    if (depth == 0) {
+        ctx->root = value;
+        ctx->have_root = true;
         return GG_ERR_OK;
     }
-
-    GgKV *pairs = NULL;
-    if (obj != NULL) {
-        pairs = GG_ARENA_ALLOCN(arena, GgKV, len);
-        if (pairs == NULL) {
-            GG_LOGE("Insufficent memory to decode yaml.");
-            return GG_ERR_NOMEM;
-        }
+    if (pending_len == GGL_YAML_MAX_PENDING_ITEMS) {
+        GG_LOGE("Insufficent memory to decode yaml.");
+        return GG_ERR_NOMEM;
     }
+    pending_items[pending_len] = value;
+    pending_len += 1;
+    return GG_ERR_OK;
+}
 
-    yaml_node_pair_t *node_pairs = node->data.mapping.pairs.start;
-    for (size_t i = 0; i < len; i++) {
-        yaml_node_t *key_node
-            = yaml_document_get_node(document, node_pairs[i].key);
-        if (key_node == NULL) {
-            GG_LOGE("Yaml mapping key NULL.");
-            return GG_ERR_FAILURE;
-        }
-        yaml_node_t *value_node
-            = yaml_document_get_node(document, node_pairs[i].value);
-        if (value_node == NULL) {
-            GG_LOGE("Yaml mapping value NULL.");
-            return GG_ERR_FAILURE;
-        }
-
-        if (key_node->type != YAML_SCALAR_NODE) {
-            GG_LOGE("Yaml mapping key not a scalar.");
-            return GG_ERR_FAILURE;
-        }
-
-        GgError ret;
-        if (pairs == NULL) {
-            ret = yaml_node_to_buf(key_node, NULL);
+static GgError decode_scalar(YamlDecoder *ctx, yaml_event_t *event) {
+    GgBuffer value = { .data = event->data.scalar.value,
+                       .len = event->data.scalar.length };
+    GgBuffer result = GG_STR("");
+
+    if (ctx->arena != NULL) {
+        // libyaml copies input as it reads, so input up to the end of this
+        // event can be overwritten. Escapes can make a scalar longer than its
+        // source text; those go in the arena instead.
+        if (value.len <= (event->end_mark.index - ctx->buf_used)) {
+            result = (GgBuffer) { .data = &ctx->buf.data[ctx->buf_used],
+                                  .len = value.len };
+            ctx->buf_used += value.len;
         } else {
-            GgBuffer key = { 0 };
-            ret = yaml_node_to_buf(key_node, &key);
-            gg_kv_set_key(&pairs[i], key);
+            result.data = GG_ARENA_ALLOCN(ctx->arena, uint8_t, value.len);
+            if (result.data == NULL) {
+                GG_LOGE("Insufficent memory to decode yaml.");
+                return GG_ERR_NOMEM;
+            }
+            result.len = value.len;
         }
-        if (ret != GG_ERR_OK) {
-            return ret;
+        if (value.len > 0) {
+            memcpy(result.data, value.data, value.len);
         }
+    }
 
-        GgObject *val = (pairs == NULL) ? NULL : gg_kv_val(&pairs[i]);
-
-        ret = yaml_to_obj(document, value_node, arena, val);
-        if (ret != GG_ERR_OK) {
-            return ret;
-        }
+    size_t anchor;
+    GgError ret = add_anchor(event->data.scalar.anchor, &anchor);
+    if (ret != GG_ERR_OK) {
+        return ret;
     }
+    complete_anchor(anchor, gg_obj_buf(result));
+    return add_value(ctx, gg_obj_buf(result));
+}
 
-    if (obj != NULL) {
-        *obj = gg_obj_map((GgMap) { .pairs = pairs, .len = len });
+static GgError start_collection(bool is_map, uint8_t *anchor) {
+    if (expecting_key()) {
+        GG_LOGE("Yaml mapping key not a scalar.");
+        return GG_ERR_FAILURE;
     }
+    if (depth == GG_MAX_OBJECT_DEPTH) {
+        GG_LOGE("Yaml document exceeds maximum nesting depth.");
+        return GG_ERR_RANGE;
+    }
+    YamlFrame *frame = &frames[depth];
+    frame->is_map = is_map;
+    frame->start = pending_len;
+    GgError ret = add_anchor(anchor, &frame->anchor);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    depth += 1;
     return GG_ERR_OK;
 }
 
-// NOLINTNEXTLINE(misc-no-recursion)
-static GgError yaml_sequence_to_obj(
-    yaml_document_t *document, yaml_node_t *node, GgArena *arena, GgObject *obj
-) {
-    assert(document != NULL);
-    assert(node != NULL);
-    assert(node->type == YAML_SEQUENCE_NODE);
-    assert(arena != NULL);
-
-    if (node->data.sequence.items.top < node->data.sequence.items.start) {
+static GgError end_collection(YamlDecoder *ctx) {
+    if (depth == 0) {
         GG_LOGE("Unexpected result from libyaml.");
         return GG_ERR_FAILURE;
     }
-
-    size_t len = (size_t) (node->data.sequence.items.top
-                           - node->data.sequence.items.start);
-
-    if (len == 0) {
-        if (obj != NULL) {
-            *obj = gg_obj_list((GgList) { 0 });
+    depth -= 1;
+    const YamlFrame *frame = &frames[depth];
+    GgObject *items = &pending_items[frame->start];
+    size_t len = pending_len - frame->start;
+    pending_len = frame->start;
+
+    GgObject result;
+    if (frame->is_map) {
+        GgMap map = { 0 };
+        if ((len > 0) && (ctx->arena != NULL)) {
+            map.pairs = GG_ARENA_ALLOCN(ctx->arena, GgKV, len / 2);
+            if (map.pairs == NULL) {
+                GG_LOGE("Insufficent memory to decode yaml.");
+                return GG_ERR_NOMEM;
+            }
+            map.len = len / 2;
+            for (size_t i = 0; i < map.len; i++) {
+                map.pairs[i] = gg_kv(
+                    gg_obj_into_buf(items[2 * i]), items[(2 * i) + 1]
+                );
+            }
         }
-        return GG_ERR_OK;
-    }
-
-    GgObject *items = NULL;
-    if (obj != NULL) {
-        items = GG_ARENA_ALLOCN(arena, GgObject, len);
-        if (items == NULL) {
-            GG_LOGE("Insufficent memory to decode yaml.");
-            return GG_ERR_NOMEM;
+        result = gg_obj_map(map);
+    } else {
+        GgList list = { 0 };
+        if ((len > 0) && (ctx->arena != NULL)) {
+            list.items = GG_ARENA_ALLOCN(ctx->arena, GgObject, len);
+            if (list.items == NULL) {
+                GG_LOGE("Insufficent memory to decode yaml.");
+                return GG_ERR_NOMEM;
+            }
+            memcpy(list.items, items, len * sizeof(GgObject));
+            list.len = len;
         }
+        result = gg_obj_list(list);
     }
 
-    yaml_node_item_t *item_nodes = node->data.sequence.items.start;
-    for (size_t i = 0; i < len; i++) {
-        yaml_node_t *item_node
-            = yaml_document_get_node(document, item_nodes[i]);
-        if (item_node == NULL) {
-            GG_LOGE("Yaml sequence node NULL.");
-            return GG_ERR_FAILURE;
-        }
-
-        GgObject *item = (items == NULL) ? NULL : &items[i];
+    complete_anchor(frame->anchor, result);
+    return add_value(ctx, result);
+}
 
-        GgError ret = yaml_to_obj(document, item_node, arena, item);
+static GgError decode_event(YamlDecoder *ctx, yaml_event_t *event) {
+    switch (event->type) {
+    case YAML_STREAM_START_EVENT:
+    case YAML_DOCUMENT_START_EVENT:
+    case YAML_DOCUMENT_END_EVENT:
+    case YAML_STREAM_END_EVENT:
+        return GG_ERR_OK;
+    case YAML_SCALAR_EVENT:
+        return decode_scalar(ctx, event);
+    case YAML_SEQUENCE_START_EVENT:
+        return start_collection(false, event->data.sequence_start.anchor);
+    case YAML_MAPPING_START_EVENT:
+        return start_collection(true, event->data.mapping_start.anchor);
+    case YAML_SEQUENCE_END_EVENT:
+    case YAML_MAPPING_END_EVENT:
+        return end_collection(ctx);
+    case YAML_ALIAS_EVENT: {
+        GgObject value;
+        GgError ret = find_anchor(event->data.alias.anchor, &value);
         if (ret != GG_ERR_OK) {
             return ret;
         }
+        return add_value(ctx, value);
     }
-
-    if (obj != NULL) {
-        *obj = gg_obj_list((GgList) { .items = items, .len = len });
+    case YAML_NO_EVENT:
+        break;
     }
-    return GG_ERR_OK;
+    GG_LOGE("Unexpected event type from libyaml.");
+    return GG_ERR_FAILURE;
 }
 
-// NOLINTNEXTLINE(misc-no-recursion)
-static GgError yaml_to_obj(
-    yaml_document_t *document, yaml_node_t *node, GgArena *arena, GgObject *obj
-) {
-    assert(document != NULL);
-    assert(node != NULL);
-    assert(arena != NULL);
-
-    switch (node->type) {
-    case YAML_NO_NODE: {
-        GG_LOGE("Unexpected missing node from libyaml.");
-        return GG_ERR_FAILURE;
-    }
-    case YAML_SCALAR_NODE:
-        return yaml_scalar_to_obj(node, obj);
-    case YAML_MAPPING_NODE:
-        return yaml_mapping_to_obj(document, node, arena, obj);
-    case YAML_SEQUENCE_NODE:
-        return yaml_sequence_to_obj(document, node, arena, obj);
+/// Decodes the first document in the stream, building the object directly
+/// from parser events.
+static GgError decode_document(yaml_parser_t *parser, YamlDecoder *ctx) {
+    pending_len = 0;
+    depth = 0;
+    anchor_count = 0;
+    anchor_name_used = 0;
+
+    while (true) {
+        yaml_event_t event;
+        if (!yaml_parser_parse(parser, &event)) {
+            GG_LOGE(
+                "Yaml parser load failed. Parser error: %s, at line %zu, column %zu",
+                parser->problem,
+                parser->problem_mark.line + 1,
+                parser->problem_mark.column + 1
+            );
+            return GG_ERR_PARSE;
+        }
+        GgError ret = decode_event(ctx, &event);
+        yaml_event_type_t type = event.type;
+        yaml_event_delete(&event);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        if ((type == YAML_DOCUMENT_END_EVENT)
+            || (type == YAML_STREAM_END_EVENT)) {
+            break;
+        }
     }
 
-    GG_LOGE("Unexpected node type from libyaml.");
-    return GG_ERR_FAILURE;
+    if (!ctx->have_root) {
+        GG_LOGE("Yaml document is empty.");
+        return GG_ERR_NOENTRY;
+    }
+    return GG_ERR_OK;
 }
 
 GgError ggl_yaml_decode_destructive(
@@ -226,22 +325,6 @@ GgError ggl_yaml_decode_destructive(
         return GG_ERR_FATAL;
     }
     yaml_parser_set_input_string(&parser, buf.data, buf.len);
-    static yaml_document_t document;
-    if (!yaml_parser_load(&parser, &document)) {
-        GG_LOGE(
-            "Yaml parser load failed. Parser error: %s, at line %zu, column %zu",
-            parser.problem,
-            parser.problem_mark.line + 1,
-            parser.problem_mark.column + 1
-        );
-        yaml_parser_delete(&parser);
-        return GG_ERR_PARSE;
-    }
-    yaml_node_t *root_node = yaml_document_get_root_node(&document);
-    if (root_node == NULL) {
-        GG_LOGE("Yaml document is empty.");
-        return GG_ERR_NOENTRY;
-    }
 
     // Handle NULL arena arg
     GgArena empty_arena = { 0 };
@@ -250,23 +333,18 @@ GgError ggl_yaml_decode_destructive(
     // Copy to avoid committing allocation on error path
     GgArena arena_copy = *result_arena;
 
-    GgError ret = yaml_to_obj(&document, root_node, &arena_copy, obj);
+    YamlDecoder ctx = {
+        .buf = buf,
+        .arena = (obj == NULL) ? NULL : &arena_copy,
+    };
+    GgError ret = decode_document(&parser, &ctx);
 
-    if (obj != NULL) {
-        if (ret == GG_ERR_OK) {
-            // Copy buffers (dynamically allocated by libyaml) into buf to mimic
-            // in-place buffer decoding
-            GgArena buf_arena = gg_arena_init(buf);
-            ret = gg_arena_claim_obj_bufs(obj, &buf_arena);
-        }
-
-        if (ret == GG_ERR_OK) {
-            // Commit allocations
-            *result_arena = arena_copy;
-        }
+    if ((ret == GG_ERR_OK) && (obj != NULL)) {
+        *obj = ctx.root;
+        // Commit allocations
+        *result_arena = arena_copy;
     }
 
-    yaml_document_delete(&document);
     yaml_parser_delete(&parser);
 
     return ret;
@@ -310,4 +388,26 @@ GG_TEST_DEFINE(yaml_decode_empty_input) {
     GG_TEST_ASSERT_BAD(ggl_yaml_decode_destructive(buf, &arena, &obj));
 }
 
+GG_TEST_DEFINE(yaml_decode_nested_with_alias) {
+    uint8_t yaml_buf[] = "base: &b\n"
+                         "  name: \"a\\tb\"\n"
+                         "  list: [1, 2]\n"
+                         "copy: *b\n";
+    GgBuffer buf = { .data = yaml_buf, .len = sizeof(yaml_buf) - 1 };
+    uint8_t arena_mem[4096];
+    GgArena arena = gg_arena_init(GG_BUF(arena_mem));
+    GgObject obj = { 0 };
+    GG_TEST_ASSERT_OK(ggl_yaml_decode_destructive(buf, &arena, &obj));
+    TEST_ASSERT_EQUAL(GG_TYPE_MAP, gg_obj_type(obj));
+    GgObject *copy;
+    TEST_ASSERT_TRUE(gg_map_get(gg_obj_into_map(obj), GG_STR("copy"), &copy));
+    TEST_ASSERT_EQUAL(GG_TYPE_MAP, gg_obj_type(*copy));
+    GgObject *name;
+    TEST_ASSERT_TRUE(gg_map_get(gg_obj_into_map(*copy), GG_STR("name"), &name));
+    GG_TEST_ASSERT_BUF_EQUAL(GG_STR("a\tb"), gg_obj_into_buf(*name));
+    GgObject *list;
+    TEST_ASSERT_TRUE(gg_map_get(gg_obj_into_map(*copy), GG_STR("list"), &list));
+    TEST_ASSERT_EQUAL(2, gg_obj_into_list(*list).len);
+}
+
 #endif
@@ -11,13 +11,25 @@
 #include <gg/types.h>
 #include <ggl/zip.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include <zip.h>
 #include <zipconf.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+/// Read size for decompressed entry data. Large enough that each write is a
+/// single syscall for most files.
+#define ZIP_COPY_BUFFER_SIZE (64 * 1024)
+/// Upper bound on threads extracting entries concurrently.
+#define ZIP_MAX_WORKERS 8
+/// Entries are split into this many buckets per worker by name, for load
+/// balancing.
+#define ZIP_BUCKETS_PER_WORKER 4
+
 static inline void cleanup_zip_fclose(zip_file_t **zip_entry) {
     if (*zip_entry != NULL) {
         zip_fclose(*zip_entry);
@@ -30,11 +42,11 @@ static inline void cleanup_zip_close(zip_t **zip_archive) {
     }
 }
 
-static GgError write_entry_to_fd(zip_file_t *entry, int fd) {
-    uint8_t read_buffer[32];
+static GgError write_entry_to_fd(
+    zip_file_t *entry, int fd, uint8_t *buffer, size_t buffer_len
+) {
     for (;;) {
-        zip_int64_t bytes_read
-            = zip_fread(entry, read_buffer, sizeof(read_buffer));
+        zip_int64_t bytes_read = zip_fread(entry, buffer, buffer_len);
         // end of file
         if (bytes_read == 0) {
             return GG_ERR_OK;
@@ -45,7 +57,7 @@ static GgError write_entry_to_fd(zip_file_t *entry, int fd) {
             return GG_ERR_FAILURE;
         }
         GgBuffer bytes
-            = (GgBuffer) { .data = read_buffer, .len = (size_t) bytes_read };
+            = (GgBuffer) { .data = buffer, .len = (size_t) bytes_read };
         GgError ret = gg_file_write(fd, bytes);
         if (ret != GG_ERR_OK) {
             return GG_ERR_FAILURE;
@@ -82,84 +94,411 @@ static bool validate_path(GgBuffer path) {
     return true;
 }
 
-GgError ggl_zip_unarchive(
-    int source_dest_dir_fd, GgBuffer zip_path, int dest_dir_fd, mode_t mode
+static GgError open_zip(int source_dir_fd, GgBuffer zip_path, zip_t **zip) {
+    int zip_fd;
+    GgError ret
+        = gg_file_openat(source_dir_fd, zip_path, O_RDONLY, 0, &zip_fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    int err = -1;
+    *zip = zip_fdopen(zip_fd, ZIP_RDONLY, &err);
+    if (*zip == NULL) {
+        GG_LOGE("Failed to open zip file with error %d.", err);
+        (void) close(zip_fd);
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+/// Returns the validated name of entry i, or an empty buffer if the entry
+/// should be skipped.
+static GgError get_entry_name(zip_t *zip, zip_uint64_t i, GgBuffer *name) {
+    const char *name_str = zip_get_name(zip, i, 0);
+    if (name_str == NULL) {
+        int err = zip_error_code_zip(zip_get_error(zip));
+        GG_LOGE(
+            "Failed to get the name of entry %" PRIu64 " with error %d.",
+            (uint64_t) i,
+            err
+        );
+        return GG_ERR_FAILURE;
+    }
+
+    *name = gg_buffer_from_null_term((char *) name_str);
+    if (!validate_path(*name)) {
+        *name = (GgBuffer) { 0 };
+    }
+    return GG_ERR_OK;
+}
+
+static bool is_dir_entry(GgBuffer name) {
+    return gg_buffer_has_suffix(name, GG_STR("/"));
+}
+
+static GgError extract_file_entry(
+    zip_t *zip,
+    zip_uint64_t i,
+    GgBuffer name,
+    int dest_dir_fd,
+    mode_t mode,
+    uint8_t *buffer,
+    size_t buffer_len
 ) {
-    zip_t *zip;
-    {
-        int zip_fd;
-        GgError ret = gg_file_openat(
-            source_dest_dir_fd, zip_path, O_RDONLY, 0, &zip_fd
+    zip_file_t *entry = zip_fopen_index(zip, i, 0);
+    if (entry == NULL) {
+        int err = zip_error_code_zip(zip_get_error(zip));
+        GG_LOGE(
+            "Failed to open file \"%.*s\" (index %" PRIu64
+            ") from zip with error %d.",
+            (int) name.len,
+            name.data,
+            i,
+            err
         );
+        return GG_ERR_FAILURE;
+    }
+    GG_CLEANUP(cleanup_zip_fclose, entry);
+
+    int dest_file_fd;
+    GgError ret = gg_file_openat(
+        dest_dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC, mode, &dest_file_fd
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, dest_file_fd);
+
+    return write_entry_to_fd(entry, dest_file_fd, buffer, buffer_len);
+}
+
+typedef struct {
+    int source_dir_fd;
+    GgBuffer zip_path;
+    int dest_dir_fd;
+    mode_t mode;
+    zip_uint64_t num_entries;
+    size_t num_buckets;
+    atomic_size_t next_bucket;
+    atomic_int err;
+} UnzipCtx;
+
+/// Archives may contain several entries with the same name, of which the last
+/// one is kept. Entries are assigned to buckets by name, so that same-name
+/// entries are extracted by one worker, in archive order.
+static size_t name_bucket(const char *name, size_t num_buckets) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037U;
+    for (const char *c = name; *c != '\0'; c++) {
+        hash ^= (uint8_t) *c;
+        hash *= 1099511628211U;
+    }
+    return (size_t) (hash % num_buckets);
+}
+
+static void unzip_set_error(UnzipCtx *ctx, GgError err) {
+    int expected = GG_ERR_OK;
+    atomic_compare_exchange_strong(&ctx->err, &expected, (int) err);
+}
+
+static GgError extract_bucket(
+    UnzipCtx *ctx, zip_t *zip, size_t bucket, uint8_t *buffer, size_t buffer_len
+) {
+    for (zip_uint64_t i = 0; i < ctx->num_entries; i++) {
+        const char *name_str = zip_get_name(zip, i, 0);
+        if ((name_str != NULL)
+            && (name_bucket(name_str, ctx->num_buckets) != bucket)) {
+            continue;
+        }
+        GgBuffer name;
+        GgError ret = get_entry_name(zip, i, &name);
         if (ret != GG_ERR_OK) {
             return ret;
         }
-        int err = -1;
-        zip = zip_fdopen(zip_fd, ZIP_RDONLY, &err);
-        if (zip == NULL) {
-            GG_LOGE("Failed to open zip file with error %d.", err);
-            return GG_ERR_FAILURE;
+        if ((name.len == 0) || is_dir_entry(name)) {
+            continue;
         }
+        ret = extract_file_entry(
+            zip, i, name, ctx->dest_dir_fd, ctx->mode, buffer, buffer_len
+        );
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    return GG_ERR_OK;
+}
+
+/// Extracts buckets of file entries claimed from the shared index until none
+/// remain. Each worker reads through its own zip handle, as libzip handles are
+/// not thread-safe.
+static void *unzip_worker(void *arg) {
+    UnzipCtx *ctx = arg;
+    _Alignas(4096) uint8_t buffer[ZIP_COPY_BUFFER_SIZE];
+
+    zip_t *zip;
+    GgError ret = open_zip(ctx->source_dir_fd, ctx->zip_path, &zip);
+    if (ret != GG_ERR_OK) {
+        unzip_set_error(ctx, ret);
+        return NULL;
+    }
+    GG_CLEANUP(cleanup_zip_close, zip);
+
+    while (atomic_load(&ctx->err) == GG_ERR_OK) {
+        size_t bucket = atomic_fetch_add(&ctx->next_bucket, 1);
+        if (bucket >= ctx->num_buckets) {
+            break;
+        }
+        ret = extract_bucket(ctx, zip, bucket, buffer, sizeof(buffer));
+        if (ret != GG_ERR_OK) {
+            unzip_set_error(ctx, ret);
+        }
+    }
+    return NULL;
+}
+
+static size_t unzip_worker_count(size_t file_entries) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t workers = (cpus > 0) ? (size_t) cpus : 1;
+    if (workers > ZIP_MAX_WORKERS) {
+        workers = ZIP_MAX_WORKERS;
+    }
+    if (workers > file_entries) {
+        workers = file_entries;
+    }
+    return (workers == 0) ? 1 : workers;
+}
+
+GgError ggl_zip_unarchive(
+    int source_dest_dir_fd, GgBuffer zip_path, int dest_dir_fd, mode_t mode
+) {
+    zip_t *zip;
+    GgError ret = open_zip(source_dest_dir_fd, zip_path, &zip);
+    if (ret != GG_ERR_OK) {
+        return ret;
     }
     GG_CLEANUP(cleanup_zip_close, zip);
 
+    // Create directories up front so file entries can be extracted in any
+    // order.
     zip_uint64_t num_entries = (zip_uint64_t) zip_get_num_entries(zip, 0);
+    size_t file_entries = 0;
     for (zip_uint64_t i = 0; i < num_entries; i++) {
-        const char *name = zip_get_name(zip, i, 0);
-        if (name == NULL) {
-            int err = zip_error_code_zip(zip_get_error(zip));
-            GG_LOGE(
-                "Failed to get the name of entry %" PRIu64 " with error %d.",
-                (uint64_t) i,
-                err
-            );
-            return GG_ERR_FAILURE;
+        GgBuffer name;
+        ret = get_entry_name(zip, i, &name);
+        if (ret != GG_ERR_OK) {
+            return ret;
         }
-
-        GgBuffer name_buf = gg_buffer_from_null_term((char *) name);
-        if (!validate_path(name_buf)) {
+        if (name.len == 0) {
             continue;
         }
-
-        zip_file_t *entry = zip_fopen_index(zip, i, 0);
-        if (entry == NULL) {
-            int err = zip_error_code_zip(zip_get_error(zip));
-            GG_LOGE(
-                "Failed to open file \"%s\" (index %" PRIu64
-                ") from zip with error %d.",
-                name_buf.data,
-                i,
-                err
-            );
-            return GG_ERR_FAILURE;
-        }
-        GG_CLEANUP(cleanup_zip_fclose, entry);
-
-        GgError ret;
-        int dest_file_fd;
-        if (gg_buffer_has_suffix(name_buf, GG_STR("/"))) {
-            ret = gg_dir_openat(
-                dest_dir_fd, name_buf, O_PATH, mode, &dest_file_fd
-            );
-        } else {
-            ret = gg_file_openat(
-                dest_dir_fd,
-                name_buf,
-                O_WRONLY | O_CREAT | O_TRUNC,
-                mode,
-                &dest_file_fd
-            );
+        if (!is_dir_entry(name)) {
+            file_entries++;
+            continue;
         }
+        int dir_fd;
+        ret = gg_dir_openat(dest_dir_fd, name, O_PATH, mode, &dir_fd);
         if (ret != GG_ERR_OK) {
             return ret;
         }
-        GG_CLEANUP(cleanup_close, dest_file_fd);
+        (void) close(dir_fd);
+    }
 
-        ret = write_entry_to_fd(entry, dest_file_fd);
-        if (ret != GG_ERR_OK) {
-            return ret;
+    size_t workers = unzip_worker_count(file_entries);
+    UnzipCtx ctx = { .source_dir_fd = source_dest_dir_fd,
+                     .zip_path = zip_path,
+                     .dest_dir_fd = dest_dir_fd,
+                     .mode = mode,
+                     .num_entries = num_entries,
+                     .num_buckets = (workers == 1)
+                         ? 1
+                         : workers * ZIP_BUCKETS_PER_WORKER };
+    atomic_init(&ctx.next_bucket, 0);
+    atomic_init(&ctx.err, GG_ERR_OK);
+
+    // The calling thread is also a worker.
+    pthread_t threads[ZIP_MAX_WORKERS];
+    size_t started = 0;
+    for (; started + 1 < workers; started++) {
+        if (pthread_create(&threads[started], NULL, unzip_worker, &ctx) != 0) {
+            GG_LOGW("Failed to start unzip worker; continuing with fewer.");
+            break;
         }
     }
+    unzip_worker(&ctx);
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
 
-    return GG_ERR_OK;
+    return (GgError) atomic_load(&ctx.err);
 }
+
+#ifdef GG_SDK_TESTING
+
+#include <gg/test.h>
+#include <string.h>
+#include <unity.h>
+#include <zlib.h>
+#include <stdlib.h>
+
+typedef struct {
+    const char *name;
+    const char *contents;
+} TestZipEntry;
+
+static void put_le(uint8_t **pos, uint32_t value, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        (*pos)[i] = (uint8_t) (value >> (8 * i));
+    }
+    *pos += len;
+}
+
+static void put_bytes(uint8_t **pos, const char *data, size_t len) {
+    memcpy(*pos, data, len);
+    *pos += len;
+}
+
+/// Writes an archive of stored entries. Unlike libzip, this allows several
+/// entries with the same name.
+static size_t test_zip_build(
+    const TestZipEntry *entries, size_t entries_len, uint8_t *out
+) {
+    uint8_t *pos = out;
+    uint32_t offsets[64];
+    TEST_ASSERT_TRUE(entries_len <= sizeof(offsets) / sizeof(offsets[0]));
+    for (size_t i = 0; i < entries_len; i++) {
+        size_t name_len = strlen(entries[i].name);
+        size_t data_len = strlen(entries[i].contents);
+        uint32_t crc = (uint32_t) crc32(
+            0, (const uint8_t *) entries[i].contents, (uInt) data_len
+        );
+        offsets[i] = (uint32_t) (pos - out);
+        put_le(&pos, 0x04034b50, 4);
+        put_le(&pos, 20, 2); // version needed
+        put_le(&pos, 0, 2); // flags
+        put_le(&pos, 0, 2); // stored
+        put_le(&pos, 0, 2); // time
+        put_le(&pos, 0x21, 2); // date
+        put_le(&pos, crc, 4);
+        put_le(&pos, (uint32_t) data_len, 4);
+        put_le(&pos, (uint32_t) data_len, 4);
+        put_le(&pos, (uint32_t) name_len, 2);
+        put_le(&pos, 0, 2); // extra
+        put_bytes(&pos, entries[i].name, name_len);
+        put_bytes(&pos, entries[i].contents, data_len);
+    }
+
+    uint32_t central_dir_offset = (uint32_t) (pos - out);
+    for (size_t i = 0; i < entries_len; i++) {
+        size_t name_len = strlen(entries[i].name);
+        size_t data_len = strlen(entries[i].contents);
+        uint32_t crc = (uint32_t) crc32(
+            0, (const uint8_t *) entries[i].contents, (uInt) data_len
+        );
+        put_le(&pos, 0x02014b50, 4);
+        put_le(&pos, 20, 2); // version made by
+        put_le(&pos, 20, 2); // version needed
+        put_le(&pos, 0, 2); // flags
+        put_le(&pos, 0, 2); // stored
+        put_le(&pos, 0, 2); // time
+        put_le(&pos, 0x21, 2); // date
+        put_le(&pos, crc, 4);
+        put_le(&pos, (uint32_t) data_len, 4);
+        put_le(&pos, (uint32_t) data_len, 4);
+        put_le(&pos, (uint32_t) name_len, 2);
+        put_le(&pos, 0, 2); // extra
+        put_le(&pos, 0, 2); // comment
+        put_le(&pos, 0, 2); // disk
+        put_le(&pos, 0, 2); // internal attributes
+        put_le(&pos, 0, 4); // external attributes
+        put_le(&pos, offsets[i], 4);
+        put_bytes(&pos, entries[i].name, name_len);
+    }
+    uint32_t central_dir_len = (uint32_t) (pos - out) - central_dir_offset;
+
+    put_le(&pos, 0x06054b50, 4);
+    put_le(&pos, 0, 2); // disk
+    put_le(&pos, 0, 2); // central directory disk
+    put_le(&pos, (uint32_t) entries_len, 2);
+    put_le(&pos, (uint32_t) entries_len, 2);
+    put_le(&pos, central_dir_len, 4);
+    put_le(&pos, central_dir_offset, 4);
+    put_le(&pos, 0, 2); // comment
+    return (size_t) (pos - out);
+}
+
+static void test_assert_file(
+    int dir_fd, const char *name, const char *expected
+) {
+    int fd;
+    GG_TEST_ASSERT_OK(gg_file_openat(
+        dir_fd, gg_buffer_from_null_term((char *) name), O_RDONLY, 0, &fd
+    ));
+    uint8_t mem[64];
+    GgBuffer contents = GG_BUF(mem);
+    GgError ret = gg_file_read(fd, &contents);
+    (void) close(fd);
+    GG_TEST_ASSERT_OK(ret);
+    TEST_ASSERT_EQUAL_STRING_LEN(expected, contents.data, contents.len);
+    TEST_ASSERT_EQUAL(strlen(expected), contents.len);
+}
+
+GG_TEST_DEFINE(zip_unarchive_contents) {
+    static const TestZipEntry ENTRIES[] = {
+        { "dir/", "" },
+        { "dir/a.txt", "first" },
+        { "b.txt", "bee" },
+        { "../escape.txt", "skipped" },
+        { "dir/nested/", "" },
+        { "dir/nested/c.txt", "sea" },
+        { "dir/a.txt", "second" },
+        { "d.txt", "" },
+        { "e.txt", "e1" },
+        { "e.txt", "e2" },
+        { "e.txt", "e3" },
+    };
+    static uint8_t archive[4096];
+    size_t archive_len = test_zip_build(
+        ENTRIES, sizeof(ENTRIES) / sizeof(ENTRIES[0]), archive
+    );
+
+    char dir_path[] = "/tmp/ggl-zip-test-XXXXXX";
+    TEST_ASSERT_NOT_NULL(mkdtemp(dir_path));
+    int dir_fd;
+    GG_TEST_ASSERT_OK(gg_dir_open(
+        gg_buffer_from_null_term(dir_path), O_PATH, false, &dir_fd
+    ));
+
+    int archive_fd;
+    GG_TEST_ASSERT_OK(gg_file_openat(
+        dir_fd,
+        GG_STR("test.zip"),
+        O_WRONLY | O_CREAT | O_TRUNC,
+        0600,
+        &archive_fd
+    ));
+    GgError ret = gg_file_write(
+        archive_fd, (GgBuffer) { .data = archive, .len = archive_len }
+    );
+    (void) close(archive_fd);
+    GG_TEST_ASSERT_OK(ret);
+
+    int out_fd;
+    GG_TEST_ASSERT_OK(
+        gg_dir_openat(dir_fd, GG_STR("out"), O_PATH, true, &out_fd)
+    );
+    GG_TEST_ASSERT_OK(
+        ggl_zip_unarchive(dir_fd, GG_STR("test.zip"), out_fd, 0644)
+    );
+
+    test_assert_file(out_fd, "dir/a.txt", "second");
+    test_assert_file(out_fd, "b.txt", "bee");
+    test_assert_file(out_fd, "dir/nested/c.txt", "sea");
+    test_assert_file(out_fd, "d.txt", "");
+    test_assert_file(out_fd, "e.txt", "e3");
+    TEST_ASSERT_NOT_EQUAL(0, faccessat(dir_fd, "escape.txt", F_OK, 0));
+
+    (void) close(out_fd);
+    (void) close(dir_fd);
+}
+
+#endif
@@ -16,6 +16,7 @@
 #include <string.h>
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // Matches AWS IoT topic length
@@ -96,6 +97,9 @@ static GgError rpc_publish(void *ctx, GgMap params, uint32_t handle) {
         return GG_ERR_RANGE;
     }
 
+    uint32_t matched[GGL_PUBSUB_MAX_SUBSCRIPTIONS];
+    size_t matched_len = 0;
+
     for (size_t i = 0; i < GGL_PUBSUB_MAX_SUBSCRIPTIONS; i++) {
         if (sub_handle[i] != 0) {
             bool matches = false;
@@ -107,11 +111,15 @@ static GgError rpc_publish(void *ctx, GgMap params, uint32_t handle) {
                 &matches
             );
             if (matches) {
-                ggl_sub_respond(sub_handle[i], gg_obj_map(params));
+                matched[matched_len] = sub_handle[i];
+                matched_len += 1;
             }
         }
     }
 
+    // Message is forwarded as-is, so serialize it once for all subscribers
+    ggl_sub_respond_many(matched, matched_len, gg_obj_map(params));
+
     ggl_respond(handle, GG_OBJ_NULL);
     return GG_ERR_OK;
 }
@@ -443,13 +443,29 @@ static GgError write_script_with_replacement(
     return GG_ERR_OK;
 }
 
-static GgError get_system_config_error_cb(
+/// Values recipe-runner exports to the component's environment. Unset values
+/// are empty; set values are null-terminated.
+typedef struct {
+    GgBuffer root_ca_path;
+    GgBuffer thing_name;
+    GgBuffer root_path;
+    GgBuffer aws_region;
+    GgBuffer proxy_url;
+    GgBuffer no_proxy;
+    GgBuffer tes_port;
+} RunnerEnvironment;
+
+static const char *env_str(GgBuffer value) {
+    return (value.len == 0) ? "" : (const char *) value.data;
+}
+
+static GgError get_runner_environment_error_cb(
     void *ctx, GgBuffer error_code, GgBuffer message
 ) {
     (void) ctx;
 
     GG_LOGE(
-        "Received PrivateGetSystemConfig error %.*s: %.*s.",
+        "Received PrivateGetRunnerEnvironment error %.*s: %.*s.",
         (int) error_code.len,
         error_code.data,
         (int) message.len,
@@ -459,48 +475,83 @@ static GgError get_system_config_error_cb(
     return GG_ERR_FAILURE;
 }
 
-static GgError get_system_config_result_cb(void *ctx, GgMap result) {
-    GgBuffer *resp_buf = ctx;
+static GgError claim_env_value(
+    GgObject *value, GgArena *alloc, GgBuffer *result
+) {
+    *result = (GgBuffer) { 0 };
+    if (value == NULL) {
+        return GG_ERR_OK;
+    }
+    GgBuffer val_buf = gg_obj_into_buf(*value);
+    uint8_t *mem = GG_ARENA_ALLOCN(alloc, uint8_t, val_buf.len + 1);
+    if (mem == NULL) {
+        GG_LOGE("Insufficent memory provided for response.");
+        return GG_ERR_NOMEM;
+    }
+    memcpy(mem, val_buf.data, val_buf.len);
+    mem[val_buf.len] = '\0';
+    *result = (GgBuffer) { .data = mem, .len = val_buf.len };
+    return GG_ERR_OK;
+}
 
-    GgObject *value;
+static GgError get_runner_environment_result_cb(void *ctx, GgMap result) {
+    RunnerEnvironment *env = ctx;
+
+    GgObject *root_ca_path;
+    GgObject *thing_name;
+    GgObject *root_path;
+    GgObject *aws_region;
+    GgObject *proxy_url;
+    GgObject *no_proxy;
+    GgObject *tes_port;
     GgError ret = gg_map_validate(
         result,
-        GG_MAP_SCHEMA({ GG_STR("value"), GG_REQUIRED, GG_TYPE_NULL, &value })
+        GG_MAP_SCHEMA(
+            { GG_STR("rootCaPath"), GG_OPTIONAL, GG_TYPE_BUF, &root_ca_path },
+            { GG_STR("thingName"), GG_OPTIONAL, GG_TYPE_BUF, &thing_name },
+            { GG_STR("rootPath"), GG_OPTIONAL, GG_TYPE_BUF, &root_path },
+            { GG_STR("awsRegion"), GG_OPTIONAL, GG_TYPE_BUF, &aws_region },
+            { GG_STR("proxyUrl"), GG_OPTIONAL, GG_TYPE_BUF, &proxy_url },
+            { GG_STR("noProxyAddresses"),
+              GG_OPTIONAL,
+              GG_TYPE_BUF,
+              &no_proxy },
+            { GG_STR("tesPort"), GG_OPTIONAL, GG_TYPE_BUF, &tes_port },
+        )
     );
     if (ret != GG_ERR_OK) {
         GG_LOGE("Failed validating server response.");
         return GG_ERR_INVALID;
     }
 
-    if (gg_obj_type(*value) != GG_TYPE_BUF) {
-        GG_LOGE("Config value is not a string.");
-        return GG_ERR_FAILURE;
-    }
-
-    if (resp_buf != NULL) {
-        GgBuffer val_buf = gg_obj_into_buf(*value);
+    static uint8_t env_mem[4 * PATH_MAX];
+    GgArena alloc = gg_arena_init(GG_BUF(env_mem));
 
-        GgArena alloc = gg_arena_init(*resp_buf);
-        ret = gg_arena_claim_buf(&val_buf, &alloc);
+    GgObject *values[] = { root_ca_path, thing_name, root_path, aws_region,
+                           proxy_url,    no_proxy,   tes_port };
+    GgBuffer *fields[] = { &env->root_ca_path, &env->thing_name,
+                           &env->root_path,    &env->aws_region,
+                           &env->proxy_url,    &env->no_proxy,
+                           &env->tes_port };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        ret = claim_env_value(values[i], &alloc, fields[i]);
         if (ret != GG_ERR_OK) {
-            GG_LOGE("Insufficent memory provided for response.");
             return ret;
         }
-
-        *resp_buf = val_buf;
     }
 
     return GG_ERR_OK;
 }
 
-static GgError get_system_config(GgBuffer key, GgBuffer *value) {
+/// Fetches the whole runner environment in a single IPC round trip.
+static GgError get_runner_environment(RunnerEnvironment *env) {
     return ggipc_call(
-        GG_STR("aws.greengrass.private#GetSystemConfig"),
-        GG_STR("aws.greengrass.private#GetSystemConfigRequest"),
-        GG_MAP(gg_kv(GG_STR("key"), gg_obj_buf(key))),
-        &get_system_config_result_cb,
-        &get_system_config_error_cb,
-        value
+        GG_STR("aws.greengrass.private#GetRunnerEnvironment"),
+        GG_STR("aws.greengrass.private#GetRunnerEnvironmentRequest"),
+        (GgMap) { 0 },
+        &get_runner_environment_result_cb,
+        &get_runner_environment_error_cb,
+        env
     );
 }
 
@@ -567,42 +618,32 @@ GgError runner(const RecipeRunnerArgs *args) {
         GG_LOGE("setenv failed: %d.", errno);
     }
 
-    static uint8_t resp_mem[PATH_MAX];
+    RunnerEnvironment env = { 0 };
+    ret = get_runner_environment(&env);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to get the runner environment.");
+        return ret;
+    }
 
-    GgBuffer resp = GG_BUF(resp_mem);
-    resp.len -= 1;
-    ret = get_system_config(GG_STR("rootCaPath"), &resp);
-    if (ret != GG_ERR_OK || resp.len == 0) {
+    if (env.root_ca_path.len == 0) {
         GG_LOGW("rootCaPath not available; GG_ROOT_CA_PATH will be empty.");
-        resp.len = 0;
     }
-    resp_mem[resp.len] = '\0';
     // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    sys_ret = setenv("GG_ROOT_CA_PATH", (char *) resp_mem, true);
+    sys_ret = setenv("GG_ROOT_CA_PATH", env_str(env.root_ca_path), true);
     if (sys_ret != 0) {
         GG_LOGE("setenv failed: %d.", errno);
     }
 
-    resp = GG_BUF(resp_mem);
-    resp.len -= 1;
-    ret = ggipc_get_config_str(
-        GG_BUF_LIST(GG_STR("awsRegion")),
-        &GG_STR("aws.greengrass.NucleusLite"),
-        &resp
-    );
-
-    if (ret != GG_ERR_OK || resp.len == 0) {
+    if (env.aws_region.len == 0) {
         GG_LOGW("awsRegion not available; AWS_REGION will be empty.");
-        resp.len = 0;
     }
-    resp_mem[resp.len] = '\0';
     // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    sys_ret = setenv("AWS_REGION", (char *) resp_mem, true);
+    sys_ret = setenv("AWS_REGION", env_str(env.aws_region), true);
     if (sys_ret != 0) {
         GG_LOGE("setenv failed: %d.", errno);
     }
     // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    sys_ret = setenv("AWS_DEFAULT_REGION", (char *) resp_mem, true);
+    sys_ret = setenv("AWS_DEFAULT_REGION", env_str(env.aws_region), true);
     if (sys_ret != 0) {
         GG_LOGE("setenv failed: %d.", errno);
     }
@@ -613,96 +654,46 @@ GgError runner(const RecipeRunnerArgs *args) {
         GG_LOGE("setenv failed: %d.", errno);
     }
 
-    resp = GG_BUF(resp_mem);
-    resp.len -= 1;
-    ret = ggipc_get_config_str(
-        GG_BUF_LIST(GG_STR("networkProxy"), GG_STR("proxy"), GG_STR("url")),
-        &GG_STR("aws.greengrass.NucleusLite"),
-        &resp
-    );
-    switch (ret) {
-    case GG_ERR_NOMEM:
-        GG_LOGE(
-            "Failed to get network proxy url from config - value longer than supported."
-        );
-        return ret;
-    case GG_ERR_NOENTRY:
+    if (env.proxy_url.len == 0) {
         GG_LOGD("No network proxy set.");
-        break;
-    case GG_ERR_OK: {
-        if (resp.len == 0) {
-            GG_LOGD("Network proxy URL is empty.");
-            break;
-        }
-        resp_mem[resp.len] = '\0';
+    } else {
+        const char *proxy_url = env_str(env.proxy_url);
         // NOLINTBEGIN(concurrency-mt-unsafe)
-        setenv("all_proxy", (char *) resp_mem, true);
-        setenv("ALL_PROXY", (char *) resp_mem, true);
-        setenv("http_proxy", (char *) resp_mem, true);
-        setenv("HTTP_PROXY", (char *) resp_mem, true);
-        setenv("https_proxy", (char *) resp_mem, true);
-        setenv("HTTPS_PROXY", (char *) resp_mem, true);
+        setenv("all_proxy", proxy_url, true);
+        setenv("ALL_PROXY", proxy_url, true);
+        setenv("http_proxy", proxy_url, true);
+        setenv("HTTP_PROXY", proxy_url, true);
+        setenv("https_proxy", proxy_url, true);
+        setenv("HTTPS_PROXY", proxy_url, true);
         // NOLINTEND(concurrency-mt-unsafe)
-        break;
-    }
-    default:
-        GG_LOGE("Failed to get proxy url from config. Error: %d.", ret);
-        return ret;
     }
 
-    resp = GG_BUF(resp_mem);
-    resp.len -= 1;
-    ret = ggipc_get_config_str(
-        GG_BUF_LIST(GG_STR("networkProxy"), GG_STR("noProxyAddresses")),
-        &GG_STR("aws.greengrass.NucleusLite"),
-        &resp
-    );
-    switch (ret) {
-    case GG_ERR_NOMEM:
-        GG_LOGE(
-            "Failed to get network proxy url from config - value longer than supported."
-        );
-        return ret;
-    case GG_ERR_NOENTRY:
-        GG_LOGD("No network proxy set.");
-        break;
-    case GG_ERR_OK: {
-        if (resp.len == 0) {
-            GG_LOGD("Network proxy noProxyAddresses is empty.");
-            break;
-        }
-        resp_mem[resp.len] = '\0';
+    if (env.no_proxy.len == 0) {
+        GG_LOGD("Network proxy noProxyAddresses is empty.");
+    } else {
         // NOLINTNEXTLINE(concurrency-mt-unsafe)
-        setenv("no_proxy", (char *) resp_mem, true);
+        setenv("no_proxy", env_str(env.no_proxy), true);
         // NOLINTNEXTLINE(concurrency-mt-unsafe)
-        setenv("NO_PROXY", (char *) resp_mem, true);
-        break;
-    }
-    default:
-        GG_LOGE("Failed to get proxy url from config. Error: %d.", ret);
-        return ret;
+        setenv("NO_PROXY", env_str(env.no_proxy), true);
     }
 
-    static uint8_t thing_name_mem[MAX_THING_NAME_LEN + 1];
-    GgBuffer thing_name = GG_BUF(thing_name_mem);
-    thing_name.len -= 1;
-    ret = get_system_config(GG_STR("thingName"), &thing_name);
-    if (ret != GG_ERR_OK) {
+    GgBuffer thing_name = env.thing_name;
+    if (thing_name.len == 0) {
         GG_LOGW("thingName not available; AWS_IOT_THING_NAME will be empty.");
-        thing_name.len = 0;
+    } else if (thing_name.len > MAX_THING_NAME_LEN) {
+        GG_LOGE("thingName is longer than supported.");
+        return GG_ERR_NOMEM;
     }
-    thing_name_mem[thing_name.len] = '\0';
     // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    sys_ret = setenv("AWS_IOT_THING_NAME", (char *) thing_name_mem, true);
+    sys_ret = setenv("AWS_IOT_THING_NAME", env_str(thing_name), true);
     if (sys_ret != 0) {
         GG_LOGE("setenv failed: %d.", errno);
     }
 
-    GgBuffer root_path = GG_BUF(resp_mem);
-    ret = get_system_config(GG_STR("rootPath"), &root_path);
-    if (ret != GG_ERR_OK) {
+    GgBuffer root_path = env.root_path;
+    if (root_path.len == 0) {
         GG_LOGE("Failed to get root path from config.");
-        return ret;
+        return GG_ERR_CONFIG;
     }
 
     int root_path_fd;
@@ -751,20 +742,17 @@ GgError runner(const RecipeRunnerArgs *args) {
                 GG_LOGE("Failed to append http://localhost:");
                 return ret;
             }
-            GgBuffer rest = gg_byte_vec_remaining_capacity(resp_vec);
-
-            ret = ggipc_get_config_str(
-                GG_BUF_LIST(GG_STR("port")),
-                &GG_STR("aws.greengrass.TokenExchangeService"),
-                &rest
-            );
-            if (ret != GG_ERR_OK) {
+            if (env.tes_port.len == 0) {
                 GG_LOGE(
                     "Failed to get port for TES server from config. Possible reason, TES server might not have started yet."
                 );
+                return GG_ERR_NOENTRY;
+            }
+            ret = gg_byte_vec_append(&resp_vec, env.tes_port);
+            if (ret != GG_ERR_OK) {
+                GG_LOGE("Failed to append TES port.");
                 return ret;
             }
-            resp_vec.buf.len += rest.len;
             ret = gg_byte_vec_append(
                 &resp_vec, GG_STR("/2016-11-01/credentialprovider/\0")
             );
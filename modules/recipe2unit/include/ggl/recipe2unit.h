@@ -15,6 +15,8 @@ typedef struct {
     bool has_install;
     bool has_run_startup;
     bool has_bootstrap;
+    /// Set if any unit file was written because its contents changed.
+    bool units_changed;
 } HasPhase;
 
 typedef struct {
@@ -34,7 +36,9 @@ typedef struct {
 /// @param[out] recipe_obj The object containing the recipe in a map format
 /// @param[out] component_name The name of the component as provided by the
 /// recipe
-/// @param[out] existing_phases Status of which phases are present
+/// @param[out] existing_phases Status of which phases are present and whether
+/// any unit file changed. Unit files whose contents are unchanged are not
+/// rewritten.
 /// @return GG_ERR_OK on success. Failure otherwise.
 GgError convert_to_unit(
     Recipe2UnitArgs *args,
@@ -44,4 +48,18 @@ GgError convert_to_unit(
     HasPhase *existing_phases
 );
 
+/// @brief Converts the recipes of several components, spread across worker
+/// threads. Units only depend on each component's recipe and configuration,
+/// so components are converted independently.
+/// @param[in] args Recipe2Unit arguments shared by all components; the
+/// component name and version are taken from #components.
+/// @param[in] components Map of component names to version buffers
+/// @param[out] existing_phases Array of components.len entries, set as by
+/// convert_to_unit for the component at the same index
+/// @return GG_ERR_OK if all components were converted. Otherwise the first
+/// failure; remaining components may not have been converted.
+GgError convert_to_units(
+    const Recipe2UnitArgs *args, GgMap components, HasPhase *existing_phases
+);
+
 #endif
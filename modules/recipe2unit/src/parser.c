@@ -12,25 +12,34 @@
 #include <gg/error.h>
 #include <gg/file.h>
 #include <gg/log.h>
+#include <gg/map.h>
 #include <gg/object.h>
 #include <gg/types.h>
 #include <gg/vector.h>
+#include <ggl/nucleus/constants.h>
 #include <ggl/recipe.h>
 #include <ggl/recipe2unit.h>
+#include <pthread.h>
 #include <string.h>
+#include <unistd.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define MAX_UNIT_FILE_BUF_SIZE 2048
 #define MAX_COMPONENT_FILE_NAME 1024
+/// Upper bound on threads generating units concurrently.
+#define CONVERT_MAX_WORKERS 4
 
 static GgError create_unit_file(
     Recipe2UnitArgs *args,
     GgObject **component_name,
     PhaseSelection phase,
-    GgBuffer *response_buffer
+    GgBuffer *response_buffer,
+    bool *changed
 ) {
-    static uint8_t file_name_array[MAX_COMPONENT_FILE_NAME];
+    uint8_t file_name_array[MAX_COMPONENT_FILE_NAME];
     GgBuffer file_name_buffer = (GgBuffer
     ) { .data = (uint8_t *) file_name_array, .len = MAX_COMPONENT_FILE_NAME };
 
@@ -60,6 +69,20 @@ static GgError create_unit_file(
         return ret;
     }
 
+    // Leave identical units untouched so they need no reload or restart. One
+    // byte larger than any unit so a longer file never compares equal.
+    uint8_t existing_mem[MAX_UNIT_FILE_BUF_SIZE + 1];
+    GgBuffer existing = GG_BUF(existing_mem);
+    ret = gg_file_read_path(file_name_vector.buf, &existing);
+    if ((ret == GG_ERR_OK) && gg_buffer_eq(existing, *response_buffer)) {
+        GG_LOGD(
+            "Unit file %.*s is unchanged.",
+            (int) file_name_vector.buf.len - 1,
+            file_name_vector.buf.data
+        );
+        return GG_ERR_OK;
+    }
+
     int fd = -1;
     ret = gg_file_open(
         file_name_vector.buf, O_WRONLY | O_CREAT | O_TRUNC, 0644, &fd
@@ -76,9 +99,28 @@ static GgError create_unit_file(
         GG_LOGE("Failed to write to the unit file.");
         return GG_ERR_FAILURE;
     }
+    *changed = true;
     return GG_ERR_OK;
 }
 
+/// Generates a phase's unit into unit_file. Returns GG_ERR_NOENTRY if the
+/// recipe does not have the phase.
+static GgError generate_phase_unit(
+    Recipe2UnitArgs *args,
+    GgMap recipe,
+    GgObject **component_name,
+    PhaseSelection phase,
+    GgBuffer *unit_file
+) {
+    GgError ret
+        = generate_systemd_unit(recipe, unit_file, args, component_name, phase);
+    if ((ret == GG_ERR_OK) && (*component_name == NULL)) {
+        GG_LOGE("Component name was NULL");
+        return GG_ERR_FAILURE;
+    }
+    return ret;
+}
+
 GgError convert_to_unit(
     Recipe2UnitArgs *args,
     GgArena *alloc,
@@ -105,108 +147,162 @@ GgError convert_to_unit(
         GG_LOGE("No recipe found");
         return ret;
     }
+    GgMap recipe = gg_obj_into_map(*recipe_obj);
 
+    // Generate all units before touching any files, so a recipe that fails
+    // for one phase leaves the previous units in place.
     // Note: currently, if we have both run and startup phases,
     // we will only select startup for the script and service file
-    static uint8_t unit_file_buffer[MAX_UNIT_FILE_BUF_SIZE];
-
-    GgBuffer bootstrap_response_buffer = GG_BUF(unit_file_buffer);
-    bootstrap_response_buffer.len = MAX_UNIT_FILE_BUF_SIZE;
-
-    GG_LOGD("Attempting to find bootstrap phase from recipe");
-    ret = generate_systemd_unit(
-        gg_obj_into_map(*recipe_obj),
-        &bootstrap_response_buffer,
-        args,
-        component_name,
-        BOOTSTRAP
-    );
-    if (*component_name == NULL) {
-        GG_LOGE("Component name was NULL");
-        return GG_ERR_FAILURE;
-    }
+    uint8_t unit_file_mem[3][MAX_UNIT_FILE_BUF_SIZE];
+    const PhaseSelection phases[] = { BOOTSTRAP, INSTALL, RUN_STARTUP };
+    bool *has_phase[] = { &existing_phases->has_bootstrap,
+                          &existing_phases->has_install,
+                          &existing_phases->has_run_startup };
+    const char *phase_names[] = { "bootstrap", "install", "run or startup" };
+    GgBuffer unit_files[3];
 
-    if (ret == GG_ERR_NOENTRY) {
-        GG_LOGD("No bootstrap phase present");
-
-    } else if (ret != GG_ERR_OK) {
-        return ret;
-    } else {
-        ret = create_unit_file(
-            args, component_name, BOOTSTRAP, &bootstrap_response_buffer
+    for (size_t i = 0; i < 3; i++) {
+        unit_files[i] = GG_BUF(unit_file_mem[i]);
+        ret = generate_phase_unit(
+            args, recipe, component_name, phases[i], &unit_files[i]
         );
+        if (ret == GG_ERR_NOENTRY) {
+            GG_LOGD("No %s phase present", phase_names[i]);
+            continue;
+        }
         if (ret != GG_ERR_OK) {
-            GG_LOGE("Failed to create the bootstrap unit file.");
             return ret;
         }
-        existing_phases->has_bootstrap = true;
+        *has_phase[i] = true;
     }
 
-    GgBuffer install_response_buffer = GG_BUF(unit_file_buffer);
-    install_response_buffer.len = MAX_UNIT_FILE_BUF_SIZE;
-
-    GgMap recipe = gg_obj_into_map(*recipe_obj);
+    if (existing_phases->has_bootstrap == false
+        && existing_phases->has_install == false
+        && existing_phases->has_run_startup == false) {
+        GG_LOGE(
+            "Recipes without at least 1 valid lifecycle step aren't currently supported by Greengrass nucleus lite"
+        );
 
-    GG_LOGD("Attempting to find install phase from recipe");
-    ret = generate_systemd_unit(
-        recipe, &install_response_buffer, args, component_name, INSTALL
-    );
-    if (*component_name == NULL) {
-        GG_LOGE("Component name was NULL");
-        return GG_ERR_FAILURE;
+        GG_LOGW(
+            "Note that in Greengrass nucleus lite, keys are case sensitive. Check the recipe reference for the correct casing."
+        );
+        return GG_ERR_INVALID;
     }
 
-    if (ret == GG_ERR_NOENTRY) {
-        GG_LOGD("No Install phase present");
-
-    } else if (ret != GG_ERR_OK) {
+    ret = prepare_working_dir(recipe, args);
+    if (ret != GG_ERR_OK) {
         return ret;
-    } else {
+    }
+
+    for (size_t i = 0; i < 3; i++) {
+        if (!*has_phase[i]) {
+            continue;
+        }
         ret = create_unit_file(
-            args, component_name, INSTALL, &install_response_buffer
+            args,
+            component_name,
+            phases[i],
+            &unit_files[i],
+            &existing_phases->units_changed
         );
         if (ret != GG_ERR_OK) {
-            GG_LOGE("Failed to create the install unit file.");
+            GG_LOGE("Failed to create the %s unit file.", phase_names[i]);
             return ret;
         }
-        existing_phases->has_install = true;
     }
 
-    GgBuffer run_startup_response_buffer = GG_BUF(unit_file_buffer);
-    run_startup_response_buffer.len = MAX_UNIT_FILE_BUF_SIZE;
+    return GG_ERR_OK;
+}
 
-    GG_LOGD("Attempting to find run phase from recipe");
-    ret = generate_systemd_unit(
-        recipe, &run_startup_response_buffer, args, component_name, RUN_STARTUP
-    );
-    if (ret == GG_ERR_NOENTRY) {
-        GG_LOGD("Neither run nor startup phase present");
-    } else if (ret != GG_ERR_OK) {
-        return ret;
-    } else {
-        ret = create_unit_file(
-            args, component_name, RUN_STARTUP, &run_startup_response_buffer
+typedef struct {
+    const Recipe2UnitArgs *args;
+    GgMap components;
+    HasPhase *phases;
+    atomic_size_t next_component;
+    atomic_int err;
+} ConvertUnitsCtx;
+
+static void convert_units_set_error(ConvertUnitsCtx *ctx, GgError err) {
+    int expected = GG_ERR_OK;
+    atomic_compare_exchange_strong(&ctx->err, &expected, (int) err);
+}
+
+/// Converts components claimed from the shared index until none remain.
+static void *convert_units_worker(void *arg) {
+    ConvertUnitsCtx *ctx = arg;
+    Recipe2UnitArgs args = *ctx->args;
+    uint8_t recipe_mem[GGL_COMPONENT_RECIPE_MAX_LEN];
+
+    while (atomic_load(&ctx->err) == GG_ERR_OK) {
+        size_t i = atomic_fetch_add(&ctx->next_component, 1);
+        if (i >= ctx->components.len) {
+            break;
+        }
+        GgKV *component = &ctx->components.pairs[i];
+        if (gg_obj_type(*gg_kv_val(component)) != GG_TYPE_BUF) {
+            convert_units_set_error(ctx, GG_ERR_INVALID);
+            break;
+        }
+        args.component_name = gg_kv_key(*component);
+        args.component_version = gg_obj_into_buf(*gg_kv_val(component));
+
+        GgArena alloc = gg_arena_init(GG_BUF(recipe_mem));
+        GgObject recipe_obj;
+        GgObject *component_name;
+        ctx->phases[i] = (HasPhase) { 0 };
+        GgError ret = convert_to_unit(
+            &args, &alloc, &recipe_obj, &component_name, &ctx->phases[i]
         );
         if (ret != GG_ERR_OK) {
-            GG_LOGE("Failed to create the run or startup unit file.");
-            return ret;
+            GG_LOGE(
+                "Failed to generate units for %.*s.",
+                (int) args.component_name.len,
+                args.component_name.data
+            );
+            convert_units_set_error(ctx, ret);
         }
-        GG_LOGD("Created run or startup unit file.");
-        existing_phases->has_run_startup = true;
     }
+    return NULL;
+}
 
-    if (existing_phases->has_bootstrap == false
-        && existing_phases->has_install == false
-        && existing_phases->has_run_startup == false) {
-        GG_LOGE(
-            "Recipes without at least 1 valid lifecycle step aren't currently supported by Greengrass nucleus lite"
-        );
+static size_t convert_units_worker_count(size_t components) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t workers = (cpus > 0) ? (size_t) cpus : 1;
+    if (workers > CONVERT_MAX_WORKERS) {
+        workers = CONVERT_MAX_WORKERS;
+    }
+    if (workers > components) {
+        workers = components;
+    }
+    return (workers == 0) ? 1 : workers;
+}
 
-        GG_LOGW(
-            "Note that in Greengrass nucleus lite, keys are case sensitive. Check the recipe reference for the correct casing."
-        );
-        return GG_ERR_INVALID;
+GgError convert_to_units(
+    const Recipe2UnitArgs *args, GgMap components, HasPhase *existing_phases
+) {
+    ConvertUnitsCtx ctx = { .args = args,
+                            .components = components,
+                            .phases = existing_phases };
+    atomic_init(&ctx.next_component, 0);
+    atomic_init(&ctx.err, GG_ERR_OK);
+
+    // The calling thread is also a worker.
+    pthread_t threads[CONVERT_MAX_WORKERS];
+    size_t started = 0;
+    size_t workers = convert_units_worker_count(components.len);
+    for (; started + 1 < workers; started++) {
+        if (pthread_create(
+                &threads[started], NULL, convert_units_worker, &ctx
+            )
+            != 0) {
+            GG_LOGW("Failed to start unit worker; continuing with fewer.");
+            break;
+        }
+    }
+    convert_units_worker(&ctx);
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
     }
 
-    return GG_ERR_OK;
+    return (GgError) atomic_load(&ctx.err);
 }
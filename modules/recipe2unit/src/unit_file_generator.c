@@ -604,7 +604,8 @@ static GgError manifest_builder(
     }
 
     GgBuffer selected_script = { 0 };
-    GgBuffer timeout = { 0 };
+    uint8_t timeout_mem[32];
+    GgBuffer timeout = GG_BUF(timeout_mem);
     ret = fetch_script_section(
         selected_lifecycle_map,
         lifecycle_script_selection,
@@ -679,13 +680,13 @@ static GgError fill_service_section(
         return ret;
     }
 
-    static uint8_t working_dir_buf[PATH_MAX - 1];
+    uint8_t working_dir_buf[PATH_MAX - 1];
     GgByteVec working_dir_vec = GG_BYTE_VEC(working_dir_buf);
 
-    static uint8_t exec_start_section_buf[2 * WORKING_DIR_LEN];
+    uint8_t exec_start_section_buf[2 * WORKING_DIR_LEN];
     GgByteVec exec_start_section_vec = GG_BYTE_VEC(exec_start_section_buf);
 
-    static uint8_t script_name_prefix_buf[PATH_MAX];
+    uint8_t script_name_prefix_buf[PATH_MAX];
     GgByteVec script_name_prefix_vec = GG_BYTE_VEC(script_name_prefix_buf);
     ret = gg_byte_vec_append(&script_name_prefix_vec, GG_STR("ggl."));
 
@@ -714,6 +715,41 @@ static GgError fill_service_section(
         return ret;
     }
 
+    // Add Env Var for GG_root path
+    ret = gg_byte_vec_append(
+        out,
+        GG_STR(
+            "Environment=\"AWS_GG_NUCLEUS_DOMAIN_SOCKET_FILEPATH_FOR_COMPONENT="
+        )
+    );
+    gg_byte_vec_chain_append(
+        &ret, out, gg_buffer_from_null_term(args->root_dir)
+    );
+    gg_byte_vec_chain_append(&ret, out, GG_STR("/gg-ipc.socket"));
+    gg_byte_vec_chain_append(&ret, out, GG_STR("\"\n"));
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    ret = manifest_builder(
+        recipe_map, out, exec_start_section_vec, args, phase
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    return GG_ERR_OK;
+}
+
+GgError prepare_working_dir(GgMap recipe_map, Recipe2UnitArgs *args) {
+    uint8_t working_dir_buf[PATH_MAX - 1];
+    GgByteVec working_dir_vec = GG_BYTE_VEC(working_dir_buf);
+    GgError ret = concat_working_dir_vec(recipe_map, &working_dir_vec, args);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Working directory String prefix concat failed.");
+        return ret;
+    }
+
     // Create the working directory if not existant
     int working_dir;
     ret = gg_dir_open(working_dir_vec.buf, O_RDONLY, true, &working_dir);
@@ -724,7 +760,7 @@ static GgError fill_service_section(
     GG_CLEANUP(cleanup_close, working_dir);
 
     struct passwd user_info_mem;
-    static char user_info_buf[2000];
+    char user_info_buf[2000];
     struct passwd *user_info = NULL;
     int sys_ret = getpwnam_r(
         args->user,
@@ -769,29 +805,6 @@ static GgError fill_service_section(
         return GG_ERR_FAILURE;
     }
 
-    // Add Env Var for GG_root path
-    ret = gg_byte_vec_append(
-        out,
-        GG_STR(
-            "Environment=\"AWS_GG_NUCLEUS_DOMAIN_SOCKET_FILEPATH_FOR_COMPONENT="
-        )
-    );
-    gg_byte_vec_chain_append(
-        &ret, out, gg_buffer_from_null_term(args->root_dir)
-    );
-    gg_byte_vec_chain_append(&ret, out, GG_STR("/gg-ipc.socket"));
-    gg_byte_vec_chain_append(&ret, out, GG_STR("\"\n"));
-    if (ret != GG_ERR_OK) {
-        return ret;
-    }
-
-    ret = manifest_builder(
-        recipe_map, out, exec_start_section_vec, args, phase
-    );
-    if (ret != GG_ERR_OK) {
-        return ret;
-    }
-
     return GG_ERR_OK;
 }
 
@@ -15,6 +15,8 @@ typedef enum {
     BOOTSTRAP
 } PhaseSelection;
 
+/// Generates the unit file for a phase. Only reads the recipe and
+/// configuration; files are left to the caller.
 GgError generate_systemd_unit(
     GgMap recipe_map,
     GgBuffer *unit_file_buffer,
@@ -23,4 +25,7 @@ GgError generate_systemd_unit(
     PhaseSelection phase
 );
 
+/// Creates the component's working directory, owned by the run-as user.
+GgError prepare_working_dir(GgMap recipe_map, Recipe2UnitArgs *args);
+
 #endif
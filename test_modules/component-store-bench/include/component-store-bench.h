@@ -0,0 +1,16 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef COMPONENT_STORE_BENCH_H
+#define COMPONENT_STORE_BENCH_H
+
+#include <gg/error.h>
+#include <stdint.h>
+
+/// Populates a recipe directory in work_dir with sample recipes and times
+/// resolving a version of each component, both by scanning the directory and
+/// through the component index.
+GgError run_component_store_bench(char *work_dir, uint32_t iterations);
+
+#endif
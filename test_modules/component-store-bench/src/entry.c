@@ -0,0 +1,248 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "component_index.h"
+#include "component_store.h"
+#include <component-store-bench.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/file.h>
+#include <gg/log.h>
+#include <gg/types.h>
+#include <ggl/semver.h>
+#include <limits.h>
+#include <time.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Shape of the sample store: 500 recipes as 10 versions of 50 components.
+#define COMPONENTS 50U
+#define VERSIONS_PER_COMPONENT 10U
+
+static GgBuffer format_buf(char *buf, size_t size, int len) {
+    if ((len < 0) || ((size_t) len >= size)) {
+        return (GgBuffer) { 0 };
+    }
+    return (GgBuffer) { .data = (uint8_t *) buf, .len = (size_t) len };
+}
+
+static GgBuffer component_name(char *buf, size_t size, uint32_t component) {
+    return format_buf(
+        buf,
+        size,
+        snprintf(buf, size, "com.example.Component%02u", component)
+    );
+}
+
+// Selects versions up to 1.<n>.0, where n varies by component.
+static GgBuffer component_requirement(
+    char *buf, size_t size, uint32_t component
+) {
+    return format_buf(
+        buf,
+        size,
+        snprintf(
+            buf,
+            size,
+            ">=1.0.0 <=1.%u.0",
+            component % VERSIONS_PER_COMPONENT
+        )
+    );
+}
+
+static GgError populate_recipes(int recipe_dir_fd) {
+    for (uint32_t component = 0; component < COMPONENTS; component++) {
+        for (uint32_t version = 0; version < VERSIONS_PER_COMPONENT;
+             version++) {
+            char name[64];
+            GgBuffer file_name = format_buf(
+                name,
+                sizeof(name),
+                snprintf(
+                    name,
+                    sizeof(name),
+                    "com.example.Component%02u-1.%u.0.json",
+                    component,
+                    version
+                )
+            );
+            int fd;
+            GgError ret = gg_file_openat(
+                recipe_dir_fd,
+                file_name,
+                O_CREAT | O_WRONLY | O_TRUNC,
+                (mode_t) 0644,
+                &fd
+            );
+            if (ret != GG_ERR_OK) {
+                GG_LOGE("Failed to create recipe %s.", name);
+                return ret;
+            }
+            GG_CLEANUP(cleanup_close, fd);
+            ret = gg_file_write(fd, GG_STR("{}"));
+            if (ret != GG_ERR_OK) {
+                return ret;
+            }
+        }
+    }
+    return GG_ERR_OK;
+}
+
+/// Resolves a version by reading the whole directory, as done before the
+/// component index existed.
+static GgError scan_for_component(
+    int recipe_dir_fd, GgBuffer name, GgBuffer requirement
+) {
+    int dir_fd;
+    GgError ret
+        = gg_dir_openat(recipe_dir_fd, GG_STR("."), O_RDONLY, false, &dir_fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    DIR *dir = fdopendir(dir_fd);
+    if (dir == NULL) {
+        (void) gg_close(dir_fd);
+        return GG_ERR_FAILURE;
+    }
+    GG_CLEANUP(cleanup_closedir, dir);
+
+    uint8_t name_mem[NAME_MAX];
+    uint8_t version_mem[NAME_MAX];
+    struct dirent *entry = NULL;
+    while (true) {
+        GgBuffer found_name = GG_BUF(name_mem);
+        GgBuffer found_version = GG_BUF(version_mem);
+        ret = iterate_over_components(dir, &found_name, &found_version, &entry);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        if (gg_buffer_eq(name, found_name)
+            && is_in_range(found_version, requirement)) {
+            return GG_ERR_OK;
+        }
+    }
+}
+
+static GgError resolve_all(int recipe_dir_fd, bool indexed) {
+    if (indexed) {
+        component_index_invalidate();
+        GgError ret = component_index_refresh(recipe_dir_fd);
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Failed to build component index.");
+            return ret;
+        }
+    }
+
+    for (uint32_t component = 0; component < COMPONENTS; component++) {
+        char name_mem[64];
+        char requirement_mem[64];
+        GgBuffer name = component_name(name_mem, sizeof(name_mem), component);
+        GgBuffer requirement = component_requirement(
+            requirement_mem, sizeof(requirement_mem), component
+        );
+        GgError ret;
+        if (indexed) {
+            GglSemverRange range;
+            ret = ggl_semver_range_compile(requirement, &range);
+            if (ret == GG_ERR_OK) {
+                ret = component_index_refresh(recipe_dir_fd);
+            }
+            if (ret == GG_ERR_OK) {
+                GgBuffer version;
+                ret = component_index_find(name, &range, &version);
+            }
+        } else {
+            ret = scan_for_component(recipe_dir_fd, name, requirement);
+        }
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Failed to resolve %s.", name_mem);
+            return ret;
+        }
+    }
+    return GG_ERR_OK;
+}
+
+static double elapsed_ms(struct timespec start, struct timespec end) {
+    return ((double) (end.tv_sec - start.tv_sec) * 1000.0)
+        + ((double) (end.tv_nsec - start.tv_nsec) / 1000000.0);
+}
+
+static GgError time_resolution(
+    int recipe_dir_fd, bool indexed, uint32_t iterations
+) {
+    const char *label = indexed ? "Indexed" : "Scan";
+    double total_ms = 0.0;
+    double min_ms = 0.0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        struct timespec start;
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        GgError ret = resolve_all(recipe_dir_fd, indexed);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+
+        double ms = elapsed_ms(start, end);
+        printf("%s iteration %u: %.3f ms\n", label, i, ms);
+        total_ms += ms;
+        if ((i == 0) || (ms < min_ms)) {
+            min_ms = ms;
+        }
+    }
+
+    if (iterations > 0) {
+        printf(
+            "%s: min %.3f ms, mean %.3f ms over %u iterations.\n",
+            label,
+            min_ms,
+            total_ms / iterations,
+            iterations
+        );
+    }
+    return GG_ERR_OK;
+}
+
+GgError run_component_store_bench(char *work_dir, uint32_t iterations) {
+    int work_fd;
+    GgError ret = gg_dir_open(
+        gg_buffer_from_null_term(work_dir), O_PATH, true, &work_fd
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to open work directory %s.", work_dir);
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, work_fd);
+
+    int recipe_dir_fd;
+    ret = gg_dir_openat(
+        work_fd, GG_STR("recipes"), O_RDONLY, true, &recipe_dir_fd
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to open recipe directory.");
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, recipe_dir_fd);
+
+    ret = populate_recipes(recipe_dir_fd);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    printf(
+        "Store: %u recipes, resolving %u components per iteration.\n",
+        COMPONENTS * VERSIONS_PER_COMPONENT,
+        COMPONENTS
+    );
+
+    ret = time_resolution(recipe_dir_fd, false, iterations);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    return time_resolution(recipe_dir_fd, true, iterations);
+}
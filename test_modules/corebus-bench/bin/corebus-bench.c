@@ -0,0 +1,20 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <corebus-bench.h>
+#include <gg/error.h>
+#include <ggl/nucleus/init.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+    ggl_nucleus_init();
+
+    uint32_t iterations
+        = (argc < 2) ? 10000 : (uint32_t) strtoul(argv[1], NULL, 10);
+    GgError ret = run_corebus_bench(iterations);
+    if (ret != GG_ERR_OK) {
+        return 1;
+    }
+}
@@ -0,0 +1,17 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef COREBUS_BENCH_H
+#define COREBUS_BENCH_H
+
+#include <gg/error.h>
+#include <stdint.h>
+
+/// Times core-bus calls, subscription fan-out, and message encoding against
+/// an in-process server, and ggconfigd and ggpubsubd operations if those are
+/// running. Results are printed to stdout as one JSON object; benchmarks of
+/// daemons that are not running are null.
+GgError run_corebus_bench(uint32_t iterations);
+
+#endif
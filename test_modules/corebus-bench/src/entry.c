@@ -0,0 +1,544 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "object_serde.h"
+#include <corebus-bench.h>
+#include <gg/arena.h>
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/eventstream/encode.h>
+#include <gg/eventstream/types.h>
+#include <gg/json_encode.h>
+#include <gg/log.h>
+#include <gg/map.h>
+#include <gg/object.h>
+#include <gg/types.h>
+#include <gg/utils.h>
+#include <gg/vector.h>
+#include <ggl/core_bus/client.h>
+#include <ggl/core_bus/constants.h>
+#include <ggl/core_bus/gg_config.h>
+#include <ggl/core_bus/server.h>
+#include <pthread.h>
+#include <time.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_INTERFACE "corebus_bench"
+#define BENCH_TOPIC "corebus-bench/topic"
+
+// Payload size of calls, fan-out messages and publishes.
+#define PAYLOAD_LEN 256U
+
+#define MAX_SAMPLES 100000U
+
+// Fan-out shape: each message is sent to every subscriber.
+#define FANOUT_SUBSCRIBERS 16U
+#define FANOUT_MESSAGES 1000U
+
+// ggconfigd writes go to its database, so fewer are timed.
+#define MAX_CONFIG_OPS 1000U
+
+// Time allowed for all subscription messages of a run to arrive.
+#define RECEIVE_TIMEOUT_SECONDS 30
+
+static uint8_t payload_mem[PAYLOAD_LEN];
+static uint64_t samples[MAX_SAMPLES];
+
+static pthread_mutex_t stream_mtx = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t stream_handles[FANOUT_SUBSCRIBERS];
+static size_t stream_handles_len = 0;
+
+// Counts messages received on subscriptions.
+static pthread_mutex_t received_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t received_cond = PTHREAD_COND_INITIALIZER;
+static size_t received = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000U) + (uint64_t) now.tv_nsec;
+}
+
+static double per_second(size_t count, uint64_t elapsed_ns) {
+    if (elapsed_ns == 0) {
+        return 0.0;
+    }
+    return (double) count * 1e9 / (double) elapsed_ns;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static GgError rpc_echo(void *ctx, GgMap params, uint32_t handle) {
+    (void) ctx;
+    ggl_respond(handle, gg_obj_map(params));
+    return GG_ERR_OK;
+}
+
+static void stream_close(void *ctx, uint32_t handle) {
+    (void) ctx;
+    GG_MTX_SCOPE_GUARD(&stream_mtx);
+    for (size_t i = 0; i < stream_handles_len; i++) {
+        if (stream_handles[i] == handle) {
+            stream_handles[i] = stream_handles[stream_handles_len - 1];
+            stream_handles_len -= 1;
+            return;
+        }
+    }
+}
+
+static GgError rpc_stream(void *ctx, GgMap params, uint32_t handle) {
+    (void) ctx;
+    (void) params;
+    GG_MTX_SCOPE_GUARD(&stream_mtx);
+    if (stream_handles_len == FANOUT_SUBSCRIBERS) {
+        return GG_ERR_NOMEM;
+    }
+    ggl_sub_accept(handle, stream_close, NULL);
+    stream_handles[stream_handles_len] = handle;
+    stream_handles_len += 1;
+    return GG_ERR_OK;
+}
+
+/// Sends `count` messages to every open stream subscription.
+static GgError rpc_fire(void *ctx, GgMap params, uint32_t handle) {
+    (void) ctx;
+    GgObject *count_obj;
+    GgError ret = gg_map_validate(
+        params,
+        GG_MAP_SCHEMA({ GG_STR("count"), GG_REQUIRED, GG_TYPE_I64, &count_obj })
+    );
+    if (ret != GG_ERR_OK) {
+        return GG_ERR_INVALID;
+    }
+    int64_t count = gg_obj_into_i64(*count_obj);
+
+    uint32_t handles[FANOUT_SUBSCRIBERS];
+    size_t handles_len;
+    {
+        GG_MTX_SCOPE_GUARD(&stream_mtx);
+        handles_len = stream_handles_len;
+        for (size_t i = 0; i < handles_len; i++) {
+            handles[i] = stream_handles[i];
+        }
+    }
+
+    GgObject message = gg_obj_map(
+        GG_MAP(gg_kv(GG_STR("payload"), gg_obj_buf(GG_BUF(payload_mem))))
+    );
+    for (int64_t i = 0; i < count; i++) {
+        ggl_sub_respond_many(handles, handles_len, message);
+    }
+
+    ggl_respond(handle, GG_OBJ_NULL);
+    return GG_ERR_OK;
+}
+
+static void *server_thread(void *ctx) {
+    (void) ctx;
+    GglRpcMethodDesc handlers[] = {
+        { GG_STR("echo"), false, rpc_echo, NULL },
+        { GG_STR("stream"), true, rpc_stream, NULL },
+        { GG_STR("fire"), false, rpc_fire, NULL },
+    };
+    size_t handlers_len = sizeof(handlers) / sizeof(handlers[0]);
+
+    GgError ret = ggl_listen(GG_STR(BENCH_INTERFACE), handlers, handlers_len);
+    GG_LOGE("Benchmark server exited with error %u.", (unsigned) ret);
+    return NULL;
+}
+
+static GgError count_received(void *ctx, uint32_t handle, GgObject data) {
+    (void) ctx;
+    (void) handle;
+    (void) data;
+    GG_MTX_SCOPE_GUARD(&received_mtx);
+    received += 1;
+    pthread_cond_broadcast(&received_cond);
+    return GG_ERR_OK;
+}
+
+static void reset_received(void) {
+    GG_MTX_SCOPE_GUARD(&received_mtx);
+    received = 0;
+}
+
+static GgError wait_received(size_t expected) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += RECEIVE_TIMEOUT_SECONDS;
+
+    GG_MTX_SCOPE_GUARD(&received_mtx);
+    while (received < expected) {
+        if (pthread_cond_timedwait(&received_cond, &received_mtx, &deadline)
+            != 0) {
+            GG_LOGE(
+                "Received %zu of %zu subscription messages.",
+                received,
+                expected
+            );
+            return GG_ERR_TIMEOUT;
+        }
+    }
+    return GG_ERR_OK;
+}
+
+static GgError echo_call(void) {
+    uint8_t resp_mem[PAYLOAD_LEN + 64U];
+    GgArena alloc = gg_arena_init(GG_BUF(resp_mem));
+    GgObject result;
+    return ggl_call(
+        GG_STR(BENCH_INTERFACE),
+        GG_STR("echo"),
+        GG_MAP(gg_kv(GG_STR("payload"), gg_obj_buf(GG_BUF(payload_mem)))),
+        NULL,
+        &alloc,
+        &result
+    );
+}
+
+static GgError start_server(void) {
+    pthread_t ptid;
+    if (pthread_create(&ptid, NULL, server_thread, NULL) != 0) {
+        GG_LOGE("Failed to start benchmark server thread.");
+        return GG_ERR_FAILURE;
+    }
+    pthread_detach(ptid);
+
+    // Clients retry connecting while the server starts listening
+    for (int i = 0; i < 100; i++) {
+        if (echo_call() == GG_ERR_OK) {
+            return GG_ERR_OK;
+        }
+        (void) gg_sleep_ms(10);
+    }
+    GG_LOGE("Benchmark server did not start.");
+    return GG_ERR_FAILURE;
+}
+
+static GgError bench_call(uint32_t iterations, GgKV *result) {
+    size_t count = (iterations < MAX_SAMPLES) ? iterations : MAX_SAMPLES;
+    if (count == 0) {
+        return GG_ERR_INVALID;
+    }
+    for (size_t i = 0; i < count; i++) {
+        uint64_t start = now_ns();
+        GgError ret = echo_call();
+        samples[i] = now_ns() - start;
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Benchmark call failed.");
+            return ret;
+        }
+    }
+    qsort(samples, count, sizeof(samples[0]), compare_u64);
+
+    static GgKV call_kvs[4];
+    call_kvs[0] = gg_kv(GG_STR("calls"), gg_obj_i64((int64_t) count));
+    call_kvs[1] = gg_kv(
+        GG_STR("p50_us"), gg_obj_f64((double) samples[count / 2] / 1e3)
+    );
+    call_kvs[2] = gg_kv(
+        GG_STR("p99_us"),
+        gg_obj_f64((double) samples[(count * 99U) / 100U] / 1e3)
+    );
+    call_kvs[3] = gg_kv(
+        GG_STR("max_us"), gg_obj_f64((double) samples[count - 1] / 1e3)
+    );
+    *result = gg_kv(
+        GG_STR("call"), gg_obj_map((GgMap) { .pairs = call_kvs, .len = 4 })
+    );
+    return GG_ERR_OK;
+}
+
+static GgError bench_fanout(GgKV *result) {
+    uint32_t handles[FANOUT_SUBSCRIBERS] = { 0 };
+    GgError ret = GG_ERR_OK;
+    for (size_t i = 0; (ret == GG_ERR_OK) && (i < FANOUT_SUBSCRIBERS); i++) {
+        ret = ggl_subscribe(
+            GG_STR(BENCH_INTERFACE),
+            GG_STR("stream"),
+            GG_MAP(),
+            count_received,
+            NULL,
+            NULL,
+            NULL,
+            &handles[i]
+        );
+    }
+
+    uint64_t elapsed_ns = 0;
+    if (ret == GG_ERR_OK) {
+        reset_received();
+        uint64_t start = now_ns();
+        ret = ggl_call(
+            GG_STR(BENCH_INTERFACE),
+            GG_STR("fire"),
+            GG_MAP(gg_kv(GG_STR("count"), gg_obj_i64(FANOUT_MESSAGES))),
+            NULL,
+            NULL,
+            NULL
+        );
+        if (ret == GG_ERR_OK) {
+            ret = wait_received(FANOUT_SUBSCRIBERS * FANOUT_MESSAGES);
+        }
+        elapsed_ns = now_ns() - start;
+    }
+
+    for (size_t i = 0; i < FANOUT_SUBSCRIBERS; i++) {
+        if (handles[i] != 0) {
+            ggl_client_sub_close(handles[i]);
+        }
+    }
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Fan-out benchmark failed.");
+        return ret;
+    }
+
+    static GgKV fanout_kvs[3];
+    fanout_kvs[0]
+        = gg_kv(GG_STR("subscribers"), gg_obj_i64(FANOUT_SUBSCRIBERS));
+    fanout_kvs[1] = gg_kv(GG_STR("messages"), gg_obj_i64(FANOUT_MESSAGES));
+    fanout_kvs[2] = gg_kv(
+        GG_STR("deliveries_per_sec"),
+        gg_obj_f64(
+            per_second(FANOUT_SUBSCRIBERS * FANOUT_MESSAGES, elapsed_ns)
+        )
+    );
+    *result = gg_kv(
+        GG_STR("fanout"), gg_obj_map((GgMap) { .pairs = fanout_kvs, .len = 3 })
+    );
+    return GG_ERR_OK;
+}
+
+/// Times encoding a publish-shaped message as core-bus does for each send.
+static GgError bench_serialize(uint32_t iterations, GgKV *result) {
+    GgObject obj = gg_obj_map(GG_MAP(
+        gg_kv(GG_STR("topic"), gg_obj_buf(GG_STR(BENCH_TOPIC))),
+        gg_kv(GG_STR("type"), gg_obj_buf(GG_STR("json"))),
+        gg_kv(
+            GG_STR("message"),
+            gg_obj_map(GG_MAP(
+                gg_kv(GG_STR("payload"), gg_obj_buf(GG_BUF(payload_mem))),
+                gg_kv(
+                    GG_STR("values"),
+                    gg_obj_list(GG_LIST(
+                        gg_obj_i64(1), gg_obj_i64(2), gg_obj_f64(3.5)
+                    ))
+                ),
+                gg_kv(GG_STR("ok"), gg_obj_bool(true))
+            ))
+        )
+    ));
+    EventStreamHeader headers[] = {
+        { GG_STR("method"),
+          { EVENTSTREAM_STRING, .string = GG_STR("publish") } },
+        { GG_STR("type"), { EVENTSTREAM_INT32, .int32 = 1 } },
+    };
+    static uint8_t encode_mem[GGL_COREBUS_MAX_MSG_LEN];
+
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        GgBuffer buf = GG_BUF(encode_mem);
+        GgError ret = ggl_serialize(obj, &buf);
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    uint64_t serialize_ns = now_ns() - start;
+
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        GgBuffer buf = GG_BUF(encode_mem);
+        GgError ret = eventstream_encode(
+            &buf,
+            headers,
+            sizeof(headers) / sizeof(headers[0]),
+            ggl_serialize_reader(&obj)
+        );
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+    uint64_t encode_ns = now_ns() - start;
+
+    static GgKV serialize_kvs[2];
+    serialize_kvs[0] = gg_kv(
+        GG_STR("ggl_serialize_ns"),
+        gg_obj_f64((double) serialize_ns / (double) iterations)
+    );
+    serialize_kvs[1] = gg_kv(
+        GG_STR("eventstream_encode_ns"),
+        gg_obj_f64((double) encode_ns / (double) iterations)
+    );
+    *result = gg_kv(
+        GG_STR("serialize"),
+        gg_obj_map((GgMap) { .pairs = serialize_kvs, .len = 2 })
+    );
+    return GG_ERR_OK;
+}
+
+#define BENCH_CONFIG_KEY \
+    GG_BUF_LIST( \
+        GG_STR("services"), \
+        GG_STR("corebus-bench"), \
+        GG_STR("configuration"), \
+        GG_STR("value") \
+    )
+
+/// Null if ggconfigd is not running.
+static void bench_ggconfigd(uint32_t iterations, GgKV *result) {
+    *result = gg_kv(GG_STR("ggconfigd"), GG_OBJ_NULL);
+    uint32_t count = (iterations < MAX_CONFIG_OPS) ? iterations
+                                                   : MAX_CONFIG_OPS;
+
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < count; i++) {
+        GgError ret
+            = ggl_gg_config_write(BENCH_CONFIG_KEY, gg_obj_i64(i), NULL);
+        if (ret != GG_ERR_OK) {
+            GG_LOGW("ggconfigd not available; skipping its benchmark.");
+            return;
+        }
+    }
+    uint64_t write_ns = now_ns() - start;
+
+    start = now_ns();
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t mem[64];
+        GgArena alloc = gg_arena_init(GG_BUF(mem));
+        GgObject value;
+        GgError ret = ggl_gg_config_read(BENCH_CONFIG_KEY, &alloc, &value);
+        if (ret != GG_ERR_OK) {
+            GG_LOGW("ggconfigd read failed; skipping its benchmark.");
+            return;
+        }
+    }
+    uint64_t read_ns = now_ns() - start;
+
+    (void) ggl_gg_config_delete(
+        GG_BUF_LIST(GG_STR("services"), GG_STR("corebus-bench"))
+    );
+
+    static GgKV config_kvs[2];
+    config_kvs[0] = gg_kv(
+        GG_STR("read_ops_per_sec"), gg_obj_f64(per_second(count, read_ns))
+    );
+    config_kvs[1] = gg_kv(
+        GG_STR("write_ops_per_sec"), gg_obj_f64(per_second(count, write_ns))
+    );
+    *gg_kv_val(result)
+        = gg_obj_map((GgMap) { .pairs = config_kvs, .len = 2 });
+}
+
+/// Null if ggpubsubd is not running.
+/// Counts a publish once its message reaches a local subscriber.
+static void bench_ggpubsubd(uint32_t iterations, GgKV *result) {
+    *result = gg_kv(GG_STR("ggpubsubd"), GG_OBJ_NULL);
+    size_t count = (iterations < MAX_SAMPLES) ? iterations : MAX_SAMPLES;
+
+    uint32_t handle = 0;
+    GgError ret = ggl_subscribe(
+        GG_STR("gg_pubsub"),
+        GG_STR("subscribe"),
+        GG_MAP(gg_kv(GG_STR("topic_filter"), gg_obj_buf(GG_STR(BENCH_TOPIC)))),
+        count_received,
+        NULL,
+        NULL,
+        NULL,
+        &handle
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGW("ggpubsubd not available; skipping its benchmark.");
+        return;
+    }
+    GG_CLEANUP(cleanup_ggl_client_sub_close, handle);
+
+    reset_received();
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < count; i++) {
+        ret = ggl_call(
+            GG_STR("gg_pubsub"),
+            GG_STR("publish"),
+            GG_MAP(
+                gg_kv(GG_STR("topic"), gg_obj_buf(GG_STR(BENCH_TOPIC))),
+                gg_kv(GG_STR("type"), gg_obj_buf(GG_STR("base64"))),
+                gg_kv(GG_STR("message"), gg_obj_buf(GG_BUF(payload_mem)))
+            ),
+            NULL,
+            NULL,
+            NULL
+        );
+        if (ret != GG_ERR_OK) {
+            GG_LOGW("ggpubsubd publish failed; skipping its benchmark.");
+            return;
+        }
+    }
+    if (wait_received(count) != GG_ERR_OK) {
+        return;
+    }
+    uint64_t elapsed_ns = now_ns() - start;
+
+    static GgKV pubsub_kvs[1];
+    pubsub_kvs[0] = gg_kv(
+        GG_STR("publish_per_sec"), gg_obj_f64(per_second(count, elapsed_ns))
+    );
+    *gg_kv_val(result)
+        = gg_obj_map((GgMap) { .pairs = pubsub_kvs, .len = 1 });
+}
+
+GgError run_corebus_bench(uint32_t iterations) {
+    if (iterations == 0) {
+        GG_LOGE("Iterations must be positive.");
+        return GG_ERR_INVALID;
+    }
+    for (size_t i = 0; i < sizeof(payload_mem); i++) {
+        payload_mem[i] = (uint8_t) ('a' + (i % 26U));
+    }
+
+    GgError ret = start_server();
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    GgKV results[7];
+    results[0] = gg_kv(GG_STR("version"), gg_obj_buf(GG_STR(GGL_VERSION)));
+    results[1] = gg_kv(GG_STR("iterations"), gg_obj_i64(iterations));
+
+    ret = bench_call(iterations, &results[2]);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = bench_fanout(&results[3]);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = bench_serialize(iterations, &results[4]);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Serialization benchmark failed.");
+        return ret;
+    }
+    bench_ggconfigd(iterations, &results[5]);
+    bench_ggpubsubd(iterations, &results[6]);
+
+    static uint8_t json_mem[4096];
+    GgByteVec json = GG_BYTE_VEC(json_mem);
+    ret = gg_json_encode(
+        gg_obj_map((GgMap) { .pairs = results, .len = 7 }),
+        gg_byte_vec_writer(&json)
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to encode results.");
+        return ret;
+    }
+    printf("%.*s\n", (int) json.buf.len, json.buf.data);
+    return GG_ERR_OK;
+}
@@ -0,0 +1,151 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <argp.h>
+#include <errno.h>
+#include <gg/error.h>
+#include <ggl/nucleus/init.h>
+#include <ipc-loadgen.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static char doc[]
+    = "ipc-loadgen -- IPC load generator and latency profiler for ggipcd";
+
+static struct argp_option opts[] = {
+    { "socket", 's', "path", 0, "GG IPC socket path", 0 },
+    { "svcuid", 'u', "token", 0, "SVCUID to authenticate with", 0 },
+    { "component", 'n', "name", 0, "Component to authenticate as", 0 },
+    { "operation",
+      'o',
+      "op",
+      0,
+      "publish, subscribe, get-config, or iot-publish (default publish)",
+      0 },
+    { "connections", 'c', "count", 0, "IPC connections (default 1)", 0 },
+    { "payload", 'p', "bytes", 0, "Message payload size (default 256)", 0 },
+    { "rate",
+      'r',
+      "per-sec",
+      0,
+      "Requests per second per connection; 0 for closed loop (default 0)",
+      0 },
+    { "duration", 'd', "seconds", 0, "Run time (default 10)", 0 },
+    { "topic", 't', "topic", 0, "Topic prefix (default ipc-loadgen)", 0 },
+    { "key-path", 'k', "path", 0, "Slash-separated GetConfiguration key", 0 },
+    { "qos", 'q', "qos", 0, "PublishToIoTCore QoS (default 0)", 0 },
+    { "mqtt-stand-in",
+      'm',
+      0,
+      0,
+      "Serve aws_iot_mqtt in-process; iotcored must be stopped",
+      0 },
+    { 0 },
+};
+
+static error_t parse_u32(char *arg, struct argp_state *state, uint32_t *out) {
+    char *end;
+    unsigned long value = strtoul(arg, &end, 10);
+    if ((*arg == '\0') || (*end != '\0') || (value > UINT32_MAX)) {
+        argp_error(state, "invalid number: %s", arg);
+        return EINVAL;
+    }
+    *out = (uint32_t) value;
+    return 0;
+}
+
+static error_t parse_operation(
+    char *arg, struct argp_state *state, IpcLoadgenOperation *out
+) {
+    if (strcmp(arg, "publish") == 0) {
+        *out = IPC_LOADGEN_PUBLISH;
+    } else if (strcmp(arg, "subscribe") == 0) {
+        *out = IPC_LOADGEN_SUBSCRIBE;
+    } else if (strcmp(arg, "get-config") == 0) {
+        *out = IPC_LOADGEN_GET_CONFIG;
+    } else if (strcmp(arg, "iot-publish") == 0) {
+        *out = IPC_LOADGEN_IOT_PUBLISH;
+    } else {
+        argp_error(state, "unknown operation: %s", arg);
+        return EINVAL;
+    }
+    return 0;
+}
+
+static error_t arg_parser(int key, char *arg, struct argp_state *state) {
+    IpcLoadgenArgs *args = state->input;
+    uint32_t qos;
+    error_t ret;
+    switch (key) {
+    case 's':
+        args->socket_path = arg;
+        break;
+    case 'u':
+        args->svcuid = arg;
+        break;
+    case 'n':
+        args->component_name = arg;
+        break;
+    case 'o':
+        return parse_operation(arg, state, &args->operation);
+    case 'c':
+        return parse_u32(arg, state, &args->connections);
+    case 'p':
+        return parse_u32(arg, state, &args->payload_len);
+    case 'r':
+        return parse_u32(arg, state, &args->rate);
+    case 'd':
+        return parse_u32(arg, state, &args->duration_s);
+    case 't':
+        args->topic = arg;
+        break;
+    case 'k':
+        args->key_path = arg;
+        break;
+    case 'q':
+        ret = parse_u32(arg, state, &qos);
+        if ((ret == 0) && (qos > 2)) {
+            argp_error(state, "qos must be 0, 1, or 2");
+            return EINVAL;
+        }
+        args->qos = (uint8_t) qos;
+        return ret;
+    case 'm':
+        args->mqtt_stand_in = true;
+        break;
+    case ARGP_KEY_END:
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static struct argp argp = { opts, arg_parser, 0, doc, 0, 0, 0 };
+
+int main(int argc, char **argv) {
+    // Components started by the nucleus are given these in their environment.
+    // NOLINTBEGIN(concurrency-mt-unsafe)
+    IpcLoadgenArgs args = {
+        .socket_path
+        = getenv("AWS_GG_NUCLEUS_DOMAIN_SOCKET_FILEPATH_FOR_COMPONENT"),
+        .svcuid = getenv("SVCUID"),
+        .operation = IPC_LOADGEN_PUBLISH,
+        .connections = 1,
+        .payload_len = 256,
+        .duration_s = 10,
+        .topic = "ipc-loadgen",
+    };
+
+    argp_parse(&argp, argc, argv, 0, 0, &args);
+    // NOLINTEND(concurrency-mt-unsafe)
+
+    ggl_nucleus_init();
+
+    GgError ret = run_ipc_loadgen(&args);
+    if (ret != GG_ERR_OK) {
+        return 1;
+    }
+}
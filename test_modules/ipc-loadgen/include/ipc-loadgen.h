@@ -0,0 +1,48 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef IPC_LOADGEN_H
+#define IPC_LOADGEN_H
+
+#include <gg/error.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    /// PublishToTopic with a binary message.
+    IPC_LOADGEN_PUBLISH,
+    /// PublishToTopic to a topic the same connection is subscribed to; also
+    /// times delivery of each message to the subscriber.
+    IPC_LOADGEN_SUBSCRIBE,
+    /// GetConfiguration of `key_path`.
+    IPC_LOADGEN_GET_CONFIG,
+    /// PublishToIoTCore with a binary payload.
+    IPC_LOADGEN_IOT_PUBLISH,
+} IpcLoadgenOperation;
+
+typedef struct {
+    char *socket_path;
+    char *svcuid;
+    char *component_name;
+    IpcLoadgenOperation operation;
+    /// Number of IPC connections, each driven by its own threads.
+    uint32_t connections;
+    uint32_t payload_len;
+    /// Requests per second per connection; 0 sends each request once the
+    /// previous one is answered.
+    uint32_t rate;
+    uint32_t duration_s;
+    char *topic;
+    /// Slash-separated; empty reads the whole component configuration.
+    char *key_path;
+    uint8_t qos;
+    /// Serve aws_iot_mqtt publishes in-process instead of iotcored.
+    bool mqtt_stand_in;
+} IpcLoadgenArgs;
+
+/// Drives ggipcd with the configured load and prints per-operation latency
+/// histograms to stdout as one JSON object.
+GgError run_ipc_loadgen(const IpcLoadgenArgs *args);
+
+#endif
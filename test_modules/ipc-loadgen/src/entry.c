@@ -0,0 +1,770 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "histogram.h"
+#include "ipc_conn.h"
+#include <errno.h>
+#include <gg/arena.h>
+#include <gg/base64.h>
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/eventstream/rpc.h>
+#include <gg/eventstream/types.h>
+#include <gg/ipc/limits.h>
+#include <gg/json_decode.h>
+#include <gg/json_encode.h>
+#include <gg/log.h>
+#include <gg/map.h>
+#include <gg/object.h>
+#include <gg/types.h>
+#include <gg/utils.h>
+#include <gg/vector.h>
+#include <ggl/core_bus/client.h>
+#include <ggl/core_bus/server.h>
+#include <ipc-loadgen.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_CONNECTIONS 64U
+
+// Base64 of the largest payload still fits in one IPC message.
+#define MAX_PAYLOAD_LEN 4096U
+
+// Requests in flight per connection in open-loop mode. Sends are delayed once
+// this many are unanswered; their latency still counts from the scheduled
+// send time.
+#define WINDOW 1024U
+
+#define MAX_KEY_PATH_LEN 16U
+
+// Time allowed after the run for outstanding requests to be answered.
+#define DRAIN_TIMEOUT_SECONDS 10
+
+// The connection subscribes on the first stream; requests use the rest.
+#define SUBSCRIBE_STREAM_ID 1
+
+typedef struct {
+    size_t index;
+    int fd;
+    pthread_t sender;
+    pthread_t receiver;
+    uint8_t send_mem[GG_IPC_MAX_MSG_LEN];
+    uint8_t recv_mem[GG_IPC_MAX_MSG_LEN];
+    uint8_t topic_mem[256];
+    GgBuffer topic;
+
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    // Send time of each unanswered request by stream id; 0 if the slot is
+    // free.
+    uint64_t sent_at[WINDOW];
+    size_t outstanding;
+    uint64_t sent;
+    uint64_t completed;
+    uint64_t delivered;
+    uint64_t errors;
+    uint64_t last_response_ns;
+    bool closed;
+    LatencyHistogram response;
+    LatencyHistogram delivery;
+} LoadConn;
+
+static const IpcLoadgenArgs *config;
+static uint64_t start_ns;
+
+static LoadConn conns[MAX_CONNECTIONS];
+
+static uint8_t payload_mem[MAX_PAYLOAD_LEN];
+static GgBuffer payload;
+static uint8_t payload_b64_mem[((MAX_PAYLOAD_LEN + 2U) / 3U) * 4U];
+static GgBuffer payload_b64;
+
+static GgObject key_path_mem[MAX_KEY_PATH_LEN];
+static GgList key_path;
+
+static uint64_t now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000U) + (uint64_t) now.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t deadline) {
+    struct timespec ts = {
+        .tv_sec = (time_t) (deadline / 1000000000U),
+        .tv_nsec = (long) (deadline % 1000000000U),
+    };
+    int ret;
+    do {
+        ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    } while (ret == EINTR);
+}
+
+static GgBuffer operation_name(void) {
+    switch (config->operation) {
+    case IPC_LOADGEN_PUBLISH:
+    case IPC_LOADGEN_SUBSCRIBE:
+        return GG_STR("PublishToTopic");
+    case IPC_LOADGEN_GET_CONFIG:
+        return GG_STR("GetConfiguration");
+    case IPC_LOADGEN_IOT_PUBLISH:
+        return GG_STR("PublishToIoTCore");
+    }
+    return GG_STR("");
+}
+
+static GgError build_key_path(void) {
+    key_path = (GgList) { .items = key_path_mem, .len = 0 };
+    if (config->key_path == NULL) {
+        return GG_ERR_OK;
+    }
+    GgBuffer rest = gg_buffer_from_null_term(config->key_path);
+    while (rest.len > 0) {
+        size_t len = 0;
+        while ((len < rest.len) && (rest.data[len] != '/')) {
+            len++;
+        }
+        if (len > 0) {
+            if (key_path.len == MAX_KEY_PATH_LEN) {
+                GG_LOGE("Key path has too many components.");
+                return GG_ERR_RANGE;
+            }
+            key_path_mem[key_path.len]
+                = gg_obj_buf(gg_buffer_substr(rest, 0, len));
+            key_path.len += 1;
+        }
+        if (len == rest.len) {
+            break;
+        }
+        rest = gg_buffer_substr(rest, len + 1, rest.len);
+    }
+    return GG_ERR_OK;
+}
+
+static GgError send_request(
+    LoadConn *conn, int32_t stream_id, uint64_t send_ns
+) {
+    GgBuffer buf = GG_BUF(conn->send_mem);
+    GgBuffer operation = GG_STR("aws.greengrass#PublishToTopic");
+    GgMap params;
+
+    switch (config->operation) {
+    case IPC_LOADGEN_PUBLISH:
+        params = GG_MAP(
+            gg_kv(GG_STR("topic"), gg_obj_buf(conn->topic)),
+            gg_kv(
+                GG_STR("publishMessage"),
+                gg_obj_map(GG_MAP(gg_kv(
+                    GG_STR("binaryMessage"),
+                    gg_obj_map(GG_MAP(
+                        gg_kv(GG_STR("message"), gg_obj_buf(payload_b64))
+                    ))
+                )))
+            )
+        );
+        return ipc_conn_send(conn->fd, buf, stream_id, operation, params);
+    case IPC_LOADGEN_SUBSCRIBE:
+        // The send time is carried in the message to time its delivery.
+        params = GG_MAP(
+            gg_kv(GG_STR("topic"), gg_obj_buf(conn->topic)),
+            gg_kv(
+                GG_STR("publishMessage"),
+                gg_obj_map(GG_MAP(gg_kv(
+                    GG_STR("jsonMessage"),
+                    gg_obj_map(GG_MAP(gg_kv(
+                        GG_STR("message"),
+                        gg_obj_map(GG_MAP(
+                            gg_kv(
+                                GG_STR("sent_ns"),
+                                gg_obj_i64((int64_t) send_ns)
+                            ),
+                            gg_kv(GG_STR("padding"), gg_obj_buf(payload))
+                        ))
+                    )))
+                )))
+            )
+        );
+        return ipc_conn_send(conn->fd, buf, stream_id, operation, params);
+    case IPC_LOADGEN_GET_CONFIG:
+        params = GG_MAP(gg_kv(GG_STR("keyPath"), gg_obj_list(key_path)));
+        return ipc_conn_send(
+            conn->fd,
+            buf,
+            stream_id,
+            GG_STR("aws.greengrass#GetConfiguration"),
+            params
+        );
+    case IPC_LOADGEN_IOT_PUBLISH:
+        params = GG_MAP(
+            gg_kv(GG_STR("topicName"), gg_obj_buf(conn->topic)),
+            gg_kv(GG_STR("payload"), gg_obj_buf(payload_b64)),
+            gg_kv(GG_STR("qos"), gg_obj_i64(config->qos))
+        );
+        return ipc_conn_send(
+            conn->fd,
+            buf,
+            stream_id,
+            GG_STR("aws.greengrass#PublishToIoTCore"),
+            params
+        );
+    }
+    return GG_ERR_INVALID;
+}
+
+static bool conn_drained(const LoadConn *conn) {
+    if (conn->outstanding > 0) {
+        return false;
+    }
+    return (config->operation != IPC_LOADGEN_SUBSCRIBE)
+        || (conn->delivered + conn->errors >= conn->sent);
+}
+
+static void *sender_thread(void *ctx) {
+    LoadConn *conn = ctx;
+    bool open_loop = config->rate > 0;
+    uint64_t period_ns = open_loop ? (1000000000U / config->rate) : 0;
+    uint64_t end_ns = start_ns + ((uint64_t) config->duration_s * 1000000000U);
+    int32_t stream_id = SUBSCRIBE_STREAM_ID;
+
+    for (uint64_t i = 0;; i++) {
+        uint64_t send_ns;
+        if (open_loop) {
+            send_ns = start_ns + (i * period_ns);
+            if (send_ns >= end_ns) {
+                break;
+            }
+            sleep_until_ns(send_ns);
+        } else {
+            if (now_ns() >= end_ns) {
+                break;
+            }
+        }
+
+        stream_id += 1;
+        size_t slot = (size_t) stream_id % WINDOW;
+        size_t limit = open_loop ? WINDOW : 1U;
+        {
+            GG_MTX_SCOPE_GUARD(&conn->mtx);
+            while (!conn->closed
+                   && ((conn->outstanding >= limit)
+                       || (conn->sent_at[slot] != 0))) {
+                pthread_cond_wait(&conn->cond, &conn->mtx);
+            }
+            if (conn->closed) {
+                break;
+            }
+            if (!open_loop) {
+                send_ns = now_ns();
+            }
+            conn->sent_at[slot] = send_ns;
+            conn->outstanding += 1;
+            conn->sent += 1;
+        }
+
+        GgError ret = send_request(conn, stream_id, send_ns);
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Connection %zu failed to send request.", conn->index);
+            break;
+        }
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += DRAIN_TIMEOUT_SECONDS;
+    {
+        GG_MTX_SCOPE_GUARD(&conn->mtx);
+        while (!conn->closed && !conn_drained(conn)) {
+            if (pthread_cond_timedwait(&conn->cond, &conn->mtx, &deadline)
+                != 0) {
+                GG_LOGW(
+                    "Connection %zu has %zu requests unanswered.",
+                    conn->index,
+                    conn->outstanding
+                );
+                break;
+            }
+        }
+    }
+
+    // Unblocks the receiver.
+    (void) shutdown(conn->fd, SHUT_RDWR);
+    return NULL;
+}
+
+static GgError delivery_sent_ns(GgBuffer json, uint64_t *sent_ns) {
+    uint8_t mem[512];
+    GgArena alloc = gg_arena_init(GG_BUF(mem));
+    GgObject obj;
+    GgError ret = gg_json_decode_destructive(json, &alloc, &obj);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    GgBuffer path[] = {
+        GG_STR("jsonMessage"),
+        GG_STR("message"),
+        GG_STR("sent_ns"),
+    };
+    for (size_t i = 0; i < sizeof(path) / sizeof(path[0]); i++) {
+        GgObject *next;
+        if ((gg_obj_type(obj) != GG_TYPE_MAP)
+            || !gg_map_get(gg_obj_into_map(obj), path[i], &next)) {
+            return GG_ERR_PARSE;
+        }
+        obj = *next;
+    }
+    if (gg_obj_type(obj) != GG_TYPE_I64) {
+        return GG_ERR_PARSE;
+    }
+    *sent_ns = (uint64_t) gg_obj_into_i64(obj);
+    return GG_ERR_OK;
+}
+
+static void handle_delivery(
+    LoadConn *conn,
+    const EventStreamMessage *msg,
+    EventStreamCommonHeaders common_headers,
+    uint64_t received_ns
+) {
+    uint64_t sent_ns = 0;
+    GgError ret = GG_ERR_FAILURE;
+    if (common_headers.message_type == EVENTSTREAM_APPLICATION_MESSAGE) {
+        ret = delivery_sent_ns(msg->payload, &sent_ns);
+    }
+
+    GG_MTX_SCOPE_GUARD(&conn->mtx);
+    if (ret != GG_ERR_OK) {
+        conn->errors += 1;
+    } else {
+        conn->delivered += 1;
+        latency_histogram_record(
+            &conn->delivery, (received_ns - sent_ns) / 1000U
+        );
+    }
+    pthread_cond_broadcast(&conn->cond);
+}
+
+static void handle_response(
+    LoadConn *conn,
+    EventStreamCommonHeaders common_headers,
+    uint64_t received_ns
+) {
+    size_t slot = (size_t) common_headers.stream_id % WINDOW;
+
+    GG_MTX_SCOPE_GUARD(&conn->mtx);
+    uint64_t sent_ns = conn->sent_at[slot];
+    if (sent_ns == 0) {
+        GG_LOGW(
+            "Connection %zu got response on unknown stream %d.",
+            conn->index,
+            common_headers.stream_id
+        );
+        return;
+    }
+    conn->sent_at[slot] = 0;
+    conn->outstanding -= 1;
+    conn->last_response_ns = received_ns;
+    if (common_headers.message_type == EVENTSTREAM_APPLICATION_MESSAGE) {
+        conn->completed += 1;
+        latency_histogram_record(
+            &conn->response, (received_ns - sent_ns) / 1000U
+        );
+    } else {
+        conn->errors += 1;
+    }
+    pthread_cond_broadcast(&conn->cond);
+}
+
+static void *receiver_thread(void *ctx) {
+    LoadConn *conn = ctx;
+
+    while (true) {
+        EventStreamMessage msg;
+        EventStreamCommonHeaders common_headers;
+        GgError ret = ipc_conn_recv(
+            conn->fd, GG_BUF(conn->recv_mem), &msg, &common_headers
+        );
+        if (ret != GG_ERR_OK) {
+            break;
+        }
+        uint64_t received_ns = now_ns();
+
+        if ((config->operation == IPC_LOADGEN_SUBSCRIBE)
+            && (common_headers.stream_id == SUBSCRIBE_STREAM_ID)) {
+            handle_delivery(conn, &msg, common_headers, received_ns);
+        } else {
+            handle_response(conn, common_headers, received_ns);
+        }
+    }
+
+    GG_MTX_SCOPE_GUARD(&conn->mtx);
+    conn->closed = true;
+    pthread_cond_broadcast(&conn->cond);
+    return NULL;
+}
+
+static GgError subscribe(LoadConn *conn) {
+    GgError ret = ipc_conn_send(
+        conn->fd,
+        GG_BUF(conn->send_mem),
+        SUBSCRIBE_STREAM_ID,
+        GG_STR("aws.greengrass#SubscribeToTopic"),
+        GG_MAP(gg_kv(GG_STR("topic"), gg_obj_buf(conn->topic)))
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    EventStreamMessage msg;
+    EventStreamCommonHeaders common_headers;
+    ret = ipc_conn_recv(
+        conn->fd, GG_BUF(conn->recv_mem), &msg, &common_headers
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    if (common_headers.message_type != EVENTSTREAM_APPLICATION_MESSAGE) {
+        GG_LOGE(
+            "SubscribeToTopic failed: %.*s",
+            (int) msg.payload.len,
+            msg.payload.data
+        );
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+static GgError open_conn(LoadConn *conn, size_t index) {
+    conn->index = index;
+    conn->fd = -1;
+    pthread_mutex_init(&conn->mtx, NULL);
+    pthread_cond_init(&conn->cond, NULL);
+
+    int len = snprintf(
+        (char *) conn->topic_mem,
+        sizeof(conn->topic_mem),
+        "%s/%zu",
+        config->topic,
+        index
+    );
+    if ((len < 0) || ((size_t) len >= sizeof(conn->topic_mem))) {
+        GG_LOGE("Topic is too long.");
+        return GG_ERR_RANGE;
+    }
+    conn->topic = (GgBuffer) { .data = conn->topic_mem, .len = (size_t) len };
+
+    GgError ret = ipc_conn_connect(
+        gg_buffer_from_null_term(config->socket_path),
+        (config->svcuid != NULL) ? gg_buffer_from_null_term(config->svcuid)
+                                 : GG_STR(""),
+        (config->component_name != NULL)
+            ? gg_buffer_from_null_term(config->component_name)
+            : GG_STR(""),
+        GG_BUF(conn->recv_mem),
+        &conn->fd
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    if (config->operation == IPC_LOADGEN_SUBSCRIBE) {
+        ret = subscribe(conn);
+        if (ret != GG_ERR_OK) {
+            (void) close(conn->fd);
+            conn->fd = -1;
+            return ret;
+        }
+    }
+    return GG_ERR_OK;
+}
+
+static GgError stand_in_publish(void *ctx, GgMap params, uint32_t handle) {
+    (void) ctx;
+    (void) params;
+    ggl_respond(handle, GG_OBJ_NULL);
+    return GG_ERR_OK;
+}
+
+static void *mqtt_stand_in_thread(void *ctx) {
+    (void) ctx;
+    GglRpcMethodDesc handlers[] = {
+        { GG_STR("publish"), false, stand_in_publish, NULL },
+    };
+    size_t handlers_len = sizeof(handlers) / sizeof(handlers[0]);
+
+    GgError ret = ggl_listen(GG_STR("aws_iot_mqtt"), handlers, handlers_len);
+    GG_LOGE("MQTT stand-in exited with error %u.", (unsigned) ret);
+    return NULL;
+}
+
+static GgError stand_in_call(void) {
+    return ggl_call(
+        GG_STR("aws_iot_mqtt"), GG_STR("publish"), GG_MAP(), NULL, NULL, NULL
+    );
+}
+
+/// Serves aws_iot_mqtt publishes in-process so that PublishToIoTCore can be
+/// timed through ggipcd without a broker.
+static GgError start_mqtt_stand_in(void) {
+    // iotcored rejects a publish without parameters; the stand-in accepts it.
+    if (stand_in_call() != GG_ERR_NOCONN) {
+        GG_LOGE("aws_iot_mqtt is already served; stop iotcored first.");
+        return GG_ERR_FAILURE;
+    }
+
+    pthread_t ptid;
+    if (pthread_create(&ptid, NULL, mqtt_stand_in_thread, NULL) != 0) {
+        GG_LOGE("Failed to start MQTT stand-in thread.");
+        return GG_ERR_FAILURE;
+    }
+    pthread_detach(ptid);
+
+    for (int i = 0; i < 100; i++) {
+        if (stand_in_call() == GG_ERR_OK) {
+            return GG_ERR_OK;
+        }
+        (void) gg_sleep_ms(10);
+    }
+    GG_LOGE("MQTT stand-in did not start.");
+    return GG_ERR_FAILURE;
+}
+
+static GgError validate_args(void) {
+    if (config->socket_path == NULL) {
+        GG_LOGE("IPC socket path is not set.");
+        return GG_ERR_INVALID;
+    }
+    if ((config->svcuid == NULL) && (config->component_name == NULL)) {
+        GG_LOGE("Either a svcuid or a component name is required.");
+        return GG_ERR_INVALID;
+    }
+    if ((config->connections == 0) || (config->connections > MAX_CONNECTIONS)) {
+        GG_LOGE("Connections must be between 1 and %u.", MAX_CONNECTIONS);
+        return GG_ERR_RANGE;
+    }
+    if (config->payload_len > MAX_PAYLOAD_LEN) {
+        GG_LOGE("Payload must be at most %u bytes.", MAX_PAYLOAD_LEN);
+        return GG_ERR_RANGE;
+    }
+    if ((config->rate > 1000000000U) || (config->duration_s == 0)) {
+        GG_LOGE("Invalid rate or duration.");
+        return GG_ERR_RANGE;
+    }
+    return GG_ERR_OK;
+}
+
+static GgError prepare_payload(void) {
+    for (size_t i = 0; i < config->payload_len; i++) {
+        payload_mem[i] = (uint8_t) ('a' + (i % 26U));
+    }
+    payload = (GgBuffer) { .data = payload_mem, .len = config->payload_len };
+
+    GgArena alloc = gg_arena_init(GG_BUF(payload_b64_mem));
+    return gg_base64_encode(payload, &alloc, &payload_b64);
+}
+
+// Each histogram is reported with its non-empty buckets.
+static GgObject histogram_obj(
+    const LatencyHistogram *hist,
+    GgKV (*kvs)[8],
+    GgObject (*buckets)[LATENCY_HISTOGRAM_BUCKETS],
+    GgKV (*bucket_kvs)[LATENCY_HISTOGRAM_BUCKETS][2]
+) {
+    size_t buckets_len = 0;
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        if (hist->counts[i] == 0) {
+            continue;
+        }
+        (*bucket_kvs)[buckets_len][0] = gg_kv(
+            GG_STR("le_us"),
+            gg_obj_i64((int64_t) latency_histogram_bucket_max(i))
+        );
+        (*bucket_kvs)[buckets_len][1]
+            = gg_kv(GG_STR("count"), gg_obj_i64((int64_t) hist->counts[i]));
+        (*buckets)[buckets_len] = gg_obj_map(
+            (GgMap) { .pairs = (*bucket_kvs)[buckets_len], .len = 2 }
+        );
+        buckets_len += 1;
+    }
+
+    double mean_us = (hist->total == 0)
+        ? 0.0
+        : (double) hist->sum_us / (double) hist->total;
+    (*kvs)[0] = gg_kv(GG_STR("count"), gg_obj_i64((int64_t) hist->total));
+    (*kvs)[1] = gg_kv(GG_STR("mean_us"), gg_obj_f64(mean_us));
+    (*kvs)[2] = gg_kv(
+        GG_STR("p50_us"),
+        gg_obj_i64((int64_t) latency_histogram_percentile(hist, 50.0))
+    );
+    (*kvs)[3] = gg_kv(
+        GG_STR("p90_us"),
+        gg_obj_i64((int64_t) latency_histogram_percentile(hist, 90.0))
+    );
+    (*kvs)[4] = gg_kv(
+        GG_STR("p99_us"),
+        gg_obj_i64((int64_t) latency_histogram_percentile(hist, 99.0))
+    );
+    (*kvs)[5] = gg_kv(
+        GG_STR("p999_us"),
+        gg_obj_i64((int64_t) latency_histogram_percentile(hist, 99.9))
+    );
+    (*kvs)[6] = gg_kv(GG_STR("max_us"), gg_obj_i64((int64_t) hist->max_us));
+    (*kvs)[7] = gg_kv(
+        GG_STR("buckets"),
+        gg_obj_list((GgList) { .items = *buckets, .len = buckets_len })
+    );
+    return gg_obj_map((GgMap) { .pairs = *kvs, .len = 8 });
+}
+
+static GgError print_results(uint64_t elapsed_ns) {
+    static LatencyHistogram response;
+    static LatencyHistogram delivery;
+    uint64_t sent = 0;
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    for (size_t i = 0; i < config->connections; i++) {
+        latency_histogram_merge(&response, &conns[i].response);
+        latency_histogram_merge(&delivery, &conns[i].delivery);
+        sent += conns[i].sent;
+        completed += conns[i].completed;
+        errors += conns[i].errors;
+    }
+
+    static GgKV hist_kvs[2][8];
+    static GgObject hist_buckets[2][LATENCY_HISTOGRAM_BUCKETS];
+    static GgKV hist_bucket_kvs[2][LATENCY_HISTOGRAM_BUCKETS][2];
+    GgKV latency[2];
+    size_t latency_len = 1;
+    latency[0] = gg_kv(
+        operation_name(),
+        histogram_obj(
+            &response, &hist_kvs[0], &hist_buckets[0], &hist_bucket_kvs[0]
+        )
+    );
+    if (config->operation == IPC_LOADGEN_SUBSCRIBE) {
+        latency[1] = gg_kv(
+            GG_STR("SubscriptionResponseMessage"),
+            histogram_obj(
+                &delivery, &hist_kvs[1], &hist_buckets[1], &hist_bucket_kvs[1]
+            )
+        );
+        latency_len = 2;
+    }
+
+    double throughput = (elapsed_ns == 0)
+        ? 0.0
+        : (double) completed * 1e9 / (double) elapsed_ns;
+
+    GgObject results = gg_obj_map(GG_MAP(
+        gg_kv(GG_STR("version"), gg_obj_buf(GG_STR(GGL_VERSION))),
+        gg_kv(GG_STR("operation"), gg_obj_buf(operation_name())),
+        gg_kv(GG_STR("connections"), gg_obj_i64(config->connections)),
+        gg_kv(GG_STR("payload_bytes"), gg_obj_i64(config->payload_len)),
+        gg_kv(
+            GG_STR("mode"),
+            gg_obj_buf((config->rate > 0) ? GG_STR("open") : GG_STR("closed"))
+        ),
+        gg_kv(GG_STR("rate_per_connection"), gg_obj_i64(config->rate)),
+        gg_kv(GG_STR("duration_s"), gg_obj_i64(config->duration_s)),
+        gg_kv(GG_STR("sent"), gg_obj_i64((int64_t) sent)),
+        gg_kv(GG_STR("completed"), gg_obj_i64((int64_t) completed)),
+        gg_kv(GG_STR("errors"), gg_obj_i64((int64_t) errors)),
+        gg_kv(GG_STR("throughput_per_sec"), gg_obj_f64(throughput)),
+        gg_kv(
+            GG_STR("latency"),
+            gg_obj_map((GgMap) { .pairs = latency, .len = latency_len })
+        )
+    ));
+
+    static uint8_t json_mem[16384];
+    GgByteVec json = GG_BYTE_VEC(json_mem);
+    GgError ret = gg_json_encode(results, gg_byte_vec_writer(&json));
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to encode results.");
+        return ret;
+    }
+    printf("%.*s\n", (int) json.buf.len, json.buf.data);
+    return GG_ERR_OK;
+}
+
+GgError run_ipc_loadgen(const IpcLoadgenArgs *args) {
+    config = args;
+
+    GgError ret = validate_args();
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = prepare_payload();
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = build_key_path();
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    if (config->mqtt_stand_in) {
+        ret = start_mqtt_stand_in();
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+    }
+
+    size_t opened = 0;
+    for (; opened < config->connections; opened++) {
+        ret = open_conn(&conns[opened], opened);
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Failed to open IPC connection %zu.", opened);
+            break;
+        }
+    }
+
+    start_ns = now_ns();
+    size_t started = 0;
+    if (ret == GG_ERR_OK) {
+        for (; started < opened; started++) {
+            LoadConn *conn = &conns[started];
+            if (pthread_create(&conn->receiver, NULL, receiver_thread, conn)
+                != 0) {
+                ret = GG_ERR_FAILURE;
+                break;
+            }
+            if (pthread_create(&conn->sender, NULL, sender_thread, conn)
+                != 0) {
+                (void) shutdown(conn->fd, SHUT_RDWR);
+                pthread_join(conn->receiver, NULL);
+                ret = GG_ERR_FAILURE;
+                break;
+            }
+        }
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Failed to start load threads.");
+        }
+    }
+
+    uint64_t end_ns = start_ns;
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(conns[i].sender, NULL);
+        pthread_join(conns[i].receiver, NULL);
+        if (conns[i].last_response_ns > end_ns) {
+            end_ns = conns[i].last_response_ns;
+        }
+    }
+    for (size_t i = 0; i < opened; i++) {
+        (void) close(conns[i].fd);
+    }
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    return print_results(end_ns - start_ns);
+}
@@ -0,0 +1,103 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "histogram.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Values 0-3 get a bucket each; above that, a power of two is split by the two
+// bits after the leading one.
+static size_t bucket_index(uint64_t latency_us) {
+    if (latency_us < 4U) {
+        return (size_t) latency_us;
+    }
+    size_t msb = 63U - (size_t) __builtin_clzll(latency_us);
+    size_t sub = (size_t) ((latency_us >> (msb - 2U)) & 3U);
+    size_t index = (4U * (msb - 1U)) + sub;
+    if (index >= LATENCY_HISTOGRAM_BUCKETS) {
+        return LATENCY_HISTOGRAM_BUCKETS - 1U;
+    }
+    return index;
+}
+
+uint64_t latency_histogram_bucket_max(size_t index) {
+    if (index < 4U) {
+        return index;
+    }
+    size_t msb = (index / 4U) + 1U;
+    uint64_t sub = index % 4U;
+    return ((5U + sub) << (msb - 2U)) - 1U;
+}
+
+void latency_histogram_record(LatencyHistogram *hist, uint64_t latency_us) {
+    hist->counts[bucket_index(latency_us)] += 1;
+    hist->total += 1;
+    hist->sum_us += latency_us;
+    if (latency_us > hist->max_us) {
+        hist->max_us = latency_us;
+    }
+}
+
+void latency_histogram_merge(
+    LatencyHistogram *dest, const LatencyHistogram *src
+) {
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        dest->counts[i] += src->counts[i];
+    }
+    dest->total += src->total;
+    dest->sum_us += src->sum_us;
+    if (src->max_us > dest->max_us) {
+        dest->max_us = src->max_us;
+    }
+}
+
+uint64_t latency_histogram_percentile(
+    const LatencyHistogram *hist, double percentile
+) {
+    if (hist->total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t) ((double) hist->total * percentile / 100.0);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint64_t bound = latency_histogram_bucket_max(i);
+            return (bound < hist->max_us) ? bound : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+#ifdef GG_SDK_TESTING
+
+#include <gg/test.h>
+#include <unity.h>
+
+GG_TEST_DEFINE(latency_histogram_buckets_contiguous) {
+    for (uint64_t us = 0; us < 100000U; us++) {
+        size_t index = bucket_index(us);
+        TEST_ASSERT_TRUE(us <= latency_histogram_bucket_max(index));
+        if (index > 0) {
+            TEST_ASSERT_TRUE(us > latency_histogram_bucket_max(index - 1U));
+        }
+    }
+}
+
+GG_TEST_DEFINE(latency_histogram_percentiles) {
+    static LatencyHistogram hist;
+    for (uint64_t us = 1; us <= 100U; us++) {
+        latency_histogram_record(&hist, us);
+    }
+    TEST_ASSERT_EQUAL_UINT64(100U, hist.max_us);
+    TEST_ASSERT_EQUAL_UINT64(100U, latency_histogram_percentile(&hist, 100.0));
+
+    // p50 is 50, which falls in the 48-55 bucket.
+    TEST_ASSERT_EQUAL_UINT64(55U, latency_histogram_percentile(&hist, 50.0));
+}
+
+#endif
@@ -0,0 +1,38 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef IPC_LOADGEN_HISTOGRAM_H
+#define IPC_LOADGEN_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Latencies are bucketed in microseconds, with four buckets per power of two
+// (within 25% of the recorded value). Latencies over 2^32 µs share the last
+// bucket.
+#define LATENCY_HISTOGRAM_BUCKETS 128U
+
+typedef struct {
+    uint64_t counts[LATENCY_HISTOGRAM_BUCKETS];
+    uint64_t total;
+    uint64_t sum_us;
+    uint64_t max_us;
+} LatencyHistogram;
+
+void latency_histogram_record(LatencyHistogram *hist, uint64_t latency_us);
+
+void latency_histogram_merge(
+    LatencyHistogram *dest, const LatencyHistogram *src
+);
+
+/// Largest latency that falls in a bucket.
+uint64_t latency_histogram_bucket_max(size_t index);
+
+/// Latency at or below which `percentile` percent of the recorded latencies
+/// fall, rounded up to the bucket bound. Returns 0 if nothing was recorded.
+uint64_t latency_histogram_percentile(
+    const LatencyHistogram *hist, double percentile
+);
+
+#endif
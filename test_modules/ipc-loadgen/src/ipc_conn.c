@@ -0,0 +1,152 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ipc_conn.h"
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/eventstream/decode.h>
+#include <gg/eventstream/encode.h>
+#include <gg/eventstream/rpc.h>
+#include <gg/eventstream/types.h>
+#include <gg/file.h>
+#include <gg/json_encode.h>
+#include <gg/log.h>
+#include <gg/map.h>
+#include <gg/object.h>
+#include <gg/socket.h>
+#include <gg/types.h>
+#include <stdint.h>
+
+GgError ipc_conn_send(
+    int fd, GgBuffer buf, int32_t stream_id, GgBuffer operation, GgMap params
+) {
+    EventStreamHeader headers[] = {
+        { GG_STR(":message-type"),
+          { EVENTSTREAM_INT32, .int32 = EVENTSTREAM_APPLICATION_MESSAGE } },
+        { GG_STR(":message-flags"), { EVENTSTREAM_INT32, .int32 = 0 } },
+        { GG_STR(":stream-id"), { EVENTSTREAM_INT32, .int32 = stream_id } },
+        { GG_STR("operation"), { EVENTSTREAM_STRING, .string = operation } },
+        { GG_STR(":content-type"),
+          { EVENTSTREAM_STRING, .string = GG_STR("application/json") } },
+    };
+    size_t headers_len = sizeof(headers) / sizeof(headers[0]);
+
+    GgObject payload = gg_obj_map(params);
+    GgError ret = eventstream_encode(
+        &buf, headers, headers_len, gg_json_reader(&payload)
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to encode request; payload may be too large.");
+        return ret;
+    }
+    return gg_socket_write(fd, buf);
+}
+
+GgError ipc_conn_recv(
+    int fd,
+    GgBuffer buf,
+    EventStreamMessage *msg,
+    EventStreamCommonHeaders *common_headers
+) {
+    if (buf.len < 12U) {
+        return GG_ERR_NOMEM;
+    }
+    GgBuffer prelude_buf = gg_buffer_substr(buf, 0, 12);
+    GgError ret = gg_file_read_exact(fd, prelude_buf);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    EventStreamPrelude prelude;
+    ret = eventstream_decode_prelude(prelude_buf, &prelude);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    if (prelude.data_len > buf.len) {
+        GG_LOGE("Message from ggipcd does not fit in buffer.");
+        return GG_ERR_NOMEM;
+    }
+
+    GgBuffer data_section = gg_buffer_substr(buf, 0, prelude.data_len);
+    ret = gg_file_read_exact(fd, data_section);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    ret = eventstream_decode(&prelude, data_section, msg);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    return eventstream_get_common_headers(msg, common_headers);
+}
+
+GgError ipc_conn_connect(
+    GgBuffer socket_path,
+    GgBuffer svcuid,
+    GgBuffer component_name,
+    GgBuffer buf,
+    int *fd
+) {
+    int conn = -1;
+    GgError ret = gg_connect(socket_path, &conn);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE(
+            "Failed to connect to %.*s.",
+            (int) socket_path.len,
+            socket_path.data
+        );
+        return ret;
+    }
+    GG_CLEANUP_ID(conn_cleanup, cleanup_close, conn);
+
+    EventStreamHeader headers[] = {
+        { GG_STR(":message-type"),
+          { EVENTSTREAM_INT32, .int32 = EVENTSTREAM_CONNECT } },
+        { GG_STR(":message-flags"), { EVENTSTREAM_INT32, .int32 = 0 } },
+        { GG_STR(":stream-id"), { EVENTSTREAM_INT32, .int32 = 0 } },
+        { GG_STR(":version"),
+          { EVENTSTREAM_STRING, .string = GG_STR("0.1.0") } },
+        { GG_STR(":content-type"),
+          { EVENTSTREAM_STRING, .string = GG_STR("application/json") } },
+    };
+    size_t headers_len = sizeof(headers) / sizeof(headers[0]);
+
+    GgObject payload = gg_obj_map(
+        (svcuid.len > 0)
+            ? GG_MAP(gg_kv(GG_STR("authToken"), gg_obj_buf(svcuid)))
+            : GG_MAP(gg_kv(GG_STR("componentName"), gg_obj_buf(component_name)))
+    );
+
+    GgBuffer encoded = buf;
+    ret = eventstream_encode(
+        &encoded, headers, headers_len, gg_json_reader(&payload)
+    );
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    ret = gg_socket_write(conn, encoded);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+
+    EventStreamMessage msg;
+    EventStreamCommonHeaders common_headers;
+    ret = ipc_conn_recv(conn, buf, &msg, &common_headers);
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to read connect response from ggipcd.");
+        return ret;
+    }
+    if ((common_headers.message_type != EVENTSTREAM_CONNECT_ACK)
+        || ((common_headers.message_flags & EVENTSTREAM_CONNECTION_ACCEPTED)
+            == 0)) {
+        GG_LOGE("ggipcd rejected the connection.");
+        return GG_ERR_FAILURE;
+    }
+
+    // NOLINTNEXTLINE(clang-analyzer-deadcode.DeadStores) false positive
+    conn_cleanup = -1;
+    *fd = conn;
+    return GG_ERR_OK;
+}
@@ -0,0 +1,44 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef IPC_LOADGEN_IPC_CONN_H
+#define IPC_LOADGEN_IPC_CONN_H
+
+//! Minimal ggipcd EventStream client. Unlike the SDK IPC client, which keeps
+//! one connection per process, each caller owns its own socket so that many
+//! connections can be driven from one process.
+
+#include <gg/error.h>
+#include <gg/eventstream/rpc.h>
+#include <gg/eventstream/types.h>
+#include <gg/types.h>
+#include <stdint.h>
+
+/// Connects to ggipcd and completes the connect handshake.
+/// Authenticates with `svcuid` if not empty, otherwise as `component_name`.
+/// `buf` is used to encode and receive the handshake messages.
+GgError ipc_conn_connect(
+    GgBuffer socket_path,
+    GgBuffer svcuid,
+    GgBuffer component_name,
+    GgBuffer buf,
+    int *fd
+);
+
+/// Sends a request opening stream `stream_id`.
+/// `buf` is used to encode the message.
+GgError ipc_conn_send(
+    int fd, GgBuffer buf, int32_t stream_id, GgBuffer operation, GgMap params
+);
+
+/// Reads the next message from ggipcd into `buf`.
+/// `msg` references `buf`.
+GgError ipc_conn_recv(
+    int fd,
+    GgBuffer buf,
+    EventStreamMessage *msg,
+    EventStreamCommonHeaders *common_headers
+);
+
+#endif
@@ -122,6 +122,7 @@ GgError run_s3_test(char *region, char *bucket, char *key, char *file_path) {
             (GgBuffer) { .data = host_vec.buf.data, .len = host_vec.buf.len },
             gg_buffer_from_null_term(key),
             fd,
+            NULL,
             (SigV4Details) { .aws_region = gg_buffer_from_null_term(region),
                              .aws_service = GG_STR("s3"),
                              .access_key_id = aws_access_key_id,
@@ -0,0 +1,24 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gg/error.h>
+#include <ggl/nucleus/init.h>
+#include <zip-bench.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        return 1;
+    }
+
+    ggl_nucleus_init();
+
+    uint32_t iterations
+        = (argc < 3) ? 5 : (uint32_t) strtoul(argv[2], NULL, 10);
+    GgError ret = run_zip_bench(argv[1], iterations);
+    if (ret != GG_ERR_OK) {
+        return 1;
+    }
+}
@@ -0,0 +1,15 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ZIP_BENCH_H
+#define ZIP_BENCH_H
+
+#include <gg/error.h>
+#include <stdint.h>
+
+/// Builds a sample archive in work_dir and times unarchiving it. Each
+/// iteration extracts into a new out-<n> directory, which is left in place.
+GgError run_zip_bench(char *work_dir, uint32_t iterations);
+
+#endif
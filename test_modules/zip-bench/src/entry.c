@@ -0,0 +1,205 @@
+// aws-greengrass-lite - AWS IoT Greengrass runtime for constrained devices
+// Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <fcntl.h>
+#include <gg/buffer.h>
+#include <gg/cleanup.h>
+#include <gg/error.h>
+#include <gg/file.h>
+#include <gg/log.h>
+#include <gg/types.h>
+#include <gg/vector.h>
+#include <ggl/zip.h>
+#include <time.h>
+#include <zip-bench.h>
+#include <zip.h>
+#include <zipconf.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Shape of the sample archive: a Python-style component with many small
+// sources and a few large native libraries.
+#define SMALL_DIRS 50U
+#define SMALL_FILES_PER_DIR 40U
+#define SMALL_FILE_MAX 8192U
+#define LARGE_FILES 4U
+#define LARGE_FILE_SIZE (16U * 1024U * 1024U)
+
+static uint8_t sample_data[LARGE_FILE_SIZE];
+
+/// Fills the sample data with word-like text so it compresses like source
+/// code rather than like random or constant data.
+static void fill_sample_data(void) {
+    static const char *const WORDS[]
+        = { "import ", "def ",    "return ", "self",   ".", "(", ")",
+            ":\n    ", "value",   " = ",     "None",   ",", "\n", "class ",
+            "for ",    " in ",    "if ",     "config", "_", "0", "1" };
+    size_t word_count = sizeof(WORDS) / sizeof(WORDS[0]);
+    uint32_t state = 12345U;
+    size_t pos = 0;
+    while (pos < sizeof(sample_data)) {
+        state = (state * 1103515245U) + 12345U;
+        const char *word = WORDS[(state >> 16) % word_count];
+        for (size_t i = 0; (word[i] != '\0') && (pos < sizeof(sample_data));
+             i++) {
+            sample_data[pos] = (uint8_t) word[i];
+            pos++;
+        }
+    }
+}
+
+static GgError add_sample_file(
+    zip_t *zip, const char *name, size_t offset, size_t len
+) {
+    zip_source_t *source
+        = zip_source_buffer(zip, &sample_data[offset], len, 0);
+    if (source == NULL) {
+        GG_LOGE("Failed to create zip source: %s.", zip_strerror(zip));
+        return GG_ERR_FAILURE;
+    }
+    if (zip_file_add(zip, name, source, ZIP_FL_OVERWRITE) < 0) {
+        GG_LOGE("Failed to add %s to archive: %s.", name, zip_strerror(zip));
+        zip_source_free(source);
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+static GgError build_archive(const char *zip_path) {
+    int err = 0;
+    zip_t *zip = zip_open(zip_path, ZIP_CREATE | ZIP_TRUNCATE, &err);
+    if (zip == NULL) {
+        GG_LOGE("Failed to create %s with error %d.", zip_path, err);
+        return GG_ERR_FAILURE;
+    }
+
+    char name[64];
+    size_t offset = 0;
+    for (uint32_t dir = 0; dir < SMALL_DIRS; dir++) {
+        (void) snprintf(name, sizeof(name), "pkg%02u/", dir);
+        if (zip_dir_add(zip, name, 0) < 0) {
+            GG_LOGE("Failed to add %s to archive.", name);
+            zip_discard(zip);
+            return GG_ERR_FAILURE;
+        }
+        for (uint32_t file = 0; file < SMALL_FILES_PER_DIR; file++) {
+            size_t len = 256U + ((size_t) (dir * 131U + file * 977U))
+                    % SMALL_FILE_MAX;
+            offset = (offset + 4099U) % (sizeof(sample_data) - SMALL_FILE_MAX);
+            (void) snprintf(
+                name, sizeof(name), "pkg%02u/module%03u.py", dir, file
+            );
+            GgError ret = add_sample_file(zip, name, offset, len);
+            if (ret != GG_ERR_OK) {
+                zip_discard(zip);
+                return ret;
+            }
+        }
+    }
+
+    for (uint32_t file = 0; file < LARGE_FILES; file++) {
+        (void) snprintf(name, sizeof(name), "lib/native%u.so", file);
+        GgError ret = add_sample_file(zip, name, 0, sizeof(sample_data));
+        if (ret != GG_ERR_OK) {
+            zip_discard(zip);
+            return ret;
+        }
+    }
+
+    if (zip_close(zip) != 0) {
+        GG_LOGE("Failed to write %s: %s.", zip_path, zip_strerror(zip));
+        zip_discard(zip);
+        return GG_ERR_FAILURE;
+    }
+    return GG_ERR_OK;
+}
+
+static double elapsed_ms(struct timespec start, struct timespec end) {
+    return ((double) (end.tv_sec - start.tv_sec) * 1000.0)
+        + ((double) (end.tv_nsec - start.tv_nsec) / 1000000.0);
+}
+
+GgError run_zip_bench(char *work_dir, uint32_t iterations) {
+    int work_fd;
+    GgError ret = gg_dir_open(
+        gg_buffer_from_null_term(work_dir), O_PATH, true, &work_fd
+    );
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Failed to open work directory %s.", work_dir);
+        return ret;
+    }
+    GG_CLEANUP(cleanup_close, work_fd);
+
+    static char zip_path[4096];
+    GgByteVec zip_path_vec = GG_BYTE_VEC(zip_path);
+    gg_byte_vec_chain_append(
+        &ret, &zip_path_vec, gg_buffer_from_null_term(work_dir)
+    );
+    gg_byte_vec_chain_append(&ret, &zip_path_vec, GG_STR("/bench.zip\0"));
+    if (ret != GG_ERR_OK) {
+        GG_LOGE("Work directory path too long.");
+        return ret;
+    }
+
+    fill_sample_data();
+    ret = build_archive(zip_path);
+    if (ret != GG_ERR_OK) {
+        return ret;
+    }
+    printf(
+        "Archive: %u small files, %u x %u MiB files.\n",
+        SMALL_DIRS * SMALL_FILES_PER_DIR,
+        LARGE_FILES,
+        LARGE_FILE_SIZE / (1024U * 1024U)
+    );
+
+    double total_ms = 0.0;
+    double min_ms = 0.0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        char out_name[32];
+        int out_len = snprintf(out_name, sizeof(out_name), "out-%u", i);
+        int out_fd;
+        ret = gg_dir_openat(
+            work_fd,
+            (GgBuffer) { .data = (uint8_t *) out_name,
+                         .len = (size_t) out_len },
+            O_PATH,
+            true,
+            &out_fd
+        );
+        if (ret != GG_ERR_OK) {
+            return ret;
+        }
+        GG_CLEANUP(cleanup_close, out_fd);
+
+        struct timespec start;
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ret = ggl_zip_unarchive(work_fd, GG_STR("bench.zip"), out_fd, 0644);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (ret != GG_ERR_OK) {
+            GG_LOGE("Unarchive failed.");
+            return ret;
+        }
+
+        double ms = elapsed_ms(start, end);
+        printf("Iteration %u: %.1f ms\n", i, ms);
+        total_ms += ms;
+        if ((i == 0) || (ms < min_ms)) {
+            min_ms = ms;
+        }
+    }
+
+    if (iterations > 0) {
+        printf(
+            "Unarchive: min %.1f ms, mean %.1f ms over %u iterations.\n",
+            min_ms,
+            total_ms / iterations,
+            iterations
+        );
+    }
+    return GG_ERR_OK;
+}